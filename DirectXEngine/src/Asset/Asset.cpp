@@ -2,12 +2,16 @@
 
 #include "../Debug/Debug.h"
 
+std::atomic<unsigned int> Asset::m_nextRuntimeID(0);
+
 Asset::Asset(ID3D11Device* device, ID3D11DeviceContext* context, std::string assetID, std::string filepath)
 {
 	m_device = device;
 	m_context = context;
 	m_assetID = assetID;
 	m_filepath = filepath;
+
+	m_runtimeID = m_nextRuntimeID++;
 }
 
 Asset::~Asset()
@@ -23,12 +27,12 @@ void Asset::saveToJSON(rapidjson::PrettyWriter<rapidjson::StringBuffer>& writer)
 	writer.String(m_filepath.c_str());
 }
 
-std::string Asset::getAssetID() const
+const std::string& Asset::getAssetID() const
 {
 	return m_assetID;
 }
 
-std::string Asset::getFilepath() const
+const std::string& Asset::getFilepath() const
 {
 	return m_filepath;
 }
@@ -39,3 +43,8 @@ bool Asset::wasLoadedFromFile() const
 
 	return true;
 }
+
+unsigned int Asset::getRuntimeID() const
+{
+	return m_runtimeID;
+}
@@ -5,6 +5,7 @@
 #include "rapidjson/document.h"
 #include "rapidjson/prettywriter.h"
 
+#include <atomic>
 #include <d3d11.h>
 #include <string>
 
@@ -16,11 +17,15 @@ public:
 	virtual bool loadFromFile() = 0;
 	virtual void saveToJSON(rapidjson::PrettyWriter<rapidjson::StringBuffer>& writer);
 
-	std::string getAssetID() const;
-	std::string getFilepath() const;
+	const std::string& getAssetID() const;
+	const std::string& getFilepath() const;
 
 	bool wasLoadedFromFile() const;
 
+	// A number unique to this asset for as long as the program runs, handed out in creation order.
+	// Cheaper than the asset ID to compare and pack into things like draw sort keys.
+	unsigned int getRuntimeID() const;
+
 protected:
 	Asset(ID3D11Device* device, ID3D11DeviceContext* context, std::string assetID, std::string filepath);
 	virtual ~Asset();
@@ -29,5 +34,9 @@ protected:
 	ID3D11DeviceContext* m_context;
 	std::string m_assetID;
 	std::string m_filepath;
+
+private:
+	unsigned int m_runtimeID;
+	static std::atomic<unsigned int> m_nextRuntimeID;
 };
 
@@ -1,5 +1,6 @@
 #include "AssetManager.h"
 
+#include "../Render/ShadowAtlas.h"
 #include "../Util.h"
 
 using namespace DirectX;
@@ -150,6 +151,9 @@ bool AssetManager::loadDefaultAssets()
 	VertexShader* basicVertexShader = loadAsset<VertexShader>(BASIC_SHADER_VERTEX, "Assets/Shaders/BasicVertexShader.cso");
 	if (!basicVertexShader) return false;
 
+	VertexShader* instancedVertexShader = loadAsset<VertexShader>(INSTANCED_SHADER_VERTEX, "Assets/Shaders/InstancedVertexShader.cso");
+	if (!instancedVertexShader) return false;
+
 	// Creates the default textures
 	if (!createAsset<Texture>(DEFAULT_TEXTURE_DIFFUSE, 0xff808080)) return false;
 	if (!createAsset<Texture>(DEFAULT_TEXTURE_WHITE, 0xffffffff)) return false;
@@ -161,6 +165,15 @@ bool AssetManager::loadDefaultAssets()
 	shadowMapParameters.shaderResourceViewFormat = DXGI_FORMAT_R32_FLOAT;
 	if (!createAsset<Texture>(DEFAULT_TEXTURE_SHADOWMAP, 0xffffffff, shadowMapParameters)) return false;
 
+	// Every shadow casting light renders into its own tile of this one depth texture
+	TextureParameters shadowAtlasParameters = {};
+	shadowAtlasParameters.usage = D3D11_USAGE_DEFAULT;
+	shadowAtlasParameters.bindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_DEPTH_STENCIL;
+	shadowAtlasParameters.textureFormat = DXGI_FORMAT_R32_TYPELESS;
+	shadowAtlasParameters.shaderResourceViewFormat = DXGI_FORMAT_R32_FLOAT;
+	shadowAtlasParameters.depthStencilViewFormat = DXGI_FORMAT_D32_FLOAT;
+	if (!createAsset<Texture>(SHADOW_ATLAS_TEXTURE, SHADOW_ATLAS_SIZE, SHADOW_ATLAS_SIZE, shadowAtlasParameters)) return false;
+
 	// Creates the default sampler
 	D3D11_SAMPLER_DESC defaultSamplerDesc = {};
 	defaultSamplerDesc.AddressU = D3D11_TEXTURE_ADDRESS_WRAP;
@@ -8605,10 +8618,10 @@ bool AssetManager::loadDefaultAssets()
 	return true;
 }
 
-bool AssetManager::isDefaultAsset(std::string assetName)
+bool AssetManager::isDefaultAsset(std::string_view assetName)
 {
-	if (assetName == DEFAULT_SHADER_VERTEX || assetName == DEFAULT_SHADER_PIXEL || assetName == BASIC_SHADER_VERTEX
-		|| assetName == DEFAULT_TEXTURE_DIFFUSE || assetName == DEFAULT_TEXTURE_WHITE || assetName == DEFAULT_TEXTURE_RED || assetName == DEFAULT_TEXTURE_NORMAL || assetName == DEFAULT_TEXTURE_SHADOWMAP
+	if (assetName == DEFAULT_SHADER_VERTEX || assetName == DEFAULT_SHADER_PIXEL || assetName == BASIC_SHADER_VERTEX || assetName == INSTANCED_SHADER_VERTEX
+		|| assetName == DEFAULT_TEXTURE_DIFFUSE || assetName == DEFAULT_TEXTURE_WHITE || assetName == DEFAULT_TEXTURE_RED || assetName == DEFAULT_TEXTURE_NORMAL || assetName == DEFAULT_TEXTURE_SHADOWMAP || assetName == SHADOW_ATLAS_TEXTURE
 		|| assetName == DEFAULT_MATERIAL || assetName == DEFAULT_RED_MATERIAL
 		|| assetName == DEFAULT_MODEL_CUBE || assetName == DEFAULT_MODEL_SPHERE || assetName == DEFAULT_MODEL_CAPSULE || assetName == DEFAULT_MODEL_TETRAHEDRON
 		|| assetName == DEFAULT_SAMPLER || assetName == SHADOWMAP_SAMPLER
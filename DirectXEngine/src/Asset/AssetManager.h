@@ -9,10 +9,14 @@
 #include "Font.h"
 #include "Sampler.h"
 
+#include "../Util.h"
+
+#include <string_view>
 #include <unordered_map>
 
 #define DEFAULT_SHADER_VERTEX "defaultVertex"
 #define BASIC_SHADER_VERTEX "basicVertex"
+#define INSTANCED_SHADER_VERTEX "instancedVertex"
 #define DEFAULT_SHADER_PIXEL "defaultPixel"
 
 #define DEFAULT_TEXTURE_DIFFUSE "defaultDiffuse"
@@ -20,6 +24,7 @@
 #define DEFAULT_TEXTURE_RED "defaultRed"
 #define DEFAULT_TEXTURE_NORMAL "defaultNormal"
 #define DEFAULT_TEXTURE_SHADOWMAP "defaultShadowMap"
+#define SHADOW_ATLAS_TEXTURE "shadowAtlas"
 
 #define DEFAULT_MATERIAL "defaultMaterial"
 #define DEFAULT_RED_MATERIAL "defaultRedMaterial"
@@ -58,7 +63,7 @@ public:
 	static T* loadAsset(std::string assetID, std::string filepath, Args... args);
 
 	template<typename T>
-	static T* getAsset(std::string assetID);
+	static T* getAsset(std::string_view assetID);
 
 	static std::vector<Asset*> getAllAssets();
 
@@ -70,7 +75,7 @@ public:
 
 	static void unloadAllAssets();
 
-	static bool isDefaultAsset(std::string assetName);
+	static bool isDefaultAsset(std::string_view assetName);
 
 private:
 	bool loadDefaultAssets();
@@ -133,14 +138,14 @@ inline T* AssetManager::loadAsset(std::string assetID, std::string filepath, Arg
 }
 
 template<typename T>
-inline T* AssetManager::getAsset(std::string assetID)
+inline T* AssetManager::getAsset(std::string_view assetID)
 {
 	static_assert(std::is_base_of<Asset, T>::value, "Given type is not an Asset.");
 
-	auto it = m_instance->m_assets.find(assetID);
+	auto it = m_instance->m_assets.find(Util::lookupKey(assetID));
 	if (it == m_instance->m_assets.end())
 	{
-		Debug::warning("Could not find asset with ID " + assetID);
+		Debug::warning("Could not find asset with ID " + std::string(assetID));
 		return nullptr;
 	}
 
@@ -156,7 +161,7 @@ std::vector<T*> AssetManager::getAllAssets()
 
 	for (auto it = m_instance->m_assets.begin(); it != m_instance->m_assets.end(); it++)
 	{
-		T* asset = getAsset<T>(it->first);
+		T* asset = dynamic_cast<T*>(it->second);
 		if (asset) assetVector.push_back(asset);
 	}
 
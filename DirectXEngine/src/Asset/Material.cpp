@@ -17,6 +17,8 @@ Material::Material(ID3D11Device* device, ID3D11DeviceContext* context, std::stri
 
 Material::Material(ID3D11Device* device, ID3D11DeviceContext* context, std::string assetID) : Asset(device, context, assetID, "")
 {
+	m_vertexShader = nullptr;
+	m_pixelShader = nullptr;
 	m_diffuseTexture = nullptr;
 	m_specularTexture = nullptr;
 	m_normalTexture = nullptr;
@@ -37,6 +39,7 @@ bool Material::create(VertexShader* vertexShader, PixelShader* pixelShader, cons
 {
 	m_vertexShader = vertexShader;
 	m_pixelShader = pixelShader;
+	findShaderHandles();
 	setMaterialSettings(materialSettings);
 
 	return true;
@@ -60,6 +63,19 @@ PixelShader* Material::getPixelShader() const
 	return m_pixelShader;
 }
 
+RenderMaterial Material::getRenderMaterial()
+{
+	RenderMaterial material;
+	material.id = getRuntimeID();
+	material.material = this;
+	material.vertexShader = static_cast<SimpleVertexShader*>(m_vertexShader);
+	material.vertexShaderID = m_vertexShader ? m_vertexShader->getRuntimeID() : 0;
+	material.pixelShader = static_cast<SimplePixelShader*>(m_pixelShader);
+	material.pixelShaderID = m_pixelShader ? m_pixelShader->getRuntimeID() : 0;
+
+	return material;
+}
+
 bool Material::loadFromFile()
 {
 	// Load the json file
@@ -118,6 +134,8 @@ bool Material::loadFromFile()
 		m_pixelShader = AssetManager::getAsset<PixelShader>(DEFAULT_SHADER_PIXEL);
 	}
 
+	findShaderHandles();
+
 	MaterialSettings settings;
 
 	rapidjson::Value::MemberIterator diffuse = dom.FindMember("diffuse");
@@ -238,9 +256,26 @@ void Material::useMaterial()
 			return;
 		}
 
-		m_pixelShader->SetShaderResourceView("diffuseTexture", diffuseSRV);
-		m_pixelShader->SetShaderResourceView("specularTexture", specularSRV);
-		m_pixelShader->SetShaderResourceView("normalTexture", normalSRV);
-		m_pixelShader->SetSamplerState("materialSampler", m_sampler->getSamplerState());
+		m_pixelShader->SetShaderResourceView(m_diffuseTextureHandle, diffuseSRV);
+		m_pixelShader->SetShaderResourceView(m_specularTextureHandle, specularSRV);
+		m_pixelShader->SetShaderResourceView(m_normalTextureHandle, normalSRV);
+		m_pixelShader->SetSamplerState(m_samplerHandle, m_sampler->getSamplerState());
 	}
 }
+
+void Material::findShaderHandles()
+{
+	if (!m_pixelShader)
+	{
+		m_diffuseTextureHandle = SimpleSRVHandle();
+		m_specularTextureHandle = SimpleSRVHandle();
+		m_normalTextureHandle = SimpleSRVHandle();
+		m_samplerHandle = SimpleSamplerHandle();
+		return;
+	}
+
+	m_diffuseTextureHandle = m_pixelShader->GetShaderResourceViewHandle("diffuseTexture");
+	m_specularTextureHandle = m_pixelShader->GetShaderResourceViewHandle("specularTexture");
+	m_normalTextureHandle = m_pixelShader->GetShaderResourceViewHandle("normalTexture");
+	m_samplerHandle = m_pixelShader->GetSamplerHandle("materialSampler");
+}
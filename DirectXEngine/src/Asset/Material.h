@@ -30,16 +30,27 @@ public:
 	VertexShader* getVertexShader() const;
 	PixelShader* getPixelShader() const;
 
+	// The material and its shaders as the renderer sorts and binds them
+	RenderMaterial getRenderMaterial();
+
 	MaterialSettings getMaterialSettings() const;
 	void setMaterialSettings(const MaterialSettings& settings);
 
 	void useMaterial();
 
 private:
+	// Looks up the pixel shader's texture and sampler slots once, so using the material doesn't look them up by name
+	void findShaderHandles();
+
 	VertexShader* m_vertexShader;
 	PixelShader* m_pixelShader;
 	Texture* m_diffuseTexture;
 	Texture* m_specularTexture;
 	Texture* m_normalTexture;
 	Sampler* m_sampler;
+
+	SimpleSRVHandle m_diffuseTextureHandle;
+	SimpleSRVHandle m_specularTextureHandle;
+	SimpleSRVHandle m_normalTextureHandle;
+	SimpleSamplerHandle m_samplerHandle;
 };
\ No newline at end of file
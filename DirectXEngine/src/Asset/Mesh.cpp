@@ -12,6 +12,10 @@ Mesh::Mesh(ID3D11Device* device, ID3D11DeviceContext* context, std::string asset
 	m_vertexCount = 0;
 	m_indices = nullptr;
 	m_indexCount = 0;
+
+	m_boundsCenter = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	m_boundsExtents = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	m_boundsRadius = 0.0f;
 }
 
 Mesh::Mesh(ID3D11Device* device, ID3D11DeviceContext* context, std::string assetID) : Asset(device, context, assetID, "")
@@ -20,6 +24,10 @@ Mesh::Mesh(ID3D11Device* device, ID3D11DeviceContext* context, std::string asset
 	m_vertexCount = 0;
 	m_indices = nullptr;
 	m_indexCount = 0;
+
+	m_boundsCenter = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	m_boundsExtents = XMFLOAT3(0.0f, 0.0f, 0.0f);
+	m_boundsRadius = 0.0f;
 }
 
 Mesh::~Mesh()
@@ -53,8 +61,10 @@ void Mesh::saveToJSON(rapidjson::PrettyWriter<rapidjson::StringBuffer>& writer)
 	writer.String("model");
 }
 
-void Mesh::updateVertices() const
+void Mesh::updateVertices()
 {
+	calculateBounds();
+
 	D3D11_MAPPED_SUBRESOURCE resource;
 	m_context->Map(m_vertexBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &resource);
 	memcpy_s(resource.pData, sizeof(Vertex) * m_vertexCount, m_vertices, sizeof(Vertex) * m_vertexCount);
@@ -258,6 +268,7 @@ bool Mesh::createBuffers(bool immutable)
 	}
 
 	calculateTangentsAndBarycentric();
+	calculateBounds();
 
 	// Create the VERTEX BUFFER description -----------------------------------
 	// - The description is created on the stack because we only need
@@ -346,6 +357,68 @@ size_t Mesh::getIndexCount() const
 	return m_indexCount;
 }
 
+RenderMesh Mesh::getRenderMesh() const
+{
+	RenderMesh mesh;
+	mesh.id = getRuntimeID();
+	mesh.vertexBuffer = m_vertexBuffer;
+	mesh.indexBuffer = m_indexBuffer;
+	mesh.vertexStride = sizeof(Vertex);
+	mesh.indexCount = m_indexCount;
+
+	return mesh;
+}
+
+XMFLOAT3 Mesh::getBoundsCenter() const
+{
+	return m_boundsCenter;
+}
+
+XMFLOAT3 Mesh::getBoundsExtents() const
+{
+	return m_boundsExtents;
+}
+
+float Mesh::getBoundsRadius() const
+{
+	return m_boundsRadius;
+}
+
+void Mesh::calculateBounds()
+{
+	if (m_vertexCount == 0)
+	{
+		m_boundsCenter = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		m_boundsExtents = XMFLOAT3(0.0f, 0.0f, 0.0f);
+		m_boundsRadius = 0.0f;
+		return;
+	}
+
+	XMVECTOR min = XMLoadFloat3(&m_vertices[0].position);
+	XMVECTOR max = min;
+
+	for (unsigned int i = 1; i < m_vertexCount; i++)
+	{
+		XMVECTOR position = XMLoadFloat3(&m_vertices[i].position);
+		min = XMVectorMin(min, position);
+		max = XMVectorMax(max, position);
+	}
+
+	XMStoreFloat3(&m_boundsCenter, XMVectorScale(XMVectorAdd(min, max), 0.5f));
+	XMStoreFloat3(&m_boundsExtents, XMVectorScale(XMVectorSubtract(max, min), 0.5f));
+
+	// The sphere is fitted to the vertices rather than the box, which is usually tighter than one through the box's corners
+	XMVECTOR center = XMLoadFloat3(&m_boundsCenter);
+	XMVECTOR radiusSquared = XMVectorZero();
+	for (unsigned int i = 0; i < m_vertexCount; i++)
+	{
+		XMVECTOR offset = XMVectorSubtract(XMLoadFloat3(&m_vertices[i].position), center);
+		radiusSquared = XMVectorMax(radiusSquared, XMVector3LengthSq(offset));
+	}
+
+	m_boundsRadius = sqrtf(XMVectorGetX(radiusSquared));
+}
+
 // Code adapted from: http://www.terathon.com/code/tangent.html
 void Mesh::calculateTangentsAndBarycentric()
 {
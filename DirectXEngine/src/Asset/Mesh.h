@@ -1,6 +1,8 @@
 #pragma once
 #include "Asset.h"
 
+#include "../Render/RenderTypes.h"
+
 #include <d3d11.h>
 #include <DirectXMath.h>
 
@@ -24,7 +26,9 @@ public:
 	bool loadFromFile() override;
 	void saveToJSON(rapidjson::PrettyWriter<rapidjson::StringBuffer>& writer) override;
 
-	void updateVertices() const;
+	// Uploads the vertices after they've been changed on the CPU and recalculates the bounds around them.
+	// Whoever changed them should also mark their transform as moved so the scene picks up the new bounds.
+	void updateVertices();
 
 	ID3D11Buffer* getVertexBuffer() const;
 	ID3D11Buffer* getIndexBuffer() const;
@@ -34,9 +38,20 @@ public:
 	unsigned int getVertexCount() const;
 	unsigned int getIndexCount() const;
 
+	// The buffers and counts the renderer draws the mesh with
+	RenderMesh getRenderMesh() const;
+
+	// The mesh's axis-aligned bounding box in model space, empty if the mesh has no vertices
+	DirectX::XMFLOAT3 getBoundsCenter() const;
+	DirectX::XMFLOAT3 getBoundsExtents() const;
+	// The radius of a model space bounding sphere around the bounding box's center
+	float getBoundsRadius() const;
+
 private:
 	bool createBuffers(bool immutable);
 
+	void calculateBounds();
+
 	// A helper function when loading meshes to calculate tangents for the normal map lighting calculation and assigns barycentric coordinates for solid wireframe rendering.
 	void calculateTangentsAndBarycentric();
 
@@ -45,6 +60,10 @@ private:
 	unsigned int* m_indices;
 	unsigned int m_indexCount;
 
+	DirectX::XMFLOAT3 m_boundsCenter;
+	DirectX::XMFLOAT3 m_boundsExtents;
+	float m_boundsRadius;
+
 	ID3D11Buffer* m_vertexBuffer;
 	ID3D11Buffer* m_indexBuffer;
 };
\ No newline at end of file
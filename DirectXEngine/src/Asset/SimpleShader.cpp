@@ -4,6 +4,9 @@
 // ------ BASE SIMPLE SHADER --------------------------------------------------
 ///////////////////////////////////////////////////////////////////////////////
 
+RenderCommandBuffer* ISimpleShader::commandBuffer = nullptr;
+unsigned int ISimpleShader::uploadGeneration = 0;
+
 // --------------------------------------------------------
 // Constructor accepts DirectX device & context
 // --------------------------------------------------------
@@ -177,6 +180,10 @@ bool ISimpleShader::LoadShaderFile(LPCWSTR shaderFile)
 		constantBuffers[b].LocalDataBuffer = new unsigned char[bufferDesc.Size];
 		ZeroMemory(constantBuffers[b].LocalDataBuffer, bufferDesc.Size);
 
+		// The GPU buffer starts out uninitialized, so the first copy always happens
+		constantBuffers[b].Dirty = true;
+		constantBuffers[b].UploadGeneration = uploadGeneration;
+
 		// Loop through all variables in this buffer
 		for (unsigned int v = 0; v < bufferDesc.Variables; v++)
 		{
@@ -280,9 +287,7 @@ void ISimpleShader::CopyAllBufferData()
 	for (unsigned int i = 0; i < constantBufferCount; i++)
 	{
 		// Copy the entire local data buffer
-		deviceContext->UpdateSubresource(
-			constantBuffers[i].ConstantBuffer, 0, 0,
-			constantBuffers[i].LocalDataBuffer, 0, 0);
+		UploadConstantBuffer(&constantBuffers[i]);
 	}
 }
 
@@ -311,9 +316,7 @@ void ISimpleShader::CopyBufferData(unsigned int index)
 	if (!cb) return;
 
 	// Copy the data and get out
-	deviceContext->UpdateSubresource(
-		cb->ConstantBuffer, 0, 0, 
-		cb->LocalDataBuffer, 0, 0);
+	UploadConstantBuffer(cb);
 }
 
 // --------------------------------------------------------
@@ -333,8 +336,38 @@ void ISimpleShader::CopyBufferData(std::string bufferName)
 	if (!cb) return;
 
 	// Copy the data and get out
+	UploadConstantBuffer(cb);
+}
+
+// --------------------------------------------------------
+// Copies local data to the constant buffer a handle from
+// GetBufferHandle() refers to
+// --------------------------------------------------------
+void ISimpleShader::CopyBufferData(SimpleBufferHandle handle)
+{
+	CopyBufferData(handle.Index);
+}
+
+// --------------------------------------------------------
+// Copies a constant buffer's local data to the GPU, or
+// records the copy if a command buffer is set. Buffers
+// that haven't changed since their last copy in this
+// upload generation are skipped.
+// --------------------------------------------------------
+void ISimpleShader::UploadConstantBuffer(SimpleConstantBuffer* cb)
+{
+	if (!cb->Dirty && cb->UploadGeneration == uploadGeneration) return;
+	cb->Dirty = false;
+	cb->UploadGeneration = uploadGeneration;
+
+	if (commandBuffer)
+	{
+		commandBuffer->updateBuffer(cb->ConstantBuffer, cb->LocalDataBuffer, cb->Size);
+		return;
+	}
+
 	deviceContext->UpdateSubresource(
-		cb->ConstantBuffer, 0, 0, 
+		cb->ConstantBuffer, 0, 0,
 		cb->LocalDataBuffer, 0, 0);
 }
 
@@ -357,15 +390,55 @@ bool ISimpleShader::SetData(std::string name, const void* data, unsigned int siz
 		return false;
 
 	// Set the data in the local data buffer
-	memcpy(
-		constantBuffers[var->ConstantBufferIndex].LocalDataBuffer + var->ByteOffset,
-		data,
-		size);
+	WriteBufferData(&constantBuffers[var->ConstantBufferIndex], var->ByteOffset, data, size);
 
 	// Success
 	return true;
 }
 
+// --------------------------------------------------------
+// Sets a variable through a handle with arbitrary data of
+// the specified size
+//
+// handle - A handle from this shader's GetVariableHandle()
+// data - The data to set in the buffer
+// size - The size of the data (this must match the variable's size)
+//
+// Returns true if data is copied, false if the handle is
+// invalid, doesn't fit this shader or sizes don't match
+// --------------------------------------------------------
+bool ISimpleShader::SetData(const SimpleVariableHandle& handle, const void* data, unsigned int size)
+{
+	// Validate the handle against this shader's buffers
+	if (handle.ConstantBufferIndex >= constantBufferCount || handle.Size != size)
+		return false;
+
+	SimpleConstantBuffer* cb = &constantBuffers[handle.ConstantBufferIndex];
+	if (handle.ByteOffset > cb->Size || size > cb->Size - handle.ByteOffset)
+		return false;
+
+	// Set the data in the local data buffer
+	WriteBufferData(cb, handle.ByteOffset, data, size);
+
+	// Success
+	return true;
+}
+
+// --------------------------------------------------------
+// Copies data into a constant buffer's local data, only
+// marking the buffer for copying if the data changed
+// --------------------------------------------------------
+void ISimpleShader::WriteBufferData(SimpleConstantBuffer* cb, unsigned int byteOffset, const void* data, unsigned int size)
+{
+	unsigned char* destination = cb->LocalDataBuffer + byteOffset;
+
+	if (memcmp(destination, data, size) != 0)
+	{
+		memcpy(destination, data, size);
+		cb->Dirty = true;
+	}
+}
+
 // --------------------------------------------------------
 // Sets INTEGER data
 // --------------------------------------------------------
@@ -446,6 +519,105 @@ bool ISimpleShader::SetMatrix4x4(std::string name, const DirectX::XMFLOAT4X4 dat
 	return this->SetData(name, &data, sizeof(float) * 16);
 }
 
+// --------------------------------------------------------
+// Sets typed data through a variable handle
+// --------------------------------------------------------
+bool ISimpleShader::SetInt(const SimpleVariableHandle& handle, int data)
+{
+	return this->SetData(handle, &data, sizeof(int));
+}
+
+bool ISimpleShader::SetFloat(const SimpleVariableHandle& handle, float data)
+{
+	return this->SetData(handle, &data, sizeof(float));
+}
+
+bool ISimpleShader::SetFloat2(const SimpleVariableHandle& handle, const DirectX::XMFLOAT2& data)
+{
+	return this->SetData(handle, &data, sizeof(float) * 2);
+}
+
+bool ISimpleShader::SetFloat3(const SimpleVariableHandle& handle, const DirectX::XMFLOAT3& data)
+{
+	return this->SetData(handle, &data, sizeof(float) * 3);
+}
+
+bool ISimpleShader::SetFloat4(const SimpleVariableHandle& handle, const DirectX::XMFLOAT4& data)
+{
+	return this->SetData(handle, &data, sizeof(float) * 4);
+}
+
+bool ISimpleShader::SetMatrix4x4(const SimpleVariableHandle& handle, const DirectX::XMFLOAT4X4& data)
+{
+	return this->SetData(handle, &data, sizeof(float) * 16);
+}
+
+// --------------------------------------------------------
+// Gets a handle to a shader variable, which is invalid
+// if the variable doesn't exist
+// --------------------------------------------------------
+SimpleVariableHandle ISimpleShader::GetVariableHandle(std::string name)
+{
+	SimpleVariableHandle handle;
+
+	SimpleShaderVariable* var = FindVariable(name, -1);
+	if (var == 0)
+		return handle;
+
+	handle.ConstantBufferIndex = var->ConstantBufferIndex;
+	handle.ByteOffset = var->ByteOffset;
+	handle.Size = var->Size;
+	return handle;
+}
+
+// --------------------------------------------------------
+// Gets a handle to a constant buffer, which is invalid
+// if the buffer doesn't exist
+// --------------------------------------------------------
+SimpleBufferHandle ISimpleShader::GetBufferHandle(std::string name)
+{
+	SimpleBufferHandle handle;
+
+	SimpleConstantBuffer* cb = FindConstantBuffer(name);
+	if (cb == 0)
+		return handle;
+
+	handle.Index = (unsigned int)(cb - constantBuffers);
+	return handle;
+}
+
+// --------------------------------------------------------
+// Gets a handle to an SRV, which is invalid if the SRV
+// doesn't exist
+// --------------------------------------------------------
+SimpleSRVHandle ISimpleShader::GetShaderResourceViewHandle(std::string name)
+{
+	SimpleSRVHandle handle;
+
+	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
+	if (srvInfo == 0)
+		return handle;
+
+	handle.BindIndex = srvInfo->BindIndex;
+	return handle;
+}
+
+// --------------------------------------------------------
+// Gets a handle to a sampler, which is invalid if the
+// sampler doesn't exist
+// --------------------------------------------------------
+SimpleSamplerHandle ISimpleShader::GetSamplerHandle(std::string name)
+{
+	SimpleSamplerHandle handle;
+
+	const SimpleSampler* sampInfo = GetSamplerInfo(name);
+	if (sampInfo == 0)
+		return handle;
+
+	handle.BindIndex = sampInfo->BindIndex;
+	return handle;
+}
+
 // --------------------------------------------------------
 // Gets info about a shader variable, if it exists
 // --------------------------------------------------------
@@ -754,6 +926,18 @@ void SimpleVertexShader::SetShaderAndCBs()
 	// Is shader valid?
 	if (!shaderValid) return;
 
+	if (commandBuffer)
+	{
+		commandBuffer->setInputLayout(inputLayout);
+		commandBuffer->setShader(SHADERSTAGE_VERTEX, shader);
+
+		for (unsigned int i = 0; i < constantBufferCount; i++)
+		{
+			commandBuffer->setConstantBuffer(SHADERSTAGE_VERTEX, constantBuffers[i].BindIndex, constantBuffers[i].ConstantBuffer);
+		}
+		return;
+	}
+
 	// Set the shader and input layout
 	deviceContext->IASetInputLayout(inputLayout);
 	deviceContext->VSSetShader(shader, 0, 0);
@@ -778,27 +962,39 @@ void SimpleVertexShader::SetShaderAndCBs()
 // --------------------------------------------------------
 bool SimpleVertexShader::SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv)
 {
-	// Look for the variable and verify
-	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
-	if (srvInfo == 0)
-		return false;
+	return SetShaderResourceView(GetShaderResourceViewHandle(name), srv);
+}
 
-	// Set the shader resource view
-	deviceContext->VSSetShaderResources(srvInfo->BindIndex, 1, &srv);
+bool SimpleVertexShader::SetShaderResourceViewArray(std::string name, ID3D11ShaderResourceView** srvs, unsigned int srvCount)
+{
+	return SetShaderResourceViewArray(GetShaderResourceViewHandle(name), srvs, srvCount);
+}
 
-	// Success
-	return true;
+// --------------------------------------------------------
+// Sets shader resource views through a handle from
+// GetShaderResourceViewHandle()
+//
+// Returns true if the handle is valid, false otherwise
+// --------------------------------------------------------
+bool SimpleVertexShader::SetShaderResourceView(SimpleSRVHandle handle, ID3D11ShaderResourceView* srv)
+{
+	return SetShaderResourceViewArray(handle, &srv, 1);
 }
 
-bool SimpleVertexShader::SetShaderResourceViewArray(std::string name, ID3D11ShaderResourceView** srvs, unsigned int srvCount)
+bool SimpleVertexShader::SetShaderResourceViewArray(SimpleSRVHandle handle, ID3D11ShaderResourceView** srvs, unsigned int srvCount)
 {
-	// Look for the variable and verify
-	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
-	if (srvInfo == 0)
+	// Verify the handle
+	if (!handle.IsValid())
 		return false;
 
 	// Set the shader resource views
-	deviceContext->VSSetShaderResources(srvInfo->BindIndex, srvCount, srvs);
+	if (commandBuffer)
+	{
+		commandBuffer->setShaderResources(SHADERSTAGE_VERTEX, handle.BindIndex, (const RenderHandle*)srvs, srvCount);
+		return true;
+	}
+
+	deviceContext->VSSetShaderResources(handle.BindIndex, srvCount, srvs);
 
 	// Success
 	return true;
@@ -814,13 +1010,29 @@ bool SimpleVertexShader::SetShaderResourceViewArray(std::string name, ID3D11Shad
 // --------------------------------------------------------
 bool SimpleVertexShader::SetSamplerState(std::string name, ID3D11SamplerState* samplerState)
 {
-	// Look for the variable and verify
-	const SimpleSampler* sampInfo = GetSamplerInfo(name);
-	if (sampInfo == 0)
+	return SetSamplerState(GetSamplerHandle(name), samplerState);
+}
+
+// --------------------------------------------------------
+// Sets a sampler state through a handle from
+// GetSamplerHandle()
+//
+// Returns true if the handle is valid, false otherwise
+// --------------------------------------------------------
+bool SimpleVertexShader::SetSamplerState(SimpleSamplerHandle handle, ID3D11SamplerState* samplerState)
+{
+	// Verify the handle
+	if (!handle.IsValid())
 		return false;
 
-	// Set the shader resource view
-	deviceContext->VSSetSamplers(sampInfo->BindIndex, 1, &samplerState);
+	// Set the sampler state
+	if (commandBuffer)
+	{
+		commandBuffer->setSampler(SHADERSTAGE_VERTEX, handle.BindIndex, samplerState);
+		return true;
+	}
+
+	deviceContext->VSSetSamplers(handle.BindIndex, 1, &samplerState);
 
 	// Success
 	return true;
@@ -889,6 +1101,17 @@ void SimplePixelShader::SetShaderAndCBs()
 {
 	// Is shader valid?
 	if (!shaderValid) return;
+
+	if (commandBuffer)
+	{
+		commandBuffer->setShader(SHADERSTAGE_PIXEL, shader);
+
+		for (unsigned int i = 0; i < constantBufferCount; i++)
+		{
+			commandBuffer->setConstantBuffer(SHADERSTAGE_PIXEL, constantBuffers[i].BindIndex, constantBuffers[i].ConstantBuffer);
+		}
+		return;
+	}
 	
 	// Set the shader
 	deviceContext->PSSetShader(shader, 0, 0);
@@ -913,27 +1136,39 @@ void SimplePixelShader::SetShaderAndCBs()
 // --------------------------------------------------------
 bool SimplePixelShader::SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv)
 {
-	// Look for the variable and verify
-	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
-	if (srvInfo == 0)
-		return false;
+	return SetShaderResourceView(GetShaderResourceViewHandle(name), srv);
+}
 
-	// Set the shader resource view
-	deviceContext->PSSetShaderResources(srvInfo->BindIndex, 1, &srv);
+bool SimplePixelShader::SetShaderResourceViewArray(std::string name, ID3D11ShaderResourceView*const* srvs, unsigned int srvCount)
+{
+	return SetShaderResourceViewArray(GetShaderResourceViewHandle(name), srvs, srvCount);
+}
 
-	// Success
-	return true;
+// --------------------------------------------------------
+// Sets shader resource views through a handle from
+// GetShaderResourceViewHandle()
+//
+// Returns true if the handle is valid, false otherwise
+// --------------------------------------------------------
+bool SimplePixelShader::SetShaderResourceView(SimpleSRVHandle handle, ID3D11ShaderResourceView* srv)
+{
+	return SetShaderResourceViewArray(handle, &srv, 1);
 }
 
-bool SimplePixelShader::SetShaderResourceViewArray(std::string name, ID3D11ShaderResourceView*const* srvs, unsigned int srvCount)
+bool SimplePixelShader::SetShaderResourceViewArray(SimpleSRVHandle handle, ID3D11ShaderResourceView*const* srvs, unsigned int srvCount)
 {
-	// Look for the variable and verify
-	const SimpleSRV* srvInfo = GetShaderResourceViewInfo(name);
-	if (srvInfo == 0)
+	// Verify the handle
+	if (!handle.IsValid())
 		return false;
 
 	// Set the shader resource views
-	deviceContext->PSSetShaderResources(srvInfo->BindIndex, srvCount, srvs);
+	if (commandBuffer)
+	{
+		commandBuffer->setShaderResources(SHADERSTAGE_PIXEL, handle.BindIndex, (const RenderHandle*)srvs, srvCount);
+		return true;
+	}
+
+	deviceContext->PSSetShaderResources(handle.BindIndex, srvCount, srvs);
 
 	// Success
 	return true;
@@ -949,13 +1184,29 @@ bool SimplePixelShader::SetShaderResourceViewArray(std::string name, ID3D11Shade
 // --------------------------------------------------------
 bool SimplePixelShader::SetSamplerState(std::string name, ID3D11SamplerState* samplerState)
 {
-	// Look for the variable and verify
-	const SimpleSampler* sampInfo = GetSamplerInfo(name);
-	if (sampInfo == 0)
+	return SetSamplerState(GetSamplerHandle(name), samplerState);
+}
+
+// --------------------------------------------------------
+// Sets a sampler state through a handle from
+// GetSamplerHandle()
+//
+// Returns true if the handle is valid, false otherwise
+// --------------------------------------------------------
+bool SimplePixelShader::SetSamplerState(SimpleSamplerHandle handle, ID3D11SamplerState* samplerState)
+{
+	// Verify the handle
+	if (!handle.IsValid())
 		return false;
 
-	// Set the shader resource view
-	deviceContext->PSSetSamplers(sampInfo->BindIndex, 1, &samplerState);
+	// Set the sampler state
+	if (commandBuffer)
+	{
+		commandBuffer->setSampler(SHADERSTAGE_PIXEL, handle.BindIndex, samplerState);
+		return true;
+	}
+
+	deviceContext->PSSetSamplers(handle.BindIndex, 1, &samplerState);
 
 	// Success
 	return true;
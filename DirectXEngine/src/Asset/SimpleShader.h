@@ -1,5 +1,6 @@
 #pragma once
 #include "Asset.h"
+#include "../Render/RenderCommandBuffer.h"
 
 #pragma comment(lib, "dxguid.lib")
 #pragma comment(lib, "d3dcompiler.lib")
@@ -36,6 +37,11 @@ struct SimpleConstantBuffer
 	ID3D11Buffer* ConstantBuffer;
 	unsigned char* LocalDataBuffer;
 	std::vector<SimpleShaderVariable> Variables;
+
+	// Whether the local data has changed since it was last copied to the GPU
+	bool Dirty;
+	// The upload generation of the last copy. Copies from an earlier generation may never have reached the GPU.
+	unsigned int UploadGeneration;
 };
 
 // --------------------------------------------------------
@@ -56,6 +62,44 @@ struct SimpleSampler
 	unsigned int BindIndex; // The register of the Sampler
 };
 
+// --------------------------------------------------------
+// Handles to variables, buffers and resources, looked up
+// by name once and then used to set them without hashing
+// the name again. Default handles are invalid, and
+// setting through one fails the same as an unknown name.
+// --------------------------------------------------------
+#define SIMPLE_SHADER_INVALID_INDEX 0xFFFFFFFF
+
+struct SimpleVariableHandle
+{
+	unsigned int ConstantBufferIndex = SIMPLE_SHADER_INVALID_INDEX;
+	unsigned int ByteOffset = 0;
+	unsigned int Size = 0;
+
+	bool IsValid() const { return ConstantBufferIndex != SIMPLE_SHADER_INVALID_INDEX; }
+};
+
+struct SimpleBufferHandle
+{
+	unsigned int Index = SIMPLE_SHADER_INVALID_INDEX;
+
+	bool IsValid() const { return Index != SIMPLE_SHADER_INVALID_INDEX; }
+};
+
+struct SimpleSRVHandle
+{
+	unsigned int BindIndex = SIMPLE_SHADER_INVALID_INDEX;
+
+	bool IsValid() const { return BindIndex != SIMPLE_SHADER_INVALID_INDEX; }
+};
+
+struct SimpleSamplerHandle
+{
+	unsigned int BindIndex = SIMPLE_SHADER_INVALID_INDEX;
+
+	bool IsValid() const { return BindIndex != SIMPLE_SHADER_INVALID_INDEX; }
+};
+
 // --------------------------------------------------------
 // Base abstract class for simplifying shader handling
 // --------------------------------------------------------
@@ -77,6 +121,7 @@ public:
 	void CopyAllBufferData();
 	void CopyBufferData(unsigned int index);
 	void CopyBufferData(std::string bufferName);
+	void CopyBufferData(SimpleBufferHandle handle);
 
 	// Sets arbitrary shader data
 	bool SetData(std::string name, const void* data, unsigned int size);
@@ -92,10 +137,26 @@ public:
 	bool SetMatrix4x4(std::string name, const float data[16]);
 	bool SetMatrix4x4(std::string name, const DirectX::XMFLOAT4X4 data);
 
+	// Sets shader data through a handle, which skips the name lookup
+	bool SetData(const SimpleVariableHandle& handle, const void* data, unsigned int size);
+
+	bool SetInt(const SimpleVariableHandle& handle, int data);
+	bool SetFloat(const SimpleVariableHandle& handle, float data);
+	bool SetFloat2(const SimpleVariableHandle& handle, const DirectX::XMFLOAT2& data);
+	bool SetFloat3(const SimpleVariableHandle& handle, const DirectX::XMFLOAT3& data);
+	bool SetFloat4(const SimpleVariableHandle& handle, const DirectX::XMFLOAT4& data);
+	bool SetMatrix4x4(const SimpleVariableHandle& handle, const DirectX::XMFLOAT4X4& data);
+
 	// Setting shader resources
 	virtual bool SetShaderResourceView(std::string name, ID3D11ShaderResourceView* srv) = 0;
 	virtual bool SetSamplerState(std::string name, ID3D11SamplerState* samplerState) = 0;
 
+	// Looking up handles, which are only valid for the shader they came from
+	SimpleVariableHandle GetVariableHandle(std::string name);
+	SimpleBufferHandle GetBufferHandle(std::string name);
+	SimpleSRVHandle GetShaderResourceViewHandle(std::string name);
+	SimpleSamplerHandle GetSamplerHandle(std::string name);
+
 	// Getting data about variables and resources
 	const SimpleShaderVariable* GetVariableInfo(std::string name);
 	
@@ -116,7 +177,18 @@ public:
 	// Misc getters
 	ID3DBlob* GetShaderBlob() { return shaderBlob; }
 
+	// While a command buffer is set, vertex and pixel shaders record their binds and constant buffer
+	// uploads into it instead of calling the device context. Set it back to null to go back to immediate calls.
+	static void SetCommandBuffer(RenderCommandBuffer* commands) { commandBuffer = commands; }
+	static RenderCommandBuffer* GetCommandBuffer() { return commandBuffer; }
+
+	// Makes every constant buffer copy again the next time it's asked to, changed or not. Needed whenever recorded
+	// copies go somewhere other than the device, like a null backend, so the device doesn't keep stale constants.
+	static void InvalidateUploads() { uploadGeneration++; }
+
 protected:
+	static RenderCommandBuffer* commandBuffer;
+	static unsigned int uploadGeneration;
 	
 	bool shaderValid;
 	ID3DBlob* shaderBlob;
@@ -144,6 +216,12 @@ protected:
 	// Helpers for finding data by name
 	SimpleShaderVariable* FindVariable(std::string name, int size);
 	SimpleConstantBuffer* FindConstantBuffer(std::string name);
+
+	// Copies data into a constant buffer's local data, marking it dirty if it changed
+	void WriteBufferData(SimpleConstantBuffer* cb, unsigned int byteOffset, const void* data, unsigned int size);
+
+	// Uploads a constant buffer's local data, or records the upload if a command buffer is set
+	void UploadConstantBuffer(SimpleConstantBuffer* cb);
 };
 
 // --------------------------------------------------------
@@ -163,6 +241,10 @@ public:
 	bool SetShaderResourceViewArray(std::string name, ID3D11ShaderResourceView** srvs, unsigned int srvCount);
 	bool SetSamplerState(std::string name, ID3D11SamplerState* samplerState);
 
+	bool SetShaderResourceView(SimpleSRVHandle handle, ID3D11ShaderResourceView* srv);
+	bool SetShaderResourceViewArray(SimpleSRVHandle handle, ID3D11ShaderResourceView** srvs, unsigned int srvCount);
+	bool SetSamplerState(SimpleSamplerHandle handle, ID3D11SamplerState* samplerState);
+
 protected:
 	bool perInstanceCompatible;
 	ID3D11InputLayout* inputLayout;
@@ -187,6 +269,10 @@ public:
 	bool SetShaderResourceViewArray(std::string name, ID3D11ShaderResourceView*const* srvs, unsigned int srvCount);
 	bool SetSamplerState(std::string name, ID3D11SamplerState* samplerState);
 
+	bool SetShaderResourceView(SimpleSRVHandle handle, ID3D11ShaderResourceView* srv);
+	bool SetShaderResourceViewArray(SimpleSRVHandle handle, ID3D11ShaderResourceView*const* srvs, unsigned int srvCount);
+	bool SetSamplerState(SimpleSamplerHandle handle, ID3D11SamplerState* samplerState);
+
 protected:
 	ID3D11PixelShader* shader;
 	bool CreateShader(ID3DBlob* shaderBlob);
@@ -53,6 +53,17 @@ DirectX::XMFLOAT4X4 CameraComponent::getViewMatrix() const
 	return m_viewMatrix;
 }
 
+Frustum CameraComponent::getFrustum() const
+{
+	XMFLOAT4X4 proj = Window::getProjectionMatrix();
+	XMMATRIX viewProjectionMatrix = XMMatrixMultiply(XMLoadFloat4x4(&m_viewMatrix), XMLoadFloat4x4(&proj));
+
+	XMFLOAT4X4 viewProjection;
+	XMStoreFloat4x4(&viewProjection, viewProjectionMatrix);
+
+	return Frustum::fromViewProjection(viewProjection);
+}
+
 DirectX::XMFLOAT3 CameraComponent::screenToWorld(DirectX::XMFLOAT2 screenPoint)
 {
 	XMFLOAT2 adjustedScreenPoint = XMFLOAT2(screenPoint.x, screenPoint.y);
@@ -1,5 +1,6 @@
 #pragma once
 #include "Component.h"
+#include "../Scene/Frustum.h"
 
 class CameraComponent : public Component
 {
@@ -12,6 +13,9 @@ public:
 
 	DirectX::XMFLOAT4X4 getViewMatrix() const;
 
+	// The world space volume the camera can see, e.g. for Scene::getEntitiesInFrustum.
+	Frustum getFrustum() const;
+
 	DirectX::XMFLOAT3 screenToWorld(DirectX::XMFLOAT2 screenPoint);
 	DirectX::XMFLOAT2 worldToScreen(DirectX::XMFLOAT3 worldPoint);
 	bool isVisible(DirectX::XMFLOAT3 worldPoint);
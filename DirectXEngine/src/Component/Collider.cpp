@@ -123,8 +123,8 @@ bool Collider::calculateMTV(Collider& other, XMFLOAT3& mtv) const
 
 	if (!transform || !otherTransform) return false;
 
-	std::vector<XMFLOAT3> mtvAxes;
-	std::vector<float> mtvOverlaps;
+	FrameVector<XMFLOAT3> mtvAxes;
+	FrameVector<float> mtvOverlaps;
 
 	XMFLOAT4X4 worldMatrixFloat4x4 = transform->getWorldMatrix();
 	XMMATRIX worldMatrix = XMLoadFloat4x4(&worldMatrixFloat4x4);
@@ -132,7 +132,7 @@ bool Collider::calculateMTV(Collider& other, XMFLOAT3& mtv) const
 	XMFLOAT4X4 otherWorldMatrixFloat4x4 = otherTransform->getWorldMatrix();
 	XMMATRIX otherWorldMatrix = XMLoadFloat4x4(&otherWorldMatrixFloat4x4);
 
-	std::vector<XMFLOAT3> axes = std::vector<XMFLOAT3>(m_faceNormals.size());
+	FrameVector<XMFLOAT3> axes = FrameVector<XMFLOAT3>(m_faceNormals.size());
 	for (unsigned int i = 0; i < m_faceNormals.size(); i++)
 	{
 		XMVECTOR faceNormal = XMLoadFloat3(&m_faceNormals[i]);
@@ -140,7 +140,7 @@ bool Collider::calculateMTV(Collider& other, XMFLOAT3& mtv) const
 		XMStoreFloat3(&axes[i], transformedFaceNormal);
 	}
 
-	std::vector<XMFLOAT3> otherAxes = std::vector<XMFLOAT3>(other.m_faceNormals.size());
+	FrameVector<XMFLOAT3> otherAxes = FrameVector<XMFLOAT3>(other.m_faceNormals.size());
 	for (unsigned int i = 0; i < other.m_faceNormals.size(); i++)
 	{
 		XMVECTOR faceNormal = XMLoadFloat3(&other.m_faceNormals[i]);
@@ -148,6 +148,11 @@ bool Collider::calculateMTV(Collider& other, XMFLOAT3& mtv) const
 		XMStoreFloat3(&otherAxes[i], transformedFaceNormal);
 	}
 
+	// Frame allocations can't be given back, so reserve room for every candidate axis up front instead of growing
+	size_t maxAxisCount = axes.size() + otherAxes.size() + axes.size() * otherAxes.size();
+	mtvAxes.reserve(maxAxisCount);
+	mtvOverlaps.reserve(maxAxisCount);
+
 	// Check all axes from first collider
 	for (unsigned int i = 0; i < axes.size(); i++)
 	{
@@ -3,6 +3,8 @@
 
 #include "Transform.h"
 
+#include "../Memory/FrameAllocator.h"
+
 #include <DirectXMath.h>
 #include <vector>
 
@@ -1,10 +1,14 @@
 #include "Component.h"
 
 #include "ComponentRegistry.h"
+#include "../Scene/Scene.h"
 
-Component::Component(Entity& entity) : entity(entity), enabled(true)
+Component::Component(Entity& entity) : entity(entity), m_enabled(true), m_updateListBucket(-1), m_updateListIndex(-1)
 {
 	typeName = "";
+
+	m_tickInterval = TickInterval::everyFrame();
+	m_hasTickInterval = false;
 }
 
 Component::~Component()
@@ -132,7 +136,7 @@ void Component::init()
 
 void Component::initDebugVariables()
 {
-	debugAddBool("Enabled", &enabled);
+	debugAddBool("Enabled", &m_enabled, nullptr, &debugComponentSetEnabled);
 }
 
 void Component::update(float deltaTime, float totalTime)
@@ -148,14 +152,14 @@ void Component::loadFromJSON(rapidjson::Value& dataObject)
 	rapidjson::Value::MemberIterator componentEnabled = dataObject.FindMember("enabled");
 	if (componentEnabled != dataObject.MemberEnd())
 	{
-		enabled = componentEnabled->value.GetBool();
+		setEnabled(componentEnabled->value.GetBool());
 	}
 }
 
 void Component::saveToJSON(rapidjson::PrettyWriter<rapidjson::StringBuffer>& writer)
 {
 	writer.Key("enabled");
-	writer.Bool(enabled);
+	writer.Bool(m_enabled);
 }
 
 void Component::onSceneLoaded()
@@ -167,7 +171,7 @@ Entity& Component::getEntity() const
 	return entity;
 }
 
-std::string Component::getName() const
+const std::string& Component::getName() const
 {
 	return typeName;
 }
@@ -176,3 +180,48 @@ std::vector<DebugComponentData>& Component::getDebugComponentData()
 {
 	return d_debugComponentData;
 }
+
+bool Component::getEnabled() const
+{
+	return m_enabled;
+}
+
+void Component::setEnabled(bool enabled)
+{
+	if (m_enabled == enabled) return;
+
+	m_enabled = enabled;
+	entity.getScene().onComponentEnabledChanged(this);
+}
+
+void Component::setTickInterval(TickInterval interval)
+{
+	m_tickInterval = interval;
+	m_hasTickInterval = true;
+	entity.getScene().onComponentTickIntervalChanged(this);
+}
+
+void Component::clearTickInterval()
+{
+	if (!m_hasTickInterval) return;
+
+	m_tickInterval = TickInterval::everyFrame();
+	m_hasTickInterval = false;
+	entity.getScene().onComponentTickIntervalChanged(this);
+}
+
+bool Component::hasTickInterval() const
+{
+	return m_hasTickInterval;
+}
+
+TickInterval Component::getTickInterval() const
+{
+	return m_tickInterval;
+}
+
+void debugComponentSetEnabled(Component* component, const void* value)
+{
+	bool enabled = *static_cast<const bool*>(value);
+	component->setEnabled(enabled);
+}
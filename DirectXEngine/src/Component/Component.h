@@ -8,6 +8,7 @@
 #include "rapidjson/prettywriter.h"
 
 #include "../Util.h"
+#include "../Scene/TickSettings.h"
 
 #include <Windows.h>
 #include <DirectXMath.h>
@@ -16,6 +17,8 @@ class Component
 {
 public:
 	friend class Entity;
+	friend class TypePools;
+	friend class IComponentUpdateList;
 
 	virtual void init();
 	virtual void initDebugVariables();
@@ -26,11 +29,18 @@ public:
 	virtual void onSceneLoaded();
 
 	Entity& getEntity() const;
-	std::string getName() const;
+	const std::string& getName() const;
 
 	std::vector<DebugComponentData>& getDebugComponentData();
 
-	bool enabled;
+	bool getEnabled() const;
+	void setEnabled(bool enabled);
+
+	// Overrides how often this component ticks, instead of using the interval declared for its type.
+	void setTickInterval(TickInterval interval);
+	void clearTickInterval();
+	bool hasTickInterval() const;
+	TickInterval getTickInterval() const;
 	
 protected:
 	Component(Entity& entity);
@@ -62,5 +72,17 @@ protected:
 	void debugAddFont(std::string label, Font** data, DebugGetterFunc getterFunc = nullptr, DebugSetterFunc setterFunc = nullptr);
 
 private:
+	bool m_enabled;
+
+	// Which bucket of the scene's update list for this component's type it's in and its slot in that bucket,
+	// or -1 if it isn't being ticked.
+	int m_updateListBucket;
+	int m_updateListIndex;
+
+	TickInterval m_tickInterval;
+	bool m_hasTickInterval;
+
 	std::vector<DebugComponentData> d_debugComponentData;
-};
\ No newline at end of file
+};
+
+void debugComponentSetEnabled(Component* component, const void* value);
\ No newline at end of file
@@ -2,6 +2,10 @@
 
 std::unordered_map<std::string, ComponentRegistry::CreateComponentFunc> ComponentRegistry::m_componentRegistry = std::unordered_map<std::string, CreateComponentFunc>();
 std::unordered_map<std::type_index, std::string> ComponentRegistry::m_componentRegistryReverse = std::unordered_map<std::type_index, std::string>();
+std::unordered_map<std::type_index, ComponentRegistry::CreateUpdateListFunc> ComponentRegistry::m_updateListRegistry = std::unordered_map<std::type_index, CreateUpdateListFunc>();
+std::unordered_map<std::type_index, SystemAccess> ComponentRegistry::m_systemAccessRegistry = std::unordered_map<std::type_index, SystemAccess>();
+std::unordered_map<std::type_index, std::pair<TickGroup, TickInterval>> ComponentRegistry::m_tickSettingsRegistry = std::unordered_map<std::type_index, std::pair<TickGroup, TickInterval>>();
+std::unordered_map<std::string, ComponentRegistry::GetPoolFunc> ComponentRegistry::m_componentPoolRegistry = std::unordered_map<std::string, GetPoolFunc>();
 
 Component* ComponentRegistry::addComponentToEntity(Entity& entity, std::string componentType, bool initialize)
 {
@@ -47,6 +51,47 @@ const std::vector<std::string> ComponentRegistry::getAllTypeNames()
 	return typeNames;
 }
 
+IComponentUpdateList* ComponentRegistry::createUpdateList(std::type_index type)
+{
+	auto it = m_updateListRegistry.find(type);
+	if (it == m_updateListRegistry.end())
+	{
+		return nullptr;
+	}
+
+	IComponentUpdateList* updateList = it->second();
+
+	// Types without declared access keep the default exclusive access and run on their own
+	auto accessIt = m_systemAccessRegistry.find(type);
+	if (accessIt != m_systemAccessRegistry.end())
+	{
+		updateList->setAccess(accessIt->second);
+	}
+
+	// Types without declared tick settings update before physics every frame
+	auto tickIt = m_tickSettingsRegistry.find(type);
+	if (tickIt != m_tickSettingsRegistry.end())
+	{
+		updateList->setTickSettings(tickIt->second.first, tickIt->second.second);
+	}
+
+	return updateList;
+}
+
+bool ComponentRegistry::reserveComponents(std::string_view componentType, unsigned int count)
+{
+	auto it = m_componentPoolRegistry.find(Util::lookupKey(componentType));
+	if (it == m_componentPoolRegistry.end())
+	{
+		Debug::warning("Failed to reserve components of type " + std::string(componentType) + " because the component was not found in the registry.");
+		return false;
+	}
+
+	PoolAllocator& pool = it->second();
+	pool.reserve(pool.getAllocatedCount() + count);
+	return true;
+}
+
 void ComponentRegistry::registerEngineComponents()
 {
 	// Engine components
@@ -64,9 +109,27 @@ void ComponentRegistry::registerEngineComponents()
 	registerComponent<Rigidbody>("Rigidbody");
 	registerComponent<Softbody>("Softbody");
 	registerComponent<Transform>("Transform");
+
+	// Declare what each ticking engine component touches so non-conflicting ones can run at the same time.
+	// Transforms are brought up to date before each scheduled phase and after each system that writes them, so reading one never recalculates it.
+	// Lights read the main camera's transform as well as their own. Debug sprites flip their own entity's selection from their icon's GUI transform.
+	// GUIButtonComponent is left undeclared since its click callbacks can do anything, so it runs exclusively.
+	declareAccess<CameraComponent>({ typeid(Transform) }, {});
+	declareAccess<FreeCamControls>({}, { typeid(Transform) });
+	declareAccess<GUIDebugSpriteComponent>({ typeid(GUITransform) }, {});
+	declareAccess<LightComponent>({ typeid(Transform) }, {});
+	declareAccess<Rigidbody>({ typeid(Transform) }, {});
+	declareAccess<Softbody>({}, {});
+
+	// GUI reacts to the final state of the frame, so it ticks just before rendering. Everything else updates before physics.
+	declareTick<GUIButtonComponent>(TICKGROUP_PRE_RENDER);
+	declareTick<GUIDebugSpriteComponent>(TICKGROUP_PRE_RENDER);
 }
 
 void ComponentRegistry::registerCustomComponents()
 {
 	// REGISTER ALL COMPONENTS HERE (keep in alphabetical order for neatness)
+	// Components that override update or lateUpdate should also declare their access with declareAccess<T>(reads, writes),
+	// otherwise they're run on their own. Components that don't need to tick before physics every frame can
+	// declare when and how often they do with declareTick<T>(group, interval).
 }
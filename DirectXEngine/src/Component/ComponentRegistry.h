@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <string_view>
 #include <unordered_map>
 #include <typeindex>
 
@@ -20,6 +21,9 @@
 #include "Softbody.h"
 #include "Transform.h"
 
+#include "../Memory/PoolAllocator.h"
+#include "../Scene/ComponentUpdateList.h"
+
 class Component;
 class Entity;
 
@@ -32,17 +36,37 @@ public:
 	static std::string getTypeName(std::type_index type);
 	static const std::vector<std::string> getAllTypeNames();
 
+	// Creates an update list for the given component type, or returns nullptr if the type doesn't override update or lateUpdate.
+	static IComponentUpdateList* createUpdateList(std::type_index type);
+
+	// Makes room in the given component type's pool for count more components, so spawning that many won't allocate.
+	static bool reserveComponents(std::string_view componentType, unsigned int count);
+
 private:
 	typedef Component*(Entity::*CreateComponentFunc)(bool);
+	typedef IComponentUpdateList*(*CreateUpdateListFunc)();
+	typedef PoolAllocator&(*GetPoolFunc)();
 
 	template<typename T>
 	bool registerComponent(std::string componentType);
 
+	// Declares which other component types T's update and lateUpdate read and write. T itself is always written.
+	template<typename T>
+	void declareAccess(std::vector<std::type_index> reads, std::vector<std::type_index> writes);
+
+	// Declares which group T's update runs in and how often its components tick unless they override it.
+	template<typename T>
+	void declareTick(TickGroup group, TickInterval interval = TickInterval::everyFrame());
+
 	void registerEngineComponents();
 	void registerCustomComponents();
 
 	static std::unordered_map<std::string, CreateComponentFunc> m_componentRegistry;
 	static std::unordered_map<std::type_index, std::string> m_componentRegistryReverse;
+	static std::unordered_map<std::type_index, CreateUpdateListFunc> m_updateListRegistry;
+	static std::unordered_map<std::type_index, SystemAccess> m_systemAccessRegistry;
+	static std::unordered_map<std::type_index, std::pair<TickGroup, TickInterval>> m_tickSettingsRegistry;
+	static std::unordered_map<std::string, GetPoolFunc> m_componentPoolRegistry;
 };
 
 template<typename T>
@@ -56,6 +80,15 @@ inline bool ComponentRegistry::registerComponent(std::string componentType)
 		m_componentRegistry[componentType] = func;
 
 		m_componentRegistryReverse[typeid(T)] = componentType;
+
+		// Components are allocated from a pool per type. The pool is looked up when it's needed rather than kept,
+		// since pools are deleted on shutdown
+		m_componentPoolRegistry[componentType] = &TypePools::get<T>;
+
+		// Only types that actually do per-frame work get an update list
+		if (ComponentUpdateTraits<T>::hasUpdate || ComponentUpdateTraits<T>::hasLateUpdate)
+			m_updateListRegistry[typeid(T)] = &ComponentUpdateList<T>::create;
+
 		return true;
 	}
 	else
@@ -64,3 +97,25 @@ inline bool ComponentRegistry::registerComponent(std::string componentType)
 		return false;
 	}
 }
+
+template<typename T>
+inline void ComponentRegistry::declareAccess(std::vector<std::type_index> reads, std::vector<std::type_index> writes)
+{
+	static_assert(std::is_base_of<Component, T>::value, "Given type is not a Component.");
+
+	SystemAccess access;
+	access.exclusive = false;
+	access.reads = reads;
+	access.writes = writes;
+	access.writes.push_back(typeid(T));
+
+	m_systemAccessRegistry[typeid(T)] = access;
+}
+
+template<typename T>
+inline void ComponentRegistry::declareTick(TickGroup group, TickInterval interval)
+{
+	static_assert(std::is_base_of<Component, T>::value, "Given type is not a Component.");
+
+	m_tickSettingsRegistry[typeid(T)] = std::make_pair(group, interval);
+}
\ No newline at end of file
@@ -10,7 +10,6 @@ using namespace DirectX;
 
 LightComponent::LightComponent(Entity& entity) : Component(entity)
 {
-	m_shadowMap = nullptr;
 	m_shadowMapSize = 0;
 
 	XMStoreFloat4x4(&m_viewMatrix, XMMatrixIdentity());
@@ -30,11 +29,6 @@ LightComponent::~LightComponent()
 		if (entity.hasTag(TAG_LIGHT))
 			entity.removeTag(TAG_LIGHT);
 	}
-
-	if (m_shadowMap)
-	{
-		deleteShadowMap();
-	}
 }
 
 void LightComponent::init()
@@ -275,11 +269,6 @@ void LightComponent::useDefaultSettings()
 	setSettingsDefault();
 }
 
-Texture* LightComponent::getShadowMap() const
-{
-	return m_shadowMap;
-}
-
 DirectX::XMFLOAT4X4 LightComponent::getViewMatrix() const
 {
 	return m_viewMatrix;
@@ -304,9 +293,6 @@ void LightComponent::setShadowMapSize(unsigned int powOfTwo)
 	}
 
 	m_shadowMapSize = powOfTwo;
-
-	if(m_castShadows)
-		createShadowMap();
 }
 
 bool LightComponent::canCastShadows() const
@@ -323,14 +309,6 @@ void LightComponent::canCastShadows(bool castShadows)
 	}
 
 	m_castShadows = castShadows;
-
-	if (m_castShadows)
-	{
-		if (!createShadowMap())
-			m_castShadows = !m_castShadows;
-	}
-	else
-		deleteShadowMap();
 }
 
 ShadowType LightComponent::getShadowType() const
@@ -356,36 +334,6 @@ void LightComponent::setSettingsDefault()
 	setLightSettings(settings);
 }
 
-bool LightComponent::createShadowMap()
-{
-	deleteShadowMap(); // In case there is already a shadow map
-
-	TextureParameters parameters = {};
-	parameters.usage = D3D11_USAGE_DEFAULT;
-	parameters.bindFlags = D3D11_BIND_SHADER_RESOURCE | D3D11_BIND_DEPTH_STENCIL;
-	parameters.textureFormat = DXGI_FORMAT_R32_TYPELESS;
-	parameters.shaderResourceViewFormat = DXGI_FORMAT_R32_FLOAT;
-	parameters.depthStencilViewFormat = DXGI_FORMAT_D32_FLOAT;
-	m_shadowMap = AssetManager::createAsset<Texture>(" tex_" + entity.getName() + "_shadowMap", m_shadowMapSize, m_shadowMapSize, parameters);
-
-	if (!m_shadowMap)
-	{
-		Debug::error("Failed to create shadow map for light entity " + entity.getName() + ".");
-		return false;
-	}
-
-	return true;
-}
-
-void LightComponent::deleteShadowMap()
-{
-	if (m_shadowMap)
-	{
-		AssetManager::unloadAsset<Texture>(m_shadowMap);
-		m_shadowMap = nullptr;
-	}	
-}
-
 void LightComponent::updateViewMatrix()
 {
 	Transform* transform = entity.getComponent<Transform>();
@@ -1,28 +1,7 @@
 #pragma once
 #include "Component.h"
 
-enum LightType
-{
-	POINT_LIGHT,
-	DIRECTIONAL_LIGHT,
-	SPOT_LIGHT
-};
-
-enum ShadowType
-{
-	SHADOWTYPE_HARD = 0,
-	SHADOWTYPE_SOFT = 2,
-	SHADOWTYPE_VERY_SOFT = 4
-};
-
-struct LightSettings
-{
-	DirectX::XMFLOAT4 color;
-	float brightness;
-	float specularity;
-	float radius;
-	float spotAngle;
-};
+#include "../Render/RenderTypes.h"
 
 class LightComponent : public Component
 {
@@ -47,10 +26,11 @@ public:
 	// Sets the light's settings back to default.
 	void useDefaultSettings();
 
-	Texture* getShadowMap() const;
 	DirectX::XMFLOAT4X4 getViewMatrix() const;
 	DirectX::XMFLOAT4X4 getProjectionMatrix() const;
 
+	// The largest tile the light is given in the shadow atlas. Lights covering less of the screen get smaller ones.
+	// A size of 0 uses the atlas's default.
 	unsigned int getShadowMapSize() const;
 	void setShadowMapSize(unsigned int powOfTwo);
 
@@ -62,8 +42,6 @@ public:
 
 private:
 	void setSettingsDefault();
-	bool createShadowMap();
-	void deleteShadowMap();
 	void updateViewMatrix();
 	void updateProjectionMatrix(float nearZ, float farZ, float width = 100.0f, float height = 100.0f);
 
@@ -71,7 +49,6 @@ private:
 	LightType m_lightType;
 	ShadowType m_shadowType;
 
-	Texture* m_shadowMap;
 	DirectX::XMFLOAT4X4 m_viewMatrix;
 	DirectX::XMFLOAT4X4 m_projectionMatrix;
 	bool m_castShadows;
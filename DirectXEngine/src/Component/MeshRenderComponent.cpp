@@ -1,5 +1,7 @@
 #include "MeshRenderComponent.h"
 
+#include "../Scene/Scene.h"
+
 MeshRenderComponent::MeshRenderComponent(Entity& entity) : RenderComponent(entity)
 {
 	castShadows = true;
@@ -71,4 +73,9 @@ Mesh* MeshRenderComponent::getMesh() const
 void MeshRenderComponent::setMesh(Mesh* mesh)
 {
 	m_mesh = mesh;
+
+	// The entity's bounds in the scene's spatial index come from its mesh, so they need refreshing
+	Transform* transform = entity.getComponent<Transform>();
+	if (transform)
+		entity.getScene().getTransformHierarchy().markMoved(transform);
 }
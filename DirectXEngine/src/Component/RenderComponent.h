@@ -1,12 +1,7 @@
 #pragma once
 #include "Component.h"
 
-enum RenderStyle
-{
-	SOLID,
-	WIREFRAME,
-	SOLID_WIREFRAME
-};
+#include "../Render/RenderTypes.h"
 
 class RenderComponent : public Component
 {
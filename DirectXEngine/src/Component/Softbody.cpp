@@ -4,6 +4,7 @@
 #include "MeshRenderComponent.h"
 
 #include "../Input.h"
+#include "../Scene/Scene.h"
 
 using namespace DirectX;
 
@@ -383,6 +384,11 @@ void Softbody::updateVisual()
 	}
 
 	m_mesh->updateVertices();
+
+	// The entity's bounds in the scene's spatial index come from its mesh, which just changed shape
+	Transform* transform = entity.getComponent<Transform>();
+	if (transform)
+		entity.getScene().getTransformHierarchy().markMoved(transform);
 }
 
 void Softbody::applyForce(DirectX::XMFLOAT3 force, BodyData* body)
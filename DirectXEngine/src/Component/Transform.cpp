@@ -1,20 +1,35 @@
 #include "Transform.h"
 
+#include "../Scene/Scene.h"
+
 using namespace DirectX;
 
 Transform::Transform(Entity& entity) : Component(entity)
 {
 	m_localPosition = XMFLOAT3();
-	m_localRotation = XMFLOAT3();
+	m_localRotation = XMFLOAT4(0.0f, 0.0f, 0.0f, 1.0f);
 	m_localScale = XMFLOAT3(1.0f, 1.0f, 1.0f);
 
+	m_localEulerAngles = XMFLOAT3();
+
 	XMStoreFloat4x4(&m_worldMatrix, XMMatrixIdentity());
 	XMStoreFloat4x4(&m_inverseWorldMatrix, XMMatrixIdentity());
-	m_isDirty = false;
+
+	m_right = XMFLOAT3(1.0f, 0.0f, 0.0f);
+	m_up = XMFLOAT3(0.0f, 1.0f, 0.0f);
+	m_forward = XMFLOAT3(0.0f, 0.0f, 1.0f);
+	m_isDirty = true;
+
+	m_hierarchySlot = -1;
+	m_hierarchyIndex = -1;
+	m_hasMoved = false;
+	entity.getScene().getTransformHierarchy().addTransform(this);
 }
 
 Transform::~Transform()
 {
+	entity.getScene().getTransformHierarchy().removeTransform(this);
+
 #if defined(DEBUG) || defined(_DEBUG)
 	entity.disableDebugIcon();
 #endif
@@ -34,7 +49,7 @@ void Transform::initDebugVariables()
 	Component::initDebugVariables();
 
 	debugAddVec3("Position", &m_localPosition, nullptr, &debugTransformSetLocalPosition);
-	debugAddVec3("Rotation", &m_localRotation, &debugTransformGetLocalRotation, &debugTransformSetLocalRotation);
+	debugAddVec3("Rotation", &m_localEulerAngles, &debugTransformGetLocalRotation, &debugTransformSetLocalRotation);
 	debugAddVec3("Scale", &m_localScale, nullptr, &debugTransformSetLocalScale);
 }
 
@@ -84,13 +99,13 @@ void Transform::saveToJSON(rapidjson::PrettyWriter<rapidjson::StringBuffer>& wri
 	writer.StartObject();
 
 	writer.Key("x");
-	writer.Double(XMConvertToDegrees(m_localRotation.x));
+	writer.Double(XMConvertToDegrees(m_localEulerAngles.x));
 
 	writer.Key("y");
-	writer.Double(XMConvertToDegrees(m_localRotation.y));
+	writer.Double(XMConvertToDegrees(m_localEulerAngles.y));
 
 	writer.Key("z");
-	writer.Double(XMConvertToDegrees(m_localRotation.z));
+	writer.Double(XMConvertToDegrees(m_localEulerAngles.z));
 
 	writer.EndObject();
 
@@ -111,20 +126,10 @@ void Transform::saveToJSON(rapidjson::PrettyWriter<rapidjson::StringBuffer>& wri
 
 DirectX::XMFLOAT3 Transform::getPosition()
 {
-	XMMATRIX worldMatrix = XMLoadFloat4x4(&m_worldMatrix);
-
-	if (m_isDirty)
-	{
-		worldMatrix = calcWorldMatrix();
-		m_isDirty = false;
-	}
-
-	XMVECTOR worldPositionVec = XMVector3Transform(XMVectorSet(0, 0, 0, 1), worldMatrix);
-
-	XMFLOAT3 worldPosition;
-	XMStoreFloat3(&worldPosition, worldPositionVec);
+	updateWorldMatrix();
 
-	return worldPosition;
+	// The translation row of the world matrix is the world position
+	return XMFLOAT3(m_worldMatrix._41, m_worldMatrix._42, m_worldMatrix._43);
 }
 
 XMFLOAT3 Transform::getLocalPosition() const
@@ -133,6 +138,11 @@ XMFLOAT3 Transform::getLocalPosition() const
 }
 
 XMFLOAT3 Transform::getLocalRotation() const
+{
+	return m_localEulerAngles;
+}
+
+XMFLOAT4 Transform::getLocalRotationQuaternion() const
 {
 	return m_localRotation;
 }
@@ -150,13 +160,33 @@ void Transform::setLocalPosition(DirectX::XMFLOAT3 position)
 
 void Transform::setLocalRotation(DirectX::XMFLOAT3 rotationDegrees)
 {
-	m_localRotation = XMFLOAT3(XMConvertToRadians(rotationDegrees.x), XMConvertToRadians(rotationDegrees.y), XMConvertToRadians(rotationDegrees.z));
-	setDirty();
+	m_localEulerAngles = XMFLOAT3(XMConvertToRadians(rotationDegrees.x), XMConvertToRadians(rotationDegrees.y), XMConvertToRadians(rotationDegrees.z));
+	setRotationFromEulerAngles();
 }
 
 void Transform::setLocalRotationRadians(DirectX::XMFLOAT3 rotationRadians)
 {
-	m_localRotation = rotationRadians;
+	m_localEulerAngles = rotationRadians;
+	setRotationFromEulerAngles();
+}
+
+void Transform::setLocalRotationQuaternion(DirectX::XMFLOAT4 rotation)
+{
+	XMVECTOR rotationVec = XMQuaternionNormalize(XMLoadFloat4(&rotation));
+	XMStoreFloat4(&m_localRotation, rotationVec);
+
+	// Recover the Euler angles from the rotation matrix, which is roll (z), then pitch (x), then yaw (y)
+	XMFLOAT4X4 rotationMatrix;
+	XMStoreFloat4x4(&rotationMatrix, XMMatrixRotationQuaternion(rotationVec));
+
+	float sinPitch = -rotationMatrix._32;
+	if (sinPitch > 1.0f) sinPitch = 1.0f;
+	if (sinPitch < -1.0f) sinPitch = -1.0f;
+
+	m_localEulerAngles.x = asinf(sinPitch);
+	m_localEulerAngles.y = atan2f(rotationMatrix._31, rotationMatrix._33);
+	m_localEulerAngles.z = atan2f(rotationMatrix._12, rotationMatrix._22);
+
 	setDirty();
 }
 
@@ -168,85 +198,32 @@ void Transform::setLocalScale(DirectX::XMFLOAT3 scale)
 
 const XMFLOAT3 Transform::getRight()
 {
-	if (m_isDirty)
-	{
-		calcWorldMatrix();
-		m_isDirty = false;
-	}
-
-	XMMATRIX rotationMatrix = XMMatrixSet(
-		m_worldMatrix.m[0][0] / m_localScale.x, m_worldMatrix.m[0][1], m_worldMatrix.m[0][2], 0,
-		m_worldMatrix.m[1][0], m_worldMatrix.m[1][1] / m_localScale.y, m_worldMatrix.m[1][2], 0,
-		m_worldMatrix.m[2][0], m_worldMatrix.m[2][1], m_worldMatrix.m[2][2] / m_localScale.z, 0,
-		0, 0, 0, 1);
-
-	XMVECTOR v = XMVector3Transform(XMVectorSet(1.0f, 0.0f, 0.0f, 0.0f), rotationMatrix);
-
-	XMFLOAT3 right;
-	XMStoreFloat3(&right, v);
-	return right;
+	updateWorldMatrix();
+	return m_right;
 }
 
 const XMFLOAT3 Transform::getUp()
 {
-	if (m_isDirty)
-	{
-		calcWorldMatrix();
-		m_isDirty = false;
-	}
-
-	XMMATRIX rotationMatrix = XMMatrixSet(
-		m_worldMatrix.m[0][0] / m_localScale.x, m_worldMatrix.m[0][1], m_worldMatrix.m[0][2], 0,
-		m_worldMatrix.m[1][0], m_worldMatrix.m[1][1] / m_localScale.y, m_worldMatrix.m[1][2], 0,
-		m_worldMatrix.m[2][0], m_worldMatrix.m[2][1], m_worldMatrix.m[2][2] / m_localScale.z, 0,
-		0, 0, 0, 1);
-
-	XMVECTOR v = XMVector3Transform(XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f), rotationMatrix);
-
-	XMFLOAT3 up;
-	XMStoreFloat3(&up, v);
-	return up;
+	updateWorldMatrix();
+	return m_up;
 }
 
 const XMFLOAT3 Transform::getForward()
 {
-	if (m_isDirty)
-	{
-		calcWorldMatrix();
-		m_isDirty = false;
-	}
-
-	XMMATRIX rotationMatrix = XMMatrixSet(
-		m_worldMatrix.m[0][0] / m_localScale.x, m_worldMatrix.m[0][1], m_worldMatrix.m[0][2], 0,
-		m_worldMatrix.m[1][0], m_worldMatrix.m[1][1] / m_localScale.y, m_worldMatrix.m[1][2], 0,
-		m_worldMatrix.m[2][0], m_worldMatrix.m[2][1], m_worldMatrix.m[2][2] / m_localScale.z, 0,
-		0, 0, 0, 1);
-
-	XMVECTOR v = XMVector3Transform(XMVectorSet(0.0f, 0.0f, 1.0f, 0.0f), rotationMatrix);
-
-	XMFLOAT3 forward;
-	XMStoreFloat3(&forward, v);
-	return forward;
+	updateWorldMatrix();
+	return m_forward;
 }
 
 const XMFLOAT4X4 Transform::getWorldMatrix()
 {
-	if (m_isDirty)
-	{
-		calcWorldMatrix();
-		m_isDirty = false;
-	}
+	updateWorldMatrix();
 	
 	return m_worldMatrix;
 }
 
 const XMFLOAT4X4 Transform::getInverseWorldMatrix()
 {
-	if (m_isDirty)
-	{
-		calcWorldMatrix();
-		m_isDirty = false;
-	}
+	updateWorldMatrix();
 
 	return m_inverseWorldMatrix;
 }
@@ -259,7 +236,7 @@ void Transform::move(XMFLOAT3 delta)
 
 	setDirty();
 
-	std::vector<Entity*> children = entity.getChildren();
+	const std::vector<Entity*>& children = entity.getChildren();
 	for (unsigned int i = 0; i < children.size(); i++)
 	{
 		Transform* childTransform = children[i]->getComponent<Transform>();
@@ -278,7 +255,7 @@ void Transform::moveX(float delta)
 
 	setDirty();
 
-	std::vector<Entity*> children = entity.getChildren();
+	const std::vector<Entity*>& children = entity.getChildren();
 	for (unsigned int i = 0; i < children.size(); i++)
 	{
 		Transform* childTransform = children[i]->getComponent<Transform>();
@@ -297,7 +274,7 @@ void Transform::moveY(float delta)
 
 	setDirty();
 
-	std::vector<Entity*> children = entity.getChildren();
+	const std::vector<Entity*>& children = entity.getChildren();
 	for (unsigned int i = 0; i < children.size(); i++)
 	{
 		Transform* childTransform = children[i]->getComponent<Transform>();
@@ -316,7 +293,7 @@ void Transform::moveZ(float delta)
 
 	setDirty();
 
-	std::vector<Entity*> children = entity.getChildren();
+	const std::vector<Entity*>& children = entity.getChildren();
 	for (unsigned int i = 0; i < children.size(); i++)
 	{
 		Transform* childTransform = children[i]->getComponent<Transform>();
@@ -343,7 +320,7 @@ void Transform::moveLocal(DirectX::XMFLOAT3 delta)
 
 	setDirty();
 
-	std::vector<Entity*> children = entity.getChildren();
+	const std::vector<Entity*>& children = entity.getChildren();
 	for (unsigned int i = 0; i < children.size(); i++)
 	{
 		Transform* childTransform = children[i]->getComponent<Transform>();
@@ -365,7 +342,7 @@ void Transform::moveLocalX(float delta)
 
 	setDirty();
 
-	std::vector<Entity*> children = entity.getChildren();
+	const std::vector<Entity*>& children = entity.getChildren();
 	for (unsigned int i = 0; i < children.size(); i++)
 	{
 		Transform* childTransform = children[i]->getComponent<Transform>();
@@ -387,7 +364,7 @@ void Transform::moveLocalY(float delta)
 
 	setDirty();
 
-	std::vector<Entity*> children = entity.getChildren();
+	const std::vector<Entity*>& children = entity.getChildren();
 	for (unsigned int i = 0; i < children.size(); i++)
 	{
 		Transform* childTransform = children[i]->getComponent<Transform>();
@@ -409,7 +386,7 @@ void Transform::moveLocalZ(float delta)
 
 	setDirty();
 
-	std::vector<Entity*> children = entity.getChildren();
+	const std::vector<Entity*>& children = entity.getChildren();
 	for (unsigned int i = 0; i < children.size(); i++)
 	{
 		Transform* childTransform = children[i]->getComponent<Transform>();
@@ -446,42 +423,39 @@ void Transform::rotateLocalZ(float degrees)
 
 void Transform::rotateLocalRadians(DirectX::XMFLOAT3 rotRadians)
 {
-	XMVECTOR rotation = XMLoadFloat3(&m_localRotation);
+	XMVECTOR rotation = XMLoadFloat3(&m_localEulerAngles);
 	XMVECTOR rotVector = XMLoadFloat3(&rotRadians);
 	rotation = XMVectorAdd(rotation, rotVector);
-	XMStoreFloat3(&m_localRotation, rotation);
+	XMStoreFloat3(&m_localEulerAngles, rotation);
 
-	setDirty();
+	setRotationFromEulerAngles();
 }
 
 void Transform::rotateLocalXRadians(float radians)
 {
-	XMVECTOR rotation = XMLoadFloat3(&m_localRotation);
-	XMVECTOR angleVector = XMVectorSet(radians, 0.0f, 0.0f, 0.0f);
-	rotation = XMVectorAdd(rotation, angleVector);
-	XMStoreFloat3(&m_localRotation, rotation);
-
-	setDirty();
+	m_localEulerAngles.x += radians;
+	setRotationFromEulerAngles();
 }
 
 void Transform::rotateLocalYRadians(float radians)
 {
-	XMVECTOR rotation = XMLoadFloat3(&m_localRotation);
-	XMVECTOR angleVector = XMVectorSet(0.0f, radians, 0.0f, 0.0f);
-	rotation = XMVectorAdd(rotation, angleVector);
-	XMStoreFloat3(&m_localRotation, rotation);
-
-	setDirty();
+	m_localEulerAngles.y += radians;
+	setRotationFromEulerAngles();
 }
 
 void Transform::rotateLocalZRadians(float radians)
 {
-	XMVECTOR rotation = XMLoadFloat3(&m_localRotation);
-	XMVECTOR angleVector = XMVectorSet(0.0f, 0.0f, radians, 0.0f);
-	rotation = XMVectorAdd(rotation, angleVector);
-	XMStoreFloat3(&m_localRotation, rotation);
+	m_localEulerAngles.z += radians;
+	setRotationFromEulerAngles();
+}
 
-	setDirty();
+void Transform::rotateLocalQuaternion(DirectX::XMFLOAT4 rotation)
+{
+	// The given rotation is applied first, in this transform's local space
+	XMFLOAT4 newRotation;
+	XMStoreFloat4(&newRotation, XMQuaternionMultiply(XMLoadFloat4(&rotation), XMLoadFloat4(&m_localRotation)));
+
+	setLocalRotationQuaternion(newRotation);
 }
 
 void Transform::scale(DirectX::XMFLOAT3 delta)
@@ -520,50 +494,72 @@ void Transform::scaleZ(float delta)
 	setDirty();
 }
 
-XMMATRIX Transform::calcWorldMatrix()
+void Transform::updateWorldMatrix()
+{
+	entity.getScene().getTransformHierarchy().updateTransform(this);
+}
+
+void Transform::calcWorldMatrix(const Transform* parent)
+{
+	XMFLOAT4X4 localMatrix;
+	XMFLOAT4X4 localInverseMatrix;
+	calcLocalMatrices(localMatrix, localInverseMatrix);
+
+	setWorldMatrices(localMatrix, localInverseMatrix, parent);
+}
+
+void Transform::calcLocalMatrices(XMFLOAT4X4& localMatrix, XMFLOAT4X4& localInverseMatrix) const
+{
+	XMVECTOR position = XMLoadFloat3(&m_localPosition);
+	XMVECTOR scale = XMLoadFloat3(&m_localScale);
+	XMMATRIX rotation = XMMatrixRotationQuaternion(XMLoadFloat4(&m_localRotation));
+
+	XMMATRIX local = XMMatrixMultiply(XMMatrixMultiply(XMMatrixScalingFromVector(scale), rotation), XMMatrixTranslationFromVector(position));
+
+	// The local matrix is scale * rotation * translation, so its inverse is the inverse translation, the transposed rotation
+	// and the reciprocal scale in the opposite order. Much cheaper than a general 4x4 inverse.
+	XMMATRIX localInverse = XMMatrixMultiply(XMMatrixMultiply(XMMatrixTranslationFromVector(XMVectorNegate(position)), XMMatrixTranspose(rotation)),
+		XMMatrixScalingFromVector(XMVectorReciprocal(scale)));
+
+	XMStoreFloat4x4(&localMatrix, local);
+	XMStoreFloat4x4(&localInverseMatrix, localInverse);
+}
+
+void Transform::setWorldMatrices(const XMFLOAT4X4& localMatrix, const XMFLOAT4X4& localInverseMatrix, const Transform* parent)
 {
-	XMMATRIX translation = XMMatrixTranslationFromVector(XMLoadFloat3(&m_localPosition));
-	XMMATRIX rotation = XMMatrixRotationRollPitchYawFromVector(XMLoadFloat3(&m_localRotation));
-	XMMATRIX scale = XMMatrixScalingFromVector(XMLoadFloat3(&m_localScale));
-	XMMATRIX world = XMMatrixMultiply(XMMatrixMultiply(scale, rotation), translation);
+	XMMATRIX world = XMLoadFloat4x4(&localMatrix);
+	XMMATRIX inverseWorld = XMLoadFloat4x4(&localInverseMatrix);
 
-	Entity* parent = entity.getParent();
+	// The hierarchy always brings the parent up to date first, so its cached matrices can be used as is.
+	// inverse(local * parent) = inverse(parent) * inverse(local)
 	if (parent)
 	{
-		Transform* parentTransform = parent->getComponent<Transform>();
-		if (parentTransform)
-		{
-			world = XMMatrixMultiply(world, parentTransform->calcWorldMatrix());
-			XMStoreFloat4x4(&m_worldMatrix, world);
-			XMStoreFloat4x4(&m_inverseWorldMatrix, XMMatrixInverse(nullptr, world));
-
-			return world;
-		}
+		world = XMMatrixMultiply(world, XMLoadFloat4x4(&parent->m_worldMatrix));
+		inverseWorld = XMMatrixMultiply(XMLoadFloat4x4(&parent->m_inverseWorldMatrix), inverseWorld);
 	}
 
 	XMStoreFloat4x4(&m_worldMatrix, world);
-	XMStoreFloat4x4(&m_inverseWorldMatrix, XMMatrixInverse(nullptr, world));
+	XMStoreFloat4x4(&m_inverseWorldMatrix, inverseWorld);
 
-	return world;
+	// The first three rows of the world matrix are the local axes in world space, scaled by the accumulated scale.
+	// Normalizing them gives the right basis vectors even when a parent is scaled non-uniformly.
+	XMStoreFloat3(&m_right, XMVector3Normalize(world.r[0]));
+	XMStoreFloat3(&m_up, XMVector3Normalize(world.r[1]));
+	XMStoreFloat3(&m_forward, XMVector3Normalize(world.r[2]));
 }
 
-void Transform::setDirty()
+void Transform::setRotationFromEulerAngles()
 {
-	if (!m_isDirty)
-	{
-		m_isDirty = true;
+	XMStoreFloat4(&m_localRotation, XMQuaternionRotationRollPitchYawFromVector(XMLoadFloat3(&m_localEulerAngles)));
+	setDirty();
+}
 
-		std::vector<Entity*> children = entity.getChildren();
+void Transform::setDirty()
+{
+	if (m_isDirty) return;
 
-		for (unsigned int i = 0; i < children.size(); i++)
-		{
-			Transform* childTransform = children[i]->getComponent<Transform>();
-			if (childTransform)
-			{
-				childTransform->setDirty();
-			}
-		}
-	}
+	m_isDirty = true;
+	entity.getScene().getTransformHierarchy().propagateDirty(this);
 }
 
 void debugTransformSetLocalPosition(Component* component, const void* value)
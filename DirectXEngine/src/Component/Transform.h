@@ -4,6 +4,8 @@
 class Transform : public Component
 {
 public:
+	friend class TransformHierarchy;
+
 	Transform(Entity& entity);
 	~Transform();
 
@@ -15,11 +17,13 @@ public:
 	DirectX::XMFLOAT3 getPosition();
 	DirectX::XMFLOAT3 getLocalPosition() const;
 	DirectX::XMFLOAT3 getLocalRotation() const;
+	DirectX::XMFLOAT4 getLocalRotationQuaternion() const;
 	DirectX::XMFLOAT3 getLocalScale() const;
 
 	void setLocalPosition(DirectX::XMFLOAT3 position);
 	void setLocalRotation(DirectX::XMFLOAT3 rotationDegrees);
 	void setLocalRotationRadians(DirectX::XMFLOAT3 rotationRadians);
+	void setLocalRotationQuaternion(DirectX::XMFLOAT4 rotation);
 	void setLocalScale(DirectX::XMFLOAT3 scale);
 
 	const DirectX::XMFLOAT3 getRight();
@@ -49,6 +53,8 @@ public:
 	void rotateLocalYRadians(float radians);
 	void rotateLocalZRadians(float radians);
 
+	void rotateLocalQuaternion(DirectX::XMFLOAT4 rotation);
+
 	void scale(DirectX::XMFLOAT3 delta);
 	void scaleX(float delta);
 	void scaleY(float delta);
@@ -57,15 +63,34 @@ public:
 	void setDirty();
 
 private:
-	DirectX::XMMATRIX calcWorldMatrix();
+	void updateWorldMatrix();
+	void calcWorldMatrix(const Transform* parent);
+	void calcLocalMatrices(DirectX::XMFLOAT4X4& localMatrix, DirectX::XMFLOAT4X4& localInverseMatrix) const;
+	void setWorldMatrices(const DirectX::XMFLOAT4X4& localMatrix, const DirectX::XMFLOAT4X4& localInverseMatrix, const Transform* parent);
+
+	void setRotationFromEulerAngles();
 
 	DirectX::XMFLOAT3 m_localPosition;
-	DirectX::XMFLOAT3 m_localRotation;
+	DirectX::XMFLOAT4 m_localRotation;
 	DirectX::XMFLOAT3 m_localScale;
 
+	// Euler angles in radians, kept in sync with the rotation quaternion for the inspector, JSON and the Euler based rotate functions.
+	DirectX::XMFLOAT3 m_localEulerAngles;
+
 	DirectX::XMFLOAT4X4 m_worldMatrix;
 	DirectX::XMFLOAT4X4 m_inverseWorldMatrix;
+
+	// World space basis vectors, cached whenever the world matrix is recalculated
+	DirectX::XMFLOAT3 m_right;
+	DirectX::XMFLOAT3 m_up;
+	DirectX::XMFLOAT3 m_forward;
 	bool m_isDirty;
+
+	// Where this transform is in its scene's TransformHierarchy
+	int m_hierarchySlot;
+	int m_hierarchyIndex;
+	// Whether this transform is in its hierarchy's list of moved transforms
+	bool m_hasMoved;
 };
 
 void debugTransformSetLocalPosition(Component* component, const void* value);
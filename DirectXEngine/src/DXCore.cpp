@@ -383,7 +383,8 @@ void DXCore::UpdateTitleBarStats()
 		"    Width: " << m_window->getWidth() <<
 		"    Height: " << m_window->getHeight() <<
 		"    FPS: " << fpsFrameCount <<
-		"    Frame Time: " << mspf << "ms";
+		"    Frame Time: " << mspf << "ms" <<
+		getTitleBarStats();
 
 	// Append the version of DirectX the app is using
 	switch (dxFeatureLevel)
@@ -405,6 +406,11 @@ void DXCore::UpdateTitleBarStats()
 	fpsTimeElapsed += 1.0f;
 }
 
+std::string DXCore::getTitleBarStats()
+{
+	return "";
+}
+
 // --------------------------------------------------------
 // Handles messages that are sent to our window by the
 // operating system.  Ignoring these messages would cause
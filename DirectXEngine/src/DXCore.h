@@ -53,6 +53,9 @@ protected:
 	ID3D11RenderTargetView* backBufferRTV;
 	ID3D11DepthStencilView* depthStencilView;
 
+	// Extra stats appended to the title bar, when it's showing them
+	virtual std::string getTitleBarStats();
+
 private:
 	std::string m_titleBarText;	// Custom text in window's title bar
 	bool m_titleBarStats;	// Show extra stats in title bar?
@@ -28,7 +28,7 @@ void DebugComponentList::draw()
 
 	if (m_selectedEntityID > 0)
 	{
-		std::vector<Entity*> entities = SceneManager::getActiveScene()->getAllEntities();
+		const std::vector<Entity*>& entities = SceneManager::getActiveScene()->getAllEntities();
 		for (unsigned int i = 0; i < entities.size(); i++)
 		{
 			if (m_selectedEntityID == entities[i]->getID())
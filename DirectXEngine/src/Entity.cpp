@@ -2,6 +2,7 @@
 
 #include "Scene/Scene.h"
 #include "Component/ComponentRegistry.h"
+#include "Util.h"
 
 using namespace DirectX;
 
@@ -11,6 +12,7 @@ Entity::Entity(Scene& scene, unsigned int id, std::string name, bool hasDebugIco
 	m_name = name;
 	m_components = std::vector<Component*>();
 	m_enabled = true;
+	m_enabledInHierarchy = true;
 
 	m_parent = nullptr;
 	m_children = std::vector<Entity*>();
@@ -40,7 +42,8 @@ Entity::~Entity()
 
 	while (m_components.size() > 0)
 	{
-		delete m_components.back();
+		onComponentRemoved(m_components.back());
+		TypePools::destroy(m_components.back());
 		m_components.pop_back();
 	}
 
@@ -54,7 +57,7 @@ void Entity::update(float deltaTime, float totalTime)
 {
 	for (unsigned int i = 0; i < m_components.size(); i++)
 	{
-		if (m_components[i]->enabled)
+		if (m_components[i]->getEnabled())
 			m_components[i]->update(deltaTime, totalTime);
 	}
 }
@@ -63,7 +66,7 @@ void Entity::lateUpdate(float deltaTime, float totalTime)
 {
 	for (unsigned int i = 0; i < m_components.size(); i++)
 	{
-		if (m_components[i]->enabled)
+		if (m_components[i]->getEnabled())
 			m_components[i]->lateUpdate(deltaTime, totalTime);
 	}
 }
@@ -142,7 +145,7 @@ unsigned int Entity::getID() const
 	return m_id;
 }
 
-std::string Entity::getName() const
+const std::string& Entity::getName() const
 {
 	return m_name;
 }
@@ -163,7 +166,7 @@ Component* Entity::addComponentByStringType(std::string componentType, bool init
 	return ComponentRegistry::addComponentToEntity(*this, componentType, initialize);
 }
 
-std::vector<Component*> Entity::getAllComponents() const
+const std::vector<Component*>& Entity::getAllComponents() const
 {
 	return m_components;
 }
@@ -174,8 +177,9 @@ void Entity::removeComponent(Component* component)
 	{
 		if (m_components[i] == component)
 		{
+			onComponentRemoved(component);
 			m_components.erase(m_components.begin() + i);
-			delete component;
+			TypePools::destroy(component);
 			return;
 		}
 	}
@@ -183,30 +187,20 @@ void Entity::removeComponent(Component* component)
 
 bool Entity::getEnabled() const
 {
-	if (!m_enabled) return false;
-
-	const Entity* current = this;
-	while (true)
-	{
-		if (!current->m_parent)
-		{
-			return true;
-		}
-		else
-		{
-			if (current->m_parent->m_enabled)
-				current = current->m_parent;
-			else
-				return false;
-		}
-	}
+	return m_enabledInHierarchy;
+}
 
-	return false;
+bool Entity::getEnabledSelf() const
+{
+	return m_enabled;
 }
 
 void Entity::setEnabled(bool enabled)
 {
+	if (m_enabled == enabled) return;
+
 	m_enabled = enabled;
+	refreshEnabledInHierarchy();
 }
 
 Entity* Entity::getParent() const
@@ -243,7 +237,7 @@ Entity* Entity::getChild(unsigned int index) const
 	return nullptr;
 }
 
-Entity* Entity::getChildByName(std::string childName) const
+Entity* Entity::getChildByName(std::string_view childName) const
 {
 	for (unsigned int i = 0; i < m_children.size(); i++)
 	{
@@ -251,11 +245,11 @@ Entity* Entity::getChildByName(std::string childName) const
 			return m_children[i];
 	}
 
-	Debug::warning("Child with name " + childName + " could not be found in child list for entity " + m_name);
+	Debug::warning("Child with name " + std::string(childName) + " could not be found in child list for entity " + m_name);
 	return nullptr;
 }
 
-std::vector<Entity*> Entity::getChildren() const
+const std::vector<Entity*>& Entity::getChildren() const
 {
 	return m_children;
 }
@@ -286,7 +280,7 @@ void Entity::addChild(Entity* child)
 	child->setParentNonRecursive(this);
 }
 
-void Entity::addChildByName(std::string childName)
+void Entity::addChildByName(std::string_view childName)
 {
 	if (childName == "")
 	{
@@ -325,7 +319,7 @@ void Entity::removeChildByIndex(unsigned int index)
 	Debug::warning("Child index " + std::to_string(index) + " outside bounds of children list for entity " + m_name);
 }
 
-void Entity::removeChildByName(std::string childName)
+void Entity::removeChildByName(std::string_view childName)
 {
 	for (unsigned int i = 0; i < m_children.size(); i++)
 	{
@@ -337,7 +331,7 @@ void Entity::removeChildByName(std::string childName)
 		}
 	}
 
-	Debug::warning("Child with name " + childName + " could not be found in child list for entity " + m_name);
+	Debug::warning("Child with name " + std::string(childName) + " could not be found in child list for entity " + m_name);
 }
 
 void Entity::removeAllChildren()
@@ -345,22 +339,22 @@ void Entity::removeAllChildren()
 	m_children.clear();
 }
 
-void Entity::addTag(std::string tag)
+void Entity::addTag(std::string_view tag)
 {
 	m_scene.addTagToEntity(*this, tag);
 }
 
-void Entity::removeTag(std::string tag)
+void Entity::removeTag(std::string_view tag)
 {
 	m_scene.removeTagFromEntity(*this, tag);
 }
 
-bool Entity::hasTag(std::string tag) const
+bool Entity::hasTag(std::string_view tag) const
 {
-	return m_tags.find(tag) != m_tags.end();
+	return m_tags.find(Util::lookupKey(tag)) != m_tags.end();
 }
 
-std::unordered_set<std::string> Entity::getTags() const
+const std::unordered_set<std::string>& Entity::getTags() const
 {
 	return m_tags;
 }
@@ -404,12 +398,16 @@ DebugEntity* Entity::getDebugIcon() const
 void Entity::setParentNonRecursive(Entity* parent)
 {
 	m_parent = parent;
+	m_scene.getTransformHierarchy().setOrderDirty();
 
 	Transform* transform = getComponent<Transform>();
 	if (transform)
 	{
 		transform->setDirty();
 	}
+
+	// A new parent can change whether this entity is enabled in the hierarchy
+	refreshEnabledInHierarchy();
 }
 
 void Entity::addChildNonRecursive(Entity* child)
@@ -417,12 +415,37 @@ void Entity::addChildNonRecursive(Entity* child)
 	m_children.push_back(child);
 }
 
-void Entity::addTagNonResursive(std::string tag)
+void Entity::refreshEnabledInHierarchy()
+{
+	bool enabledInHierarchy = m_enabled && (!m_parent || m_parent->m_enabledInHierarchy);
+	if (m_enabledInHierarchy == enabledInHierarchy) return;
+
+	m_enabledInHierarchy = enabledInHierarchy;
+	m_scene.onEntityEnabledChanged(this);
+
+	// Subtrees under an entity whose state didn't change are left alone
+	for (unsigned int i = 0; i < m_children.size(); i++)
+	{
+		m_children[i]->refreshEnabledInHierarchy();
+	}
+}
+
+void Entity::addTagNonResursive(std::string_view tag)
+{
+	m_tags.insert(std::string(tag));
+}
+
+void Entity::removeTagNonRecursive(std::string_view tag)
+{
+	m_tags.erase(Util::lookupKey(tag));
+}
+
+void Entity::onComponentAdded(Component* component)
 {
-	m_tags.insert(tag);
+	m_scene.onComponentAdded(component);
 }
 
-void Entity::removeTagNonRecursive(std::string tag)
+void Entity::onComponentRemoved(Component* component)
 {
-	m_tags.erase(tag);
+	m_scene.onComponentRemoved(component);
 }
@@ -2,6 +2,7 @@
 
 #include "Asset/AssetManager.h"
 #include "Debug/Debug.h"
+#include "Memory/PoolAllocator.h"
 
 #include "rapidjson/document.h"
 #include "rapidjson/prettywriter.h"
@@ -11,6 +12,7 @@
 #endif
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <unordered_set>
 #include <Windows.h>
@@ -27,6 +29,8 @@ class Entity
 {
 public:
 	friend class Scene;
+	friend class TypePools;
+	template<typename... Ts> friend class ComponentQuery;
 
 	void update(float deltaTime, float totalTime);
 	void lateUpdate(float deltaTime, float totalTime);
@@ -38,7 +42,7 @@ public:
 	Scene& getScene() const;
 
 	unsigned int getID() const;
-	std::string getName() const;
+	const std::string& getName() const;
 	void rename(std::string name);
 
 	template<typename T>
@@ -51,33 +55,37 @@ public:
 	template<typename T>
 	std::vector<T*> getComponentsByType() const;
 
-	std::vector<Component*> getAllComponents() const;
+	const std::vector<Component*>& getAllComponents() const;
 
 	template<typename T>
 	void removeComponent();
 	void removeComponent(Component* component);
 
+	// Whether this entity and all of its ancestors are enabled. Cached and only recalculated when
+	// this entity or an ancestor is enabled, disabled or reparented, so it's cheap to call every frame.
 	bool getEnabled() const;
+	// Whether this entity itself is enabled, regardless of its ancestors.
+	bool getEnabledSelf() const;
 	void setEnabled(bool enabled);
 
 	Entity* getParent() const;
 	void setParent(Entity* parent);
 
 	Entity* getChild(unsigned int index) const;
-	Entity* getChildByName(std::string childName) const;
-	std::vector<Entity*> getChildren() const;
+	Entity* getChildByName(std::string_view childName) const;
+	const std::vector<Entity*>& getChildren() const;
 
 	void addChild(Entity* child);
-	void addChildByName(std::string childName);
+	void addChildByName(std::string_view childName);
 	void removeChild(Entity* child);
 	void removeChildByIndex(unsigned int index);
-	void removeChildByName(std::string childName);
+	void removeChildByName(std::string_view childName);
 	void removeAllChildren();
 
-	void addTag(std::string tag);
-	void removeTag(std::string tag);
-	bool hasTag(std::string tag) const;
-	std::unordered_set<std::string> getTags() const;
+	void addTag(std::string_view tag);
+	void removeTag(std::string_view tag);
+	bool hasTag(std::string_view tag) const;
+	const std::unordered_set<std::string>& getTags() const;
 
 	bool selected;
 
@@ -99,8 +107,14 @@ private:
 	void setParentNonRecursive(Entity* parent);
 	void addChildNonRecursive(Entity* child);
 
-	void addTagNonResursive(std::string tag);
-	void removeTagNonRecursive(std::string tag);
+	// Recalculates whether this entity is enabled in the hierarchy, and if that changed tells the scene and does the same for its children.
+	void refreshEnabledInHierarchy();
+
+	void addTagNonResursive(std::string_view tag);
+	void removeTagNonRecursive(std::string_view tag);
+
+	void onComponentAdded(Component* component);
+	void onComponentRemoved(Component* component);
 
 	Scene& m_scene;
 
@@ -109,6 +123,7 @@ private:
 	std::vector<Component*> m_components;
 
 	bool m_enabled;
+	bool m_enabledInHierarchy;
 
 	Entity* m_parent;
 	std::vector<Entity*> m_children;
@@ -136,13 +151,15 @@ inline T* Entity::addComponent(bool initialize)
 		}
 	}
 
-	T* component = new T(*this);
+	T* component = new (TypePools::get<T>().allocate()) T(*this);
 	m_components.push_back(component);
 	component->initDebugVariables();
 
 	if (initialize)
 		component->init();
 
+	onComponentAdded(component);
+
 	return component;
 }
 
@@ -19,6 +19,9 @@ Game::Game(HINSTANCE hInstance)
 		"DirectX Game",	   // Text for the window's title bar
 		true)			   // Show extra stats (fps) in title bar?
 {
+	m_jobSystem = nullptr;
+	m_frameAllocator = nullptr;
+
 	m_assetManager = nullptr;
 	m_sceneManager = nullptr;
 
@@ -29,6 +32,9 @@ Game::Game(HINSTANCE hInstance)
 
 	m_input = nullptr;
 
+	m_simulatedScene = nullptr;
+	m_simulationJob = nullptr;
+
 	Debug::createConsoleWindow();
 }
 
@@ -44,12 +50,20 @@ Game::~Game()
 	delete m_sceneManager;
 	delete m_assetManager;
 
+	// Every entity and component is gone with the scenes
+	TypePools::release();
+
 	delete m_physicsHandler;
 
 	delete m_guiRenderer;
 	delete m_renderer;
 
 	delete m_input;
+
+	delete m_frameAllocator;
+
+	// Deleted last so nothing is still scheduling work when the worker threads are joined
+	delete m_jobSystem;
 }
 
 // --------------------------------------------------------
@@ -68,6 +82,11 @@ HRESULT Game::Init()
 
 	Debug::lateInit(m_window->getWindowHandle(), device, context);
 
+	m_jobSystem = new JobSystem();
+	Debug::message("Started job system with " + std::to_string(JobSystem::getWorkerCount()) + " worker threads.");
+
+	m_frameAllocator = new FrameAllocator();
+
 	m_assetManager = new AssetManager(device, context);
 	if (!m_assetManager->init()) return E_ABORT;
 
@@ -112,9 +131,41 @@ void Game::Update(float deltaTime, float totalTime)
 	Scene* activeScene = m_sceneManager->getActiveScene();
 	if (activeScene)
 	{
-		activeScene->update(deltaTime, totalTime);
-		activeScene->handlePhysics(m_physicsHandler);
+		m_simulatedScene = activeScene;
+
+#if PIPELINED_RENDERING
+		m_simulationJob = JobSystem::createJob([this, activeScene, deltaTime, totalTime](Job* job)
+		{
+			simulate(activeScene, deltaTime, totalTime);
+		});
+		JobSystem::run(m_simulationJob);
+#else
+		simulate(activeScene, deltaTime, totalTime);
+		finishSimulation();
+#endif
+	}
+}
+
+void Game::simulate(Scene* scene, float deltaTime, float totalTime)
+{
+	scene->update(deltaTime, totalTime);
+	scene->handlePhysics(m_physicsHandler);
+	scene->lateUpdate(deltaTime, totalTime);
+	scene->extractRenderData();
+}
+
+void Game::finishSimulation()
+{
+	if (!m_simulatedScene) return;
+
+	if (m_simulationJob)
+	{
+		JobSystem::wait(m_simulationJob);
+		m_simulationJob = nullptr;
 	}
+
+	m_simulatedScene->swapRenderSnapshots();
+	m_simulatedScene = nullptr;
 }
 
 // --------------------------------------------------------
@@ -126,7 +177,12 @@ void Game::Draw(float deltaTime, float totalTime)
 
 	Scene* activeScene = m_sceneManager->getActiveScene();
 
+	// Only reads the scene's render snapshot, so with pipelined rendering the next frame is being simulated meanwhile
 	activeScene->renderGeometry(m_renderer, backBufferRTV, depthStencilView, (float)Window::getWidth(), (float)Window::getHeight());
+
+	// The GUI and editor still read the scene directly
+	finishSimulation();
+
 	activeScene->renderGUI(m_guiRenderer);
 
 	m_renderer->end();
@@ -137,6 +193,28 @@ void Game::Draw(float deltaTime, float totalTime)
 	//  - Puts the final frame we're drawing into the window so the user can see it
 	//  - Do this exactly ONCE PER FRAME (always at the very end of the frame)
 	swapChain->Present(0, 0);
+
+	// Nothing allocated this frame is needed anymore
+	FrameAllocator::reset();
+
+	if (FrameAllocator::hasLastFrameOverflowed())
+	{
+		Debug::warning("Frame allocator overflowed its " + std::to_string(FrameAllocator::getCapacityPerThread()) + " bytes per thread, last frame peaked at " +
+			std::to_string(FrameAllocator::getLastFramePeak()) + " bytes.");
+	}
+}
+
+std::string Game::getTitleBarStats()
+{
+	if (!m_renderer) return "";
+
+	// Stats from the last frame drawn
+	const RenderBackendStats& stats = m_renderer->getStats();
+
+	return "    Draws: " + std::to_string(stats.drawCount) +
+		"    Commands: " + std::to_string(stats.commandCount) +
+		"    Skipped: " + std::to_string(stats.redundantCommands) +
+		"    Frame memory: " + std::to_string(FrameAllocator::getLastFramePeak() / 1024) + "/" + std::to_string(FrameAllocator::getCapacityPerThread() / 1024) + " KB";
 }
 
 
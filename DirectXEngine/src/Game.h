@@ -7,6 +7,13 @@
 
 #include "Input.h"
 
+#include "Job/JobSystem.h"
+#include "Memory/FrameAllocator.h"
+
+// When set to 1, the scene's update for the next frame runs as a job while the current frame's render snapshot is drawn,
+// at the cost of a frame of latency. Components must not use the device context from update while this is on.
+#define PIPELINED_RENDERING 0
+
 class Game : public DXCore
 {
 
@@ -22,7 +29,19 @@ public:
 
 	virtual LRESULT ProcessMessage(HWND hwnd, UINT msg, WPARAM wParam, LPARAM lParam) override;
 
+protected:
+	std::string getTitleBarStats() override;
+
 private:
+	// Updates the scene and extracts its next render snapshot.
+	void simulate(Scene* scene, float deltaTime, float totalTime);
+
+	// Waits for the frame's simulation to finish, then makes its snapshot the one that's rendered.
+	void finishSimulation();
+
+	JobSystem* m_jobSystem;
+	FrameAllocator* m_frameAllocator;
+
 	AssetManager* m_assetManager;
 	SceneManager* m_sceneManager;
 
@@ -32,5 +51,8 @@ private:
 	GUIRenderer* m_guiRenderer;
 
 	Input* m_input;
+
+	Scene* m_simulatedScene;
+	Job* m_simulationJob;
 };
 
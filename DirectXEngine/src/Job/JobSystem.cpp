@@ -0,0 +1,265 @@
+#include "JobSystem.h"
+
+JobSystem* JobSystem::m_instance = nullptr;
+thread_local unsigned int JobSystem::m_threadIndex = 0;
+
+void JobQueue::push(Job* job)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_jobs.push_back(job);
+}
+
+Job* JobQueue::pop()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_jobs.empty()) return nullptr;
+
+	Job* job = m_jobs.back();
+	m_jobs.pop_back();
+	return job;
+}
+
+Job* JobQueue::steal()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (m_jobs.empty()) return nullptr;
+
+	Job* job = m_jobs.front();
+	m_jobs.pop_front();
+	return job;
+}
+
+JobSystem::JobSystem(unsigned int workerCount)
+{
+	if (!m_instance) m_instance = this;
+	else return;
+
+	if (workerCount == 0)
+	{
+		workerCount = std::thread::hardware_concurrency();
+		if (workerCount == 0) workerCount = 1;
+	}
+
+	m_workerCount = workerCount;
+	m_queues = new JobQueue[m_workerCount];
+	m_jobPools = new Job[m_workerCount * MAX_JOBS_PER_THREAD];
+	m_jobPoolIndices = new unsigned int[m_workerCount]();
+
+	for (unsigned int i = 0; i < m_workerCount * MAX_JOBS_PER_THREAD; i++)
+	{
+		m_jobPools[i].parent = nullptr;
+		m_jobPools[i].unfinishedJobs = 0;
+	}
+
+	m_running = true;
+	m_pendingJobs = 0;
+
+	// The thread that created the job system is worker 0 and does work whenever it waits on a job
+	m_threadIndex = 0;
+	for (unsigned int i = 1; i < m_workerCount; i++)
+	{
+		m_threads.push_back(std::thread(&JobSystem::workerThread, this, i));
+	}
+}
+
+JobSystem::~JobSystem()
+{
+	if (m_instance != this) return;
+
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_running = false;
+	}
+	m_wakeCondition.notify_all();
+
+	for (unsigned int i = 0; i < m_threads.size(); i++)
+	{
+		m_threads[i].join();
+	}
+	m_threads.clear();
+
+	delete[] m_queues;
+	delete[] m_jobPools;
+	delete[] m_jobPoolIndices;
+
+	m_instance = nullptr;
+}
+
+Job* JobSystem::createJob(JobFunction function)
+{
+	Job* job = m_instance->allocateJob();
+	job->function = function;
+	job->parent = nullptr;
+	job->unfinishedJobs = 1;
+
+	return job;
+}
+
+Job* JobSystem::createChildJob(Job* parent, JobFunction function)
+{
+	// The parent can't finish until this child has
+	parent->unfinishedJobs++;
+
+	Job* job = m_instance->allocateJob();
+	job->function = function;
+	job->parent = parent;
+	job->unfinishedJobs = 1;
+
+	return job;
+}
+
+void JobSystem::run(Job* job)
+{
+	// Count the job before it's visible to thieves so the pending count never underflows
+	{
+		std::lock_guard<std::mutex> lock(m_instance->m_wakeMutex);
+		m_instance->m_pendingJobs++;
+	}
+
+	m_instance->m_queues[m_threadIndex].push(job);
+	m_instance->m_wakeCondition.notify_one();
+}
+
+void JobSystem::wait(const Job* job)
+{
+	while (!isFinished(job))
+	{
+		Job* next = m_instance->getJob();
+		if (next)
+			m_instance->execute(next);
+		else
+			std::this_thread::yield();
+	}
+}
+
+bool JobSystem::isFinished(const Job* job)
+{
+	return job->unfinishedJobs.load() == 0;
+}
+
+void JobSystem::parallelFor(unsigned int count, unsigned int batchSize, const std::function<void(unsigned int, unsigned int)>& function)
+{
+	if (count == 0) return;
+	if (batchSize == 0) batchSize = 1;
+
+	// Not worth the overhead of scheduling if there's only one batch
+	if (count <= batchSize || m_instance->m_workerCount == 1)
+	{
+		function(0, count);
+		return;
+	}
+
+	Job* root = createJob(nullptr);
+
+	for (unsigned int start = 0; start < count; start += batchSize)
+	{
+		unsigned int end = start + batchSize < count ? start + batchSize : count;
+
+		Job* batch = createChildJob(root, [&function, start, end](Job*)
+		{
+			function(start, end);
+		});
+
+		run(batch);
+	}
+
+	run(root);
+	wait(root);
+}
+
+unsigned int JobSystem::getWorkerCount()
+{
+	return m_instance->m_workerCount;
+}
+
+unsigned int JobSystem::getThreadIndex()
+{
+	return m_threadIndex;
+}
+
+void JobSystem::workerThread(unsigned int threadIndex)
+{
+	m_threadIndex = threadIndex;
+
+	while (m_running)
+	{
+		Job* job = getJob();
+		if (job)
+		{
+			execute(job);
+			continue;
+		}
+
+		// Nothing to do anywhere, sleep until more work is scheduled
+		std::unique_lock<std::mutex> lock(m_wakeMutex);
+		m_wakeCondition.wait(lock, [this]() { return m_pendingJobs > 0 || !m_running; });
+	}
+}
+
+Job* JobSystem::allocateJob()
+{
+	unsigned int& poolIndex = m_jobPoolIndices[m_threadIndex];
+	Job* pool = &m_jobPools[m_threadIndex * MAX_JOBS_PER_THREAD];
+
+	// A slot can only be reused once the job in it has finished. If every one of this thread's jobs is still
+	// in flight, help run other jobs until one frees up instead of overwriting a live job.
+	while (true)
+	{
+		for (unsigned int i = 0; i < MAX_JOBS_PER_THREAD; i++)
+		{
+			Job* job = &pool[poolIndex % MAX_JOBS_PER_THREAD];
+			poolIndex++;
+
+			if (job->unfinishedJobs.load() == 0)
+				return job;
+		}
+
+		Job* next = getJob();
+		if (next)
+			execute(next);
+		else
+			std::this_thread::yield();
+	}
+}
+
+Job* JobSystem::getJob()
+{
+	Job* job = m_queues[m_threadIndex].pop();
+
+	if (!job)
+	{
+		// Our own queue is empty, try to steal from the other workers, starting with our neighbour so
+		// that thieves spread out across the queues instead of all hitting worker 0.
+		for (unsigned int i = 1; i < m_workerCount && !job; i++)
+		{
+			job = m_queues[(m_threadIndex + i) % m_workerCount].steal();
+		}
+	}
+
+	if (job)
+	{
+		m_pendingJobs--;
+	}
+
+	return job;
+}
+
+void JobSystem::execute(Job* job)
+{
+	if (job->function)
+		job->function(job);
+
+	finish(job);
+}
+
+void JobSystem::finish(Job* job)
+{
+	// Once the count reaches zero the slot can be handed out again, so the parent has to be read first
+	Job* parent = job->parent;
+
+	int unfinishedJobs = --job->unfinishedJobs;
+	if (unfinishedJobs == 0 && parent)
+	{
+		finish(parent);
+	}
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// The maximum number of jobs a single thread can have in flight. Creating more waits for one of them to finish,
+// running other jobs in the meantime, so every job in flight must already be scheduled or about to be.
+#define MAX_JOBS_PER_THREAD 4096
+
+struct Job;
+
+typedef std::function<void(Job*)> JobFunction;
+
+// A unit of work. A job is finished once its own function has run and all of its children have finished,
+// so waiting on a parent job waits on the whole tree of work underneath it.
+struct Job
+{
+	JobFunction function;
+	Job* parent;
+	std::atomic<int> unfinishedJobs;
+};
+
+// Per-worker queue of jobs. The owning thread pushes and pops from the back (LIFO for cache locality)
+// while idle threads steal from the front (the oldest, usually largest, pieces of work).
+class JobQueue
+{
+public:
+	void push(Job* job);
+	Job* pop();
+	Job* steal();
+
+private:
+	std::deque<Job*> m_jobs;
+	std::mutex m_mutex;
+};
+
+class JobSystem
+{
+public:
+	// A worker count of 0 uses one worker per hardware thread. The calling thread always counts as worker 0.
+	// A worker count of 1 runs every job on the calling thread in a deterministic order, which is useful for debugging.
+	JobSystem(unsigned int workerCount = 0);
+	~JobSystem();
+
+	static Job* createJob(JobFunction function);
+	static Job* createChildJob(Job* parent, JobFunction function);
+
+	static void run(Job* job);
+
+	// Helps execute other jobs until the given job and all of its children have finished.
+	static void wait(const Job* job);
+
+	static bool isFinished(const Job* job);
+
+	// Splits [0, count) into batches of batchSize and runs function(start, end) on each batch in parallel.
+	// Returns once every batch has finished.
+	static void parallelFor(unsigned int count, unsigned int batchSize, const std::function<void(unsigned int, unsigned int)>& function);
+
+	static unsigned int getWorkerCount();
+	static unsigned int getThreadIndex();
+
+private:
+	void workerThread(unsigned int threadIndex);
+
+	Job* allocateJob();
+	Job* getJob();
+	void execute(Job* job);
+	void finish(Job* job);
+
+	static JobSystem* m_instance;
+	static thread_local unsigned int m_threadIndex;
+
+	unsigned int m_workerCount;
+	std::vector<std::thread> m_threads;
+
+	JobQueue* m_queues;
+
+	// Each thread allocates jobs out of its own ring buffer so creating a job doesn't touch the heap.
+	// Slots are only reused once the job in them has finished.
+	Job* m_jobPools;
+	unsigned int* m_jobPoolIndices;
+
+	std::atomic<bool> m_running;
+	std::atomic<unsigned int> m_pendingJobs;
+	std::mutex m_wakeMutex;
+	std::condition_variable m_wakeCondition;
+};
@@ -0,0 +1,164 @@
+#include "FrameAllocator.h"
+
+#include "../Job/JobSystem.h"
+
+#include <cstdlib>
+
+FrameAllocator* FrameAllocator::m_instance = nullptr;
+
+LinearAllocator::LinearAllocator(size_t capacity)
+{
+	m_buffer = static_cast<char*>(std::malloc(capacity));
+	m_capacity = capacity;
+	m_offset = 0;
+	m_highWaterMark = 0;
+
+	m_overflowAllocations = std::vector<void*>();
+	m_overflowBytes = 0;
+}
+
+LinearAllocator::~LinearAllocator()
+{
+	reset();
+	std::free(m_buffer);
+}
+
+void* LinearAllocator::allocate(size_t size, size_t alignment)
+{
+	if (size == 0) size = 1;
+
+	// Round the offset up to the alignment, which is always a power of two
+	size_t alignedOffset = (m_offset + alignment - 1) & ~(alignment - 1);
+
+	void* memory;
+	if (alignedOffset + size <= m_capacity)
+	{
+		memory = m_buffer + alignedOffset;
+		m_offset = alignedOffset + size;
+	}
+	else
+	{
+		// malloc is aligned for any fundamental type, which covers everything the engine allocates here
+		memory = std::malloc(size);
+		m_overflowAllocations.push_back(memory);
+		m_overflowBytes += size;
+	}
+
+	size_t used = getUsed();
+	if (used > m_highWaterMark) m_highWaterMark = used;
+
+	return memory;
+}
+
+void LinearAllocator::reset()
+{
+	m_offset = 0;
+
+	if (m_overflowAllocations.size() > 0)
+	{
+		for (unsigned int i = 0; i < m_overflowAllocations.size(); i++)
+		{
+			std::free(m_overflowAllocations[i]);
+		}
+		m_overflowAllocations.clear();
+		m_overflowBytes = 0;
+	}
+}
+
+size_t LinearAllocator::getUsed() const
+{
+	return m_offset + m_overflowBytes;
+}
+
+size_t LinearAllocator::getCapacity() const
+{
+	return m_capacity;
+}
+
+size_t LinearAllocator::getHighWaterMark() const
+{
+	return m_highWaterMark;
+}
+
+bool LinearAllocator::hasOverflowed() const
+{
+	return m_overflowAllocations.size() > 0;
+}
+
+FrameAllocator::FrameAllocator(size_t capacityPerThread)
+{
+	if (!m_instance) m_instance = this;
+	else return;
+
+	m_capacityPerThread = capacityPerThread;
+	m_lastFramePeak = 0;
+	m_lastFrameOverflowed = false;
+
+	// One allocator per job system worker, which must already exist
+	m_allocators = std::vector<LinearAllocator*>(JobSystem::getWorkerCount());
+	for (unsigned int i = 0; i < m_allocators.size(); i++)
+	{
+		m_allocators[i] = new LinearAllocator(capacityPerThread);
+	}
+}
+
+FrameAllocator::~FrameAllocator()
+{
+	if (m_instance != this) return;
+
+	for (unsigned int i = 0; i < m_allocators.size(); i++)
+	{
+		delete m_allocators[i];
+	}
+	m_allocators.clear();
+
+	m_instance = nullptr;
+}
+
+void* FrameAllocator::allocate(size_t size, size_t alignment)
+{
+	return m_instance->m_allocators[JobSystem::getThreadIndex()]->allocate(size, alignment);
+}
+
+void FrameAllocator::reset()
+{
+	m_instance->m_lastFramePeak = 0;
+	m_instance->m_lastFrameOverflowed = false;
+
+	for (unsigned int i = 0; i < m_instance->m_allocators.size(); i++)
+	{
+		// Nothing is ever freed during a frame, so what's in use now is the most the thread used all frame
+		LinearAllocator* allocator = m_instance->m_allocators[i];
+		if (allocator->getUsed() > m_instance->m_lastFramePeak) m_instance->m_lastFramePeak = allocator->getUsed();
+		if (allocator->hasOverflowed()) m_instance->m_lastFrameOverflowed = true;
+
+		allocator->reset();
+	}
+}
+
+size_t FrameAllocator::getLastFramePeak()
+{
+	return m_instance->m_lastFramePeak;
+}
+
+bool FrameAllocator::hasLastFrameOverflowed()
+{
+	return m_instance->m_lastFrameOverflowed;
+}
+
+size_t FrameAllocator::getHighWaterMark()
+{
+	size_t highWaterMark = 0;
+	for (unsigned int i = 0; i < m_instance->m_allocators.size(); i++)
+	{
+		size_t allocatorHighWaterMark = m_instance->m_allocators[i]->getHighWaterMark();
+		if (allocatorHighWaterMark > highWaterMark) highWaterMark = allocatorHighWaterMark;
+	}
+
+	return highWaterMark;
+}
+
+size_t FrameAllocator::getCapacityPerThread()
+{
+	return m_instance->m_capacityPerThread;
+}
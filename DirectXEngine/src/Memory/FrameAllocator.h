@@ -0,0 +1,117 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// How many bytes each thread's frame allocator reserves up front.
+#define FRAME_ALLOCATOR_CAPACITY (1024 * 1024)
+
+// Hands out memory by bumping an offset through a single buffer. Individual allocations are never freed,
+// the whole buffer is released at once by resetting the offset.
+// If the buffer runs out, allocations fall back to the heap until the next reset so nothing fails,
+// and the high-water mark includes them so the capacity can be raised to fit.
+class LinearAllocator
+{
+public:
+	LinearAllocator(size_t capacity);
+	~LinearAllocator();
+
+	void* allocate(size_t size, size_t alignment);
+	void reset();
+
+	size_t getUsed() const;
+	size_t getCapacity() const;
+	size_t getHighWaterMark() const;
+
+	// Whether anything had to be allocated from the heap since the last reset
+	bool hasOverflowed() const;
+
+private:
+	char* m_buffer;
+	size_t m_capacity;
+	size_t m_offset;
+	size_t m_highWaterMark;
+
+	std::vector<void*> m_overflowAllocations;
+	size_t m_overflowBytes;
+};
+
+// Scratch memory that only has to live until the end of the current frame.
+// Each worker thread has its own linear allocator so jobs can allocate without locking,
+// and every allocator is reset together once the frame is finished.
+class FrameAllocator
+{
+public:
+	FrameAllocator(size_t capacityPerThread = FRAME_ALLOCATOR_CAPACITY);
+	~FrameAllocator();
+
+	// Allocates from the calling thread's allocator.
+	static void* allocate(size_t size, size_t alignment);
+
+	template<typename T>
+	static T* allocate(size_t count);
+
+	// Frees everything allocated this frame. Must be called while no jobs are running.
+	static void reset();
+
+	// The most memory any single thread used in the frame that was last reset, including anything that went to the heap.
+	// Kept every frame, so the capacity can be tuned without having to overflow it first.
+	static size_t getLastFramePeak();
+	// Whether any thread ran out of its capacity in the frame that was last reset
+	static bool hasLastFrameOverflowed();
+
+	// The most memory any single thread has used in one frame so far
+	static size_t getHighWaterMark();
+	static size_t getCapacityPerThread();
+
+private:
+	static FrameAllocator* m_instance;
+
+	std::vector<LinearAllocator*> m_allocators;
+	size_t m_capacityPerThread;
+
+	size_t m_lastFramePeak;
+	bool m_lastFrameOverflowed;
+};
+
+template<typename T>
+inline T* FrameAllocator::allocate(size_t count)
+{
+	return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+}
+
+// Lets standard containers allocate from the frame allocator. Deallocation does nothing,
+// so containers using it must not outlive the frame they were created in.
+template<typename T>
+class FrameSTLAllocator
+{
+public:
+	typedef T value_type;
+
+	FrameSTLAllocator() noexcept {}
+
+	template<typename U>
+	FrameSTLAllocator(const FrameSTLAllocator<U>&) noexcept {}
+
+	T* allocate(size_t count)
+	{
+		return FrameAllocator::allocate<T>(count);
+	}
+
+	void deallocate(T*, size_t) noexcept {}
+};
+
+template<typename T, typename U>
+inline bool operator==(const FrameSTLAllocator<T>&, const FrameSTLAllocator<U>&)
+{
+	return true;
+}
+
+template<typename T, typename U>
+inline bool operator!=(const FrameSTLAllocator<T>&, const FrameSTLAllocator<U>&)
+{
+	return false;
+}
+
+template<typename T>
+using FrameVector = std::vector<T, FrameSTLAllocator<T>>;
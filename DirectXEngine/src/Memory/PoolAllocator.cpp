@@ -0,0 +1,136 @@
+#include "PoolAllocator.h"
+
+PoolAllocator::PoolAllocator(size_t elementSize, size_t alignment, unsigned int elementsPerBlock)
+{
+	// Every slot has to be able to hold a free list link, and be aligned for both it and the element
+	if (alignment < alignof(FreeSlot)) alignment = alignof(FreeSlot);
+	if (elementSize < sizeof(FreeSlot)) elementSize = sizeof(FreeSlot);
+
+	m_elementSize = (elementSize + alignment - 1) & ~(alignment - 1);
+	m_alignment = alignment;
+	m_elementsPerBlock = elementsPerBlock > 0 ? elementsPerBlock : 1;
+
+	m_blocks = std::vector<void*>();
+	m_freeList = nullptr;
+
+	m_allocatedCount = 0;
+	m_capacity = 0;
+}
+
+PoolAllocator::~PoolAllocator()
+{
+	for (unsigned int i = 0; i < m_blocks.size(); i++)
+	{
+		::operator delete(m_blocks[i], std::align_val_t(m_alignment));
+	}
+	m_blocks.clear();
+}
+
+void* PoolAllocator::allocate()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	if (!m_freeList) allocateBlock(m_elementsPerBlock);
+
+	FreeSlot* slot = m_freeList;
+	m_freeList = slot->next;
+	m_allocatedCount++;
+
+	return slot;
+}
+
+void PoolAllocator::free(void* element)
+{
+	if (!element) return;
+
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	// The most recently freed slot is handed out next, while it's still likely to be in the cache
+	FreeSlot* slot = static_cast<FreeSlot*>(element);
+	slot->next = m_freeList;
+	m_freeList = slot;
+	m_allocatedCount--;
+}
+
+void PoolAllocator::reserve(unsigned int count)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	if (count > m_capacity) allocateBlock(count - m_capacity);
+}
+
+unsigned int PoolAllocator::getAllocatedCount() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_allocatedCount;
+}
+
+unsigned int PoolAllocator::getCapacity() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	return m_capacity;
+}
+
+void PoolAllocator::allocateBlock(unsigned int elementCount)
+{
+	char* block = static_cast<char*>(::operator new(m_elementSize * elementCount, std::align_val_t(m_alignment)));
+	m_blocks.push_back(block);
+
+	// Link the new slots in reverse so they're handed out in address order
+	for (unsigned int i = elementCount; i > 0; i--)
+	{
+		FreeSlot* slot = reinterpret_cast<FreeSlot*>(block + (i - 1) * m_elementSize);
+		slot->next = m_freeList;
+		m_freeList = slot;
+	}
+
+	m_capacity += elementCount;
+}
+
+PoolAllocator* TypePools::find(std::type_index type)
+{
+	std::lock_guard<std::mutex> lock(getMutex());
+	std::unordered_map<std::type_index, PoolAllocator*>& pools = getPools();
+
+	auto it = pools.find(type);
+	if (it == pools.end()) return nullptr;
+
+	return it->second;
+}
+
+void TypePools::release()
+{
+	std::lock_guard<std::mutex> lock(getMutex());
+	std::unordered_map<std::type_index, PoolAllocator*>& pools = getPools();
+
+	for (auto it = pools.begin(); it != pools.end(); it++)
+	{
+		delete it->second;
+	}
+	pools.clear();
+}
+
+PoolAllocator* TypePools::add(std::type_index type, size_t elementSize, size_t alignment)
+{
+	std::lock_guard<std::mutex> lock(getMutex());
+	std::unordered_map<std::type_index, PoolAllocator*>& pools = getPools();
+
+	auto it = pools.find(type);
+	if (it != pools.end()) return it->second;
+
+	PoolAllocator* pool = new PoolAllocator(elementSize, alignment);
+	pools[type] = pool;
+	return pool;
+}
+
+std::unordered_map<std::type_index, PoolAllocator*>& TypePools::getPools()
+{
+	// Constructed on first use so pools can be created during static initialization
+	static std::unordered_map<std::type_index, PoolAllocator*> pools;
+	return pools;
+}
+
+std::mutex& TypePools::getMutex()
+{
+	static std::mutex mutex;
+	return mutex;
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <typeindex>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// How many elements a pool allocates room for each time it runs out of free slots.
+#define POOL_ALLOCATOR_BLOCK_SIZE 256
+
+// Hands out fixed-size slots from blocks of contiguous memory. Freed slots go onto a free list and are reused
+// by the next allocation, so creating and destroying the same kind of object over and over doesn't touch the heap.
+// Blocks are only released when the pool is destroyed, so pointers to allocated slots stay valid.
+// Thread safe, since components can be created and destroyed from update jobs running on any worker.
+class PoolAllocator
+{
+public:
+	PoolAllocator(size_t elementSize, size_t alignment, unsigned int elementsPerBlock = POOL_ALLOCATOR_BLOCK_SIZE);
+	~PoolAllocator();
+
+	void* allocate();
+	void free(void* element);
+
+	// Makes sure at least count elements can be allocated in total without allocating another block.
+	void reserve(unsigned int count);
+
+	unsigned int getAllocatedCount() const;
+	unsigned int getCapacity() const;
+
+private:
+	struct FreeSlot
+	{
+		FreeSlot* next;
+	};
+
+	void allocateBlock(unsigned int elementCount);
+
+	size_t m_elementSize;
+	size_t m_alignment;
+	unsigned int m_elementsPerBlock;
+
+	std::vector<void*> m_blocks;
+	FreeSlot* m_freeList;
+
+	unsigned int m_allocatedCount;
+	unsigned int m_capacity;
+
+	mutable std::mutex m_mutex;
+};
+
+// Keeps one pool per type so objects of the same type are packed next to each other.
+// Pools are created the first time a type is used and live until release is called on shutdown. Thread safe.
+class TypePools
+{
+public:
+	template<typename T>
+	static PoolAllocator& get();
+
+	// Returns nullptr if no object of the given type has been pooled yet.
+	static PoolAllocator* find(std::type_index type);
+
+	// Destroys an object created in its type's pool. For polymorphic types the object's dynamic type decides
+	// which pool it's returned to, so objects can be destroyed through a pointer to their base class.
+	template<typename T>
+	static void destroy(T* object);
+
+	// Frees every pool's memory. Only called on shutdown, once every pooled object has been destroyed.
+	static void release();
+
+private:
+	static PoolAllocator* add(std::type_index type, size_t elementSize, size_t alignment);
+	static std::unordered_map<std::type_index, PoolAllocator*>& getPools();
+	static std::mutex& getMutex();
+};
+
+template<typename T>
+inline PoolAllocator& TypePools::get()
+{
+	// Looked up every time rather than cached, since release deletes every pool
+	return *add(typeid(T), sizeof(T), alignof(T));
+}
+
+template<typename T>
+inline void TypePools::destroy(T* object)
+{
+	if (!object) return;
+
+	PoolAllocator* pool;
+	void* memory;
+
+	if constexpr (std::is_polymorphic<T>::value)
+	{
+		pool = find(typeid(*object));
+		memory = dynamic_cast<void*>(object);
+	}
+	else
+	{
+		pool = find(typeid(T));
+		memory = object;
+	}
+
+	object->~T();
+	pool->free(memory);
+}
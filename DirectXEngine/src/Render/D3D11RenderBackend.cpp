@@ -0,0 +1,173 @@
+#include "D3D11RenderBackend.h"
+
+#include "../Debug/Debug.h"
+
+#include <cstring>
+
+D3D11RenderBackend::D3D11RenderBackend(ID3D11DeviceContext* context)
+{
+	m_context = context;
+
+	m_stateCache = RenderStateCache();
+	memset(&m_stats, 0, sizeof(m_stats));
+}
+
+D3D11RenderBackend::~D3D11RenderBackend()
+{
+	m_context = nullptr;
+}
+
+void D3D11RenderBackend::execute(const RenderCommandBuffer& commands)
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+
+	// The GUI, editor and anything else using the context between frames can change its state behind the cache's back
+	m_stateCache.reset();
+
+	for (size_t i = 0; i < commands.size(); i++)
+	{
+		const RenderCommand& command = commands[i];
+
+		m_stats.commandCounts[command.type]++;
+		m_stats.commandCount++;
+
+		if (!m_stateCache.apply(commands, command))
+		{
+			m_stats.redundantCommands++;
+			continue;
+		}
+
+		executeCommand(commands, command);
+		countExecuted(m_stats, command);
+	}
+}
+
+const RenderBackendStats& D3D11RenderBackend::getStats() const
+{
+	return m_stats;
+}
+
+void D3D11RenderBackend::executeCommand(const RenderCommandBuffer& commands, const RenderCommand& command)
+{
+	switch (command.type)
+	{
+	case RENDERCOMMAND_SET_RENDER_TARGET:
+	{
+		ID3D11RenderTargetView* renderTarget = (ID3D11RenderTargetView*)command.resource;
+		m_context->OMSetRenderTargets(1, &renderTarget, (ID3D11DepthStencilView*)command.secondaryResource);
+		break;
+	}
+	case RENDERCOMMAND_SET_VIEWPORT:
+	{
+		const RenderViewport* source = (const RenderViewport*)commands.getData(command.dataOffset);
+
+		D3D11_VIEWPORT viewport = {};
+		viewport.TopLeftX = source->x;
+		viewport.TopLeftY = source->y;
+		viewport.Width = source->width;
+		viewport.Height = source->height;
+		viewport.MinDepth = source->minDepth;
+		viewport.MaxDepth = source->maxDepth;
+		m_context->RSSetViewports(1, &viewport);
+		break;
+	}
+	case RENDERCOMMAND_CLEAR_RENDER_TARGET:
+		m_context->ClearRenderTargetView((ID3D11RenderTargetView*)command.resource, (const float*)commands.getData(command.dataOffset));
+		break;
+	case RENDERCOMMAND_CLEAR_DEPTH_STENCIL:
+	{
+		float depth = *(const float*)commands.getData(command.dataOffset);
+		m_context->ClearDepthStencilView((ID3D11DepthStencilView*)command.resource, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, depth, (UINT8)command.slot);
+		break;
+	}
+	case RENDERCOMMAND_SET_RASTERIZER_STATE:
+		m_context->RSSetState((ID3D11RasterizerState*)command.resource);
+		break;
+	case RENDERCOMMAND_SET_DEPTH_STENCIL_STATE:
+		m_context->OMSetDepthStencilState((ID3D11DepthStencilState*)command.resource, 0);
+		break;
+	case RENDERCOMMAND_SET_BLEND_STATE:
+		m_context->OMSetBlendState((ID3D11BlendState*)command.resource, nullptr, 0xFFFFFFFF);
+		break;
+	case RENDERCOMMAND_SET_INPUT_LAYOUT:
+		m_context->IASetInputLayout((ID3D11InputLayout*)command.resource);
+		break;
+	case RENDERCOMMAND_SET_SHADER:
+		if (command.stage == SHADERSTAGE_VERTEX) m_context->VSSetShader((ID3D11VertexShader*)command.resource, nullptr, 0);
+		else m_context->PSSetShader((ID3D11PixelShader*)command.resource, nullptr, 0);
+		break;
+	case RENDERCOMMAND_SET_CONSTANT_BUFFER:
+	{
+		ID3D11Buffer* buffer = (ID3D11Buffer*)command.resource;
+		if (command.stage == SHADERSTAGE_VERTEX) m_context->VSSetConstantBuffers(command.slot, 1, &buffer);
+		else m_context->PSSetConstantBuffers(command.slot, 1, &buffer);
+		break;
+	}
+	case RENDERCOMMAND_SET_SHADER_RESOURCES:
+	{
+		if (command.count == 0 || command.slot + command.count > RENDER_MAX_SHADER_RESOURCES)
+		{
+			Debug::warning("Skipped binding an invalid range of shader resources.");
+			m_stats.invalidCommands++;
+			break;
+		}
+
+		const RenderHandle* handles = (const RenderHandle*)commands.getData(command.dataOffset);
+
+		ID3D11ShaderResourceView* views[RENDER_MAX_SHADER_RESOURCES];
+		for (unsigned int i = 0; i < command.count; i++)
+		{
+			views[i] = (ID3D11ShaderResourceView*)handles[i];
+		}
+
+		if (command.stage == SHADERSTAGE_VERTEX) m_context->VSSetShaderResources(command.slot, command.count, views);
+		else m_context->PSSetShaderResources(command.slot, command.count, views);
+		break;
+	}
+	case RENDERCOMMAND_SET_SAMPLER:
+	{
+		ID3D11SamplerState* sampler = (ID3D11SamplerState*)command.resource;
+		if (command.stage == SHADERSTAGE_VERTEX) m_context->VSSetSamplers(command.slot, 1, &sampler);
+		else m_context->PSSetSamplers(command.slot, 1, &sampler);
+		break;
+	}
+	case RENDERCOMMAND_SET_VERTEX_BUFFER:
+	{
+		ID3D11Buffer* buffer = (ID3D11Buffer*)command.resource;
+		m_context->IASetVertexBuffers(command.slot, 1, &buffer, &command.stride, &command.start);
+		break;
+	}
+	case RENDERCOMMAND_SET_INDEX_BUFFER:
+		m_context->IASetIndexBuffer((ID3D11Buffer*)command.resource, DXGI_FORMAT_R32_UINT, 0);
+		break;
+	case RENDERCOMMAND_UPDATE_BUFFER:
+		m_context->UpdateSubresource((ID3D11Buffer*)command.resource, 0, nullptr, commands.getData(command.dataOffset), 0, 0);
+		break;
+	case RENDERCOMMAND_WRITE_BUFFER:
+	{
+		ID3D11Buffer* buffer = (ID3D11Buffer*)command.resource;
+
+		D3D11_MAPPED_SUBRESOURCE mapped = {};
+		HRESULT hr = m_context->Map(buffer, 0, command.discard ? D3D11_MAP_WRITE_DISCARD : D3D11_MAP_WRITE_NO_OVERWRITE, 0, &mapped);
+		if (FAILED(hr))
+		{
+			Debug::error("Failed to map a buffer to write to it.");
+			break;
+		}
+
+		memcpy((unsigned char*)mapped.pData + command.start, commands.getData(command.dataOffset), command.count);
+		m_context->Unmap(buffer, 0);
+		break;
+	}
+	case RENDERCOMMAND_DRAW_INDEXED:
+		m_context->DrawIndexed(command.count, command.start, command.baseVertex);
+		break;
+	case RENDERCOMMAND_DRAW_INDEXED_INSTANCED:
+		m_context->DrawIndexedInstanced(command.count, command.instanceCount, command.start, command.baseVertex, command.firstInstance);
+		break;
+	default:
+		Debug::warning("Skipped a render command of unknown type.");
+		m_stats.invalidCommands++;
+		break;
+	}
+}
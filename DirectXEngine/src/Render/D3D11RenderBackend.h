@@ -0,0 +1,27 @@
+#pragma once
+
+#include "IRenderBackend.h"
+#include "RenderStateCache.h"
+
+#include <d3d11.h>
+
+// Executes render commands on a D3D11 device context. Every handle is the D3D11 interface the command expects.
+// Binds of something that's already bound are dropped before they reach the context.
+class D3D11RenderBackend : public IRenderBackend
+{
+public:
+	D3D11RenderBackend(ID3D11DeviceContext* context);
+	~D3D11RenderBackend();
+
+	void execute(const RenderCommandBuffer& commands) override;
+
+	const RenderBackendStats& getStats() const override;
+
+private:
+	void executeCommand(const RenderCommandBuffer& commands, const RenderCommand& command);
+
+	ID3D11DeviceContext* m_context;
+
+	RenderStateCache m_stateCache;
+	RenderBackendStats m_stats;
+};
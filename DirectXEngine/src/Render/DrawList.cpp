@@ -0,0 +1,163 @@
+#include "DrawList.h"
+
+#include <cstring>
+
+#define DRAWKEY_ID_BITS 12
+#define DRAWKEY_DEPTH_BITS 23
+
+#define DRAWKEY_PASS_SHIFT 60
+#define DRAWKEY_TRANSPARENT_SHIFT 59
+
+DrawList::DrawList()
+{
+	m_items = std::vector<DrawItem>();
+	m_sortBuffer = std::vector<DrawItem>();
+}
+
+uint64_t DrawList::makeOpaqueKey(DrawPass pass, unsigned int shaderID, unsigned int materialID, unsigned int meshID, float depth)
+{
+	const uint64_t idMask = (1 << DRAWKEY_ID_BITS) - 1;
+
+	return ((uint64_t)pass << DRAWKEY_PASS_SHIFT)
+		| ((shaderID & idMask) << 47)
+		| ((materialID & idMask) << 35)
+		| ((meshID & idMask) << 23)
+		| quantizeDepth(depth);
+}
+
+uint64_t DrawList::makeTransparentKey(DrawPass pass, unsigned int shaderID, unsigned int materialID, unsigned int meshID, float depth)
+{
+	const uint64_t idMask = (1 << DRAWKEY_ID_BITS) - 1;
+	const uint64_t depthMask = (1 << DRAWKEY_DEPTH_BITS) - 1;
+
+	// Inverting the depth sorts the furthest draws first
+	uint64_t invertedDepth = ~(uint64_t)quantizeDepth(depth) & depthMask;
+
+	return ((uint64_t)pass << DRAWKEY_PASS_SHIFT)
+		| ((uint64_t)1 << DRAWKEY_TRANSPARENT_SHIFT)
+		| (invertedDepth << 36)
+		| ((shaderID & idMask) << 24)
+		| ((materialID & idMask) << 12)
+		| (meshID & idMask);
+}
+
+DrawPass DrawList::getPass(uint64_t key)
+{
+	return (DrawPass)(key >> DRAWKEY_PASS_SHIFT);
+}
+
+bool DrawList::isTransparent(uint64_t key)
+{
+	return ((key >> DRAWKEY_TRANSPARENT_SHIFT) & 1) != 0;
+}
+
+unsigned int DrawList::quantizeDepth(float depth)
+{
+	// Also catches NaN, since comparisons with it are false
+	if (!(depth > 0.0f)) return 0;
+
+	// The bits of a positive float increase with its value, and its sign bit is 0
+	uint32_t bits;
+	memcpy(&bits, &depth, sizeof(bits));
+
+	return bits >> (31 - DRAWKEY_DEPTH_BITS);
+}
+
+void DrawList::clear()
+{
+	m_items.clear();
+}
+
+void DrawList::reserve(size_t count)
+{
+	m_items.reserve(count);
+}
+
+void DrawList::add(uint64_t key, unsigned int index)
+{
+	DrawItem item;
+	item.key = key;
+	item.index = index;
+
+	m_items.push_back(item);
+}
+
+void DrawList::sort()
+{
+	size_t count = m_items.size();
+	if (count < 2) return;
+
+	// Count every byte of every key in one pass over the items
+	unsigned int histograms[8][256];
+	memset(histograms, 0, sizeof(histograms));
+
+	for (size_t i = 0; i < count; i++)
+	{
+		uint64_t key = m_items[i].key;
+		for (unsigned int digit = 0; digit < 8; digit++)
+		{
+			histograms[digit][(key >> (digit * 8)) & 0xFF]++;
+		}
+	}
+
+	m_sortBuffer.resize(count);
+	DrawItem* source = m_items.data();
+	DrawItem* destination = m_sortBuffer.data();
+
+	for (unsigned int digit = 0; digit < 8; digit++)
+	{
+		unsigned int* histogram = histograms[digit];
+
+		// Every item has the same value for this byte, so this pass wouldn't change the order
+		unsigned int firstKeyByte = (source[0].key >> (digit * 8)) & 0xFF;
+		if (histogram[firstKeyByte] == count) continue;
+
+		// Turn the counts into the offset each byte value starts at
+		unsigned int offset = 0;
+		for (unsigned int i = 0; i < 256; i++)
+		{
+			unsigned int bucketCount = histogram[i];
+			histogram[i] = offset;
+			offset += bucketCount;
+		}
+
+		for (size_t i = 0; i < count; i++)
+		{
+			unsigned int keyByte = (source[i].key >> (digit * 8)) & 0xFF;
+			destination[histogram[keyByte]++] = source[i];
+		}
+
+		DrawItem* swap = source;
+		source = destination;
+		destination = swap;
+	}
+
+	// An odd number of passes leaves the sorted items in the sort buffer
+	if (source != m_items.data())
+		m_items.swap(m_sortBuffer);
+}
+
+const DrawItem* DrawList::begin() const
+{
+	return m_items.data();
+}
+
+const DrawItem* DrawList::end() const
+{
+	return m_items.data() + m_items.size();
+}
+
+const DrawItem& DrawList::operator[](size_t index) const
+{
+	return m_items[index];
+}
+
+size_t DrawList::size() const
+{
+	return m_items.size();
+}
+
+bool DrawList::empty() const
+{
+	return m_items.empty();
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Passes are the most significant part of a draw key, so every draw of one pass is submitted before the next pass.
+enum DrawPass
+{
+	DRAWPASS_SHADOW,
+	DRAWPASS_MAIN,
+	DRAWPASS_COUNT
+};
+
+// One draw to submit: a sort key, and the index of the object it draws in whatever list the draws were built from.
+struct DrawItem
+{
+	uint64_t key;
+	unsigned int index;
+};
+
+// Draws are collected with a 64 bit key each and radix sorted before they're submitted, so draws that share state
+// end up next to each other and the state only has to be bound once for all of them.
+// From the most significant bit down, opaque keys are:
+//   pass (4) | transparent (1) | shader (12) | material (12) | mesh (12) | depth (23), nearest first
+// and transparent keys sort by depth ahead of state, since they have to be drawn in order:
+//   pass (4) | transparent (1) | depth (23), furthest first | shader (12) | material (12) | mesh (12)
+class DrawList
+{
+public:
+	DrawList();
+
+	// IDs only need to be unique within their 12 bits. Two IDs that collide sort together, which only costs a rebind.
+	static uint64_t makeOpaqueKey(DrawPass pass, unsigned int shaderID, unsigned int materialID, unsigned int meshID, float depth);
+	static uint64_t makeTransparentKey(DrawPass pass, unsigned int shaderID, unsigned int materialID, unsigned int meshID, float depth);
+
+	static DrawPass getPass(uint64_t key);
+	static bool isTransparent(uint64_t key);
+
+	// Keeps the top 23 bits of a non-negative float, which still order the same way as the float itself.
+	static unsigned int quantizeDepth(float depth);
+
+	void clear();
+	void reserve(size_t count);
+	void add(uint64_t key, unsigned int index);
+
+	// Stable least significant digit radix sort by key, a byte at a time. Bytes that are the same for every item are skipped.
+	void sort();
+
+	const DrawItem* begin() const;
+	const DrawItem* end() const;
+	const DrawItem& operator[](size_t index) const;
+	size_t size() const;
+	bool empty() const;
+
+private:
+	std::vector<DrawItem> m_items;
+
+	// The other half of the radix sort's ping-pong, kept around to avoid allocating each sort
+	std::vector<DrawItem> m_sortBuffer;
+};
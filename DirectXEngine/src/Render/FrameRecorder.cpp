@@ -0,0 +1,627 @@
+#include "FrameRecorder.h"
+
+#include <DirectXColors.h>
+#include <cfloat>
+#include <cstring>
+
+using namespace DirectX;
+
+FrameRecorder::FrameRecorder(ParallelForFunction parallelFor)
+{
+	m_resources = {};
+
+	m_shaders = nullptr;
+	m_commands = nullptr;
+
+	m_shadowAtlas = ShadowAtlas();
+	m_lightClusters = LightClusterGrid(parallelFor);
+
+	m_instanceBufferOffset = INSTANCE_BUFFER_CAPACITY;
+
+	m_droppedLightCount = 0;
+	m_rejectedProjection = false;
+}
+
+void FrameRecorder::setResources(const FrameResources& resources)
+{
+	m_resources = resources;
+}
+
+void FrameRecorder::record(const RenderSnapshot& snapshot, RenderHandle backBufferRTV, RenderHandle backBufferDSV, float width, float height,
+	IShaderBinder& shaders, RenderCommandBuffer& commands)
+{
+	m_shaders = &shaders;
+	m_commands = &commands;
+
+	// Only draw what the camera can actually see. Shadow passes use this too, to skip casters that can't shadow anything visible.
+	XMFLOAT4X4 viewProjection;
+	XMStoreFloat4x4(&viewProjection, XMMatrixMultiply(XMLoadFloat4x4(&snapshot.view.viewMatrix), XMLoadFloat4x4(&snapshot.view.projectionMatrix)));
+
+	Frustum viewFrustum = Frustum::fromViewProjection(viewProjection);
+
+	m_visibleObjects.clear();
+	cullObjects(snapshot, viewFrustum, 0, m_visibleObjects);
+
+	unsigned int lightCount = snapshot.lights.size() < MAX_LIGHTS ? (unsigned int)snapshot.lights.size() : MAX_LIGHTS;
+	m_droppedLightCount = (unsigned int)snapshot.lights.size() - lightCount;
+
+	// Point and spot lights are bounded by spheres, used both to size their shadow tiles and to bin them into clusters
+	m_allLightBounds.resize(lightCount);
+	for (unsigned int i = 0; i < lightCount; i++)
+	{
+		const RenderLight& light = snapshot.lights[i];
+		if (light.type == SPOT_LIGHT)
+		{
+			m_allLightBounds[i] = LightClusterGrid::getSpotLightBounds(light.position, light.direction, light.settings.radius, light.settings.spotAngle);
+		}
+		else
+		{
+			m_allLightBounds[i].center = light.position;
+			m_allLightBounds[i].radius = light.settings.radius;
+		}
+	}
+
+	recordShadows(snapshot, viewFrustum, lightCount);
+
+	ClusteredLighting lighting;
+	recordLights(snapshot, lightCount, width, height, lighting);
+
+	prepareMainPass(backBufferRTV, backBufferDSV, width, height);
+	renderMainPass(snapshot, lighting);
+
+	m_shaders = nullptr;
+	m_commands = nullptr;
+}
+
+unsigned int FrameRecorder::getDroppedLightCount() const
+{
+	return m_droppedLightCount;
+}
+
+bool FrameRecorder::hasRejectedProjection() const
+{
+	return m_rejectedProjection;
+}
+
+bool FrameRecorder::hasClusterOverflow() const
+{
+	return m_lightClusters.hasOverflowed();
+}
+
+void FrameRecorder::recordShadows(const RenderSnapshot& snapshot, const Frustum& viewFrustum, unsigned int lightCount)
+{
+	// Each shadow casting light that can reach the screen asks for an atlas tile sized by how much of the screen it covers.
+	// Directional lights cover all of it.
+	m_shadowedLights.clear();
+	m_tileSizes.clear();
+	for (unsigned int i = 0; i < lightCount && m_shadowedLights.size() < MAX_SHADOWED_LIGHTS; i++)
+	{
+		const RenderLight& light = snapshot.lights[i];
+		if (!light.castsShadows) continue;
+
+		float coverage = 1.0f;
+		if (light.type != DIRECTIONAL_LIGHT)
+		{
+			if (!viewFrustum.intersectsSphere(m_allLightBounds[i].center, m_allLightBounds[i].radius)) continue;
+
+			coverage = ShadowAtlas::getScreenCoverage(m_allLightBounds[i].center, m_allLightBounds[i].radius, snapshot.view.viewMatrix, snapshot.view.projectionMatrix);
+		}
+
+		unsigned int maxTileSize = light.shadowMapSize ? light.shadowMapSize : SHADOW_ATLAS_DEFAULT_TILE_SIZE;
+
+		m_shadowedLights.push_back(i);
+		m_tileSizes.push_back(m_shadowAtlas.selectTileSize(coverage, maxTileSize));
+	}
+
+	m_tiles.resize(m_shadowedLights.size());
+	m_shadowAtlas.pack(m_tileSizes.data(), (unsigned int)m_shadowedLights.size(), m_tiles.data());
+
+	// Render each shadowed light into its tile. Lights that didn't get one are left unshadowed.
+	m_shadowData.clear();
+	m_shadowMapIndices.assign(lightCount, -1);
+
+	if (!m_shadowedLights.empty())
+	{
+		prepareShadowAtlasPass();
+	}
+
+	float atlasSize = (float)m_shadowAtlas.getSize();
+	for (unsigned int j = 0; j < m_shadowedLights.size(); j++)
+	{
+		const ShadowAtlasTile& tile = m_tiles[j];
+		if (tile.size == 0) continue;
+
+		const RenderLight& light = snapshot.lights[m_shadowedLights[j]];
+		renderShadowMapPass(snapshot, light, tile);
+
+		XMFLOAT4X4 tileMatrix = m_shadowAtlas.getTileMatrix(tile);
+		XMMATRIX atlasMatrix = XMLoadFloat4x4(&light.viewMatrix) * XMLoadFloat4x4(&light.projectionMatrix) * XMLoadFloat4x4(&tileMatrix);
+
+		// Filtering is clamped half a texel inside the tile so it never picks up a neighbour's depths
+		GPU_LIGHT_SHADOW_DATA data;
+		XMStoreFloat4x4(&data.atlasMatrix, XMMatrixTranspose(atlasMatrix));
+		data.tileMin = XMFLOAT2((tile.x + 0.5f) / atlasSize, (tile.y + 0.5f) / atlasSize);
+		data.tileMax = XMFLOAT2((tile.x + tile.size - 0.5f) / atlasSize, (tile.y + tile.size - 0.5f) / atlasSize);
+
+		m_shadowMapIndices[m_shadowedLights[j]] = (int)m_shadowData.size();
+		m_shadowData.push_back(data);
+	}
+
+	if (!m_shadowData.empty())
+	{
+		void* shadows = m_commands->writeBuffer(m_resources.lightShadowBuffer, 0, (unsigned int)(m_shadowData.size() * sizeof(GPU_LIGHT_SHADOW_DATA)), true);
+		memcpy(shadows, m_shadowData.data(), m_shadowData.size() * sizeof(GPU_LIGHT_SHADOW_DATA));
+	}
+}
+
+void FrameRecorder::recordLights(const RenderSnapshot& snapshot, unsigned int lightCount, float width, float height, ClusteredLighting& lighting)
+{
+	// Directional lights reach every pixel, so they go first and are shaded everywhere.
+	// Point and spot lights follow, and are binned into the clusters their bounds touch.
+	m_lightData.clear();
+	for (unsigned int i = 0; i < lightCount; i++)
+	{
+		if (snapshot.lights[i].type == DIRECTIONAL_LIGHT)
+			m_lightData.push_back(packLight(snapshot.lights[i], m_shadowMapIndices[i]));
+	}
+
+	lighting.cameraPosition = snapshot.view.position;
+	lighting.directionalLightCount = (unsigned int)m_lightData.size();
+
+	m_lightBounds.clear();
+	for (unsigned int i = 0; i < lightCount; i++)
+	{
+		const RenderLight& light = snapshot.lights[i];
+		if (light.type == DIRECTIONAL_LIGHT) continue;
+
+		m_lightData.push_back(packLight(light, m_shadowMapIndices[i]));
+		m_lightBounds.push_back(m_allLightBounds[i]);
+	}
+
+	m_rejectedProjection = !m_lightClusters.setProjection(snapshot.view.projectionMatrix);
+	m_lightClusters.assignLights(snapshot.view.viewMatrix, m_lightBounds.data(), (unsigned int)m_lightBounds.size());
+
+	if (!m_lightData.empty())
+	{
+		void* lights = m_commands->writeBuffer(m_resources.lightBuffer, 0, (unsigned int)(m_lightData.size() * sizeof(GPU_LIGHT_DATA)), true);
+		memcpy(lights, m_lightData.data(), m_lightData.size() * sizeof(GPU_LIGHT_DATA));
+	}
+
+	const std::vector<LightClusterRange>& clusterRanges = m_lightClusters.getClusterRanges();
+	void* ranges = m_commands->writeBuffer(m_resources.clusterRangeBuffer, 0, (unsigned int)(clusterRanges.size() * sizeof(LightClusterRange)), true);
+	memcpy(ranges, clusterRanges.data(), clusterRanges.size() * sizeof(LightClusterRange));
+
+	const std::vector<unsigned int>& clusterIndices = m_lightClusters.getLightIndices();
+	if (!clusterIndices.empty())
+	{
+		void* indices = m_commands->writeBuffer(m_resources.clusterIndexBuffer, 0, (unsigned int)(clusterIndices.size() * sizeof(unsigned int)), true);
+		memcpy(indices, clusterIndices.data(), clusterIndices.size() * sizeof(unsigned int));
+	}
+
+	// A pixel's view depth is its distance along the view matrix's z column
+	const XMFLOAT4X4& view = snapshot.view.viewMatrix;
+	lighting.viewDepthPlane = XMFLOAT4(view._13, view._23, view._33, view._43);
+	lighting.tileScale = XMFLOAT2(LIGHT_CLUSTER_TILES_X / width, LIGHT_CLUSTER_TILES_Y / height);
+	lighting.depthScale = m_lightClusters.getDepthScale();
+	lighting.depthBias = m_lightClusters.getDepthBias();
+}
+
+void FrameRecorder::prepareShadowAtlasPass()
+{
+	m_commands->clearDepthStencil(m_resources.shadowAtlasDSV, 1.0f, 0);
+
+	m_commands->setRasterizerState(m_resources.shadowMapRasterizerState);
+
+	m_commands->setRenderTarget(nullptr, m_resources.shadowAtlasDSV);
+
+	m_shaders->useVertexShader(m_resources.shadowVertexShader);
+	m_commands->setShader(SHADERSTAGE_PIXEL, nullptr);
+}
+
+void FrameRecorder::renderShadowMapPass(const RenderSnapshot& snapshot, const RenderLight& light, const ShadowAtlasTile& tile)
+{
+	// The viewport keeps the light's draws inside its own tile of the atlas
+	RenderViewport viewport = {};
+	viewport.x = (float)tile.x;
+	viewport.y = (float)tile.y;
+	viewport.minDepth = 0;
+	viewport.maxDepth = 1;
+	viewport.width = (float)tile.size;
+	viewport.height = (float)tile.size;
+	m_commands->setViewport(viewport);
+
+	m_casters.clear();
+	cullShadowCasters(snapshot, light, m_visibleObjects, m_casters);
+
+	XMMATRIX lightView = XMLoadFloat4x4(&light.viewMatrix);
+
+	// Every caster uses the same shader, so sort them by mesh to share vertex and index buffers, then nearest first
+	m_drawList.clear();
+	for (unsigned int i = 0; i < m_casters.size(); i++)
+	{
+		const RenderObject& object = snapshot.objects[m_casters[i]];
+		float depth = XMVectorGetZ(XMVector3Transform(XMLoadFloat3(&object.boundsCenter), lightView));
+
+		m_drawList.add(DrawList::makeOpaqueKey(DRAWPASS_SHADOW, 0, 0, object.mesh.id, depth), m_casters[i]);
+	}
+	m_drawList.sort();
+
+	XMFLOAT4X4 viewT;
+	XMStoreFloat4x4(&viewT, XMMatrixTranspose(lightView));
+
+	XMFLOAT4X4 projT;
+	XMStoreFloat4x4(&projT, XMMatrixTranspose(XMLoadFloat4x4(&light.projectionMatrix)));
+
+	m_shaders->setViewConstants(m_resources.shadowVertexShader, viewT, projT, true);
+
+	unsigned int currentMesh = 0;
+
+	for (unsigned int i = 0; i < m_drawList.size(); i++)
+	{
+		const RenderObject& object = snapshot.objects[m_drawList[i].index];
+
+		XMFLOAT4X4 worldT;
+		XMStoreFloat4x4(&worldT, XMMatrixTranspose(XMLoadFloat4x4(&object.worldMatrix)));
+
+		m_shaders->setObjectConstants(m_resources.shadowVertexShader, worldT, object.worldInverseMatrix);
+
+		if (i == 0 || object.mesh.id != currentMesh)
+		{
+			bindMesh(object.mesh);
+			currentMesh = object.mesh.id;
+		}
+
+		m_commands->drawIndexed(object.mesh.indexCount, 0, 0);
+	}
+}
+
+void FrameRecorder::prepareMainPass(RenderHandle backBufferRTV, RenderHandle backBufferDSV, float width, float height)
+{
+	m_commands->setRenderTarget(backBufferRTV, backBufferDSV);
+
+	m_commands->clearRenderTarget(backBufferRTV, Colors::CornflowerBlue);
+	m_commands->clearDepthStencil(backBufferDSV, 1.0f, 0);
+
+	m_commands->setRasterizerState(nullptr);
+
+	RenderViewport viewport = {};
+	viewport.x = viewport.y = 0;
+	viewport.minDepth = 0;
+	viewport.maxDepth = 1;
+	viewport.width = width;
+	viewport.height = height;
+	m_commands->setViewport(viewport);
+}
+
+void FrameRecorder::renderMainPass(const RenderSnapshot& snapshot, const ClusteredLighting& lighting)
+{
+	XMMATRIX view = XMLoadFloat4x4(&snapshot.view.viewMatrix);
+
+	XMFLOAT4X4 viewT;
+	XMStoreFloat4x4(&viewT, XMMatrixTranspose(view));
+
+	XMFLOAT4X4 projT;
+	XMStoreFloat4x4(&projT, XMMatrixTranspose(XMLoadFloat4x4(&snapshot.view.projectionMatrix)));
+
+	// Sort the visible objects so ones that share shaders, materials and meshes are drawn together.
+	// Wireframes blend their faces with what's behind them, so they're drawn after everything else, furthest first.
+	m_drawList.clear();
+	for (unsigned int i = 0; i < m_visibleObjects.size(); i++)
+	{
+		const RenderObject& object = snapshot.objects[m_visibleObjects[i]];
+
+		const RenderMaterial& material = object.material;
+		if (!material.material) continue;
+
+		unsigned int shaderID = ((material.vertexShaderID & 0x3F) << 6) | (material.pixelShaderID & 0x3F);
+		float depth = XMVectorGetZ(XMVector3Transform(XMLoadFloat3(&object.boundsCenter), view));
+
+		bool transparent = object.renderStyle == WIREFRAME && !(object.flags & RENDEROBJECT_SELECTED);
+		uint64_t key = transparent
+			? DrawList::makeTransparentKey(DRAWPASS_MAIN, shaderID, material.id, object.mesh.id, depth)
+			: DrawList::makeOpaqueKey(DRAWPASS_MAIN, shaderID, material.id, object.mesh.id, depth);
+
+		m_drawList.add(key, m_visibleObjects[i]);
+	}
+	m_drawList.sort();
+
+	// Runs of draws that only differ by their world matrix are drawn with one instanced call.
+	// Only the instanceable vertex shader has an instanced variant that reads world matrices from the instance buffer.
+	m_instanceStates.resize(m_drawList.size());
+	for (unsigned int i = 0; i < m_drawList.size(); i++)
+	{
+		const RenderObject& object = snapshot.objects[m_drawList[i].index];
+
+		InstanceDrawState& state = m_instanceStates[i];
+		state.meshID = object.mesh.id;
+		state.materialID = object.material.id;
+		state.instanceable = object.material.vertexShader == m_resources.instanceableVertexShader;
+		state.selected = (object.flags & RENDEROBJECT_SELECTED) != 0;
+		state.wireframe = object.renderStyle != SOLID;
+		state.wireframeColor[0] = object.wireframeColor.x;
+		state.wireframeColor[1] = object.wireframeColor.y;
+		state.wireframeColor[2] = object.wireframeColor.z;
+		state.wireframeColor[3] = object.wireframeColor.w;
+	}
+
+	m_instanceBatches.clear();
+	InstanceBatcher::buildBatches(m_drawList, m_instanceStates.data(), INSTANCE_BUFFER_CAPACITY, m_instanceBatches);
+	const std::vector<InstanceBatch>& batches = m_instanceBatches;
+
+	m_commands->setVertexBuffer(1, m_resources.instanceBuffer, sizeof(GPU_INSTANCE_DATA), 0);
+
+	// Only rebind what changed since the previous draw
+	const RenderMaterial* currentMaterial = nullptr;
+	RenderHandle currentVertexShader = nullptr;
+	RenderHandle preparedVertexShader = nullptr;
+	RenderHandle currentPixelShader = nullptr;
+	unsigned int currentMesh = 0;
+	bool meshBound = false;
+	bool instancedShaderPrepared = false;
+	bool blending = false;
+
+	for (unsigned int i = 0; i < batches.size(); i++)
+	{
+		const InstanceBatch& batch = batches[i];
+		const DrawItem& item = m_drawList[batch.firstItem];
+		const RenderObject& object = snapshot.objects[item.index];
+
+		bool instanced = batch.count > 1;
+
+		if (!blending && DrawList::isTransparent(item.key))
+		{
+			m_commands->setBlendState(m_resources.transparentBlendState);
+			m_commands->setDepthStencilState(m_resources.depthStencilStateReadOnly);
+			blending = true;
+		}
+
+		if (!currentMaterial || object.material.id != currentMaterial->id)
+		{
+			m_shaders->useMaterial(object.material.material);
+			currentMaterial = &object.material;
+			currentVertexShader = currentMaterial->vertexShader;
+
+			// Each pixel shader keeps its own constant buffers, so the frame's lighting only needs uploading once per shader
+			if (currentMaterial->pixelShader != currentPixelShader)
+			{
+				m_shaders->setLightingConstants(currentMaterial->pixelShader, lighting);
+				currentPixelShader = currentMaterial->pixelShader;
+			}
+		}
+
+		if (instanced)
+		{
+			if (currentVertexShader != m_resources.instancedVertexShader)
+			{
+				m_shaders->useVertexShader(m_resources.instancedVertexShader);
+				currentVertexShader = m_resources.instancedVertexShader;
+			}
+
+			// The instanced shader only has per-frame constants
+			if (!instancedShaderPrepared)
+			{
+				m_shaders->setViewConstants(m_resources.instancedVertexShader, viewT, projT, false);
+				instancedShaderPrepared = true;
+			}
+		}
+		else
+		{
+			RenderHandle vertexShader = currentMaterial->vertexShader;
+			if (currentVertexShader != vertexShader)
+			{
+				m_shaders->useVertexShader(vertexShader);
+				currentVertexShader = vertexShader;
+			}
+
+			if (vertexShader != preparedVertexShader)
+			{
+				m_shaders->setViewConstants(vertexShader, viewT, projT, false);
+				preparedVertexShader = vertexShader;
+			}
+
+			XMFLOAT4X4 worldT;
+			XMStoreFloat4x4(&worldT, XMMatrixTranspose(XMLoadFloat4x4(&object.worldMatrix)));
+
+			m_shaders->setObjectConstants(vertexShader, worldT, object.worldInverseMatrix);
+		}
+
+		// Every object in a batch shares its render style, so the first one's is used for all of them
+		if (object.flags & RENDEROBJECT_SELECTED)
+			m_shaders->setStyleConstants(currentPixelShader, SOLID_WIREFRAME, XMFLOAT4(1.0f, 1.0f, 0.0f, 1.0f));
+		else
+			m_shaders->setStyleConstants(currentPixelShader, object.renderStyle, object.wireframeColor);
+
+		if (!meshBound || object.mesh.id != currentMesh)
+		{
+			bindMesh(object.mesh);
+			currentMesh = object.mesh.id;
+			meshBound = true;
+		}
+
+		if (instanced)
+		{
+			unsigned int firstInstance = writeInstances(batch, snapshot);
+			m_commands->drawIndexedInstanced(object.mesh.indexCount, batch.count, 0, 0, firstInstance);
+			continue;
+		}
+
+		m_commands->drawIndexed(object.mesh.indexCount, 0, 0);
+	}
+
+	if (blending)
+	{
+		m_commands->setBlendState(nullptr);
+		m_commands->setDepthStencilState(m_resources.depthStencilStateDefault);
+	}
+
+	if (currentPixelShader)
+	{
+		m_shaders->unbindShadowAtlas(currentPixelShader);
+	}
+
+	// Collision meshes, only extracted in the editor
+	const RenderMaterial& debugMaterial = m_resources.debugMaterial;
+	for (unsigned int i = 0; i < snapshot.debugShapes.size(); i++)
+	{
+		const RenderDebugShape& shape = snapshot.debugShapes[i];
+
+		m_shaders->useMaterial(debugMaterial.material);
+		m_commands->setRasterizerState(m_resources.wireframeRasterizerState);
+
+		XMMATRIX shapeWorld = XMLoadFloat4x4(&shape.worldMatrix);
+
+		XMFLOAT4X4 shapeWorldT;
+		XMStoreFloat4x4(&shapeWorldT, XMMatrixTranspose(shapeWorld));
+
+		XMFLOAT4X4 shapeWorldInverse;
+		XMStoreFloat4x4(&shapeWorldInverse, XMMatrixInverse(nullptr, shapeWorld));
+
+		m_shaders->setViewConstants(debugMaterial.vertexShader, viewT, projT, false);
+		m_shaders->setObjectConstants(debugMaterial.vertexShader, shapeWorldT, shapeWorldInverse);
+
+		bindMesh(shape.mesh);
+
+		m_commands->drawIndexed(shape.mesh.indexCount, 0, 0);
+
+		m_commands->setRasterizerState(nullptr);
+	}
+}
+
+void FrameRecorder::bindMesh(const RenderMesh& mesh)
+{
+	m_commands->setVertexBuffer(0, mesh.vertexBuffer, mesh.vertexStride, 0);
+	m_commands->setIndexBuffer(mesh.indexBuffer);
+}
+
+unsigned int FrameRecorder::writeInstances(const InstanceBatch& batch, const RenderSnapshot& snapshot)
+{
+	// Batches are appended to the instance buffer without waiting on the draws still reading it, until it runs out.
+	// Then it's discarded, and the driver hands back fresh memory while the GPU finishes with the old contents.
+	bool discard = false;
+	if (m_instanceBufferOffset + batch.count > INSTANCE_BUFFER_CAPACITY)
+	{
+		discard = true;
+		m_instanceBufferOffset = 0;
+	}
+
+	unsigned int firstInstance = m_instanceBufferOffset;
+
+	GPU_INSTANCE_DATA* instances = (GPU_INSTANCE_DATA*)m_commands->writeBuffer(m_resources.instanceBuffer, firstInstance * sizeof(GPU_INSTANCE_DATA), batch.count * sizeof(GPU_INSTANCE_DATA), discard);
+	for (unsigned int i = 0; i < batch.count; i++)
+	{
+		const RenderObject& object = snapshot.objects[m_drawList[batch.firstItem + i].index];
+
+		instances[i].world = object.worldMatrix;
+		XMStoreFloat4x4(&instances[i].worldInverseTranspose, XMMatrixTranspose(XMLoadFloat4x4(&object.worldInverseMatrix)));
+	}
+
+	m_instanceBufferOffset += batch.count;
+	return firstInstance;
+}
+
+GPU_LIGHT_DATA FrameRecorder::packLight(const RenderLight& light, int shadowMapIndex)
+{
+	// Creates the final memory-aligned struct that is sent to the GPU
+	GPU_LIGHT_DATA data =
+	{
+		light.settings.color,
+		light.direction,
+		light.settings.brightness,
+		light.position,
+		light.settings.specularity,
+		light.settings.radius,
+		light.settings.spotAngle,
+		1,
+		(int)light.type,
+		shadowMapIndex >= 0 ? 1 : 0,
+		(int)light.shadowType,
+		shadowMapIndex,
+		0.0f
+	};
+
+	return data;
+}
+
+void FrameRecorder::cullObjects(const RenderSnapshot& snapshot, const Frustum& frustum, unsigned int requiredFlags, std::vector<unsigned int>& visibleObjects)
+{
+	unsigned int objectCount = (unsigned int)snapshot.objects.size();
+
+	XMFLOAT3 centers[4];
+	XMFLOAT3 extents[4];
+	float radii[4];
+
+	for (unsigned int start = 0; start < objectCount; start += 4)
+	{
+		unsigned int batchCount = objectCount - start < 4 ? objectCount - start : 4;
+
+		// A partial batch at the end is padded out by repeating its last object
+		for (unsigned int i = 0; i < 4; i++)
+		{
+			const RenderObject& object = snapshot.objects[start + (i < batchCount ? i : batchCount - 1)];
+			centers[i] = object.boundsCenter;
+			extents[i] = object.boundsExtents;
+			radii[i] = object.boundsRadius;
+		}
+
+		unsigned int visibleMask = frustum.testBoundsBatch(centers, extents, radii);
+		for (unsigned int i = 0; i < batchCount; i++)
+		{
+			if ((visibleMask & (1 << i)) && (snapshot.objects[start + i].flags & requiredFlags) == requiredFlags)
+				visibleObjects.push_back(start + i);
+		}
+	}
+}
+
+void FrameRecorder::cullShadowCasters(const RenderSnapshot& snapshot, const RenderLight& light, const std::vector<unsigned int>& visibleObjects, std::vector<unsigned int>& casters)
+{
+	if (light.type != DIRECTIONAL_LIGHT)
+	{
+		XMFLOAT4X4 lightViewProjection;
+		XMStoreFloat4x4(&lightViewProjection, XMMatrixMultiply(XMLoadFloat4x4(&light.viewMatrix), XMLoadFloat4x4(&light.projectionMatrix)));
+
+		cullObjects(snapshot, Frustum::fromViewProjection(lightViewProjection), RENDEROBJECT_CAST_SHADOWS, casters);
+		return;
+	}
+
+	// A directional light's orthographic view volume is a box in light space. Only the part of it across the light
+	// from the visible receivers, and between the light and the furthest of them, can cast a shadow anyone will see.
+	XMMATRIX inverseProjection = XMMatrixInverse(nullptr, XMLoadFloat4x4(&light.projectionMatrix));
+	XMVECTOR lightMin = XMVector3TransformCoord(XMVectorSet(-1.0f, -1.0f, 0.0f, 1.0f), inverseProjection);
+	XMVECTOR lightMax = XMVector3TransformCoord(XMVectorSet(1.0f, 1.0f, 1.0f, 1.0f), inverseProjection);
+
+	XMVECTOR receiverMin = XMVectorReplicate(FLT_MAX);
+	XMVECTOR receiverMax = XMVectorReplicate(-FLT_MAX);
+	bool hasReceivers = false;
+
+	for (unsigned int i = 0; i < visibleObjects.size(); i++)
+	{
+		const RenderObject& object = snapshot.objects[visibleObjects[i]];
+		if (!(object.flags & RENDEROBJECT_RECEIVE_SHADOWS)) continue;
+
+		XMFLOAT3 center;
+		XMFLOAT3 extents;
+		RenderSnapshot::transformBounds(object.boundsCenter, object.boundsExtents, light.viewMatrix, center, extents);
+
+		XMVECTOR centerVec = XMLoadFloat3(&center);
+		XMVECTOR extentsVec = XMLoadFloat3(&extents);
+		receiverMin = XMVectorMin(receiverMin, XMVectorSubtract(centerVec, extentsVec));
+		receiverMax = XMVectorMax(receiverMax, XMVectorAdd(centerVec, extentsVec));
+		hasReceivers = true;
+	}
+
+	if (!hasReceivers) return;
+
+	// The volume reaches all the way back to the light's near plane, since casters in front of the receivers still shadow them
+	XMVECTOR casterMin = XMVectorSelect(XMVectorMax(lightMin, receiverMin), lightMin, XMVectorSelectControl(0, 0, 1, 0));
+	XMVECTOR casterMax = XMVectorMin(lightMax, receiverMax);
+
+	// None of the visible receivers are inside the light's view volume
+	if (!XMVector3LessOrEqual(casterMin, casterMax)) return;
+
+	XMFLOAT3 casterBoundsMin;
+	XMFLOAT3 casterBoundsMax;
+	XMStoreFloat3(&casterBoundsMin, casterMin);
+	XMStoreFloat3(&casterBoundsMax, casterMax);
+
+	cullObjects(snapshot, Frustum::fromBox(casterBoundsMin, casterBoundsMax, light.viewMatrix), RENDEROBJECT_CAST_SHADOWS, casters);
+}
@@ -0,0 +1,167 @@
+#pragma once
+
+#include "DrawList.h"
+#include "IShaderBinder.h"
+#include "InstanceBatcher.h"
+#include "LightClusterGrid.h"
+#include "RenderCommandBuffer.h"
+#include "RenderSnapshot.h"
+#include "ShadowAtlas.h"
+#include "../Scene/Frustum.h"
+
+#include <DirectXMath.h>
+#include <vector>
+
+// How many lights the light buffer holds. Each pixel only shades the ones in its cluster, so this can be much higher than
+// the number that touch any one pixel.
+#define MAX_LIGHTS 1024
+// How many lights can have a tile in the shadow atlas each frame. The atlas holds this many of the smallest tiles.
+#define MAX_SHADOWED_LIGHTS ((SHADOW_ATLAS_SIZE / SHADOW_ATLAS_MIN_TILE_SIZE) * (SHADOW_ATLAS_SIZE / SHADOW_ATLAS_MIN_TILE_SIZE))
+
+// How many instances the streamed instance buffer holds, which is also the most a single instanced draw can have
+#define INSTANCE_BUFFER_CAPACITY 4096
+
+// The struct that should match the light data in the shaders.
+// Shader bools are four bytes wide, so they're ints here to keep the light buffer's layout the same.
+struct GPU_LIGHT_DATA
+{
+	DirectX::XMFLOAT4 color;
+	DirectX::XMFLOAT3 direction;
+	float brightness;
+	DirectX::XMFLOAT3 position;
+	float specularity;
+	float radius;
+	float spotAngle;
+	int enabled;
+	int type;
+	int shadowMapEnabled;
+	int shadowType;
+	int shadowMapIndex;
+	float padding;
+};
+
+// Where a light's shadow map is in the atlas, matching the light shadow data in the pixel shader.
+// The matrix takes world space straight to the atlas, and samples are clamped to the tile's texel centers.
+struct GPU_LIGHT_SHADOW_DATA
+{
+	DirectX::XMFLOAT4X4 atlasMatrix;
+	DirectX::XMFLOAT2 tileMin;
+	DirectX::XMFLOAT2 tileMax;
+};
+
+// The per-instance data the instanced vertex shader reads from its second vertex buffer.
+// Unlike constant buffers, these are read row by row, so the matrices are stored untransposed.
+struct GPU_INSTANCE_DATA
+{
+	DirectX::XMFLOAT4X4 world;
+	DirectX::XMFLOAT4X4 worldInverseTranspose;
+};
+
+// Everything on the device a frame is recorded against. The renderer creates these, the recorder only passes them on.
+struct FrameResources
+{
+	RenderHandle shadowAtlasDSV;
+
+	RenderHandle shadowMapRasterizerState;
+	RenderHandle wireframeRasterizerState;
+	RenderHandle depthStencilStateDefault;
+	RenderHandle depthStencilStateReadOnly;
+	RenderHandle transparentBlendState;
+
+	// Dynamic buffers rewritten every frame, sized by the limits above
+	RenderHandle instanceBuffer;
+	RenderHandle lightBuffer;
+	RenderHandle lightShadowBuffer;
+	RenderHandle clusterRangeBuffer;
+	RenderHandle clusterIndexBuffer;
+
+	// Shadow maps are drawn with the shadow vertex shader alone. Runs of draws using the instanceable vertex shader
+	// are drawn with the instanced one instead, since it's the only instanced variant there is.
+	RenderHandle shadowVertexShader;
+	RenderHandle instanceableVertexShader;
+	RenderHandle instancedVertexShader;
+
+	// Collision meshes are drawn as wireframes with this
+	RenderMaterial debugMaterial;
+};
+
+// Records the commands that draw a render snapshot: culls it, packs the frame's lights and shadow atlas, bins lights
+// into clusters, and sorts and batches the draws. Only ever sees handles, a command buffer and a shader binder,
+// never a graphics API, so frames can be recorded and checked against a NullRenderBackend anywhere.
+class FrameRecorder
+{
+public:
+	// Light clusters are binned through the given parallel for, or one slice after another if it's null.
+	FrameRecorder(ParallelForFunction parallelFor = nullptr);
+
+	// Must be set before the first frame is recorded.
+	void setResources(const FrameResources& resources);
+
+	// Records the shadow maps and then the main pass for a snapshot of a scene, binding shaders through the binder.
+	void record(const RenderSnapshot& snapshot, RenderHandle backBufferRTV, RenderHandle backBufferDSV, float width, float height,
+		IShaderBinder& shaders, RenderCommandBuffer& commands);
+
+	// What the last recorded frame had to leave out. Lights past MAX_LIGHTS are dropped, and when the view's
+	// projection can't be clustered, the previous projection's clusters are used.
+	unsigned int getDroppedLightCount() const;
+	bool hasRejectedProjection() const;
+	bool hasClusterOverflow() const;
+
+	// Appends the index of every object in the snapshot that has all of the required flags and whose bounds are at least partly inside the frustum.
+	static void cullObjects(const RenderSnapshot& snapshot, const Frustum& frustum, unsigned int requiredFlags, std::vector<unsigned int>& visibleObjects);
+
+	// Appends the index of every object that can cast a shadow from the light onto one of the visible objects.
+	static void cullShadowCasters(const RenderSnapshot& snapshot, const RenderLight& light, const std::vector<unsigned int>& visibleObjects, std::vector<unsigned int>& casters);
+
+private:
+	// Culls shadow casters and packs every shadowed light into the atlas, recording its shadow map as it goes
+	void recordShadows(const RenderSnapshot& snapshot, const Frustum& viewFrustum, unsigned int lightCount);
+	// Packs the lights into the light buffer and bins them into clusters
+	void recordLights(const RenderSnapshot& snapshot, unsigned int lightCount, float width, float height, ClusteredLighting& lighting);
+
+	void prepareShadowAtlasPass();
+	void renderShadowMapPass(const RenderSnapshot& snapshot, const RenderLight& light, const ShadowAtlasTile& tile);
+
+	void prepareMainPass(RenderHandle backBufferRTV, RenderHandle backBufferDSV, float width, float height);
+	void renderMainPass(const RenderSnapshot& snapshot, const ClusteredLighting& lighting);
+
+	void bindMesh(const RenderMesh& mesh);
+
+	// Writes a batch's instance data to the instance buffer, and returns the index of its first instance in it.
+	unsigned int writeInstances(const InstanceBatch& batch, const RenderSnapshot& snapshot);
+
+	// Packs a light into the layout the shaders expect. Lights without a tile in the shadow atlas this frame take a shadow map index of -1.
+	static GPU_LIGHT_DATA packLight(const RenderLight& light, int shadowMapIndex);
+
+	FrameResources m_resources;
+
+	// Only set while a frame is being recorded
+	IShaderBinder* m_shaders;
+	RenderCommandBuffer* m_commands;
+
+	// Every shadow casting light renders into its own tile of the one atlas texture
+	ShadowAtlas m_shadowAtlas;
+	LightClusterGrid m_lightClusters;
+
+	// Starting full means the first write discards, which the driver expects before any no-overwrite writes
+	unsigned int m_instanceBufferOffset;
+
+	unsigned int m_droppedLightCount;
+	bool m_rejectedProjection;
+
+	// Rebuilt every frame, kept around so recording doesn't allocate
+	std::vector<unsigned int> m_visibleObjects;
+	std::vector<unsigned int> m_casters;
+	std::vector<LightBounds> m_allLightBounds;
+	std::vector<unsigned int> m_shadowedLights;
+	std::vector<unsigned int> m_tileSizes;
+	std::vector<ShadowAtlasTile> m_tiles;
+	std::vector<GPU_LIGHT_SHADOW_DATA> m_shadowData;
+	std::vector<int> m_shadowMapIndices;
+	std::vector<GPU_LIGHT_DATA> m_lightData;
+	std::vector<LightBounds> m_lightBounds;
+
+	DrawList m_drawList;
+	std::vector<InstanceDrawState> m_instanceStates;
+	std::vector<InstanceBatch> m_instanceBatches;
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include "RenderCommandBuffer.h"
+
+#include <cstddef>
+
+// Counts of what the last call to execute did
+struct RenderBackendStats
+{
+	unsigned int commandCounts[RENDERCOMMAND_COUNT];
+	unsigned int commandCount;
+
+	unsigned int drawCount;
+	unsigned int instanceCount;
+	unsigned int indexCount;
+	size_t bytesUploaded;
+
+	// Binds of something that was already bound. Backends skip these rather than passing them on.
+	unsigned int redundantCommands;
+	unsigned int invalidCommands;
+};
+
+// Something that carries out recorded render commands, usually by passing them on to a graphics API.
+class IRenderBackend
+{
+public:
+	virtual ~IRenderBackend() {}
+
+	virtual void execute(const RenderCommandBuffer& commands) = 0;
+
+	virtual const RenderBackendStats& getStats() const = 0;
+
+protected:
+	// Adds the work a command that was actually executed does to the stats
+	static void countExecuted(RenderBackendStats& stats, const RenderCommand& command)
+	{
+		switch (command.type)
+		{
+		case RENDERCOMMAND_UPDATE_BUFFER:
+		case RENDERCOMMAND_WRITE_BUFFER:
+			stats.bytesUploaded += command.count;
+			break;
+		case RENDERCOMMAND_DRAW_INDEXED:
+			stats.drawCount++;
+			stats.instanceCount++;
+			stats.indexCount += command.count;
+			break;
+		case RENDERCOMMAND_DRAW_INDEXED_INSTANCED:
+			stats.drawCount++;
+			stats.instanceCount += command.instanceCount;
+			stats.indexCount += command.count * command.instanceCount;
+			break;
+		default:
+			break;
+		}
+	}
+};
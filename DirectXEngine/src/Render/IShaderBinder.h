@@ -0,0 +1,40 @@
+#pragma once
+
+#include "RenderTypes.h"
+
+#include <DirectXMath.h>
+
+// What the main pass needs for each pixel to shade its light cluster
+struct ClusteredLighting
+{
+	DirectX::XMFLOAT3 cameraPosition;
+	unsigned int directionalLightCount;
+	DirectX::XMFLOAT4 viewDepthPlane;
+	DirectX::XMFLOAT2 tileScale;
+	float depthScale;
+	float depthBias;
+};
+
+// Binds shaders and sets their constants while a frame is being recorded. The frame recorder only knows shaders and
+// materials by handle, so whatever created them implements this, recording into the same command buffer as the recorder.
+// Setting a constant a shader doesn't have does nothing. Matrices are given in the layout the shaders read them in.
+class IShaderBinder
+{
+public:
+	virtual ~IShaderBinder() {}
+
+	// Binds a material's shaders, along with its textures and sampler
+	virtual void useMaterial(RenderHandle material) = 0;
+	virtual void useVertexShader(RenderHandle vertexShader) = 0;
+
+	// Shadow passes keep the view in a per pass buffer, since each shadow map has its own. Everything else keeps it per frame.
+	virtual void setViewConstants(RenderHandle vertexShader, const DirectX::XMFLOAT4X4& view, const DirectX::XMFLOAT4X4& projection, bool shadowPass) = 0;
+	virtual void setObjectConstants(RenderHandle vertexShader, const DirectX::XMFLOAT4X4& world, const DirectX::XMFLOAT4X4& worldInverseTranspose) = 0;
+
+	// Binds the frame's lights, light clusters and shadow atlas to a pixel shader
+	virtual void setLightingConstants(RenderHandle pixelShader, const ClusteredLighting& lighting) = 0;
+	virtual void setStyleConstants(RenderHandle pixelShader, RenderStyle renderStyle, const DirectX::XMFLOAT4& wireColor) = 0;
+
+	// The shadow atlas is rendered to at the start of each frame, so it can't be left bound as a shader input
+	virtual void unbindShadowAtlas(RenderHandle pixelShader) = 0;
+};
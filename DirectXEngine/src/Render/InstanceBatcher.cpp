@@ -0,0 +1,48 @@
+#include "InstanceBatcher.h"
+
+void InstanceBatcher::buildBatches(const DrawList& drawList, const InstanceDrawState* states, unsigned int maxInstances, std::vector<InstanceBatch>& batches)
+{
+	unsigned int itemCount = (unsigned int)drawList.size();
+	if (maxInstances == 0) maxInstances = 1;
+
+	unsigned int i = 0;
+	while (i < itemCount)
+	{
+		const InstanceDrawState& first = states[i];
+
+		// Items that can share a draw are already next to each other, since everything they share is part of the sort key.
+		// Only a pass or transparency change splits a run the state comparison can't see.
+		DrawPass pass = DrawList::getPass(drawList[i].key);
+		bool transparent = DrawList::isTransparent(drawList[i].key);
+
+		InstanceBatch batch;
+		batch.firstItem = i;
+		batch.count = 1;
+
+		while (first.instanceable && batch.count < maxInstances && i + batch.count < itemCount)
+		{
+			const DrawItem& next = drawList[i + batch.count];
+			if (DrawList::getPass(next.key) != pass || DrawList::isTransparent(next.key) != transparent) break;
+			if (!canShareDraw(first, states[i + batch.count])) break;
+
+			batch.count++;
+		}
+
+		batches.push_back(batch);
+		i += batch.count;
+	}
+}
+
+bool InstanceBatcher::canShareDraw(const InstanceDrawState& a, const InstanceDrawState& b)
+{
+	if (a.meshID != b.meshID || a.materialID != b.materialID) return false;
+	if (a.instanceable != b.instanceable || a.wireframe != b.wireframe) return false;
+	if (a.selected || b.selected) return false;
+
+	if (!a.wireframe) return true;
+
+	return a.wireframeColor[0] == b.wireframeColor[0]
+		&& a.wireframeColor[1] == b.wireframeColor[1]
+		&& a.wireframeColor[2] == b.wireframeColor[2]
+		&& a.wireframeColor[3] == b.wireframeColor[3];
+}
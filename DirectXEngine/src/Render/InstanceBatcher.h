@@ -0,0 +1,42 @@
+#pragma once
+
+#include "DrawList.h"
+
+#include <vector>
+
+// Everything a draw has to have in common with its neighbours to be instanced with them, copied out of the object it
+// draws so batching only deals in plain IDs and never touches assets.
+struct InstanceDrawState
+{
+	unsigned int meshID;
+	unsigned int materialID;
+
+	// Whether the draw's vertex shader reads its world matrices from the instance buffer
+	bool instanceable;
+	// Selected objects are drawn with an outline the others don't have
+	bool selected;
+
+	// The wireframe colour is per draw, so it only has to match for draws that show their wireframe
+	bool wireframe;
+	float wireframeColor[4];
+};
+
+// A run of consecutive items in a sorted draw list that can all be drawn with a single call.
+struct InstanceBatch
+{
+	unsigned int firstItem;
+	unsigned int count;
+};
+
+// Groups the draws of a sorted draw list into instanced batches. Doesn't touch the GPU, so the rest of the
+// renderer decides how the batches are submitted and where their instance data is written.
+class InstanceBatcher
+{
+public:
+	// Splits a sorted draw list into batches of at most maxInstances consecutive items that can share a draw,
+	// given the state of each item in draw order. Items that aren't instanceable are always given a batch of their own.
+	static void buildBatches(const DrawList& drawList, const InstanceDrawState* states, unsigned int maxInstances, std::vector<InstanceBatch>& batches);
+
+	// Whether two draws can be made by the same instanced call: the same mesh, material and wireframe, and neither is selected.
+	static bool canShareDraw(const InstanceDrawState& a, const InstanceDrawState& b);
+};
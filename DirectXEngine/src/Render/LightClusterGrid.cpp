@@ -0,0 +1,368 @@
+#include "LightClusterGrid.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+
+LightClusterGrid::LightClusterGrid(ParallelForFunction parallelFor)
+{
+	m_parallelFor = parallelFor;
+
+	// Zeroed so the first projection always counts as a change
+	memset(&m_projectionMatrix, 0, sizeof(XMFLOAT4X4));
+	m_nearDepth = 0.0f;
+	m_farDepth = 0.0f;
+	m_depthScale = 0.0f;
+	m_depthBias = 0.0f;
+
+	m_clusterMins = std::vector<XMFLOAT3>(LIGHT_CLUSTER_COUNT);
+	m_clusterMaxes = std::vector<XMFLOAT3>(LIGHT_CLUSTER_COUNT);
+
+	m_viewLights = std::vector<ViewLight>();
+
+	m_clusterRanges = std::vector<LightClusterRange>(LIGHT_CLUSTER_COUNT);
+	m_lightIndices = std::vector<unsigned int>();
+	m_overflowed = false;
+}
+
+bool LightClusterGrid::setProjection(const XMFLOAT4X4& projectionMatrix)
+{
+	if (memcmp(&projectionMatrix, &m_projectionMatrix, sizeof(XMFLOAT4X4)) == 0)
+		return m_farDepth > m_nearDepth;
+
+	// A left handed perspective projection maps depth as z' = z * _33 + _43, with w = z
+	float nearDepth = -projectionMatrix._43 / projectionMatrix._33;
+	float farDepth = projectionMatrix._33 * nearDepth / (projectionMatrix._33 - 1.0f);
+
+	if (projectionMatrix._34 != 1.0f || !(nearDepth > 0.0f) || !(farDepth > nearDepth))
+		return false;
+
+	m_projectionMatrix = projectionMatrix;
+	m_nearDepth = nearDepth;
+	m_farDepth = farDepth;
+
+	float logDepthRange = logf(m_farDepth / m_nearDepth);
+	m_depthScale = LIGHT_CLUSTER_SLICES / logDepthRange;
+	m_depthBias = -LIGHT_CLUSTER_SLICES * logf(m_nearDepth) / logDepthRange;
+
+	buildClusterBounds();
+	return true;
+}
+
+void LightClusterGrid::assignLights(const XMFLOAT4X4& viewMatrix, const LightBounds* lights, unsigned int lightCount)
+{
+	// Without a projection there are no clusters to bin into, and the last assignment's lists mustn't be left behind
+	if (m_farDepth <= m_nearDepth)
+	{
+		clearAssignment();
+		return;
+	}
+
+	XMMATRIX view = XMLoadFloat4x4(&viewMatrix);
+
+	const XMFLOAT4X4& p = m_projectionMatrix;
+
+	// Works out which slices and rows each light could touch, so each slice only tests the lights near it
+	m_viewLights.resize(lightCount);
+	for (unsigned int i = 0; i < lightCount; i++)
+	{
+		ViewLight& light = m_viewLights[i];
+		XMStoreFloat3(&light.center, XMVector3TransformCoord(XMLoadFloat3(&lights[i].center), view));
+		light.radius = lights[i].radius;
+
+		float minDepth = light.center.z - light.radius;
+		float maxDepth = light.center.z + light.radius;
+
+		// Lights that can't touch anything get an empty slice range
+		light.minSlice = 1;
+		light.maxSlice = 0;
+
+		if (light.radius <= 0.0f || maxDepth < m_nearDepth || minDepth > m_farDepth)
+			continue;
+
+		minDepth = std::max(minDepth, m_nearDepth);
+		maxDepth = std::min(maxDepth, m_farDepth);
+
+		// The screen space bounds of the view space box around the sphere. Since x / z only ever grows
+		// or shrinks with depth, the extremes are always at the box's corners.
+		float minNDCY = FLT_MAX;
+		float maxNDCY = -FLT_MAX;
+		float cornerYs[2] = { light.center.y - light.radius, light.center.y + light.radius };
+		float cornerDepths[2] = { minDepth, maxDepth };
+
+		for (unsigned int y = 0; y < 2; y++)
+		{
+			for (unsigned int z = 0; z < 2; z++)
+			{
+				float ndcY = cornerYs[y] * p._22 / cornerDepths[z] + p._32;
+				minNDCY = std::min(minNDCY, ndcY);
+				maxNDCY = std::max(maxNDCY, ndcY);
+			}
+		}
+
+		if (maxNDCY < -1.0f || minNDCY > 1.0f)
+			continue;
+
+		light.minSlice = getSlice(minDepth);
+		light.maxSlice = getSlice(maxDepth);
+		light.minTileY = getTileY(maxNDCY);
+		light.maxTileY = getTileY(minNDCY);
+	}
+
+	auto assignSlices = [this](unsigned int start, unsigned int end)
+	{
+		for (unsigned int slice = start; slice < end; slice++)
+		{
+			assignSlice(slice);
+		}
+	};
+
+	if (m_parallelFor)
+		m_parallelFor(LIGHT_CLUSTER_SLICES, 1, assignSlices);
+	else
+		assignSlices(0, LIGHT_CLUSTER_SLICES);
+
+	// Stitches every slice's lists into one, in cluster order
+	m_lightIndices.clear();
+	m_overflowed = false;
+
+	for (unsigned int slice = 0; slice < LIGHT_CLUSTER_SLICES; slice++)
+	{
+		const std::vector<unsigned int>& sliceIndices = m_sliceIndices[slice];
+
+		unsigned int firstCluster = getClusterIndex(0, 0, slice);
+		for (unsigned int cluster = firstCluster; cluster < firstCluster + LIGHT_CLUSTER_TILES_X * LIGHT_CLUSTER_TILES_Y; cluster++)
+		{
+			LightClusterRange& range = m_clusterRanges[cluster];
+
+			unsigned int offset = (unsigned int)m_lightIndices.size();
+			unsigned int count = range.count;
+			if (count > LIGHT_CLUSTER_MAX_INDICES - offset)
+			{
+				count = LIGHT_CLUSTER_MAX_INDICES - offset;
+				m_overflowed = true;
+			}
+
+			m_lightIndices.insert(m_lightIndices.end(), sliceIndices.begin() + range.offset, sliceIndices.begin() + range.offset + count);
+
+			range.offset = offset;
+			range.count = count;
+		}
+	}
+}
+
+const std::vector<LightClusterRange>& LightClusterGrid::getClusterRanges() const
+{
+	return m_clusterRanges;
+}
+
+const std::vector<unsigned int>& LightClusterGrid::getLightIndices() const
+{
+	return m_lightIndices;
+}
+
+bool LightClusterGrid::hasOverflowed() const
+{
+	return m_overflowed;
+}
+
+float LightClusterGrid::getDepthScale() const
+{
+	return m_depthScale;
+}
+
+float LightClusterGrid::getDepthBias() const
+{
+	return m_depthBias;
+}
+
+float LightClusterGrid::getNearDepth() const
+{
+	return m_nearDepth;
+}
+
+float LightClusterGrid::getFarDepth() const
+{
+	return m_farDepth;
+}
+
+unsigned int LightClusterGrid::getClusterIndex(unsigned int tileX, unsigned int tileY, unsigned int slice)
+{
+	return (slice * LIGHT_CLUSTER_TILES_Y + tileY) * LIGHT_CLUSTER_TILES_X + tileX;
+}
+
+unsigned int LightClusterGrid::getSlice(float viewDepth) const
+{
+	if (viewDepth <= m_nearDepth)
+		return 0;
+
+	int slice = (int)(logf(viewDepth) * m_depthScale + m_depthBias);
+	return (unsigned int)std::min(std::max(slice, 0), LIGHT_CLUSTER_SLICES - 1);
+}
+
+LightBounds LightClusterGrid::getSpotLightBounds(const XMFLOAT3& position, const XMFLOAT3& direction, float radius, float spotAngle)
+{
+	LightBounds bounds;
+
+	// Past 60 degrees, a sphere around the light's whole radius is at least as tight
+	float cosAngle = cosf(XMConvertToRadians(spotAngle));
+	if (cosAngle <= 0.5f)
+	{
+		bounds.center = position;
+		bounds.radius = radius;
+		return bounds;
+	}
+
+	// The sphere through the cone's tip, the rim of its end cap and the light's position
+	bounds.radius = radius / (2.0f * cosAngle);
+	XMStoreFloat3(&bounds.center, XMVectorMultiplyAdd(XMVector3Normalize(XMLoadFloat3(&direction)), XMVectorReplicate(bounds.radius), XMLoadFloat3(&position)));
+
+	return bounds;
+}
+
+void LightClusterGrid::buildClusterBounds()
+{
+	const XMFLOAT4X4& p = m_projectionMatrix;
+
+	for (unsigned int slice = 0; slice < LIGHT_CLUSTER_SLICES; slice++)
+	{
+		float nearDepth = m_nearDepth * powf(m_farDepth / m_nearDepth, (float)slice / LIGHT_CLUSTER_SLICES);
+		float farDepth = m_nearDepth * powf(m_farDepth / m_nearDepth, (float)(slice + 1) / LIGHT_CLUSTER_SLICES);
+
+		for (unsigned int tileY = 0; tileY < LIGHT_CLUSTER_TILES_Y; tileY++)
+		{
+			// Tiles count down from the top of the screen, where y is 1 in normalized device coordinates
+			float bottom = (1.0f - 2.0f * (tileY + 1) / LIGHT_CLUSTER_TILES_Y - p._32) / p._22;
+			float top = (1.0f - 2.0f * tileY / LIGHT_CLUSTER_TILES_Y - p._32) / p._22;
+
+			for (unsigned int tileX = 0; tileX < LIGHT_CLUSTER_TILES_X; tileX++)
+			{
+				float left = (-1.0f + 2.0f * tileX / LIGHT_CLUSTER_TILES_X - p._31) / p._11;
+				float right = (-1.0f + 2.0f * (tileX + 1) / LIGHT_CLUSTER_TILES_X - p._31) / p._11;
+
+				// The cluster's edges fan out with depth, so its box spans both ends of the slice
+				unsigned int cluster = getClusterIndex(tileX, tileY, slice);
+				m_clusterMins[cluster] = XMFLOAT3(std::min(left * nearDepth, left * farDepth), std::min(bottom * nearDepth, bottom * farDepth), nearDepth);
+				m_clusterMaxes[cluster] = XMFLOAT3(std::max(right * nearDepth, right * farDepth), std::max(top * nearDepth, top * farDepth), farDepth);
+			}
+		}
+	}
+}
+
+void LightClusterGrid::assignSlice(unsigned int slice)
+{
+	std::vector<unsigned int>& indices = m_sliceIndices[slice];
+	indices.clear();
+
+	unsigned int lightCount = (unsigned int)m_viewLights.size();
+
+	SliceScratch& scratch = m_sliceScratch[slice];
+	std::vector<unsigned int>& sliceLights = scratch.sliceLights;
+	sliceLights.clear();
+	for (unsigned int i = 0; i < lightCount; i++)
+	{
+		if (m_viewLights[i].minSlice <= slice && slice <= m_viewLights[i].maxSlice)
+			sliceLights.push_back(i);
+	}
+
+	// Structure of arrays of the lights in each row, padded to a multiple of four with lights that can't touch anything
+	std::vector<unsigned int>& rowLights = scratch.rowLights;
+	std::vector<float>& centerXs = scratch.centerXs;
+	std::vector<float>& centerYs = scratch.centerYs;
+	std::vector<float>& centerZs = scratch.centerZs;
+	std::vector<float>& radiiSquared = scratch.radiiSquared;
+
+	XMVECTOR zero = XMVectorZero();
+
+	for (unsigned int tileY = 0; tileY < LIGHT_CLUSTER_TILES_Y; tileY++)
+	{
+		rowLights.clear();
+		centerXs.clear();
+		centerYs.clear();
+		centerZs.clear();
+		radiiSquared.clear();
+
+		for (unsigned int i = 0; i < sliceLights.size(); i++)
+		{
+			const ViewLight& light = m_viewLights[sliceLights[i]];
+			if (tileY < light.minTileY || tileY > light.maxTileY)
+				continue;
+
+			rowLights.push_back(sliceLights[i]);
+			centerXs.push_back(light.center.x);
+			centerYs.push_back(light.center.y);
+			centerZs.push_back(light.center.z);
+			radiiSquared.push_back(light.radius * light.radius);
+		}
+
+		while (rowLights.size() % 4 != 0)
+		{
+			rowLights.push_back(0);
+			centerXs.push_back(0.0f);
+			centerYs.push_back(0.0f);
+			centerZs.push_back(0.0f);
+			radiiSquared.push_back(-1.0f);
+		}
+
+		for (unsigned int tileX = 0; tileX < LIGHT_CLUSTER_TILES_X; tileX++)
+		{
+			unsigned int cluster = getClusterIndex(tileX, tileY, slice);
+
+			LightClusterRange& range = m_clusterRanges[cluster];
+			range.offset = (unsigned int)indices.size();
+
+			XMVECTOR minX = XMVectorReplicate(m_clusterMins[cluster].x);
+			XMVECTOR minY = XMVectorReplicate(m_clusterMins[cluster].y);
+			XMVECTOR minZ = XMVectorReplicate(m_clusterMins[cluster].z);
+			XMVECTOR maxX = XMVectorReplicate(m_clusterMaxes[cluster].x);
+			XMVECTOR maxY = XMVectorReplicate(m_clusterMaxes[cluster].y);
+			XMVECTOR maxZ = XMVectorReplicate(m_clusterMaxes[cluster].z);
+
+			// Tests four spheres against the cluster's box at once, by their distance to the closest point in it
+			for (unsigned int i = 0; i < rowLights.size(); i += 4)
+			{
+				XMVECTOR centerX = XMLoadFloat4((const XMFLOAT4*)&centerXs[i]);
+				XMVECTOR centerY = XMLoadFloat4((const XMFLOAT4*)&centerYs[i]);
+				XMVECTOR centerZ = XMLoadFloat4((const XMFLOAT4*)&centerZs[i]);
+
+				XMVECTOR distanceX = XMVectorMax(XMVectorMax(XMVectorSubtract(minX, centerX), XMVectorSubtract(centerX, maxX)), zero);
+				XMVECTOR distanceY = XMVectorMax(XMVectorMax(XMVectorSubtract(minY, centerY), XMVectorSubtract(centerY, maxY)), zero);
+				XMVECTOR distanceZ = XMVectorMax(XMVectorMax(XMVectorSubtract(minZ, centerZ), XMVectorSubtract(centerZ, maxZ)), zero);
+
+				XMVECTOR distanceSquared = XMVectorMultiplyAdd(distanceX, distanceX, XMVectorMultiplyAdd(distanceY, distanceY, XMVectorMultiply(distanceZ, distanceZ)));
+				XMVECTOR touches = XMVectorLessOrEqual(distanceSquared, XMLoadFloat4((const XMFLOAT4*)&radiiSquared[i]));
+
+				XMUINT4 touchingLanes;
+				XMStoreUInt4(&touchingLanes, touches);
+
+				if (touchingLanes.x) indices.push_back(rowLights[i]);
+				if (touchingLanes.y) indices.push_back(rowLights[i + 1]);
+				if (touchingLanes.z) indices.push_back(rowLights[i + 2]);
+				if (touchingLanes.w) indices.push_back(rowLights[i + 3]);
+			}
+
+			range.count = (unsigned int)indices.size() - range.offset;
+		}
+	}
+}
+
+unsigned int LightClusterGrid::getTileY(float ndcY)
+{
+	int tile = (int)floorf((1.0f - ndcY) * 0.5f * LIGHT_CLUSTER_TILES_Y);
+	return (unsigned int)std::min(std::max(tile, 0), LIGHT_CLUSTER_TILES_Y - 1);
+}
+
+void LightClusterGrid::clearAssignment()
+{
+	for (unsigned int i = 0; i < LIGHT_CLUSTER_COUNT; i++)
+	{
+		m_clusterRanges[i].offset = 0;
+		m_clusterRanges[i].count = 0;
+	}
+
+	m_lightIndices.clear();
+	m_overflowed = false;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <functional>
+#include <vector>
+
+// The view is split into a grid of tiles on screen, and into slices in depth that get exponentially thicker
+// further from the camera, so clusters stay roughly as deep as they are wide. These must match SharedDefines.hlsli.
+#define LIGHT_CLUSTER_TILES_X 16
+#define LIGHT_CLUSTER_TILES_Y 9
+#define LIGHT_CLUSTER_SLICES 24
+#define LIGHT_CLUSTER_COUNT (LIGHT_CLUSTER_TILES_X * LIGHT_CLUSTER_TILES_Y * LIGHT_CLUSTER_SLICES)
+
+// How many light indices every cluster's list can hold between them. Clusters past the limit lose their extra lights.
+#define LIGHT_CLUSTER_MAX_INDICES (LIGHT_CLUSTER_COUNT * 32)
+
+// Where a cluster's lights are in the light index list. Matches the cluster ranges the pixel shader reads.
+struct LightClusterRange
+{
+	unsigned int offset;
+	unsigned int count;
+};
+
+// A sphere in world space around everything a light can reach
+struct LightBounds
+{
+	DirectX::XMFLOAT3 center;
+	float radius;
+};
+
+// Runs function(start, end) over batches of [0, count), with the same contract as JobSystem::parallelFor
+typedef void(*ParallelForFunction)(unsigned int count, unsigned int batchSize, const std::function<void(unsigned int, unsigned int)>& function);
+
+// Assigns lights to the clusters of a perspective view on the CPU, so each pixel only has to shade the lights
+// whose bounds touch its cluster. Doesn't touch the GPU, so the renderer decides where the lists are uploaded.
+class LightClusterGrid
+{
+public:
+	// Depth slices are binned through the given parallel for, e.g. JobSystem::parallelFor, or one after another if it's null.
+	LightClusterGrid(ParallelForFunction parallelFor = nullptr);
+
+	// Sets the perspective projection being clustered. The cluster bounds are only rebuilt when it changes.
+	// Returns false and keeps the previous projection if it isn't a perspective projection with a finite far plane.
+	bool setProjection(const DirectX::XMFLOAT4X4& projectionMatrix);
+
+	// Lists every light in each cluster its bounds touch, in increasing index order.
+	// Each cluster is tested against four lights at a time. Every cluster is left empty until a projection has been set.
+	void assignLights(const DirectX::XMFLOAT4X4& viewMatrix, const LightBounds* lights, unsigned int lightCount);
+
+	// One range per cluster, indexed by getClusterIndex, into the shared list of light indices
+	const std::vector<LightClusterRange>& getClusterRanges() const;
+	const std::vector<unsigned int>& getLightIndices() const;
+
+	// Whether the last assignment had more indices than LIGHT_CLUSTER_MAX_INDICES and had to drop some
+	bool hasOverflowed() const;
+
+	// A pixel's slice is log(viewDepth) * depthScale + depthBias
+	float getDepthScale() const;
+	float getDepthBias() const;
+
+	float getNearDepth() const;
+	float getFarDepth() const;
+
+	// Tiles are counted from the top left of the screen
+	static unsigned int getClusterIndex(unsigned int tileX, unsigned int tileY, unsigned int slice);
+
+	// The slice a view space depth falls in, clamped to the grid
+	unsigned int getSlice(float viewDepth) const;
+
+	// A sphere around a spot light's cone. Narrow cones get a sphere centered down the cone, which is
+	// much tighter than one around the light's full radius. The spot angle is the cone's half angle in degrees.
+	static LightBounds getSpotLightBounds(const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& direction, float radius, float spotAngle);
+
+private:
+	// A light in view space, and the range of clusters its bounds could touch
+	struct ViewLight
+	{
+		DirectX::XMFLOAT3 center;
+		float radius;
+
+		unsigned int minTileY;
+		unsigned int maxTileY;
+		unsigned int minSlice;
+		unsigned int maxSlice;
+	};
+
+	// Lights binned into one depth slice, as structure of arrays, kept around so binning doesn't allocate
+	struct SliceScratch
+	{
+		std::vector<unsigned int> sliceLights;
+		std::vector<unsigned int> rowLights;
+		std::vector<float> centerXs;
+		std::vector<float> centerYs;
+		std::vector<float> centerZs;
+		std::vector<float> radiiSquared;
+	};
+
+	void buildClusterBounds();
+	void assignSlice(unsigned int slice);
+	void clearAssignment();
+
+	// Returns the row of tiles a normalized device coordinate falls in, clamped to the grid
+	static unsigned int getTileY(float ndcY);
+
+	ParallelForFunction m_parallelFor;
+
+	DirectX::XMFLOAT4X4 m_projectionMatrix;
+	float m_nearDepth;
+	float m_farDepth;
+	float m_depthScale;
+	float m_depthBias;
+
+	// View space bounding boxes of each cluster
+	std::vector<DirectX::XMFLOAT3> m_clusterMins;
+	std::vector<DirectX::XMFLOAT3> m_clusterMaxes;
+
+	std::vector<ViewLight> m_viewLights;
+
+	// Each slice is binned on its own, with offsets relative to the start of its own index list, then stitched together
+	std::vector<unsigned int> m_sliceIndices[LIGHT_CLUSTER_SLICES];
+	SliceScratch m_sliceScratch[LIGHT_CLUSTER_SLICES];
+
+	std::vector<LightClusterRange> m_clusterRanges;
+	std::vector<unsigned int> m_lightIndices;
+	bool m_overflowed;
+};
@@ -0,0 +1,120 @@
+#include "NullRenderBackend.h"
+
+#include <cstring>
+
+NullRenderBackend::NullRenderBackend()
+{
+	m_errors = std::vector<RenderValidationError>();
+	m_state = RenderStateCache();
+
+	memset(&m_stats, 0, sizeof(m_stats));
+	reset();
+}
+
+void NullRenderBackend::execute(const RenderCommandBuffer& commands)
+{
+	memset(&m_stats, 0, sizeof(m_stats));
+	m_errors.clear();
+
+	for (size_t i = 0; i < commands.size(); i++)
+	{
+		executeCommand(commands, i);
+	}
+}
+
+void NullRenderBackend::reset()
+{
+	m_state.resetToDefaults();
+}
+
+const RenderBackendStats& NullRenderBackend::getStats() const
+{
+	return m_stats;
+}
+
+const std::vector<RenderValidationError>& NullRenderBackend::getErrors() const
+{
+	return m_errors;
+}
+
+void NullRenderBackend::executeCommand(const RenderCommandBuffer& commands, size_t index)
+{
+	const RenderCommand& command = commands[index];
+
+	if (command.type >= RENDERCOMMAND_COUNT)
+	{
+		error(index, "Unknown command type.");
+		return;
+	}
+
+	if (command.stage >= SHADERSTAGE_COUNT)
+	{
+		error(index, "Unknown shader stage.");
+		return;
+	}
+
+	m_stats.commandCounts[command.type]++;
+	m_stats.commandCount++;
+
+	validateCommand(commands, index);
+
+	if (!m_state.apply(commands, command))
+	{
+		m_stats.redundantCommands++;
+		return;
+	}
+
+	countExecuted(m_stats, command);
+}
+
+void NullRenderBackend::validateCommand(const RenderCommandBuffer& commands, size_t index)
+{
+	const RenderCommand& command = commands[index];
+
+	switch (command.type)
+	{
+	case RENDERCOMMAND_CLEAR_RENDER_TARGET:
+	case RENDERCOMMAND_CLEAR_DEPTH_STENCIL:
+		if (!command.resource) error(index, "Cleared a null target.");
+		break;
+	case RENDERCOMMAND_SET_CONSTANT_BUFFER:
+		if (command.slot >= RENDER_MAX_CONSTANT_BUFFERS) error(index, "Constant buffer slot out of range.");
+		break;
+	case RENDERCOMMAND_SET_SHADER_RESOURCES:
+		if (command.count == 0 || command.slot + command.count > RENDER_MAX_SHADER_RESOURCES) error(index, "Shader resource range out of range.");
+		break;
+	case RENDERCOMMAND_SET_SAMPLER:
+		if (command.slot >= RENDER_MAX_SAMPLERS) error(index, "Sampler slot out of range.");
+		break;
+	case RENDERCOMMAND_SET_VERTEX_BUFFER:
+		if (command.slot >= RENDER_MAX_VERTEX_BUFFERS) error(index, "Vertex buffer slot out of range.");
+		break;
+	case RENDERCOMMAND_UPDATE_BUFFER:
+	case RENDERCOMMAND_WRITE_BUFFER:
+		if (!command.resource) error(index, "Wrote to a null buffer.");
+		else if (command.dataOffset + command.count > commands.getDataSize()) error(index, "Buffer write reads past the end of the command data.");
+		break;
+	case RENDERCOMMAND_DRAW_INDEXED:
+	case RENDERCOMMAND_DRAW_INDEXED_INSTANCED:
+		if (!m_state.getShader(SHADERSTAGE_VERTEX)) error(index, "Drew without a vertex shader.");
+		else if (!m_state.getInputLayout()) error(index, "Drew without an input layout.");
+		else if (!m_state.getVertexBuffer(0)) error(index, "Drew without a vertex buffer.");
+		else if (command.type == RENDERCOMMAND_DRAW_INDEXED_INSTANCED && !m_state.getVertexBuffer(1)) error(index, "Drew instances without an instance buffer.");
+		else if (!m_state.getIndexBuffer()) error(index, "Drew without an index buffer.");
+		else if (!m_state.getRenderTarget() && !m_state.getDepthStencilTarget()) error(index, "Drew without a render target.");
+		else if (!m_state.hasViewport()) error(index, "Drew without a viewport.");
+		break;
+	default:
+		break;
+	}
+}
+
+void NullRenderBackend::error(size_t commandIndex, const char* message)
+{
+	RenderValidationError validationError;
+	validationError.commandIndex = commandIndex;
+	validationError.message = message;
+
+	m_errors.push_back(validationError);
+	m_stats.invalidCommands++;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "IRenderBackend.h"
+#include "RenderStateCache.h"
+
+#include <vector>
+
+struct RenderValidationError
+{
+	size_t commandIndex;
+	const char* message;
+};
+
+// A backend that doesn't draw anything. It tracks what would be bound on a real device, so it can count the work
+// a frame's commands do, spot redundant binds and catch commands that would be invalid, like drawing without a
+// vertex shader. Needs no graphics API, so the renderer's CPU side can be run and measured anywhere.
+class NullRenderBackend : public IRenderBackend
+{
+public:
+	NullRenderBackend();
+
+	void execute(const RenderCommandBuffer& commands) override;
+
+	// Forgets what's bound, as if the device had just been created.
+	void reset();
+
+	// Stats and errors from the last call to execute
+	const RenderBackendStats& getStats() const override;
+	const std::vector<RenderValidationError>& getErrors() const;
+
+private:
+	void executeCommand(const RenderCommandBuffer& commands, size_t index);
+	void validateCommand(const RenderCommandBuffer& commands, size_t index);
+
+	void error(size_t commandIndex, const char* message);
+
+	RenderBackendStats m_stats;
+	std::vector<RenderValidationError> m_errors;
+
+	// What the device would have bound
+	RenderStateCache m_state;
+};
@@ -0,0 +1,200 @@
+#include "RenderCommandBuffer.h"
+
+#include <cstring>
+
+RenderCommandBuffer::RenderCommandBuffer()
+{
+	m_commands = std::vector<RenderCommand>();
+	m_data = std::vector<unsigned char>();
+}
+
+void RenderCommandBuffer::setRenderTarget(RenderHandle renderTarget, RenderHandle depthStencil)
+{
+	RenderCommand& command = record(RENDERCOMMAND_SET_RENDER_TARGET);
+	command.resource = renderTarget;
+	command.secondaryResource = depthStencil;
+}
+
+void RenderCommandBuffer::setViewport(const RenderViewport& viewport)
+{
+	RenderCommand& command = record(RENDERCOMMAND_SET_VIEWPORT);
+	command.dataOffset = allocateData(sizeof(RenderViewport));
+	memcpy(&m_data[command.dataOffset], &viewport, sizeof(RenderViewport));
+}
+
+void RenderCommandBuffer::clearRenderTarget(RenderHandle renderTarget, const float color[4])
+{
+	RenderCommand& command = record(RENDERCOMMAND_CLEAR_RENDER_TARGET);
+	command.resource = renderTarget;
+	command.dataOffset = allocateData(sizeof(float) * 4);
+	memcpy(&m_data[command.dataOffset], color, sizeof(float) * 4);
+}
+
+void RenderCommandBuffer::clearDepthStencil(RenderHandle depthStencil, float depth, unsigned int stencil)
+{
+	RenderCommand& command = record(RENDERCOMMAND_CLEAR_DEPTH_STENCIL);
+	command.resource = depthStencil;
+	command.slot = stencil;
+	command.dataOffset = allocateData(sizeof(float));
+	memcpy(&m_data[command.dataOffset], &depth, sizeof(float));
+}
+
+void RenderCommandBuffer::setRasterizerState(RenderHandle state)
+{
+	record(RENDERCOMMAND_SET_RASTERIZER_STATE).resource = state;
+}
+
+void RenderCommandBuffer::setDepthStencilState(RenderHandle state)
+{
+	record(RENDERCOMMAND_SET_DEPTH_STENCIL_STATE).resource = state;
+}
+
+void RenderCommandBuffer::setBlendState(RenderHandle state)
+{
+	record(RENDERCOMMAND_SET_BLEND_STATE).resource = state;
+}
+
+void RenderCommandBuffer::setInputLayout(RenderHandle inputLayout)
+{
+	record(RENDERCOMMAND_SET_INPUT_LAYOUT).resource = inputLayout;
+}
+
+void RenderCommandBuffer::setShader(ShaderStage stage, RenderHandle shader)
+{
+	RenderCommand& command = record(RENDERCOMMAND_SET_SHADER);
+	command.stage = stage;
+	command.resource = shader;
+}
+
+void RenderCommandBuffer::setConstantBuffer(ShaderStage stage, unsigned int slot, RenderHandle buffer)
+{
+	RenderCommand& command = record(RENDERCOMMAND_SET_CONSTANT_BUFFER);
+	command.stage = stage;
+	command.slot = slot;
+	command.resource = buffer;
+}
+
+void RenderCommandBuffer::setShaderResources(ShaderStage stage, unsigned int slot, const RenderHandle* resources, unsigned int count)
+{
+	unsigned int dataOffset = allocateData(sizeof(RenderHandle) * count);
+	if (count > 0) memcpy(&m_data[dataOffset], resources, sizeof(RenderHandle) * count);
+
+	RenderCommand& command = record(RENDERCOMMAND_SET_SHADER_RESOURCES);
+	command.stage = stage;
+	command.slot = slot;
+	command.count = count;
+	command.dataOffset = dataOffset;
+}
+
+void RenderCommandBuffer::setSampler(ShaderStage stage, unsigned int slot, RenderHandle sampler)
+{
+	RenderCommand& command = record(RENDERCOMMAND_SET_SAMPLER);
+	command.stage = stage;
+	command.slot = slot;
+	command.resource = sampler;
+}
+
+void RenderCommandBuffer::setVertexBuffer(unsigned int slot, RenderHandle buffer, unsigned int stride, unsigned int offset)
+{
+	RenderCommand& command = record(RENDERCOMMAND_SET_VERTEX_BUFFER);
+	command.slot = slot;
+	command.resource = buffer;
+	command.stride = stride;
+	command.start = offset;
+}
+
+void RenderCommandBuffer::setIndexBuffer(RenderHandle buffer)
+{
+	record(RENDERCOMMAND_SET_INDEX_BUFFER).resource = buffer;
+}
+
+void RenderCommandBuffer::updateBuffer(RenderHandle buffer, const void* data, unsigned int size)
+{
+	unsigned int dataOffset = allocateData(size);
+	if (size > 0) memcpy(&m_data[dataOffset], data, size);
+
+	RenderCommand& command = record(RENDERCOMMAND_UPDATE_BUFFER);
+	command.resource = buffer;
+	command.count = size;
+	command.dataOffset = dataOffset;
+}
+
+void* RenderCommandBuffer::writeBuffer(RenderHandle buffer, unsigned int offset, unsigned int size, bool discard)
+{
+	unsigned int dataOffset = allocateData(size);
+
+	RenderCommand& command = record(RENDERCOMMAND_WRITE_BUFFER);
+	command.resource = buffer;
+	command.start = offset;
+	command.count = size;
+	command.discard = discard;
+	command.dataOffset = dataOffset;
+
+	return m_data.data() + dataOffset;
+}
+
+void RenderCommandBuffer::drawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex)
+{
+	RenderCommand& command = record(RENDERCOMMAND_DRAW_INDEXED);
+	command.count = indexCount;
+	command.start = startIndex;
+	command.baseVertex = baseVertex;
+}
+
+void RenderCommandBuffer::drawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex, unsigned int firstInstance)
+{
+	RenderCommand& command = record(RENDERCOMMAND_DRAW_INDEXED_INSTANCED);
+	command.count = indexCount;
+	command.start = startIndex;
+	command.baseVertex = baseVertex;
+	command.instanceCount = instanceCount;
+	command.firstInstance = firstInstance;
+}
+
+void RenderCommandBuffer::clear()
+{
+	m_commands.clear();
+	m_data.clear();
+}
+
+const RenderCommand& RenderCommandBuffer::operator[](size_t index) const
+{
+	return m_commands[index];
+}
+
+size_t RenderCommandBuffer::size() const
+{
+	return m_commands.size();
+}
+
+bool RenderCommandBuffer::empty() const
+{
+	return m_commands.empty();
+}
+
+const void* RenderCommandBuffer::getData(unsigned int dataOffset) const
+{
+	return m_data.data() + dataOffset;
+}
+
+size_t RenderCommandBuffer::getDataSize() const
+{
+	return m_data.size();
+}
+
+RenderCommand& RenderCommandBuffer::record(RenderCommandType type)
+{
+	RenderCommand command = {};
+	command.type = type;
+
+	m_commands.push_back(command);
+	return m_commands.back();
+}
+
+unsigned int RenderCommandBuffer::allocateData(unsigned int size)
+{
+	size_t offset = (m_data.size() + 15) & ~(size_t)15;
+	m_data.resize(offset + size);
+
+	return (unsigned int)offset;
+}
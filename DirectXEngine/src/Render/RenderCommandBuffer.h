@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// An opaque GPU object: a shader, buffer, view or state. Only the backend that executes a command knows what it points to.
+typedef void* RenderHandle;
+
+// Stands in for a handle whose value isn't known, which never matches a real one
+#define RENDER_HANDLE_UNKNOWN ((RenderHandle)~(size_t)0)
+
+// How many slots of each kind a shader stage has, matching D3D11's limits
+#define RENDER_MAX_CONSTANT_BUFFERS 14
+#define RENDER_MAX_SHADER_RESOURCES 128
+#define RENDER_MAX_SAMPLERS 16
+
+// Vertex buffer slots the renderer uses: the mesh, and instance data
+#define RENDER_MAX_VERTEX_BUFFERS 2
+
+enum ShaderStage
+{
+	SHADERSTAGE_VERTEX,
+	SHADERSTAGE_PIXEL,
+	SHADERSTAGE_COUNT
+};
+
+enum RenderCommandType
+{
+	RENDERCOMMAND_SET_RENDER_TARGET,
+	RENDERCOMMAND_SET_VIEWPORT,
+	RENDERCOMMAND_CLEAR_RENDER_TARGET,
+	RENDERCOMMAND_CLEAR_DEPTH_STENCIL,
+	RENDERCOMMAND_SET_RASTERIZER_STATE,
+	RENDERCOMMAND_SET_DEPTH_STENCIL_STATE,
+	RENDERCOMMAND_SET_BLEND_STATE,
+	RENDERCOMMAND_SET_INPUT_LAYOUT,
+	RENDERCOMMAND_SET_SHADER,
+	RENDERCOMMAND_SET_CONSTANT_BUFFER,
+	RENDERCOMMAND_SET_SHADER_RESOURCES,
+	RENDERCOMMAND_SET_SAMPLER,
+	RENDERCOMMAND_SET_VERTEX_BUFFER,
+	RENDERCOMMAND_SET_INDEX_BUFFER,
+	RENDERCOMMAND_UPDATE_BUFFER,
+	RENDERCOMMAND_WRITE_BUFFER,
+	RENDERCOMMAND_DRAW_INDEXED,
+	RENDERCOMMAND_DRAW_INDEXED_INSTANCED,
+	RENDERCOMMAND_COUNT
+};
+
+struct RenderViewport
+{
+	float x;
+	float y;
+	float width;
+	float height;
+	float minDepth;
+	float maxDepth;
+};
+
+// A single recorded command. Which fields are used depends on its type, as described by the recording method for it.
+struct RenderCommand
+{
+	RenderCommandType type;
+	ShaderStage stage;
+	unsigned int slot;
+
+	// How many indices, instances, resources or bytes the command covers
+	unsigned int count;
+	// The first index, or the byte offset into a buffer
+	unsigned int start;
+	int baseVertex;
+	unsigned int instanceCount;
+	unsigned int firstInstance;
+	unsigned int stride;
+	bool discard;
+
+	// Where the command's values are stored in the command buffer's data, for commands that carry any
+	unsigned int dataOffset;
+
+	RenderHandle resource;
+	RenderHandle secondaryResource;
+};
+
+// A flat list of commands for a render backend to execute, recorded without touching any graphics API.
+// Anything a command reads (constants, instance data, resource lists) is copied into the buffer when it's recorded,
+// so the sources can change straight away and the commands can be executed, inspected or replayed later.
+class RenderCommandBuffer
+{
+public:
+	RenderCommandBuffer();
+
+	// Binds a render target and a depth stencil view, either of which can be null.
+	void setRenderTarget(RenderHandle renderTarget, RenderHandle depthStencil);
+	void setViewport(const RenderViewport& viewport);
+	void clearRenderTarget(RenderHandle renderTarget, const float color[4]);
+	void clearDepthStencil(RenderHandle depthStencil, float depth, unsigned int stencil);
+
+	// Null restores the API's default state
+	void setRasterizerState(RenderHandle state);
+	void setDepthStencilState(RenderHandle state);
+	void setBlendState(RenderHandle state);
+
+	void setInputLayout(RenderHandle inputLayout);
+	void setShader(ShaderStage stage, RenderHandle shader);
+	void setConstantBuffer(ShaderStage stage, unsigned int slot, RenderHandle buffer);
+	void setShaderResources(ShaderStage stage, unsigned int slot, const RenderHandle* resources, unsigned int count);
+	void setSampler(ShaderStage stage, unsigned int slot, RenderHandle sampler);
+
+	void setVertexBuffer(unsigned int slot, RenderHandle buffer, unsigned int stride, unsigned int offset);
+	void setIndexBuffer(RenderHandle buffer);
+
+	// Replaces the whole contents of a buffer, like a constant buffer, with a copy of the given data.
+	void updateBuffer(RenderHandle buffer, const void* data, unsigned int size);
+
+	// Writes part of a dynamic buffer, returning where to put the bytes in the command's own data.
+	// That pointer is only valid until the next command is recorded. Discarding throws away the buffer's previous contents, otherwise the write must not touch anything already drawn from.
+	void* writeBuffer(RenderHandle buffer, unsigned int offset, unsigned int size, bool discard);
+
+	void drawIndexed(unsigned int indexCount, unsigned int startIndex, int baseVertex);
+	void drawIndexedInstanced(unsigned int indexCount, unsigned int instanceCount, unsigned int startIndex, int baseVertex, unsigned int firstInstance);
+
+	void clear();
+
+	const RenderCommand& operator[](size_t index) const;
+	size_t size() const;
+	bool empty() const;
+
+	// The values a command carries, found from its dataOffset.
+	const void* getData(unsigned int dataOffset) const;
+	size_t getDataSize() const;
+
+private:
+	RenderCommand& record(RenderCommandType type);
+
+	// Reserves space for a command's values, aligned to 16 bytes so they can be copied straight into GPU memory.
+	unsigned int allocateData(unsigned int size);
+
+	std::vector<RenderCommand> m_commands;
+	std::vector<unsigned char> m_data;
+};
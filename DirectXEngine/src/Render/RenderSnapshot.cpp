@@ -0,0 +1,44 @@
+#include "RenderSnapshot.h"
+
+using namespace DirectX;
+
+RenderSnapshot::RenderSnapshot()
+{
+	hasView = false;
+	view = {};
+
+	objects = std::vector<RenderObject>();
+	lights = std::vector<RenderLight>();
+	debugShapes = std::vector<RenderDebugShape>();
+}
+
+void RenderSnapshot::clear()
+{
+	hasView = false;
+
+	objects.clear();
+	lights.clear();
+	debugShapes.clear();
+}
+
+void RenderSnapshot::transformBounds(const XMFLOAT3& center, const XMFLOAT3& extents, const XMFLOAT4X4& worldMatrix, XMFLOAT3& worldCenter, XMFLOAT3& worldExtents)
+{
+	XMMATRIX world = XMLoadFloat4x4(&worldMatrix);
+
+	XMStoreFloat3(&worldCenter, XMVector3Transform(XMLoadFloat3(&center), world));
+
+	// Each world axis extent is the sum of the model extents projected onto it
+	XMVECTOR localExtents = XMLoadFloat3(&extents);
+	XMVECTOR x = XMVectorScale(XMVectorAbs(world.r[0]), XMVectorGetX(localExtents));
+	XMVECTOR y = XMVectorScale(XMVectorAbs(world.r[1]), XMVectorGetY(localExtents));
+	XMVECTOR z = XMVectorScale(XMVectorAbs(world.r[2]), XMVectorGetZ(localExtents));
+	XMStoreFloat3(&worldExtents, XMVectorAdd(XMVectorAdd(x, y), z));
+}
+
+float RenderSnapshot::transformRadius(float radius, const XMFLOAT4X4& worldMatrix)
+{
+	XMMATRIX world = XMLoadFloat4x4(&worldMatrix);
+
+	XMVECTOR scaleSquared = XMVectorMax(XMVector3LengthSq(world.r[0]), XMVectorMax(XMVector3LengthSq(world.r[1]), XMVector3LengthSq(world.r[2])));
+	return radius * sqrtf(XMVectorGetX(scaleSquared));
+}
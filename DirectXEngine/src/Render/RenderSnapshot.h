@@ -0,0 +1,90 @@
+#pragma once
+
+#include "RenderTypes.h"
+
+#include <DirectXMath.h>
+#include <vector>
+
+enum RenderObjectFlags
+{
+	RENDEROBJECT_CAST_SHADOWS = 1 << 0,
+	RENDEROBJECT_RECEIVE_SHADOWS = 1 << 1,
+	RENDEROBJECT_SELECTED = 1 << 2
+};
+
+// Everything needed to draw one mesh, copied out of its entity's components.
+struct RenderObject
+{
+	DirectX::XMFLOAT4X4 worldMatrix;
+	DirectX::XMFLOAT4X4 worldInverseMatrix;
+
+	// World space axis-aligned bounding box, and the radius of a bounding sphere around the same center
+	DirectX::XMFLOAT3 boundsCenter;
+	DirectX::XMFLOAT3 boundsExtents;
+	float boundsRadius;
+
+	RenderMesh mesh;
+	// Objects without a material have a null material handle, and aren't drawn in the main pass
+	RenderMaterial material;
+
+	RenderStyle renderStyle;
+	DirectX::XMFLOAT4 wireframeColor;
+
+	unsigned int flags;
+};
+
+struct RenderLight
+{
+	LightType type;
+	LightSettings settings;
+	DirectX::XMFLOAT3 position;
+	DirectX::XMFLOAT3 direction;
+
+	// Shadow casting lights get a tile in the shadow atlas up to this size, or the atlas's default if it's 0
+	bool castsShadows;
+	unsigned int shadowMapSize;
+	ShadowType shadowType;
+	DirectX::XMFLOAT4X4 viewMatrix;
+	DirectX::XMFLOAT4X4 projectionMatrix;
+};
+
+// Collision meshes drawn as wireframes in the editor
+struct RenderDebugShape
+{
+	DirectX::XMFLOAT4X4 worldMatrix;
+	RenderMesh mesh;
+};
+
+struct RenderView
+{
+	DirectX::XMFLOAT4X4 viewMatrix;
+	DirectX::XMFLOAT4X4 projectionMatrix;
+	DirectX::XMFLOAT3 position;
+};
+
+// A copy of the render-relevant state of a scene at the end of an update. The renderer only ever reads a snapshot,
+// never entities or components, so one snapshot can be rendered while the next frame's simulation fills in another.
+// Meshes and materials are referenced by handle, so assets must not be unloaded while a snapshot referencing them is being rendered.
+// Doesn't include any graphics API, so snapshots can be built and recorded anywhere.
+struct RenderSnapshot
+{
+	RenderSnapshot();
+
+	// Empties the snapshot, keeping its memory for the next extraction.
+	void clear();
+
+	// Transforms a model space bounding box by a world matrix, giving a world space box that contains it.
+	static void transformBounds(const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents, const DirectX::XMFLOAT4X4& worldMatrix,
+		DirectX::XMFLOAT3& worldCenter, DirectX::XMFLOAT3& worldExtents);
+
+	// Scales a model space bounding sphere radius by the largest scale in a world matrix.
+	static float transformRadius(float radius, const DirectX::XMFLOAT4X4& worldMatrix);
+
+	// False when there was no camera to render from, in which case nothing is drawn.
+	bool hasView;
+	RenderView view;
+
+	std::vector<RenderObject> objects;
+	std::vector<RenderLight> lights;
+	std::vector<RenderDebugShape> debugShapes;
+};
@@ -0,0 +1,169 @@
+#include "RenderStateCache.h"
+
+#include <cstring>
+
+RenderStateCache::RenderStateCache()
+{
+	reset();
+}
+
+void RenderStateCache::reset()
+{
+	fill(RENDER_HANDLE_UNKNOWN);
+	m_viewportKnown = false;
+}
+
+void RenderStateCache::resetToDefaults()
+{
+	fill(nullptr);
+	m_viewportKnown = false;
+}
+
+bool RenderStateCache::apply(const RenderCommandBuffer& commands, const RenderCommand& command)
+{
+	if (command.stage >= SHADERSTAGE_COUNT) return true;
+
+	switch (command.type)
+	{
+	case RENDERCOMMAND_SET_RENDER_TARGET:
+	{
+		if (m_renderTarget == command.resource && m_depthStencilTarget == command.secondaryResource) return false;
+
+		m_renderTarget = command.resource;
+		m_depthStencilTarget = command.secondaryResource;
+
+		// Binding a texture as a target unbinds it anywhere it's bound as a shader resource, without saying where
+		for (unsigned int stage = 0; stage < SHADERSTAGE_COUNT; stage++)
+		{
+			for (unsigned int i = 0; i < RENDER_MAX_SHADER_RESOURCES; i++)
+			{
+				m_shaderResources[stage][i] = RENDER_HANDLE_UNKNOWN;
+			}
+		}
+		return true;
+	}
+	case RENDERCOMMAND_SET_VIEWPORT:
+	{
+		const RenderViewport* viewport = (const RenderViewport*)commands.getData(command.dataOffset);
+		if (m_viewportKnown && memcmp(&m_viewport, viewport, sizeof(RenderViewport)) == 0) return false;
+
+		m_viewport = *viewport;
+		m_viewportKnown = true;
+		return true;
+	}
+	case RENDERCOMMAND_SET_RASTERIZER_STATE:
+		return bind(m_rasterizerState, command.resource);
+	case RENDERCOMMAND_SET_DEPTH_STENCIL_STATE:
+		return bind(m_depthStencilState, command.resource);
+	case RENDERCOMMAND_SET_BLEND_STATE:
+		return bind(m_blendState, command.resource);
+	case RENDERCOMMAND_SET_INPUT_LAYOUT:
+		return bind(m_inputLayout, command.resource);
+	case RENDERCOMMAND_SET_SHADER:
+		return bind(m_shaders[command.stage], command.resource);
+	case RENDERCOMMAND_SET_CONSTANT_BUFFER:
+		if (command.slot >= RENDER_MAX_CONSTANT_BUFFERS) return true;
+		return bind(m_constantBuffers[command.stage][command.slot], command.resource);
+	case RENDERCOMMAND_SET_SHADER_RESOURCES:
+	{
+		if (command.count == 0 || command.slot + command.count > RENDER_MAX_SHADER_RESOURCES) return true;
+
+		// The whole range goes through if any of it changed
+		const RenderHandle* resources = (const RenderHandle*)commands.getData(command.dataOffset);
+		bool changed = false;
+		for (unsigned int i = 0; i < command.count; i++)
+		{
+			changed |= bind(m_shaderResources[command.stage][command.slot + i], resources[i]);
+		}
+		return changed;
+	}
+	case RENDERCOMMAND_SET_SAMPLER:
+		if (command.slot >= RENDER_MAX_SAMPLERS) return true;
+		return bind(m_samplers[command.stage][command.slot], command.resource);
+	case RENDERCOMMAND_SET_VERTEX_BUFFER:
+	{
+		if (command.slot >= RENDER_MAX_VERTEX_BUFFERS) return true;
+
+		bool changed = bind(m_vertexBuffers[command.slot], command.resource);
+		changed |= m_vertexBufferStrides[command.slot] != command.stride || m_vertexBufferOffsets[command.slot] != command.start;
+
+		m_vertexBufferStrides[command.slot] = command.stride;
+		m_vertexBufferOffsets[command.slot] = command.start;
+		return changed;
+	}
+	case RENDERCOMMAND_SET_INDEX_BUFFER:
+		return bind(m_indexBuffer, command.resource);
+	default:
+		return true;
+	}
+}
+
+RenderHandle RenderStateCache::getRenderTarget() const
+{
+	return m_renderTarget;
+}
+
+RenderHandle RenderStateCache::getDepthStencilTarget() const
+{
+	return m_depthStencilTarget;
+}
+
+RenderHandle RenderStateCache::getInputLayout() const
+{
+	return m_inputLayout;
+}
+
+RenderHandle RenderStateCache::getShader(ShaderStage stage) const
+{
+	return m_shaders[stage];
+}
+
+RenderHandle RenderStateCache::getVertexBuffer(unsigned int slot) const
+{
+	if (slot >= RENDER_MAX_VERTEX_BUFFERS) return nullptr;
+	return m_vertexBuffers[slot];
+}
+
+RenderHandle RenderStateCache::getIndexBuffer() const
+{
+	return m_indexBuffer;
+}
+
+bool RenderStateCache::hasViewport() const
+{
+	return m_viewportKnown;
+}
+
+void RenderStateCache::fill(RenderHandle value)
+{
+	m_renderTarget = m_depthStencilTarget = value;
+	m_rasterizerState = m_depthStencilState = m_blendState = value;
+	m_inputLayout = value;
+	m_indexBuffer = value;
+
+	for (unsigned int stage = 0; stage < SHADERSTAGE_COUNT; stage++)
+	{
+		m_shaders[stage] = value;
+
+		for (unsigned int i = 0; i < RENDER_MAX_CONSTANT_BUFFERS; i++) m_constantBuffers[stage][i] = value;
+		for (unsigned int i = 0; i < RENDER_MAX_SHADER_RESOURCES; i++) m_shaderResources[stage][i] = value;
+		for (unsigned int i = 0; i < RENDER_MAX_SAMPLERS; i++) m_samplers[stage][i] = value;
+	}
+
+	for (unsigned int i = 0; i < RENDER_MAX_VERTEX_BUFFERS; i++)
+	{
+		m_vertexBuffers[i] = value;
+		m_vertexBufferStrides[i] = 0;
+		m_vertexBufferOffsets[i] = 0;
+	}
+
+	memset(&m_viewport, 0, sizeof(m_viewport));
+}
+
+bool RenderStateCache::bind(RenderHandle& slot, RenderHandle value)
+{
+	if (slot == value) return false;
+
+	slot = value;
+	return true;
+}
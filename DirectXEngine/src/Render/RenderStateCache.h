@@ -0,0 +1,57 @@
+#pragma once
+
+#include "RenderCommandBuffer.h"
+
+// Tracks what a device has bound, so commands that would bind something already bound can be dropped.
+// Doesn't depend on any graphics API; backends feed it every command they're about to execute.
+class RenderStateCache
+{
+public:
+	RenderStateCache();
+
+	// Forgets everything, so the next bind to every slot goes through. Used whenever something outside the
+	// command stream may have touched the device, since the cache can't know what's bound anymore.
+	void reset();
+
+	// Assumes nothing is bound, like on a device that was just created.
+	void resetToDefaults();
+
+	// Updates the cache with a command's binds. Returns false if the command wouldn't change what's bound, so it can
+	// be skipped. Commands that don't bind anything, like draws and clears, always return true.
+	bool apply(const RenderCommandBuffer& commands, const RenderCommand& command);
+
+	// What's currently bound. Unknown slots, after a reset, return RENDER_HANDLE_UNKNOWN.
+	RenderHandle getRenderTarget() const;
+	RenderHandle getDepthStencilTarget() const;
+	RenderHandle getInputLayout() const;
+	RenderHandle getShader(ShaderStage stage) const;
+	RenderHandle getVertexBuffer(unsigned int slot) const;
+	RenderHandle getIndexBuffer() const;
+	bool hasViewport() const;
+
+private:
+	void fill(RenderHandle value);
+
+	// Sets a tracked slot, returning whether it changed
+	static bool bind(RenderHandle& slot, RenderHandle value);
+
+	RenderHandle m_renderTarget;
+	RenderHandle m_depthStencilTarget;
+	RenderViewport m_viewport;
+	bool m_viewportKnown;
+
+	RenderHandle m_rasterizerState;
+	RenderHandle m_depthStencilState;
+	RenderHandle m_blendState;
+
+	RenderHandle m_inputLayout;
+	RenderHandle m_shaders[SHADERSTAGE_COUNT];
+	RenderHandle m_constantBuffers[SHADERSTAGE_COUNT][RENDER_MAX_CONSTANT_BUFFERS];
+	RenderHandle m_shaderResources[SHADERSTAGE_COUNT][RENDER_MAX_SHADER_RESOURCES];
+	RenderHandle m_samplers[SHADERSTAGE_COUNT][RENDER_MAX_SAMPLERS];
+
+	RenderHandle m_vertexBuffers[RENDER_MAX_VERTEX_BUFFERS];
+	unsigned int m_vertexBufferStrides[RENDER_MAX_VERTEX_BUFFERS];
+	unsigned int m_vertexBufferOffsets[RENDER_MAX_VERTEX_BUFFERS];
+	RenderHandle m_indexBuffer;
+};
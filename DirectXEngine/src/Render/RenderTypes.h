@@ -0,0 +1,61 @@
+#pragma once
+
+#include "RenderCommandBuffer.h"
+
+#include <DirectXMath.h>
+
+// Settings shared by the components that describe what to draw and the renderer that draws it.
+// Kept apart from both so that recording a frame doesn't depend on components or on any graphics API.
+
+enum LightType
+{
+	POINT_LIGHT,
+	DIRECTIONAL_LIGHT,
+	SPOT_LIGHT
+};
+
+enum ShadowType
+{
+	SHADOWTYPE_HARD = 0,
+	SHADOWTYPE_SOFT = 2,
+	SHADOWTYPE_VERY_SOFT = 4
+};
+
+struct LightSettings
+{
+	DirectX::XMFLOAT4 color;
+	float brightness;
+	float specularity;
+	float radius;
+	float spotAngle;
+};
+
+enum RenderStyle
+{
+	SOLID,
+	WIREFRAME,
+	SOLID_WIREFRAME
+};
+
+// What drawing a mesh needs, copied out of the mesh. Meshes with no indices are never drawn.
+struct RenderMesh
+{
+	unsigned int id;
+	RenderHandle vertexBuffer;
+	RenderHandle indexBuffer;
+	unsigned int vertexStride;
+	unsigned int indexCount;
+};
+
+// A material and the shaders it uses, as the handles and runtime IDs draws are sorted and batched by.
+// The handles are only ever given back to the renderer, which knows what they point to.
+struct RenderMaterial
+{
+	unsigned int id;
+	RenderHandle material;
+
+	RenderHandle vertexShader;
+	unsigned int vertexShaderID;
+	RenderHandle pixelShader;
+	unsigned int pixelShaderID;
+};
@@ -1,5 +1,7 @@
 #include "Renderer.h"
 
+#include "../Job/JobSystem.h"
+
 using namespace DirectX;
 
 Renderer::Renderer(ID3D11Device* device, ID3D11DeviceContext* context)
@@ -7,13 +9,41 @@ Renderer::Renderer(ID3D11Device* device, ID3D11DeviceContext* context)
 	m_device = device;
 	m_context = context;
 
+	m_d3d11Backend = new D3D11RenderBackend(context);
+	m_backend = m_d3d11Backend;
+	m_commands = RenderCommandBuffer();
+
 	m_basicVertexShader = nullptr;
+	m_defaultVertexShader = nullptr;
+	m_instancedVertexShader = nullptr;
 	m_shadowMapSampler = nullptr;
 
+	m_shadowAtlasTexture = nullptr;
+	m_lightShadowBuffer = nullptr;
+	m_lightShadowBufferSRV = nullptr;
+
+	m_instanceBuffer = nullptr;
+
+	m_lightBuffer = nullptr;
+	m_lightBufferSRV = nullptr;
+	m_clusterRangeBuffer = nullptr;
+	m_clusterRangeBufferSRV = nullptr;
+	m_clusterIndexBuffer = nullptr;
+	m_clusterIndexBufferSRV = nullptr;
+
 	m_wireframeRasterizerState = nullptr;
 	m_shadowMapRasterizerState = nullptr;
 
 	m_depthStencilStateDefault = nullptr;
+	m_depthStencilStateReadOnly = nullptr;
+	m_transparentBlendState = nullptr;
+
+	m_boundVertexShader = nullptr;
+	m_boundVertexShaderHandles = nullptr;
+	m_boundPixelShader = nullptr;
+	m_boundPixelShaderHandles = nullptr;
+
+	m_recorder = FrameRecorder(&JobSystem::parallelFor);
 }
 
 Renderer::~Renderer()
@@ -22,12 +52,32 @@ Renderer::~Renderer()
 	if (m_shadowMapRasterizerState) m_shadowMapRasterizerState->Release();
 
 	if (m_depthStencilStateDefault) m_depthStencilStateDefault->Release();
+	if (m_depthStencilStateReadOnly) m_depthStencilStateReadOnly->Release();
+	if (m_transparentBlendState) m_transparentBlendState->Release();
+
+	if (m_instanceBuffer) m_instanceBuffer->Release();
+
+	if (m_lightBufferSRV) m_lightBufferSRV->Release();
+	if (m_lightBuffer) m_lightBuffer->Release();
+	if (m_clusterRangeBufferSRV) m_clusterRangeBufferSRV->Release();
+	if (m_clusterRangeBuffer) m_clusterRangeBuffer->Release();
+	if (m_clusterIndexBufferSRV) m_clusterIndexBufferSRV->Release();
+	if (m_clusterIndexBuffer) m_clusterIndexBuffer->Release();
+	if (m_lightShadowBufferSRV) m_lightShadowBufferSRV->Release();
+	if (m_lightShadowBuffer) m_lightShadowBuffer->Release();
+
+	delete m_d3d11Backend;
+	m_d3d11Backend = nullptr;
+	m_backend = nullptr;
 
 	m_device = nullptr;
 	m_context = nullptr;
 
 	m_basicVertexShader = nullptr;
+	m_defaultVertexShader = nullptr;
+	m_instancedVertexShader = nullptr;
 	m_shadowMapSampler = nullptr;
+	m_shadowAtlasTexture = nullptr;
 }
 
 bool Renderer::init()
@@ -97,6 +147,36 @@ bool Renderer::init()
 
 	m_context->OMSetDepthStencilState(m_depthStencilStateDefault, 0);
 
+	// Transparent draws are depth tested against the opaque ones, but don't hide each other
+	D3D11_DEPTH_STENCIL_DESC depthStencilReadOnlyDesc = depthStencilDefaultDesc;
+	depthStencilReadOnlyDesc.DepthWriteMask = D3D11_DEPTH_WRITE_MASK_ZERO;
+
+	hr = m_device->CreateDepthStencilState(&depthStencilReadOnlyDesc, &m_depthStencilStateReadOnly);
+	if (FAILED(hr))
+	{
+		Debug::error("Failed to create read only depth stencil state.");
+		return false;
+	}
+
+	D3D11_BLEND_DESC transparentBlendDesc = {};
+	transparentBlendDesc.AlphaToCoverageEnable = false;
+	transparentBlendDesc.IndependentBlendEnable = false;
+	transparentBlendDesc.RenderTarget[0].BlendEnable = TRUE;
+	transparentBlendDesc.RenderTarget[0].SrcBlend = D3D11_BLEND_SRC_ALPHA;
+	transparentBlendDesc.RenderTarget[0].DestBlend = D3D11_BLEND_INV_SRC_ALPHA;
+	transparentBlendDesc.RenderTarget[0].BlendOp = D3D11_BLEND_OP_ADD;
+	transparentBlendDesc.RenderTarget[0].SrcBlendAlpha = D3D11_BLEND_ONE;
+	transparentBlendDesc.RenderTarget[0].DestBlendAlpha = D3D11_BLEND_ZERO;
+	transparentBlendDesc.RenderTarget[0].BlendOpAlpha = D3D11_BLEND_OP_ADD;
+	transparentBlendDesc.RenderTarget[0].RenderTargetWriteMask = D3D11_COLOR_WRITE_ENABLE_ALL;
+
+	hr = m_device->CreateBlendState(&transparentBlendDesc, &m_transparentBlendState);
+	if (FAILED(hr))
+	{
+		Debug::error("Failed to create transparent blend state.");
+		return false;
+	}
+
 	m_basicVertexShader = AssetManager::getAsset<VertexShader>(BASIC_SHADER_VERTEX);
 	if (!m_basicVertexShader)
 	{
@@ -104,6 +184,58 @@ bool Renderer::init()
 		return false;
 	}
 
+	m_defaultVertexShader = AssetManager::getAsset<VertexShader>(DEFAULT_SHADER_VERTEX);
+	if (!m_defaultVertexShader)
+	{
+		Debug::error("Renderer failed to get default vertex shader.");
+		return false;
+	}
+
+	// Only materials using the default vertex shader are instanced, since this is the only instanced variant there is
+	m_instancedVertexShader = AssetManager::getAsset<VertexShader>(INSTANCED_SHADER_VERTEX);
+	if (!m_instancedVertexShader)
+	{
+		Debug::error("Renderer failed to get instanced vertex shader.");
+		return false;
+	}
+
+	D3D11_BUFFER_DESC instanceBufferDesc = {};
+	instanceBufferDesc.ByteWidth = sizeof(GPU_INSTANCE_DATA) * INSTANCE_BUFFER_CAPACITY;
+	instanceBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	instanceBufferDesc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	instanceBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+
+	hr = m_device->CreateBuffer(&instanceBufferDesc, nullptr, &m_instanceBuffer);
+	if (FAILED(hr))
+	{
+		Debug::error("Failed to create instance buffer.");
+		return false;
+	}
+
+	if (!createStructuredBuffer(sizeof(GPU_LIGHT_DATA), MAX_LIGHTS, &m_lightBuffer, &m_lightBufferSRV))
+	{
+		Debug::error("Failed to create light buffer.");
+		return false;
+	}
+
+	if (!createStructuredBuffer(sizeof(LightClusterRange), LIGHT_CLUSTER_COUNT, &m_clusterRangeBuffer, &m_clusterRangeBufferSRV))
+	{
+		Debug::error("Failed to create light cluster range buffer.");
+		return false;
+	}
+
+	if (!createStructuredBuffer(sizeof(unsigned int), LIGHT_CLUSTER_MAX_INDICES, &m_clusterIndexBuffer, &m_clusterIndexBufferSRV))
+	{
+		Debug::error("Failed to create light cluster index buffer.");
+		return false;
+	}
+
+	if (!createStructuredBuffer(sizeof(GPU_LIGHT_SHADOW_DATA), MAX_SHADOWED_LIGHTS, &m_lightShadowBuffer, &m_lightShadowBufferSRV))
+	{
+		Debug::error("Failed to create light shadow buffer.");
+		return false;
+	}
+
 	m_shadowMapSampler = AssetManager::getAsset<Sampler>(SHADOWMAP_SAMPLER);
 	if (!m_shadowMapSampler)
 	{
@@ -111,6 +243,38 @@ bool Renderer::init()
 		return false;
 	}
 
+	m_shadowAtlasTexture = AssetManager::getAsset<Texture>(SHADOW_ATLAS_TEXTURE);
+	if (!m_shadowAtlasTexture)
+	{
+		Debug::error("Renderer failed to get shadow atlas texture.");
+		return false;
+	}
+
+	Material* debugMaterial = AssetManager::getAsset<Material>(DEFAULT_RED_MATERIAL);
+	if (!debugMaterial)
+	{
+		Debug::error("Renderer failed to get debug material.");
+		return false;
+	}
+
+	FrameResources resources;
+	resources.shadowAtlasDSV = m_shadowAtlasTexture->getDSV();
+	resources.shadowMapRasterizerState = m_shadowMapRasterizerState;
+	resources.wireframeRasterizerState = m_wireframeRasterizerState;
+	resources.depthStencilStateDefault = m_depthStencilStateDefault;
+	resources.depthStencilStateReadOnly = m_depthStencilStateReadOnly;
+	resources.transparentBlendState = m_transparentBlendState;
+	resources.instanceBuffer = m_instanceBuffer;
+	resources.lightBuffer = m_lightBuffer;
+	resources.lightShadowBuffer = m_lightShadowBuffer;
+	resources.clusterRangeBuffer = m_clusterRangeBuffer;
+	resources.clusterIndexBuffer = m_clusterIndexBuffer;
+	resources.shadowVertexShader = static_cast<SimpleVertexShader*>(m_basicVertexShader);
+	resources.instanceableVertexShader = static_cast<SimpleVertexShader*>(m_defaultVertexShader);
+	resources.instancedVertexShader = static_cast<SimpleVertexShader*>(m_instancedVertexShader);
+	resources.debugMaterial = debugMaterial->getRenderMaterial();
+	m_recorder.setResources(resources);
+
 	return true;
 }
 
@@ -123,250 +287,241 @@ void Renderer::end()
 {
 }
 
-void Renderer::prepareShadowMapPass(Texture* shadowMap)
+void Renderer::render(const RenderSnapshot& snapshot, ID3D11RenderTargetView* backBufferRTV, ID3D11DepthStencilView* backBufferDSV, float width, float height)
 {
-	if (!shadowMap)
+	if (!snapshot.hasView) return;
+
+	// The whole frame is recorded first, shader binds included, then handed to the backend in one go
+	m_commands.clear();
+	ISimpleShader::SetCommandBuffer(&m_commands);
+
+	// Shaders can be unloaded between frames, so nothing is treated as bound until the recorder binds it
+	m_boundVertexShader = nullptr;
+	m_boundPixelShader = nullptr;
+
+	m_recorder.record(snapshot, backBufferRTV, backBufferDSV, width, height, *this, m_commands);
+
+	ISimpleShader::SetCommandBuffer(nullptr);
+
+	if (m_recorder.getDroppedLightCount() > 0)
 	{
-		Debug::warning("Could not prepare shadow pass since no shadow map was given.");
-		return;
+		Debug::warning("Scene has " + std::to_string(snapshot.lights.size()) + " lights but only " + std::to_string(MAX_LIGHTS) + " can be rendered, the rest were dropped.");
 	}
 
-	ID3D11DepthStencilView* shadowMapDSV = shadowMap->getDSV();
+	if (m_recorder.hasRejectedProjection())
+	{
+		Debug::warning("Light clusters need a perspective projection with a finite far plane, keeping the previous projection.");
+	}
 
-	m_context->ClearDepthStencilView(shadowMapDSV, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
+	if (m_recorder.hasClusterOverflow())
+	{
+		Debug::warning("Light clusters ran out of room for light indices, some lights were dropped.");
+	}
 
-	m_context->RSSetState(m_shadowMapRasterizerState);
+	m_backend->execute(m_commands);
+}
 
-	ID3D11RenderTargetView* nullRTV = nullptr;
-	m_context->OMSetRenderTargets(1, &nullRTV, shadowMapDSV);
+void Renderer::setBackend(IRenderBackend* backend)
+{
+	IRenderBackend* newBackend = backend ? backend : m_d3d11Backend;
+	if (newBackend == m_backend) return;
 
-	D3D11_VIEWPORT viewport = {};
-	viewport.TopLeftX = viewport.TopLeftY = 0;
-	viewport.MinDepth = 0;
-	viewport.MaxDepth = 1;
-	viewport.Width = (float)shadowMap->getWidth();
-	viewport.Height = (float)shadowMap->getHeight();
-	m_context->RSSetViewports(1, &viewport);
+	// Shaders skip copying constants that haven't changed since their last copy, but copies executed by the previous
+	// backend never reached this one's GPU, so every constant buffer has to be copied again
+	ISimpleShader::InvalidateUploads();
 
-	m_basicVertexShader->SetShader();
-	m_context->PSSetShader(nullptr, nullptr, 0);
+	m_backend = newBackend;
 }
 
-void Renderer::renderShadowMapPass(Entity** entities, size_t entityCount, const LightComponent& light)
+const RenderCommandBuffer& Renderer::getCommands() const
 {
-	XMFLOAT4X4 view = light.getViewMatrix();
-	XMMATRIX viewMatrixT = XMMatrixTranspose(XMLoadFloat4x4(&view));
-	XMFLOAT4X4 viewT;
-	XMStoreFloat4x4(&viewT, viewMatrixT);
+	return m_commands;
+}
 
-	XMMATRIX projectionMatrixT = XMMatrixTranspose(XMLoadFloat4x4(&light.getProjectionMatrix()));
-	XMFLOAT4X4 projT;
-	XMStoreFloat4x4(&projT, projectionMatrixT);
+const RenderBackendStats& Renderer::getStats() const
+{
+	return m_backend->getStats();
+}
 
-	unsigned int stride = sizeof(Vertex);
-	unsigned int offset = 0;
+void Renderer::useMaterial(RenderHandle material)
+{
+	Material* boundMaterial = static_cast<Material*>(material);
+	boundMaterial->useMaterial();
 
-	for (unsigned int i = 0; i < entityCount; i++)
-	{
-		//  Don't use disabled entities
-		if (!entities[i]->getEnabled()) continue;
-
-		Transform* transform = entities[i]->getComponent<Transform>();
-		MeshRenderComponent* meshRenderComponent = entities[i]->getComponent<MeshRenderComponent>();
-		if (meshRenderComponent && meshRenderComponent->enabled && meshRenderComponent->castShadows && transform)
-		{
-			XMFLOAT4X4 world = transform->getWorldMatrix();
-			XMMATRIX worldMatrixT = XMMatrixTranspose(XMLoadFloat4x4(&world));
-			XMFLOAT4X4 worldT;
-			XMStoreFloat4x4(&worldT, worldMatrixT);
-
-			m_basicVertexShader->SetMatrix4x4("world", worldT);
-			m_basicVertexShader->SetMatrix4x4("view", viewT);
-			m_basicVertexShader->SetMatrix4x4("projection", projT);
-			m_basicVertexShader->CopyBufferData("matrices");
-
-			Mesh* mesh = meshRenderComponent->getMesh();
-			if (mesh)
-			{
-				ID3D11Buffer* vertexBuffer = mesh->getVertexBuffer();
-				ID3D11Buffer* indexBuffer = mesh->getIndexBuffer();
-
-				m_context->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
-				m_context->IASetIndexBuffer(indexBuffer, DXGI_FORMAT_R32_UINT, 0);
-
-				m_context->DrawIndexed(mesh->getIndexCount(), 0, 0);								
-			}
-		}
-	}
+	bindHandles(boundMaterial->getVertexShader());
+	bindHandles(boundMaterial->getPixelShader());
 }
 
-void Renderer::prepareMainPass(ID3D11RenderTargetView* backBufferRTV, ID3D11DepthStencilView* backBufferDSV, float width, float height)
+void Renderer::useVertexShader(RenderHandle vertexShader)
 {
-	m_context->OMSetRenderTargets(1, &backBufferRTV, backBufferDSV);
+	SimpleVertexShader* shader = static_cast<SimpleVertexShader*>(vertexShader);
+	shader->SetShader();
 
-	m_context->ClearRenderTargetView(backBufferRTV, Colors::CornflowerBlue);
-	m_context->ClearDepthStencilView(backBufferDSV, D3D11_CLEAR_DEPTH | D3D11_CLEAR_STENCIL, 1.0f, 0);
+	bindHandles(shader);
+}
 
-	m_context->RSSetState(nullptr);
+void Renderer::setViewConstants(RenderHandle vertexShader, const XMFLOAT4X4& view, const XMFLOAT4X4& projection, bool shadowPass)
+{
+	SimpleVertexShader* shader = static_cast<SimpleVertexShader*>(vertexShader);
+	const VertexShaderHandles& handles = getBoundHandles(shader);
 
-	D3D11_VIEWPORT viewport = {};
-	viewport.TopLeftX = viewport.TopLeftY = 0;
-	viewport.MinDepth = 0;
-	viewport.MaxDepth = 1;
-	viewport.Width = width;
-	viewport.Height = height;
-	m_context->RSSetViewports(1, &viewport);
+	shader->SetMatrix4x4(handles.view, view);
+	shader->SetMatrix4x4(handles.projection, projection);
+	shader->CopyBufferData(shadowPass ? handles.passBuffer : handles.frameBuffer);
 }
 
-void Renderer::renderMainPass(const CameraComponent& mainCamera, DirectX::XMFLOAT4X4 projectionMatrix, Entity*const * entities, size_t entityCount,
-	const GPU_LIGHT_DATA* lightData, const GPU_SHADOW_MATRICES* shadowMatrices, ID3D11ShaderResourceView*const * shadowMapSRVs)
+void Renderer::setObjectConstants(RenderHandle vertexShader, const XMFLOAT4X4& world, const XMFLOAT4X4& worldInverseTranspose)
 {
-	Transform* mainCameraTransform = mainCamera.getEntity().getComponent<Transform>();
-	if (!mainCameraTransform) return;
+	SimpleVertexShader* shader = static_cast<SimpleVertexShader*>(vertexShader);
+	const VertexShaderHandles& handles = getBoundHandles(shader);
 
-	// Used for collider visualization
-	Material* red = AssetManager::getAsset<Material>(DEFAULT_RED_MATERIAL);
-	VertexShader* redVertexShader = red->getVertexShader();
+	shader->SetMatrix4x4(handles.world, world);
+	shader->SetMatrix4x4(handles.worldInverseTranspose, worldInverseTranspose);
+	shader->CopyBufferData(handles.objectBuffer);
+}
 
-	XMFLOAT4X4 view = mainCamera.getViewMatrix();
-	XMMATRIX viewMatrixT = XMMatrixTranspose(XMLoadFloat4x4(&view));
-	XMFLOAT4X4 viewT;
-	XMStoreFloat4x4(&viewT, viewMatrixT);
+void Renderer::setLightingConstants(RenderHandle pixelShader, const ClusteredLighting& lighting)
+{
+	SimplePixelShader* shader = static_cast<SimplePixelShader*>(pixelShader);
+	const PixelShaderHandles& handles = getBoundHandles(shader);
+
+	shader->SetSamplerState(handles.shadowMapSampler, m_shadowMapSampler->getSamplerState());
+	shader->SetShaderResourceView(handles.shadowAtlas, m_shadowAtlasTexture->getSRV());
+	shader->SetShaderResourceView(handles.lightShadows, m_lightShadowBufferSRV);
+
+	shader->SetShaderResourceView(handles.lights, m_lightBufferSRV);
+	shader->SetShaderResourceView(handles.clusterLightRanges, m_clusterRangeBufferSRV);
+	shader->SetShaderResourceView(handles.clusterLightIndices, m_clusterIndexBufferSRV);
+
+	shader->SetFloat3(handles.cameraWorldPosition, lighting.cameraPosition);
+	shader->SetInt(handles.directionalLightCount, (int)lighting.directionalLightCount);
+	shader->SetFloat4(handles.viewDepthPlane, lighting.viewDepthPlane);
+	shader->SetFloat2(handles.clusterTileScale, lighting.tileScale);
+	shader->SetFloat(handles.clusterDepthScale, lighting.depthScale);
+	shader->SetFloat(handles.clusterDepthBias, lighting.depthBias);
+	shader->CopyBufferData(handles.frameBuffer);
+}
 
-	XMMATRIX projectionMatrixT = XMMatrixTranspose(XMLoadFloat4x4(&projectionMatrix));
-	XMFLOAT4X4 projT;
-	XMStoreFloat4x4(&projT, projectionMatrixT);
+void Renderer::setStyleConstants(RenderHandle pixelShader, RenderStyle renderStyle, const XMFLOAT4& wireColor)
+{
+	SimplePixelShader* shader = static_cast<SimplePixelShader*>(pixelShader);
+	const PixelShaderHandles& handles = getBoundHandles(shader);
 
-	unsigned int stride = sizeof(Vertex);
-	unsigned int offset = 0;
+	shader->SetInt(handles.renderStyle, (int)renderStyle);
+	shader->SetFloat4(handles.wireColor, wireColor);
+	shader->CopyBufferData(handles.objectBuffer);
+}
 
-	for (unsigned int i = 0; i < entityCount; i++)
-	{
-		//  Don't use disabled entities
-		if (!entities[i]->getEnabled()) continue;
-
-		// Don't draw the entity if it can't be seen anyway
-		Transform* transform = entities[i]->getComponent<Transform>();
-		MeshRenderComponent* meshRenderComponent = entities[i]->getComponent<MeshRenderComponent>();
-		if (meshRenderComponent && transform)
-		{
-			Mesh* mesh = meshRenderComponent->getMesh();
-			if (mesh)
-			{
-				XMFLOAT4X4 world = transform->getWorldMatrix();
-				XMMATRIX worldMatrix = XMLoadFloat4x4(&world);
-
-				if (meshRenderComponent->enabled)
-				{
-					Material* material = meshRenderComponent->getMaterial();
-					if (material)
-					{
-						material->useMaterial();
-
-						SimpleVertexShader* vertexShader = material->getVertexShader();
-						SimplePixelShader* pixelShader = material->getPixelShader();
-
-						XMMATRIX worldMatrixT = XMMatrixTranspose(worldMatrix);
-						XMFLOAT4X4 worldT;
-						XMStoreFloat4x4(&worldT, worldMatrixT);
-
-						XMFLOAT4X4 worldMatrixInverse = transform->getInverseWorldMatrix();
-
-						vertexShader->SetMatrix4x4("world", worldT);
-						vertexShader->SetMatrix4x4("view", viewT);
-						vertexShader->SetMatrix4x4("projection", projT);
-						vertexShader->SetMatrix4x4("worldInverseTranspose", worldMatrixInverse);
-						vertexShader->SetData("shadowMatrices", &shadowMatrices[0], sizeof(GPU_SHADOW_MATRICES) * MAX_SHADOWMAPS);
-
-						vertexShader->CopyBufferData("matrices");
-
-						pixelShader->SetSamplerState("shadowMapSampler", m_shadowMapSampler->getSamplerState());
-
-						pixelShader->SetFloat3("cameraWorldPosition", mainCameraTransform->getPosition());
-						pixelShader->CopyBufferData("camera");
-
-						if (!Debug::inPlayMode && entities[i]->selected)
-						{
-							pixelShader->SetInt("renderStyle", (int)SOLID_WIREFRAME);
-							pixelShader->SetFloat4("wireColor", XMFLOAT4(1.0f, 1.0f, 0.0f, 1.0f));
-						}
-						else
-						{
-							pixelShader->SetInt("renderStyle", (int)meshRenderComponent->getRenderStyle());
-							pixelShader->SetFloat4("wireColor", meshRenderComponent->getWireframeColor());
-						}
-
-						pixelShader->CopyBufferData("renderStyle");
-
-						pixelShader->SetShaderResourceViewArray("shadowMaps", shadowMapSRVs, MAX_SHADOWMAPS);
-
-						pixelShader->SetData("lights", lightData, sizeof(GPU_LIGHT_DATA) * MAX_LIGHTS);
-						pixelShader->CopyBufferData("lighting");
-
-						ID3D11Buffer* vertexBuffer = mesh->getVertexBuffer();
-						ID3D11Buffer* indexBuffer = mesh->getIndexBuffer();
-
-						m_context->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
-						m_context->IASetIndexBuffer(indexBuffer, DXGI_FORMAT_R32_UINT, 0);
-
-						// Finally do the actual drawing
-						//  - Do this ONCE PER OBJECT you intend to draw
-						//  - This will use all of the currently set DirectX "stuff" (shaders, buffers, etc)
-						//  - DrawIndexed() uses the currently set INDEX BUFFER to look up corresponding
-						//     vertices in the currently set VERTEX BUFFER
-						m_context->DrawIndexed(
-							mesh->getIndexCount(),			// The number of indices to use (we could draw a subset if we wanted)
-							0,								// Offset to the first index we want to use
-							0);								// Offset to add to each index when looking up vertices
-
-															// If the entity has a collider, render that too
-
-						ID3D11ShaderResourceView* empty[MAX_SHADOWMAPS];
-						for (unsigned int i = 0; i < MAX_SHADOWMAPS; i++)
-						{
-							empty[i] = nullptr;
-						}
-						pixelShader->SetShaderResourceViewArray("shadowMaps", &empty[0], MAX_SHADOWMAPS);
-					}
-				}
-
-				if (!Debug::inPlayMode)
-				{
-					Collider* collider = entities[i]->getComponent<Collider>();
-					if (collider && collider->enabled)
-					{
-						const Mesh* collisionMesh = collider->getMesh();
-						if (collisionMesh)
-						{
-							red->useMaterial();
-							m_context->RSSetState(m_wireframeRasterizerState);
-
-							XMFLOAT4X4 colliderMatrixFloat4x4 = collider->getOffsetScaleMatrix();
-							XMMATRIX colliderMatrix = XMLoadFloat4x4(&colliderMatrixFloat4x4);
-
-							XMMATRIX colliderWorldMatrix = XMMatrixMultiply(colliderMatrix, worldMatrix);
-							XMFLOAT4X4 colliderWorldMatrixT;
-							XMStoreFloat4x4(&colliderWorldMatrixT, XMMatrixTranspose(colliderWorldMatrix));
-
-							redVertexShader->SetMatrix4x4("world", colliderWorldMatrixT);
-							redVertexShader->SetMatrix4x4("view", viewT);
-							redVertexShader->SetMatrix4x4("projection", projT);
-
-							redVertexShader->CopyBufferData("matrices");
-
-							ID3D11Buffer* vertexBuffer = collisionMesh->getVertexBuffer();
-							ID3D11Buffer* indexBuffer = collisionMesh->getIndexBuffer();
-
-							m_context->IASetVertexBuffers(0, 1, &vertexBuffer, &stride, &offset);
-							m_context->IASetIndexBuffer(indexBuffer, DXGI_FORMAT_R32_UINT, 0);
-
-							m_context->DrawIndexed(collisionMesh->getIndexCount(), 0, 0);
-
-							m_context->RSSetState(nullptr);
-						}
-					}
-				}
-			}
-		}
-	}
+void Renderer::unbindShadowAtlas(RenderHandle pixelShader)
+{
+	SimplePixelShader* shader = static_cast<SimplePixelShader*>(pixelShader);
+	shader->SetShaderResourceView(getBoundHandles(shader).shadowAtlas, nullptr);
+}
+
+bool Renderer::createStructuredBuffer(unsigned int elementSize, unsigned int elementCount, ID3D11Buffer** buffer, ID3D11ShaderResourceView** srv)
+{
+	D3D11_BUFFER_DESC bufferDesc = {};
+	bufferDesc.ByteWidth = elementSize * elementCount;
+	bufferDesc.Usage = D3D11_USAGE_DYNAMIC;
+	bufferDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	bufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+	bufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+	bufferDesc.StructureByteStride = elementSize;
+
+	HRESULT hr = m_device->CreateBuffer(&bufferDesc, nullptr, buffer);
+	if (FAILED(hr))
+		return false;
+
+	D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+	srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+	srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+	srvDesc.Buffer.FirstElement = 0;
+	srvDesc.Buffer.NumElements = elementCount;
+
+	hr = m_device->CreateShaderResourceView(*buffer, &srvDesc, srv);
+	if (FAILED(hr))
+		return false;
+
+	return true;
+}
+
+void Renderer::bindHandles(SimpleVertexShader* shader)
+{
+	if (shader == m_boundVertexShader) return;
+
+	m_boundVertexShader = shader;
+	m_boundVertexShaderHandles = &getHandles(shader);
+}
+
+void Renderer::bindHandles(SimplePixelShader* shader)
+{
+	if (shader == m_boundPixelShader) return;
+
+	m_boundPixelShader = shader;
+	m_boundPixelShaderHandles = &getHandles(shader);
+}
+
+const VertexShaderHandles& Renderer::getBoundHandles(SimpleVertexShader* shader)
+{
+	// The recorder always binds a shader before setting its per draw constants, so this is only a fallback
+	if (shader != m_boundVertexShader)
+		return getHandles(shader);
+
+	return *m_boundVertexShaderHandles;
+}
+
+const PixelShaderHandles& Renderer::getBoundHandles(SimplePixelShader* shader)
+{
+	if (shader != m_boundPixelShader)
+		return getHandles(shader);
+
+	return *m_boundPixelShaderHandles;
+}
+
+const VertexShaderHandles& Renderer::getHandles(SimpleVertexShader* shader)
+{
+	std::unordered_map<unsigned int, VertexShaderHandles>::iterator cached = m_vertexShaderHandles.find(shader->getRuntimeID());
+	if (cached != m_vertexShaderHandles.end())
+		return cached->second;
+
+	VertexShaderHandles& handles = m_vertexShaderHandles[shader->getRuntimeID()];
+	handles.view = shader->GetVariableHandle("view");
+	handles.projection = shader->GetVariableHandle("projection");
+	handles.world = shader->GetVariableHandle("world");
+	handles.worldInverseTranspose = shader->GetVariableHandle("worldInverseTranspose");
+
+	handles.passBuffer = shader->GetBufferHandle("pass");
+	handles.frameBuffer = shader->GetBufferHandle("frame");
+	handles.objectBuffer = shader->GetBufferHandle("object");
+
+	return handles;
+}
+
+const PixelShaderHandles& Renderer::getHandles(SimplePixelShader* shader)
+{
+	std::unordered_map<unsigned int, PixelShaderHandles>::iterator cached = m_pixelShaderHandles.find(shader->getRuntimeID());
+	if (cached != m_pixelShaderHandles.end())
+		return cached->second;
+
+	PixelShaderHandles& handles = m_pixelShaderHandles[shader->getRuntimeID()];
+	handles.cameraWorldPosition = shader->GetVariableHandle("cameraWorldPosition");
+	handles.directionalLightCount = shader->GetVariableHandle("directionalLightCount");
+	handles.viewDepthPlane = shader->GetVariableHandle("viewDepthPlane");
+	handles.clusterTileScale = shader->GetVariableHandle("clusterTileScale");
+	handles.clusterDepthScale = shader->GetVariableHandle("clusterDepthScale");
+	handles.clusterDepthBias = shader->GetVariableHandle("clusterDepthBias");
+	handles.renderStyle = shader->GetVariableHandle("renderStyle");
+	handles.wireColor = shader->GetVariableHandle("wireColor");
+
+	handles.shadowAtlas = shader->GetShaderResourceViewHandle("shadowAtlas");
+	handles.lightShadows = shader->GetShaderResourceViewHandle("lightShadows");
+	handles.lights = shader->GetShaderResourceViewHandle("lights");
+	handles.clusterLightRanges = shader->GetShaderResourceViewHandle("clusterLightRanges");
+	handles.clusterLightIndices = shader->GetShaderResourceViewHandle("clusterLightIndices");
+	handles.shadowMapSampler = shader->GetSamplerHandle("shadowMapSampler");
+
+	handles.frameBuffer = shader->GetBufferHandle("frame");
+	handles.objectBuffer = shader->GetBufferHandle("object");
+
+	return handles;
 }
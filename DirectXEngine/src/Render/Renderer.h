@@ -1,41 +1,55 @@
 #pragma once
+#include "D3D11RenderBackend.h"
+#include "FrameRecorder.h"
 #include "IRenderer.h"
-
-#include "../Component/Transform.h"
-#include "../Component/MeshRenderComponent.h"
-#include "../Component/LightComponent.h"
-#include "../Component/CameraComponent.h"
-#include "../Component/Collider.h"
+#include "IShaderBinder.h"
+#include "RenderCommandBuffer.h"
+#include "RenderSnapshot.h"
+#include "../Asset/AssetManager.h"
 
 #include <DirectXMath.h>
+#include <unordered_map>
 
-#define MAX_LIGHTS 64
-#define MAX_SHADOWMAPS 16
-
-// The struct that should match the light data in the shaders.
-struct GPU_LIGHT_DATA
+// Handles to everything the renderer sets on a vertex shader. Shaders only have some of these,
+// and setting through the ones they don't have does nothing.
+struct VertexShaderHandles
 {
-	DirectX::XMFLOAT4 color;
-	DirectX::XMFLOAT3 direction;
-	float brightness;
-	DirectX::XMFLOAT3 position;
-	float specularity;
-	float radius;
-	float spotAngle;
-	bool enabled;
-	int type;
-	bool shadowMapEnabled;
-	int shadowType;
-	DirectX::XMFLOAT2 padding;
+	SimpleVariableHandle view;
+	SimpleVariableHandle projection;
+	SimpleVariableHandle world;
+	SimpleVariableHandle worldInverseTranspose;
+
+	SimpleBufferHandle passBuffer;
+	SimpleBufferHandle frameBuffer;
+	SimpleBufferHandle objectBuffer;
 };
 
-struct GPU_SHADOW_MATRICES
+// Handles to everything the renderer sets on a pixel shader
+struct PixelShaderHandles
 {
-	DirectX::XMFLOAT4X4 lightViewMatrix;
-	DirectX::XMFLOAT4X4 lightProjectionMatrix;
+	SimpleVariableHandle cameraWorldPosition;
+	SimpleVariableHandle directionalLightCount;
+	SimpleVariableHandle viewDepthPlane;
+	SimpleVariableHandle clusterTileScale;
+	SimpleVariableHandle clusterDepthScale;
+	SimpleVariableHandle clusterDepthBias;
+	SimpleVariableHandle renderStyle;
+	SimpleVariableHandle wireColor;
+
+	SimpleSRVHandle shadowAtlas;
+	SimpleSRVHandle lightShadows;
+	SimpleSRVHandle lights;
+	SimpleSRVHandle clusterLightRanges;
+	SimpleSRVHandle clusterLightIndices;
+	SimpleSamplerHandle shadowMapSampler;
+
+	SimpleBufferHandle frameBuffer;
+	SimpleBufferHandle objectBuffer;
 };
 
-class Renderer : public IRenderer
+// Draws render snapshots with D3D11. Creates everything a frame is recorded against and binds shaders for the frame recorder,
+// which does the rest of the work of turning a snapshot into commands without touching the device.
+class Renderer : public IRenderer, public IShaderBinder
 {
 public:
 	Renderer(ID3D11Device* device, ID3D11DeviceContext* context);
@@ -46,22 +60,83 @@ public:
 	void begin() override;
 	void end() override;
 
-	void prepareShadowMapPass(Texture* shadowMap);
-	void renderShadowMapPass(Entity** entities, size_t entityCount, const LightComponent& light);
+	// Renders the shadow maps and then the main pass for a snapshot of a scene.
+	void render(const RenderSnapshot& snapshot, ID3D11RenderTargetView* backBufferRTV, ID3D11DepthStencilView* backBufferDSV, float width, float height);
 
-	void prepareMainPass(ID3D11RenderTargetView* backBufferRTV, ID3D11DepthStencilView* backBufferDSV, float width, float height);
-	void renderMainPass(const CameraComponent& mainCamera, DirectX::XMFLOAT4X4 projectionMatrix, Entity*const * entities, size_t entityCount,
-		const GPU_LIGHT_DATA* lightData, const GPU_SHADOW_MATRICES* shadowMatrices, ID3D11ShaderResourceView*const * shadowMapSRVs);
+	// Frames are executed by the D3D11 backend unless another one is set, like a null backend to measure the CPU side alone.
+	// Setting null goes back to D3D11. The renderer doesn't take ownership of the backend.
+	// Changing backend makes every shader copy its constants again on the next frame.
+	void setBackend(IRenderBackend* backend);
+
+	// The commands recorded for the last rendered frame, and what the backend did with them
+	const RenderCommandBuffer& getCommands() const;
+	const RenderBackendStats& getStats() const;
+
+	// Binds shaders for the frame recorder. Handles are the SimpleShader or Material they were made from.
+	void useMaterial(RenderHandle material) override;
+	void useVertexShader(RenderHandle vertexShader) override;
+	void setViewConstants(RenderHandle vertexShader, const DirectX::XMFLOAT4X4& view, const DirectX::XMFLOAT4X4& projection, bool shadowPass) override;
+	void setObjectConstants(RenderHandle vertexShader, const DirectX::XMFLOAT4X4& world, const DirectX::XMFLOAT4X4& worldInverseTranspose) override;
+	void setLightingConstants(RenderHandle pixelShader, const ClusteredLighting& lighting) override;
+	void setStyleConstants(RenderHandle pixelShader, RenderStyle renderStyle, const DirectX::XMFLOAT4& wireColor) override;
+	void unbindShadowAtlas(RenderHandle pixelShader) override;
 
 private:
+	// Creates a dynamic structured buffer the CPU rewrites every frame, with a view for shaders to read it through
+	bool createStructuredBuffer(unsigned int elementSize, unsigned int elementCount, ID3D11Buffer** buffer, ID3D11ShaderResourceView** srv);
+
+	// Looks up a shader's handles the first time it's drawn with, and returns the cached ones after that
+	const VertexShaderHandles& getHandles(SimpleVertexShader* shader);
+	const PixelShaderHandles& getHandles(SimplePixelShader* shader);
+
+	// Remembers the handles of the shaders just bound, so constants set every draw don't look them up every draw
+	void bindHandles(SimpleVertexShader* shader);
+	void bindHandles(SimplePixelShader* shader);
+	const VertexShaderHandles& getBoundHandles(SimpleVertexShader* shader);
+	const PixelShaderHandles& getBoundHandles(SimplePixelShader* shader);
+
 	ID3D11Device* m_device;
 	ID3D11DeviceContext* m_context;
 
 	VertexShader* m_basicVertexShader;
+	VertexShader* m_defaultVertexShader;
+	VertexShader* m_instancedVertexShader;
 	Sampler* m_shadowMapSampler;
 
+	// Every shadow casting light renders into its own tile of the one atlas texture
+	Texture* m_shadowAtlasTexture;
+	ID3D11Buffer* m_lightShadowBuffer;
+	ID3D11ShaderResourceView* m_lightShadowBufferSRV;
+
 	ID3D11RasterizerState* m_wireframeRasterizerState;
 	ID3D11RasterizerState* m_shadowMapRasterizerState;
 
 	ID3D11DepthStencilState* m_depthStencilStateDefault;
-};
+	ID3D11DepthStencilState* m_depthStencilStateReadOnly;
+	ID3D11BlendState* m_transparentBlendState;
+
+	ID3D11Buffer* m_instanceBuffer;
+
+	// Every light visible this frame, and which of them each light cluster has
+	ID3D11Buffer* m_lightBuffer;
+	ID3D11ShaderResourceView* m_lightBufferSRV;
+	ID3D11Buffer* m_clusterRangeBuffer;
+	ID3D11ShaderResourceView* m_clusterRangeBufferSRV;
+	ID3D11Buffer* m_clusterIndexBuffer;
+	ID3D11ShaderResourceView* m_clusterIndexBufferSRV;
+
+	// Keyed by runtime ID rather than pointer, since those are never reused by a later shader
+	std::unordered_map<unsigned int, VertexShaderHandles> m_vertexShaderHandles;
+	std::unordered_map<unsigned int, PixelShaderHandles> m_pixelShaderHandles;
+
+	// Map values never move, so these stay valid for as long as the shaders are bound
+	SimpleVertexShader* m_boundVertexShader;
+	const VertexShaderHandles* m_boundVertexShaderHandles;
+	SimplePixelShader* m_boundPixelShader;
+	const PixelShaderHandles* m_boundPixelShaderHandles;
+
+	FrameRecorder m_recorder;
+	RenderCommandBuffer m_commands;
+	D3D11RenderBackend* m_d3d11Backend;
+	IRenderBackend* m_backend;
+};
\ No newline at end of file
@@ -0,0 +1,168 @@
+#include "ShadowAtlas.h"
+
+#include <algorithm>
+
+using namespace DirectX;
+
+ShadowAtlas::ShadowAtlas(unsigned int atlasSize, unsigned int minTileSize)
+{
+	m_size = atlasSize;
+	m_minTileSize = minTileSize < atlasSize ? minTileSize : atlasSize;
+
+	m_order = std::vector<unsigned int>();
+	m_sizes = std::vector<unsigned int>();
+}
+
+unsigned int ShadowAtlas::selectTileSize(float screenCoverage, unsigned int maxTileSize) const
+{
+	maxTileSize = roundDownToPowerOfTwo(std::min(std::max(maxTileSize, m_minTileSize), m_size));
+
+	float coverage = std::min(std::max(screenCoverage, 0.0f), 1.0f);
+	unsigned int tileSize = roundDownToPowerOfTwo((unsigned int)(maxTileSize * coverage));
+
+	return std::min(std::max(tileSize, m_minTileSize), maxTileSize);
+}
+
+float ShadowAtlas::getScreenCoverage(const XMFLOAT3& center, float radius, const XMFLOAT4X4& viewMatrix, const XMFLOAT4X4& projectionMatrix)
+{
+	XMFLOAT3 viewCenter;
+	XMStoreFloat3(&viewCenter, XMVector3TransformCoord(XMLoadFloat3(&center), XMLoadFloat4x4(&viewMatrix)));
+
+	if (viewCenter.z - radius <= 0.0f)
+		return 1.0f;
+
+	// The sphere's projected diameter, over the two units of height normalized device coordinates span
+	float coverage = radius * projectionMatrix._22 / viewCenter.z;
+	return std::min(coverage, 1.0f);
+}
+
+void ShadowAtlas::pack(const unsigned int* tileSizes, unsigned int count, ShadowAtlasTile* tiles)
+{
+	m_order.resize(count);
+	m_sizes.resize(count);
+	for (unsigned int i = 0; i < count; i++)
+	{
+		m_order[i] = i;
+		m_sizes[i] = roundDownToPowerOfTwo(std::min(std::max(tileSizes[i], m_minTileSize), m_size));
+	}
+
+	std::stable_sort(m_order.begin(), m_order.end(), [this](unsigned int a, unsigned int b)
+	{
+		return m_sizes[a] > m_sizes[b];
+	});
+
+	// Positions along the curve are counted in cells of the smallest tile size
+	unsigned int cellsPerSide = m_size / m_minTileSize;
+	unsigned int capacity = cellsPerSide * cellsPerSide;
+
+	unsigned int totalCells = 0;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		totalCells += getCellCount(m_sizes[i]);
+	}
+
+	// While the tiles don't all fit, halve the largest ones. Halving from the end of the run of largest tiles
+	// keeps the order largest first, and each tile only gives up resolution once every bigger one has.
+	while (totalCells > capacity && count > 0 && m_sizes[m_order[0]] > m_minTileSize)
+	{
+		unsigned int largest = m_sizes[m_order[0]];
+		unsigned int runEnd = 0;
+		while (runEnd < count && m_sizes[m_order[runEnd]] == largest)
+		{
+			runEnd++;
+		}
+
+		for (unsigned int i = runEnd; i > 0 && totalCells > capacity; i--)
+		{
+			unsigned int& size = m_sizes[m_order[i - 1]];
+			totalCells -= getCellCount(size) - getCellCount(size / 2);
+			size /= 2;
+		}
+	}
+
+	// Every tile is at least as big as the ones after it, so each one starts aligned to its own size.
+	// Once even the smallest tiles don't fit, the rest get nothing.
+	unsigned int cursor = 0;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		ShadowAtlasTile& tile = tiles[m_order[i]];
+		unsigned int size = m_sizes[m_order[i]];
+		unsigned int cells = getCellCount(size);
+
+		if (cursor + cells > capacity)
+		{
+			tile.x = 0;
+			tile.y = 0;
+			tile.size = 0;
+			continue;
+		}
+
+		unsigned int cellX;
+		unsigned int cellY;
+		decodeMorton(cursor, cellX, cellY);
+
+		tile.x = cellX * m_minTileSize;
+		tile.y = cellY * m_minTileSize;
+		tile.size = size;
+
+		cursor += cells;
+	}
+}
+
+XMFLOAT4X4 ShadowAtlas::getTileMatrix(const ShadowAtlasTile& tile) const
+{
+	// Scales normalized device coordinates from [-1, 1] to the tile's size in texture coordinates, flipping y since
+	// textures start at the top, then moves them to the tile's center. Depth is left as it is.
+	float scale = 0.5f * tile.size / m_size;
+	float offsetX = (tile.x + 0.5f * tile.size) / m_size;
+	float offsetY = (tile.y + 0.5f * tile.size) / m_size;
+
+	return XMFLOAT4X4(
+		scale, 0.0f, 0.0f, 0.0f,
+		0.0f, -scale, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f,
+		offsetX, offsetY, 0.0f, 1.0f);
+}
+
+unsigned int ShadowAtlas::getSize() const
+{
+	return m_size;
+}
+
+unsigned int ShadowAtlas::getMinTileSize() const
+{
+	return m_minTileSize;
+}
+
+void ShadowAtlas::decodeMorton(unsigned int index, unsigned int& x, unsigned int& y)
+{
+	x = 0;
+	y = 0;
+
+	// Even bits of the index are x, odd bits are y
+	for (unsigned int bit = 0; bit < 16; bit++)
+	{
+		x |= ((index >> (2 * bit)) & 1) << bit;
+		y |= ((index >> (2 * bit + 1)) & 1) << bit;
+	}
+}
+
+unsigned int ShadowAtlas::getCellCount(unsigned int tileSize) const
+{
+	unsigned int cellsPerSide = tileSize / m_minTileSize;
+	return cellsPerSide * cellsPerSide;
+}
+
+unsigned int ShadowAtlas::roundDownToPowerOfTwo(unsigned int value)
+{
+	if (value == 0)
+		return 0;
+
+	unsigned int power = 1;
+	while (power <= value / 2)
+	{
+		power *= 2;
+	}
+
+	return power;
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <vector>
+
+// The width and height of the single depth texture every shadow casting light renders into
+#define SHADOW_ATLAS_SIZE 4096
+// The smallest tile a light is given, and the grid every tile is aligned to
+#define SHADOW_ATLAS_MIN_TILE_SIZE 128
+// The largest tile a light is given when it doesn't ask for a size of its own
+#define SHADOW_ATLAS_DEFAULT_TILE_SIZE 1024
+
+// Where a light's shadow map is in the atlas, in texels. Lights that didn't fit have a size of 0.
+struct ShadowAtlasTile
+{
+	unsigned int x;
+	unsigned int y;
+	unsigned int size;
+};
+
+// Hands out square tiles of one large shadow map texture, sized by how much of the screen each light covers.
+// Doesn't touch the GPU, so the renderer decides how the tiles are rendered to and sampled.
+class ShadowAtlas
+{
+public:
+	// Both sizes must be powers of two, with the atlas at least as big as the smallest tile.
+	ShadowAtlas(unsigned int atlasSize = SHADOW_ATLAS_SIZE, unsigned int minTileSize = SHADOW_ATLAS_MIN_TILE_SIZE);
+
+	// Scales a light's largest tile size down by how much of the screen it covers, so lights keep about the same
+	// shadow resolution per pixel on screen. Always a power of two between the smallest tile size and the atlas size.
+	unsigned int selectTileSize(float screenCoverage, unsigned int maxTileSize) const;
+
+	// How much of the screen's height a world space sphere covers, from 0 to 1. Spheres the camera is inside cover all of it.
+	static float getScreenCoverage(const DirectX::XMFLOAT3& center, float radius, const DirectX::XMFLOAT4X4& viewMatrix, const DirectX::XMFLOAT4X4& projectionMatrix);
+
+	// Packs tiles of the given power of two sizes, largest first, filling tiles in for each size in the same order.
+	// When they don't all fit, the largest tiles are halved until they do. If they still don't fit at the smallest
+	// tile size, the tiles that come last get a size of 0.
+	void pack(const unsigned int* tileSizes, unsigned int count, ShadowAtlasTile* tiles);
+
+	// Maps a light's clip space into its tile's texture coordinates. Multiplied onto a light's view projection
+	// matrix, it takes world space positions straight to where they are in the atlas.
+	DirectX::XMFLOAT4X4 getTileMatrix(const ShadowAtlasTile& tile) const;
+
+	unsigned int getSize() const;
+	unsigned int getMinTileSize() const;
+
+private:
+	// Turns a position along a Z-order curve into grid coordinates. Any run of 4^n cells starting at a multiple
+	// of 4^n is an aligned square, so placing tiles largest first along the curve never leaves gaps.
+	static void decodeMorton(unsigned int index, unsigned int& x, unsigned int& y);
+
+	// How many of the smallest tiles a tile of the given size takes up
+	unsigned int getCellCount(unsigned int tileSize) const;
+	static unsigned int roundDownToPowerOfTwo(unsigned int value);
+
+	unsigned int m_size;
+	unsigned int m_minTileSize;
+
+	// Tile indices sorted largest first and the size each tile ends up with, kept around so packing doesn't allocate
+	std::vector<unsigned int> m_order;
+	std::vector<unsigned int> m_sizes;
+};
@@ -0,0 +1,170 @@
+#pragma once
+
+#include "../Entity.h"
+
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+
+// A persistent query for every active entity that has an active component of each of a set of types.
+// The scene owns its queries and keeps them up to date as components are added, removed, enabled and disabled,
+// so reading a query's matches every frame doesn't allocate or search through the scene's entities.
+class IComponentQuery
+{
+public:
+	virtual ~IComponentQuery() {}
+
+	// Whether the given component is one of the types this query matches on.
+	virtual bool isInterestedIn(const Component* component) const = 0;
+
+	// Re-checks whether the given entity matches the query, ignoring removedComponent since it's about to be deleted.
+	virtual void refresh(Entity* entity, const Component* removedComponent) = 0;
+};
+
+template<typename... Ts>
+struct QueryMatch
+{
+	Entity* entity;
+	std::tuple<Ts*...> components;
+
+	template<typename T>
+	T* get() const { return std::get<T*>(components); }
+};
+
+template<typename... Ts>
+class ComponentQuery : public IComponentQuery
+{
+public:
+	typedef QueryMatch<Ts...> Match;
+
+	bool isInterestedIn(const Component* component) const override;
+	void refresh(Entity* entity, const Component* removedComponent) override;
+
+	// The matches are stored contiguously, so these can be iterated over like an array.
+	// Structural changes to the scene (adding, removing, enabling or disabling components) invalidate them.
+	const Match* begin() const;
+	const Match* end() const;
+	const Match& operator[](size_t index) const;
+
+	size_t size() const;
+	bool empty() const;
+
+private:
+	template<typename T>
+	static T* findComponent(const Entity* entity, const Component* removedComponent);
+
+	void add(const Match& match);
+	void remove(Entity* entity);
+
+	std::vector<Match> m_matches;
+	std::unordered_map<const Entity*, size_t> m_matchIndices;
+};
+
+template<typename... Ts>
+inline bool ComponentQuery<Ts...>::isInterestedIn(const Component* component) const
+{
+	bool interested = false;
+	int expand[] = { 0, (interested = interested || dynamic_cast<const Ts*>(component) != nullptr, 0)... };
+	(void)expand;
+
+	return interested;
+}
+
+template<typename... Ts>
+inline void ComponentQuery<Ts...>::refresh(Entity* entity, const Component* removedComponent)
+{
+	Match match;
+	match.entity = entity;
+	match.components = std::tuple<Ts*...>(findComponent<Ts>(entity, removedComponent)...);
+
+	bool matched = entity->getEnabled();
+	int expand[] = { 0, (matched = matched && std::get<Ts*>(match.components) != nullptr, 0)... };
+	(void)expand;
+
+	if (matched)
+		add(match);
+	else
+		remove(entity);
+}
+
+template<typename... Ts>
+inline const typename ComponentQuery<Ts...>::Match* ComponentQuery<Ts...>::begin() const
+{
+	return m_matches.data();
+}
+
+template<typename... Ts>
+inline const typename ComponentQuery<Ts...>::Match* ComponentQuery<Ts...>::end() const
+{
+	return m_matches.data() + m_matches.size();
+}
+
+template<typename... Ts>
+inline const typename ComponentQuery<Ts...>::Match& ComponentQuery<Ts...>::operator[](size_t index) const
+{
+	return m_matches[index];
+}
+
+template<typename... Ts>
+inline size_t ComponentQuery<Ts...>::size() const
+{
+	return m_matches.size();
+}
+
+template<typename... Ts>
+inline bool ComponentQuery<Ts...>::empty() const
+{
+	return m_matches.empty();
+}
+
+template<typename... Ts>
+template<typename T>
+inline T* ComponentQuery<Ts...>::findComponent(const Entity* entity, const Component* removedComponent)
+{
+	static_assert(std::is_base_of<Component, T>::value, "Given type is not a Component.");
+
+	for (unsigned int i = 0; i < entity->m_components.size(); i++)
+	{
+		Component* component = entity->m_components[i];
+		if (component == removedComponent || !component->getEnabled()) continue;
+
+		T* typedComponent = dynamic_cast<T*>(component);
+		if (typedComponent) return typedComponent;
+	}
+
+	return nullptr;
+}
+
+template<typename... Ts>
+inline void ComponentQuery<Ts...>::add(const Match& match)
+{
+	auto it = m_matchIndices.find(match.entity);
+	if (it != m_matchIndices.end())
+	{
+		// Already matched, but which of the entity's components matched may have changed
+		m_matches[it->second] = match;
+		return;
+	}
+
+	m_matchIndices[match.entity] = m_matches.size();
+	m_matches.push_back(match);
+}
+
+template<typename... Ts>
+inline void ComponentQuery<Ts...>::remove(Entity* entity)
+{
+	auto it = m_matchIndices.find(entity);
+	if (it == m_matchIndices.end()) return;
+
+	// Swap the last match into the removed slot to keep the matches contiguous
+	size_t index = it->second;
+	m_matchIndices.erase(it);
+
+	if (index != m_matches.size() - 1)
+	{
+		m_matches[index] = m_matches.back();
+		m_matchIndices[m_matches[index].entity] = index;
+	}
+
+	m_matches.pop_back();
+}
@@ -0,0 +1,166 @@
+#include "ComponentUpdateList.h"
+
+IComponentUpdateList::IComponentUpdateList()
+{
+	m_buckets = std::vector<TickBucket>();
+
+	m_tickGroup = TICKGROUP_PRE_PHYSICS;
+	m_tickInterval = TickInterval::everyFrame();
+
+	m_ticking = false;
+	m_removedWhileTicking = false;
+}
+
+void IComponentUpdateList::add(Component* component)
+{
+	// Components remember their bucket and slot so adding and removing are constant time
+	if (component->m_updateListIndex >= 0) return;
+
+	TickInterval interval = component->m_hasTickInterval ? component->m_tickInterval : m_tickInterval;
+	unsigned int bucketIndex = getBucket(interval);
+	TickBucket& bucket = m_buckets[bucketIndex];
+
+	component->m_updateListBucket = (int)bucketIndex;
+	component->m_updateListIndex = (int)bucket.components.size();
+	bucket.components.push_back(component);
+}
+
+void IComponentUpdateList::remove(Component* component)
+{
+	int index = component->m_updateListIndex;
+	if (index < 0) return;
+
+	std::vector<Component*>& components = m_buckets[component->m_updateListBucket].components;
+	if (m_ticking)
+	{
+		components[index] = nullptr;
+		m_removedWhileTicking = true;
+	}
+	else
+	{
+		// Swap the last component in the bucket into the removed slot to keep the bucket contiguous
+		Component* last = components.back();
+		components[index] = last;
+		last->m_updateListIndex = index;
+
+		components.pop_back();
+	}
+
+	component->m_updateListBucket = -1;
+	component->m_updateListIndex = -1;
+}
+
+void IComponentUpdateList::beginFrame(unsigned int frameIndex, float deltaTime)
+{
+	for (size_t i = 0; i < m_buckets.size(); i++)
+	{
+		TickBucket& bucket = m_buckets[i];
+		bucket.timeSinceTick += deltaTime;
+
+		if (bucket.interval.seconds > 0.0f)
+		{
+			bucket.timeUntilTick -= deltaTime;
+			bucket.due = bucket.timeUntilTick <= 0.0f;
+
+			// Keep to the schedule rather than drifting, but don't try to catch up on ticks missed during a long frame
+			if (bucket.due)
+			{
+				bucket.timeUntilTick += bucket.interval.seconds;
+				if (bucket.timeUntilTick <= 0.0f)
+					bucket.timeUntilTick = bucket.interval.seconds;
+			}
+		}
+		else
+		{
+			bucket.due = frameIndex % bucket.interval.frames == bucket.phase;
+		}
+
+		if (bucket.due)
+		{
+			bucket.deltaTime = bucket.timeSinceTick;
+			bucket.timeSinceTick = 0.0f;
+		}
+	}
+}
+
+void IComponentUpdateList::beginTicking()
+{
+	m_ticking = true;
+}
+
+void IComponentUpdateList::endTicking()
+{
+	m_ticking = false;
+	if (!m_removedWhileTicking) return;
+
+	// Close up the emptied slots, keeping the order of the components that are left
+	for (size_t i = 0; i < m_buckets.size(); i++)
+	{
+		std::vector<Component*>& components = m_buckets[i].components;
+
+		size_t remaining = 0;
+		for (size_t j = 0; j < components.size(); j++)
+		{
+			if (!components[j]) continue;
+
+			components[j]->m_updateListIndex = (int)remaining;
+			components[remaining] = components[j];
+			remaining++;
+		}
+		components.resize(remaining);
+	}
+
+	m_removedWhileTicking = false;
+}
+
+size_t IComponentUpdateList::size() const
+{
+	size_t count = 0;
+	for (size_t i = 0; i < m_buckets.size(); i++)
+	{
+		count += m_buckets[i].components.size();
+	}
+
+	return count;
+}
+
+void IComponentUpdateList::setTickSettings(TickGroup group, TickInterval interval)
+{
+	m_tickGroup = group;
+	m_tickInterval = interval;
+}
+
+unsigned int IComponentUpdateList::getBucket(const TickInterval& interval)
+{
+	int best = -1;
+	for (size_t i = 0; i < m_buckets.size(); i++)
+	{
+		if (m_buckets[i].interval != interval) continue;
+
+		if (best < 0 || m_buckets[i].components.size() < m_buckets[best].components.size())
+			best = (int)i;
+	}
+
+	if (best >= 0) return (unsigned int)best;
+
+	// Frame based intervals get one bucket per frame of the interval, and frequency based ones a fixed number,
+	// each offset from the last so the interval's components are spread evenly over it.
+	unsigned int bucketCount = interval.seconds > 0.0f ? TICK_FREQUENCY_BUCKETS : interval.frames;
+	best = (int)m_buckets.size();
+
+	for (unsigned int i = 0; i < bucketCount; i++)
+	{
+		TickBucket bucket;
+		bucket.components = std::vector<Component*>();
+		bucket.interval = interval;
+		bucket.phase = i;
+		bucket.timeUntilTick = interval.seconds * i / bucketCount;
+		bucket.timeSinceTick = 0.0f;
+		bucket.due = false;
+		bucket.deltaTime = 0.0f;
+
+		m_buckets.push_back(bucket);
+	}
+
+	return (unsigned int)best;
+}
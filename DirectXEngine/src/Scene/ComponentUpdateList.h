@@ -0,0 +1,162 @@
+#pragma once
+
+#include "../Component/Component.h"
+#include "SystemScheduler.h"
+#include "TickSettings.h"
+
+#include <type_traits>
+#include <vector>
+
+// Compile time check for whether a component type overrides Component::update or Component::lateUpdate.
+// If a type doesn't declare its own override, &T::update resolves to the base class member and has Component's member pointer type.
+template<typename T>
+struct ComponentUpdateTraits
+{
+	static constexpr bool hasUpdate = !std::is_same<decltype(&T::update), void(Component::*)(float, float)>::value;
+	static constexpr bool hasLateUpdate = !std::is_same<decltype(&T::lateUpdate), void(Component::*)(float, float)>::value;
+};
+
+// A list of all of the active components of one exact type that need to be ticked.
+// The scene keeps one of these per ticking component type and iterates them type by type.
+// Components are kept in buckets by how often they tick. Every-frame components share one bucket, and throttled
+// components are spread over several buckets that tick on different frames, so a bucket that isn't due costs nothing.
+class IComponentUpdateList
+{
+public:
+	IComponentUpdateList();
+	virtual ~IComponentUpdateList() {}
+
+	void add(Component* component);
+	void remove(Component* component);
+
+	// Works out which buckets tick this frame. Called once per frame before any of the list's updates.
+	void beginFrame(unsigned int frameIndex, float deltaTime);
+
+	// Ticks the components in the buckets that are due, each with the time since its bucket last ticked.
+	virtual void update(float totalTime) = 0;
+	virtual void lateUpdate(float totalTime) = 0;
+
+	virtual bool hasUpdate() const = 0;
+	virtual bool hasLateUpdate() const = 0;
+	size_t size() const;
+
+	// What this component type's update and lateUpdate read and write, used to schedule the list alongside others.
+	const SystemAccess& getAccess() const { return m_access; }
+	void setAccess(const SystemAccess& access) { m_access = access; }
+
+	// Which group this component type's update runs in, and how often components that don't override it tick.
+	TickGroup getTickGroup() const { return m_tickGroup; }
+	void setTickSettings(TickGroup group, TickInterval interval);
+
+protected:
+	struct TickBucket
+	{
+		std::vector<Component*> components;
+
+		TickInterval interval;
+		// Which of the interval's frames this bucket ticks on, for frame based intervals
+		unsigned int phase;
+
+		// Time until a frequency based bucket is due, and time since the bucket last ticked
+		float timeUntilTick;
+		float timeSinceTick;
+
+		bool due;
+		float deltaTime;
+	};
+
+	std::vector<TickBucket> m_buckets;
+
+	// Removing a component while the list is being ticked empties its slot instead of swapping another component
+	// into it, so a component that hasn't ticked yet is never skipped. Emptied slots are compacted away once the loop ends.
+	void beginTicking();
+	void endTicking();
+
+private:
+	// Returns the least full bucket for an interval, creating the interval's buckets the first time it's used.
+	unsigned int getBucket(const TickInterval& interval);
+
+	SystemAccess m_access;
+
+	bool m_ticking;
+	bool m_removedWhileTicking;
+
+	TickGroup m_tickGroup;
+	TickInterval m_tickInterval;
+};
+
+template<typename T>
+class ComponentUpdateList : public IComponentUpdateList
+{
+public:
+	static IComponentUpdateList* create();
+
+	void update(float totalTime) override;
+	void lateUpdate(float totalTime) override;
+
+	bool hasUpdate() const override;
+	bool hasLateUpdate() const override;
+};
+
+template<typename T>
+inline IComponentUpdateList* ComponentUpdateList<T>::create()
+{
+	static_assert(std::is_base_of<Component, T>::value, "Given type is not a Component.");
+	return new ComponentUpdateList<T>();
+}
+
+template<typename T>
+inline void ComponentUpdateList<T>::update(float totalTime)
+{
+	if (!ComponentUpdateTraits<T>::hasUpdate) return;
+
+	// Qualified calls so the update is bound to T's implementation instead of going through the vtable.
+	// Sizes are re-read each iteration in case an update adds another component of this type.
+	beginTicking();
+	for (size_t i = 0; i < m_buckets.size(); i++)
+	{
+		if (!m_buckets[i].due) continue;
+
+		// Indexed rather than held by reference, since an update adding a component can add buckets
+		for (size_t j = 0; j < m_buckets[i].components.size(); j++)
+		{
+			Component* component = m_buckets[i].components[j];
+			if (component)
+				static_cast<T*>(component)->T::update(m_buckets[i].deltaTime, totalTime);
+		}
+	}
+	endTicking();
+}
+
+template<typename T>
+inline void ComponentUpdateList<T>::lateUpdate(float totalTime)
+{
+	if (!ComponentUpdateTraits<T>::hasLateUpdate) return;
+
+	beginTicking();
+	for (size_t i = 0; i < m_buckets.size(); i++)
+	{
+		if (!m_buckets[i].due) continue;
+
+		// Indexed rather than held by reference, since an update adding a component can add buckets
+		for (size_t j = 0; j < m_buckets[i].components.size(); j++)
+		{
+			Component* component = m_buckets[i].components[j];
+			if (component)
+				static_cast<T*>(component)->T::lateUpdate(m_buckets[i].deltaTime, totalTime);
+		}
+	}
+	endTicking();
+}
+
+template<typename T>
+inline bool ComponentUpdateList<T>::hasUpdate() const
+{
+	return ComponentUpdateTraits<T>::hasUpdate;
+}
+
+template<typename T>
+inline bool ComponentUpdateList<T>::hasLateUpdate() const
+{
+	return ComponentUpdateTraits<T>::hasLateUpdate;
+}
@@ -0,0 +1,126 @@
+#include "Frustum.h"
+
+using namespace DirectX;
+
+Frustum Frustum::fromViewProjection(const XMFLOAT4X4& viewProjectionMatrix)
+{
+	// Points are row vectors, so each clip space coordinate is a dot product with a column of the matrix.
+	// A point is inside when -w <= x <= w, -w <= y <= w and 0 <= z <= w.
+	const XMFLOAT4X4& m = viewProjectionMatrix;
+	XMVECTOR x = XMVectorSet(m._11, m._21, m._31, m._41);
+	XMVECTOR y = XMVectorSet(m._12, m._22, m._32, m._42);
+	XMVECTOR z = XMVectorSet(m._13, m._23, m._33, m._43);
+	XMVECTOR w = XMVectorSet(m._14, m._24, m._34, m._44);
+
+	XMVECTOR planes[FRUSTUMPLANE_COUNT];
+	planes[FRUSTUMPLANE_LEFT] = XMVectorAdd(w, x);
+	planes[FRUSTUMPLANE_RIGHT] = XMVectorSubtract(w, x);
+	planes[FRUSTUMPLANE_BOTTOM] = XMVectorAdd(w, y);
+	planes[FRUSTUMPLANE_TOP] = XMVectorSubtract(w, y);
+	planes[FRUSTUMPLANE_NEAR] = z;
+	planes[FRUSTUMPLANE_FAR] = XMVectorSubtract(w, z);
+
+	Frustum frustum;
+	for (unsigned int i = 0; i < FRUSTUMPLANE_COUNT; i++)
+	{
+		XMStoreFloat4(&frustum.planes[i], XMPlaneNormalize(planes[i]));
+	}
+
+	return frustum;
+}
+
+Frustum Frustum::fromBox(const XMFLOAT3& min, const XMFLOAT3& max, const XMFLOAT4X4& viewMatrix)
+{
+	XMVECTOR planes[FRUSTUMPLANE_COUNT];
+	planes[FRUSTUMPLANE_LEFT] = XMVectorSet(1.0f, 0.0f, 0.0f, -min.x);
+	planes[FRUSTUMPLANE_RIGHT] = XMVectorSet(-1.0f, 0.0f, 0.0f, max.x);
+	planes[FRUSTUMPLANE_BOTTOM] = XMVectorSet(0.0f, 1.0f, 0.0f, -min.y);
+	planes[FRUSTUMPLANE_TOP] = XMVectorSet(0.0f, -1.0f, 0.0f, max.y);
+	planes[FRUSTUMPLANE_NEAR] = XMVectorSet(0.0f, 0.0f, 1.0f, -min.z);
+	planes[FRUSTUMPLANE_FAR] = XMVectorSet(0.0f, 0.0f, -1.0f, max.z);
+
+	// A plane is moved into world space by the transpose of the matrix that moves points out of it
+	XMMATRIX viewTranspose = XMMatrixTranspose(XMLoadFloat4x4(&viewMatrix));
+
+	Frustum frustum;
+	for (unsigned int i = 0; i < FRUSTUMPLANE_COUNT; i++)
+	{
+		XMStoreFloat4(&frustum.planes[i], XMPlaneNormalize(XMPlaneTransform(planes[i], viewTranspose)));
+	}
+
+	return frustum;
+}
+
+FrustumTestResult Frustum::testBox(const XMFLOAT3& center, const XMFLOAT3& extents) const
+{
+	XMVECTOR centerVec = XMVectorSet(center.x, center.y, center.z, 1.0f);
+	XMVECTOR extentsVec = XMLoadFloat3(&extents);
+
+	FrustumTestResult result = FRUSTUM_INSIDE;
+	for (unsigned int i = 0; i < FRUSTUMPLANE_COUNT; i++)
+	{
+		XMVECTOR plane = XMLoadFloat4(&planes[i]);
+
+		// How far the box reaches along the plane's normal, and how far its center is in front of the plane
+		float radius = XMVectorGetX(XMVector3Dot(extentsVec, XMVectorAbs(plane)));
+		float distance = XMVectorGetX(XMVector4Dot(centerVec, plane));
+
+		if (distance < -radius)
+			return FRUSTUM_OUTSIDE;
+
+		if (distance < radius)
+			result = FRUSTUM_INTERSECTS;
+	}
+
+	return result;
+}
+
+unsigned int Frustum::testBoundsBatch(const XMFLOAT3* centers, const XMFLOAT3* extents, const float* radii) const
+{
+	// Structure of arrays, so each vector holds one value from all four volumes
+	XMVECTOR centerX = XMVectorSet(centers[0].x, centers[1].x, centers[2].x, centers[3].x);
+	XMVECTOR centerY = XMVectorSet(centers[0].y, centers[1].y, centers[2].y, centers[3].y);
+	XMVECTOR centerZ = XMVectorSet(centers[0].z, centers[1].z, centers[2].z, centers[3].z);
+
+	XMVECTOR extentsX = XMVectorSet(extents[0].x, extents[1].x, extents[2].x, extents[3].x);
+	XMVECTOR extentsY = XMVectorSet(extents[0].y, extents[1].y, extents[2].y, extents[3].y);
+	XMVECTOR extentsZ = XMVectorSet(extents[0].z, extents[1].z, extents[2].z, extents[3].z);
+
+	XMVECTOR radius = XMVectorSet(radii[0], radii[1], radii[2], radii[3]);
+
+	XMVECTOR outside = XMVectorFalseInt();
+	for (unsigned int i = 0; i < FRUSTUMPLANE_COUNT; i++)
+	{
+		XMVECTOR plane = XMLoadFloat4(&planes[i]);
+		XMVECTOR planeX = XMVectorSplatX(plane);
+		XMVECTOR planeY = XMVectorSplatY(plane);
+		XMVECTOR planeZ = XMVectorSplatZ(plane);
+		XMVECTOR planeW = XMVectorSplatW(plane);
+
+		XMVECTOR distance = XMVectorMultiplyAdd(centerX, planeX, XMVectorMultiplyAdd(centerY, planeY, XMVectorMultiplyAdd(centerZ, planeZ, planeW)));
+
+		// How far the box reaches along the plane's normal. Whichever of the box and sphere reaches less is the tighter test.
+		XMVECTOR boxRadius = XMVectorMultiplyAdd(extentsX, XMVectorAbs(planeX), XMVectorMultiplyAdd(extentsY, XMVectorAbs(planeY), XMVectorMultiply(extentsZ, XMVectorAbs(planeZ))));
+		XMVECTOR reach = XMVectorMin(radius, boxRadius);
+
+		outside = XMVectorOrInt(outside, XMVectorLess(distance, XMVectorNegate(reach)));
+	}
+
+	XMUINT4 outsideLanes;
+	XMStoreUInt4(&outsideLanes, outside);
+
+	return (outsideLanes.x ? 0 : 1) | (outsideLanes.y ? 0 : 2) | (outsideLanes.z ? 0 : 4) | (outsideLanes.w ? 0 : 8);
+}
+
+bool Frustum::intersectsSphere(const XMFLOAT3& center, float radius) const
+{
+	XMVECTOR centerVec = XMVectorSet(center.x, center.y, center.z, 1.0f);
+
+	for (unsigned int i = 0; i < FRUSTUMPLANE_COUNT; i++)
+	{
+		if (XMVectorGetX(XMVector4Dot(centerVec, XMLoadFloat4(&planes[i]))) < -radius)
+			return false;
+	}
+
+	return true;
+}
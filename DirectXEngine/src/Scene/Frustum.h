@@ -0,0 +1,40 @@
+#pragma once
+
+#include <DirectXMath.h>
+
+enum FrustumTestResult
+{
+	FRUSTUM_OUTSIDE,
+	FRUSTUM_INTERSECTS,
+	FRUSTUM_INSIDE
+};
+
+enum FrustumPlane
+{
+	FRUSTUMPLANE_LEFT,
+	FRUSTUMPLANE_RIGHT,
+	FRUSTUMPLANE_BOTTOM,
+	FRUSTUMPLANE_TOP,
+	FRUSTUMPLANE_NEAR,
+	FRUSTUMPLANE_FAR,
+	FRUSTUMPLANE_COUNT
+};
+
+// A view volume as six planes, each stored as (normal, distance) with the normal pointing into the volume.
+struct Frustum
+{
+	DirectX::XMFLOAT4 planes[FRUSTUMPLANE_COUNT];
+
+	// Extracts the planes of a view projection matrix, so anything the matrix maps into clip space is inside.
+	static Frustum fromViewProjection(const DirectX::XMFLOAT4X4& viewProjectionMatrix);
+
+	// Builds the planes of a box given in the space a rigid view matrix transforms into, like an orthographic view volume.
+	static Frustum fromBox(const DirectX::XMFLOAT3& min, const DirectX::XMFLOAT3& max, const DirectX::XMFLOAT4X4& viewMatrix);
+
+	FrustumTestResult testBox(const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents) const;
+	bool intersectsSphere(const DirectX::XMFLOAT3& center, float radius) const;
+
+	// Tests four bounding volumes at once, one per SIMD lane. Each is a box and a sphere around the same center,
+	// and is rejected if either is entirely outside any plane. Returns a mask with bit i set if volume i may be visible.
+	unsigned int testBoundsBatch(const DirectX::XMFLOAT3* centers, const DirectX::XMFLOAT3* extents, const float* radii) const;
+};
@@ -0,0 +1,408 @@
+#include "LooseOctree.h"
+
+#include "../Entity.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+LooseOctree::LooseOctree()
+{
+	m_nodes = std::vector<Node>();
+	m_freeNodes = std::vector<int>();
+
+	m_entries = std::vector<Entry>();
+	m_entryIndices = std::unordered_map<const Entity*, unsigned int>();
+
+	clear();
+}
+
+void LooseOctree::update(Entity* entity, const XMFLOAT3& center, const XMFLOAT3& extents)
+{
+	int nodeIndex = findNode(center, extents);
+
+	auto it = m_entryIndices.find(entity);
+	if (it != m_entryIndices.end())
+	{
+		Entry& entry = m_entries[it->second];
+		entry.center = center;
+		entry.extents = extents;
+
+		// Most moves stay within the same node, which only needs the new bounds
+		if (entry.node == nodeIndex) return;
+
+		// Pruned after adding, since the new node can be a child of the old one
+		int oldNodeIndex = entry.node;
+		removeFromNode(it->second);
+		addToNode(it->second, nodeIndex);
+		pruneNode(oldNodeIndex);
+		return;
+	}
+
+	Entry entry;
+	entry.entity = entity;
+	entry.center = center;
+	entry.extents = extents;
+	entry.node = -1;
+	entry.nodeSlot = 0;
+
+	unsigned int entryIndex = (unsigned int)m_entries.size();
+	m_entries.push_back(entry);
+	m_entryIndices[entity] = entryIndex;
+
+	addToNode(entryIndex, nodeIndex);
+}
+
+void LooseOctree::remove(const Entity* entity)
+{
+	auto it = m_entryIndices.find(entity);
+	if (it == m_entryIndices.end()) return;
+
+	unsigned int entryIndex = it->second;
+	m_entryIndices.erase(it);
+
+	int nodeIndex = m_entries[entryIndex].node;
+	removeFromNode(entryIndex);
+	pruneNode(nodeIndex);
+
+	// Swap the last entry into the removed slot to keep the entries contiguous
+	unsigned int lastIndex = (unsigned int)m_entries.size() - 1;
+	if (entryIndex != lastIndex)
+	{
+		Entry& moved = m_entries[lastIndex];
+		m_nodes[moved.node].entries[moved.nodeSlot] = entryIndex;
+		m_entryIndices[moved.entity] = entryIndex;
+		m_entries[entryIndex] = moved;
+	}
+
+	m_entries.pop_back();
+}
+
+void LooseOctree::clear()
+{
+	m_nodes.clear();
+	m_freeNodes.clear();
+	m_entries.clear();
+	m_entryIndices.clear();
+
+	createNode(-1, XMFLOAT3(0, 0, 0), OCTREE_ROOT_HALF_SIZE);
+}
+
+void LooseOctree::queryRadius(const XMFLOAT3& center, float radius, std::vector<Entity*>& results) const
+{
+	float radiusSquared = radius * radius;
+
+	query([&](const XMFLOAT3& nodeCenter, const XMFLOAT3& nodeExtents)
+	{
+		return distanceSquaredToBox(center, nodeCenter, nodeExtents) <= radiusSquared ? FRUSTUM_INTERSECTS : FRUSTUM_OUTSIDE;
+	},
+	[&](const Entry& entry)
+	{
+		return distanceSquaredToBox(center, entry.center, entry.extents) <= radiusSquared;
+	}, results);
+}
+
+void LooseOctree::queryBox(const XMFLOAT3& center, const XMFLOAT3& extents, std::vector<Entity*>& results) const
+{
+	auto overlaps = [&](const XMFLOAT3& boxCenter, const XMFLOAT3& boxExtents)
+	{
+		return fabsf(boxCenter.x - center.x) <= boxExtents.x + extents.x
+			&& fabsf(boxCenter.y - center.y) <= boxExtents.y + extents.y
+			&& fabsf(boxCenter.z - center.z) <= boxExtents.z + extents.z;
+	};
+
+	query([&](const XMFLOAT3& nodeCenter, const XMFLOAT3& nodeExtents)
+	{
+		if (!overlaps(nodeCenter, nodeExtents))
+			return FRUSTUM_OUTSIDE;
+
+		bool contained = fabsf(nodeCenter.x - center.x) + nodeExtents.x <= extents.x
+			&& fabsf(nodeCenter.y - center.y) + nodeExtents.y <= extents.y
+			&& fabsf(nodeCenter.z - center.z) + nodeExtents.z <= extents.z;
+
+		return contained ? FRUSTUM_INSIDE : FRUSTUM_INTERSECTS;
+	},
+	[&](const Entry& entry)
+	{
+		return overlaps(entry.center, entry.extents);
+	}, results);
+}
+
+void LooseOctree::queryFrustum(const Frustum& frustum, std::vector<Entity*>& results) const
+{
+	query([&](const XMFLOAT3& nodeCenter, const XMFLOAT3& nodeExtents)
+	{
+		return frustum.testBox(nodeCenter, nodeExtents);
+	},
+	[&](const Entry& entry)
+	{
+		return frustum.testBox(entry.center, entry.extents) != FRUSTUM_OUTSIDE;
+	}, results);
+}
+
+void LooseOctree::queryNearest(const XMFLOAT3& point, unsigned int count, float maxDistance, std::vector<Entity*>& results) const
+{
+	if (count == 0) return;
+
+	typedef std::pair<float, int> Candidate;
+
+	// Nodes are visited closest first, and the search stops once the next node is further away than the
+	// furthest of the closest entries found so far.
+	FrameVector<Candidate> nodes;
+	FrameVector<Candidate> nearest;
+	nearest.reserve(count + 1);
+
+	auto furthestFirst = [](const Candidate& a, const Candidate& b) { return a.first < b.first; };
+	auto closestFirst = [](const Candidate& a, const Candidate& b) { return a.first > b.first; };
+
+	float maxDistanceSquared = maxDistance < FLT_MAX ? maxDistance * maxDistance : FLT_MAX;
+
+	// The root holds entries that are outside of its bounds, so it's always searched
+	nodes.push_back(Candidate(0.0f, 0));
+
+	while (!nodes.empty())
+	{
+		std::pop_heap(nodes.begin(), nodes.end(), closestFirst);
+		Candidate node = nodes.back();
+		nodes.pop_back();
+
+		float cutoff = nearest.size() == count ? nearest.front().first : maxDistanceSquared;
+		if (node.first > cutoff) break;
+
+		const Node& current = m_nodes[node.second];
+		for (size_t i = 0; i < current.entries.size(); i++)
+		{
+			const Entry& entry = m_entries[current.entries[i]];
+			if (!entry.entity->getEnabled()) continue;
+
+			float distanceSquared = distanceSquaredToBox(point, entry.center, entry.extents);
+			if (distanceSquared > maxDistanceSquared) continue;
+
+			if (nearest.size() == count)
+			{
+				if (distanceSquared >= nearest.front().first) continue;
+
+				std::pop_heap(nearest.begin(), nearest.end(), furthestFirst);
+				nearest.pop_back();
+			}
+
+			nearest.push_back(Candidate(distanceSquared, (int)current.entries[i]));
+			std::push_heap(nearest.begin(), nearest.end(), furthestFirst);
+		}
+
+		for (unsigned int i = 0; i < 8; i++)
+		{
+			int childIndex = current.children[i];
+			if (childIndex < 0) continue;
+
+			const Node& child = m_nodes[childIndex];
+			float looseSize = child.halfSize * 2.0f;
+			float distanceSquared = distanceSquaredToBox(point, child.center, XMFLOAT3(looseSize, looseSize, looseSize));
+
+			nodes.push_back(Candidate(distanceSquared, childIndex));
+			std::push_heap(nodes.begin(), nodes.end(), closestFirst);
+		}
+	}
+
+	std::sort_heap(nearest.begin(), nearest.end(), furthestFirst);
+	for (size_t i = 0; i < nearest.size(); i++)
+	{
+		results.push_back(m_entries[nearest[i].second].entity);
+	}
+}
+
+size_t LooseOctree::size() const
+{
+	return m_entries.size();
+}
+
+int LooseOctree::findNode(const XMFLOAT3& center, const XMFLOAT3& extents)
+{
+	float size = extents.x > extents.y ? extents.x : extents.y;
+	size = size > extents.z ? size : extents.z;
+
+	// Anything too big for the root or centered outside of it stays in the root
+	if (size > OCTREE_ROOT_HALF_SIZE
+		|| fabsf(center.x) > OCTREE_ROOT_HALF_SIZE
+		|| fabsf(center.y) > OCTREE_ROOT_HALF_SIZE
+		|| fabsf(center.z) > OCTREE_ROOT_HALF_SIZE)
+	{
+		return 0;
+	}
+
+	// Descend into the child containing the center for as long as the bounds are no bigger than the child.
+	// A node's loose bounds reach half a node past its edges, so they always contain the whole of the bounds.
+	int nodeIndex = 0;
+	for (unsigned int depth = 0; depth < OCTREE_MAX_DEPTH; depth++)
+	{
+		XMFLOAT3 nodeCenter = m_nodes[nodeIndex].center;
+		float childHalfSize = m_nodes[nodeIndex].halfSize * 0.5f;
+		if (size > childHalfSize) break;
+
+		unsigned int octant = (center.x >= nodeCenter.x ? 1 : 0) | (center.y >= nodeCenter.y ? 2 : 0) | (center.z >= nodeCenter.z ? 4 : 0);
+
+		int childIndex = m_nodes[nodeIndex].children[octant];
+		if (childIndex < 0)
+		{
+			XMFLOAT3 childCenter = XMFLOAT3(
+				nodeCenter.x + ((octant & 1) ? childHalfSize : -childHalfSize),
+				nodeCenter.y + ((octant & 2) ? childHalfSize : -childHalfSize),
+				nodeCenter.z + ((octant & 4) ? childHalfSize : -childHalfSize));
+
+			childIndex = createNode(nodeIndex, childCenter, childHalfSize);
+			m_nodes[nodeIndex].children[octant] = childIndex;
+		}
+
+		nodeIndex = childIndex;
+	}
+
+	return nodeIndex;
+}
+
+int LooseOctree::createNode(int parent, const XMFLOAT3& center, float halfSize)
+{
+	Node node;
+	node.center = center;
+	node.halfSize = halfSize;
+	node.parent = parent;
+	for (unsigned int i = 0; i < 8; i++)
+	{
+		node.children[i] = -1;
+	}
+	node.entries = std::vector<unsigned int>();
+	node.subtreeCount = 0;
+
+	if (!m_freeNodes.empty())
+	{
+		int nodeIndex = m_freeNodes.back();
+		m_freeNodes.pop_back();
+
+		m_nodes[nodeIndex] = node;
+		return nodeIndex;
+	}
+
+	m_nodes.push_back(node);
+	return (int)m_nodes.size() - 1;
+}
+
+void LooseOctree::addToNode(unsigned int entryIndex, int nodeIndex)
+{
+	Entry& entry = m_entries[entryIndex];
+	entry.node = nodeIndex;
+	entry.nodeSlot = (unsigned int)m_nodes[nodeIndex].entries.size();
+	m_nodes[nodeIndex].entries.push_back(entryIndex);
+
+	for (int i = nodeIndex; i >= 0; i = m_nodes[i].parent)
+	{
+		m_nodes[i].subtreeCount++;
+	}
+}
+
+void LooseOctree::removeFromNode(unsigned int entryIndex)
+{
+	Entry& entry = m_entries[entryIndex];
+	int nodeIndex = entry.node;
+
+	// Swap the node's last entry into the removed slot
+	std::vector<unsigned int>& entries = m_nodes[nodeIndex].entries;
+	unsigned int last = entries.back();
+	entries[entry.nodeSlot] = last;
+	m_entries[last].nodeSlot = entry.nodeSlot;
+	entries.pop_back();
+
+	entry.node = -1;
+
+	for (int i = nodeIndex; i >= 0; i = m_nodes[i].parent)
+	{
+		m_nodes[i].subtreeCount--;
+	}
+}
+
+void LooseOctree::pruneNode(int nodeIndex)
+{
+	// Free the node and its ancestors that are now empty. An empty node's children are already gone, since they were empty too.
+	while (nodeIndex > 0 && m_nodes[nodeIndex].subtreeCount == 0)
+	{
+		int parent = m_nodes[nodeIndex].parent;
+		for (unsigned int i = 0; i < 8; i++)
+		{
+			if (m_nodes[parent].children[i] == nodeIndex)
+				m_nodes[parent].children[i] = -1;
+		}
+
+		m_nodes[nodeIndex].entries.clear();
+		m_freeNodes.push_back(nodeIndex);
+		nodeIndex = parent;
+	}
+}
+
+template<typename NodeTest, typename EntryTest>
+void LooseOctree::query(const NodeTest& nodeTest, const EntryTest& entryTest, std::vector<Entity*>& results) const
+{
+	FrameVector<int> stack;
+	stack.push_back(0);
+
+	while (!stack.empty())
+	{
+		int nodeIndex = stack.back();
+		stack.pop_back();
+
+		const Node& node = m_nodes[nodeIndex];
+		if (node.subtreeCount == 0) continue;
+
+		// The root holds entries that are outside of its bounds, so it's always searched entry by entry
+		if (nodeIndex != 0)
+		{
+			float looseSize = node.halfSize * 2.0f;
+			FrustumTestResult result = nodeTest(node.center, XMFLOAT3(looseSize, looseSize, looseSize));
+
+			if (result == FRUSTUM_OUTSIDE)
+				continue;
+
+			if (result == FRUSTUM_INSIDE)
+			{
+				appendSubtree(nodeIndex, results);
+				continue;
+			}
+		}
+
+		for (size_t i = 0; i < node.entries.size(); i++)
+		{
+			const Entry& entry = m_entries[node.entries[i]];
+			if (entry.entity->getEnabled() && entryTest(entry))
+				results.push_back(entry.entity);
+		}
+
+		for (unsigned int i = 0; i < 8; i++)
+		{
+			if (node.children[i] >= 0)
+				stack.push_back(node.children[i]);
+		}
+	}
+}
+
+void LooseOctree::appendSubtree(int nodeIndex, std::vector<Entity*>& results) const
+{
+	const Node& node = m_nodes[nodeIndex];
+	for (size_t i = 0; i < node.entries.size(); i++)
+	{
+		Entity* entity = m_entries[node.entries[i]].entity;
+		if (entity->getEnabled())
+			results.push_back(entity);
+	}
+
+	for (unsigned int i = 0; i < 8; i++)
+	{
+		if (node.children[i] >= 0)
+			appendSubtree(node.children[i], results);
+	}
+}
+
+float LooseOctree::distanceSquaredToBox(const XMFLOAT3& point, const XMFLOAT3& center, const XMFLOAT3& extents)
+{
+	XMVECTOR offset = XMVectorSubtract(XMLoadFloat3(&point), XMLoadFloat3(&center));
+	XMVECTOR outside = XMVectorMax(XMVectorSubtract(XMVectorAbs(offset), XMLoadFloat3(&extents)), XMVectorZero());
+
+	return XMVectorGetX(XMVector3LengthSq(outside));
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "Frustum.h"
+#include "../Memory/FrameAllocator.h"
+
+#include <DirectXMath.h>
+#include <cfloat>
+#include <unordered_map>
+#include <vector>
+
+// Half the width of the octree's root node, centered on the origin. Entities outside it are kept in the root.
+#define OCTREE_ROOT_HALF_SIZE 1024.0f
+// How many times the root can be subdivided
+#define OCTREE_MAX_DEPTH 8
+
+class Entity;
+
+// A spatial index of entity bounds. Each node's bounds are loosened to twice its size, so an entity only ever lives
+// in one node (picked by its center and size) and moving it is a constant time reinsert instead of a rebalance.
+// Nodes are created as entities move into them and freed once nothing is left inside them.
+class LooseOctree
+{
+public:
+	LooseOctree();
+
+	// Adds an entity with the given world space bounds, or moves it if it's already in the tree.
+	void update(Entity* entity, const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents);
+	void remove(const Entity* entity);
+	void clear();
+
+	// Queries only read the tree, so any number can run at once as long as nothing is being updated.
+	// These append every active entity whose bounds touch the given volume to results, in no particular order.
+	void queryRadius(const DirectX::XMFLOAT3& center, float radius, std::vector<Entity*>& results) const;
+	void queryBox(const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents, std::vector<Entity*>& results) const;
+	void queryFrustum(const Frustum& frustum, std::vector<Entity*>& results) const;
+
+	// Appends up to count of the active entities whose bounds are closest to a point, nearest first.
+	void queryNearest(const DirectX::XMFLOAT3& point, unsigned int count, float maxDistance, std::vector<Entity*>& results) const;
+
+	size_t size() const;
+
+private:
+	struct Node
+	{
+		DirectX::XMFLOAT3 center;
+		float halfSize;
+
+		int parent;
+		int children[8];
+
+		// Indices of the entries that live in this node, and how many entries this node and its descendants hold
+		std::vector<unsigned int> entries;
+		unsigned int subtreeCount;
+	};
+
+	struct Entry
+	{
+		Entity* entity;
+		DirectX::XMFLOAT3 center;
+		DirectX::XMFLOAT3 extents;
+
+		int node;
+		unsigned int nodeSlot;
+	};
+
+	// Finds the node that bounds of the given size centered at the given point belong in, creating it if needed.
+	int findNode(const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents);
+	int createNode(int parent, const DirectX::XMFLOAT3& center, float halfSize);
+
+	void addToNode(unsigned int entryIndex, int nodeIndex);
+	void removeFromNode(unsigned int entryIndex);
+	void pruneNode(int nodeIndex);
+
+	// Walks every node the node test doesn't reject, appending the entries that pass the entry test.
+	// The node test classifies a node's loose bounds as outside, intersecting or inside the queried volume.
+	// Nodes entirely inside the queried volume have all of their entries appended without testing them.
+	template<typename NodeTest, typename EntryTest>
+	void query(const NodeTest& nodeTest, const EntryTest& entryTest, std::vector<Entity*>& results) const;
+	void appendSubtree(int nodeIndex, std::vector<Entity*>& results) const;
+
+	static float distanceSquaredToBox(const DirectX::XMFLOAT3& point, const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents);
+
+	std::vector<Node> m_nodes;
+	std::vector<int> m_freeNodes;
+
+	std::vector<Entry> m_entries;
+	std::unordered_map<const Entity*, unsigned int> m_entryIndices;
+};
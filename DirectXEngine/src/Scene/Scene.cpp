@@ -1,9 +1,15 @@
 #include "Scene.h"
 
+#include "ComponentUpdateList.h"
+#include "../Component/ComponentRegistry.h"
 #include "../Component/FreeCamControls.h"
 #include "../Component/GUIDebugSpriteComponent.h"
+#include "../Job/JobSystem.h"
+#include "../Util.h"
 
 #include "rapidjson/error/en.h"
+#include <algorithm>
+#include <cstring>
 #include <fstream>
 #include <string>
 
@@ -16,24 +22,71 @@ Scene::Scene()
 	m_entityCount = 0;
 	m_entities = std::vector<Entity*>();
 	m_taggedEntities = std::unordered_map<std::string, std::vector<Entity*>>();
+	m_activeGUIs = std::vector<GUIComponent*>();
+	m_activeGUIsDirty = true;
+
+	m_poolReservations = std::unordered_map<std::string, unsigned int>();
+
+	m_updateListsByType = std::unordered_map<std::type_index, IComponentUpdateList*>();
+	m_tickingLists = std::vector<IComponentUpdateList*>();
+	for (unsigned int i = 0; i < TICKGROUP_COUNT; i++)
+	{
+		m_updateLists[i] = std::vector<IComponentUpdateList*>();
+	}
+	m_lateUpdateLists = std::vector<IComponentUpdateList*>();
+	m_frameIndex = 0;
+
+	m_queriesByType = std::unordered_map<std::type_index, IComponentQuery*>();
+	m_queries = std::vector<IComponentQuery*>();
+
+	m_commandBuffers = std::vector<SceneCommandBuffer>();
+	m_systemOrder = 0;
+	m_playbackCommands = std::vector<SceneCommand>();
+	m_playbackDeletedEntities = std::vector<Entity*>();
+	m_playbackRemovedComponents = std::unordered_set<Component*>();
 
 	m_debugCamera = nullptr;
 	m_mainCamera = nullptr;
 
+	XMStoreFloat4x4(&m_lastDebugViewMatrix, XMMatrixIdentity());
+	m_debugIconSlice = 0;
+
+	m_renderSnapshotIndex = 0;
+
 	m_dirty = false;
 }
 
 Scene::~Scene()
 {
-	delete m_debugCamera;
+	TypePools::destroy(m_debugCamera);
 
 	for (unsigned int i = 0; i < m_entities.size(); i++)
 	{
-		delete m_entities[i];
+		TypePools::destroy(m_entities[i]);
 	}
 	m_entities.clear();
 	m_taggedEntities.clear();
 
+	// Deleted after the entities since deleting their components removes them from these lists
+	for (auto it = m_updateListsByType.begin(); it != m_updateListsByType.end(); it++)
+	{
+		delete it->second;
+	}
+	m_updateListsByType.clear();
+	m_tickingLists.clear();
+	for (unsigned int i = 0; i < TICKGROUP_COUNT; i++)
+	{
+		m_updateLists[i].clear();
+	}
+	m_lateUpdateLists.clear();
+
+	for (unsigned int i = 0; i < m_queries.size(); i++)
+	{
+		delete m_queries[i];
+	}
+	m_queriesByType.clear();
+	m_queries.clear();
+
 	AssetManager::unloadAllAssets();
 }
 
@@ -47,7 +100,10 @@ bool Scene::init()
 	addTag(TAG_COLLIDER);
 	addTag(TAG_PHYSICSBODY);
 
-	m_debugCamera = new Entity(*this, 0, "DebugCamera", false);
+	// One command buffer per worker thread so recording a command never needs a lock
+	m_commandBuffers.resize(JobSystem::getWorkerCount());
+
+	m_debugCamera = new (TypePools::get<Entity>().allocate()) Entity(*this, 0, "DebugCamera", false);
 	Transform* debugCameraTransform = m_debugCamera->addComponent<Transform>();
 	debugCameraTransform->move(XMFLOAT3(0, 10, -10));
 	debugCameraTransform->rotateLocalX(30);
@@ -61,19 +117,14 @@ void Scene::update(float deltaTime, float totalTime)
 {
 	if (Debug::inPlayMode)
 	{
-		// Update all entities in the scene
-		for (unsigned int i = 0; i < m_entities.size(); i++)
+		// Work out which of each type's buckets of components tick this frame, then update the ones that go before physics
+		for (unsigned int i = 0; i < m_tickingLists.size(); i++)
 		{
-			if (m_entities[i]->getEnabled())
-				m_entities[i]->update(deltaTime, totalTime);
+			m_tickingLists[i]->beginFrame(m_frameIndex, deltaTime);
 		}
+		m_frameIndex++;
 
-		// LateUpdate for all entities in the scene
-		for (unsigned int i = 0; i < m_entities.size(); i++)
-		{
-			if (m_entities[i]->getEnabled())
-				m_entities[i]->lateUpdate(deltaTime, totalTime);
-		}
+		tick(TICKGROUP_PRE_PHYSICS, totalTime);
 	}
 	else
 	{
@@ -81,19 +132,13 @@ void Scene::update(float deltaTime, float totalTime)
 		m_debugCamera->update(deltaTime, totalTime);
 		m_debugCamera->lateUpdate(deltaTime, totalTime);
 
-		for (unsigned int i = 0; i < m_entities.size(); i++)
-		{
-			Transform* entityTransform = m_entities[i]->getComponent<Transform>();
-			DebugEntity* entityDebugIcon = m_entities[i]->getDebugIcon();
-			if (entityDebugIcon && entityTransform)
-			{
-				GUIDebugSpriteComponent* debugIconSpriteComponent = entityDebugIcon->getGUIDebugSpriteComponent();
-				debugIconSpriteComponent->update(deltaTime, totalTime);
-				debugIconSpriteComponent->calculatePosition(entityTransform->getPosition());
-			}
+		updateDebugIcons(deltaTime, totalTime);
 
-			// Run lateUpdate for light components regardless if they're enabled since they need to update in debug mode.
-			LightComponent* lightComponent = m_entities[i]->getComponent<LightComponent>();
+		// Run lateUpdate for light components regardless if they're enabled since they need to update in debug mode.
+		const std::vector<Entity*>& lights = getAllEntitiesWithTag(TAG_LIGHT);
+		for (unsigned int i = 0; i < lights.size(); i++)
+		{
+			LightComponent* lightComponent = lights[i]->getComponent<LightComponent>();
 			if (lightComponent)
 			{
 				lightComponent->lateUpdate(deltaTime, totalTime);
@@ -101,38 +146,36 @@ void Scene::update(float deltaTime, float totalTime)
 		}
 #endif
 	}
+
+	// Every update has finished, so it's safe to make the structural changes they asked for
+	playbackCommands();
+
+	// Bring every transform that moved this frame up to date in one pass, rather than one at a time as they're read
+	updateTransforms();
 }
 
 void Scene::handlePhysics(PhysicsHandler* physicsHandler)
 {
 	if (Debug::inPlayMode)
 	{
-		// Integrate physics bodies (rigid and soft)
-		std::vector<Entity*> bodyEntities = m_taggedEntities.at(TAG_PHYSICSBODY);
-		for (unsigned int i = 0; i < bodyEntities.size(); i++)
+		// Integrate physics bodies (rigid and soft). Queries only hold active bodies and colliders,
+		// so disabled ones (and anything under a disabled parent) cost nothing here.
+		const ComponentQuery<IPhysicsBody>& bodies = query<IPhysicsBody>();
+		for (unsigned int i = 0; i < bodies.size(); i++)
 		{
-			if (!bodyEntities[i]->getEnabled()) continue;
-
-			IPhysicsBody* body = bodyEntities[i]->getComponent<IPhysicsBody>();
-			if (body && body->enabled)
-			{
-				body->integrateForces();
-				body->integrateVelocity();
-			}
+			IPhysicsBody* body = bodies[i].get<IPhysicsBody>();
+			body->integrateForces();
+			body->integrateVelocity();
 		}
 
 		// Check for and resolve collisions
-		std::vector<Collider*> colliders = std::vector<Collider*>();
+		const ComponentQuery<Collider>& colliderMatches = query<Collider>();
 
-		std::vector<Entity*> colliderEntities = m_taggedEntities.at(TAG_COLLIDER);
-		for (unsigned int i = 0; i < colliderEntities.size(); i++)
+		FrameVector<Collider*> colliders;
+		colliders.reserve(colliderMatches.size());
+		for (unsigned int i = 0; i < colliderMatches.size(); i++)
 		{
-			if (!colliderEntities[i]->getEnabled()) continue;
-
-			Collider* collider = colliderEntities[i]->getComponent<Collider>();
-			if (collider && collider->enabled)
-				colliders.push_back(collider);
-
+			colliders.push_back(colliderMatches[i].get<Collider>());
 		}
 
 		if (colliders.size() > 0)
@@ -143,6 +186,30 @@ void Scene::handlePhysics(PhysicsHandler* physicsHandler)
 	}
 }
 
+void Scene::lateUpdate(float deltaTime, float totalTime)
+{
+	if (!Debug::inPlayMode) return;
+
+	tick(TICKGROUP_POST_PHYSICS, totalTime);
+
+	// Updates in the late group go before every component's lateUpdate
+	tick(TICKGROUP_LATE, totalTime);
+
+	m_transformHierarchy.update();
+
+	m_lateUpdateScheduler.clear();
+	for (unsigned int i = 0; i < m_lateUpdateLists.size(); i++)
+	{
+		scheduleUpdateList(m_lateUpdateScheduler, m_lateUpdateLists[i], true, totalTime);
+	}
+	runSystems(m_lateUpdateScheduler);
+
+	tick(TICKGROUP_PRE_RENDER, totalTime);
+
+	playbackCommands();
+	updateTransforms();
+}
+
 bool Scene::isDirty() const
 {
 	return m_dirty;
@@ -195,10 +262,41 @@ bool Scene::loadFromJSON(std::string filepath)
 	rapidjson::Value& assets = dom["assets"];
 	AssetManager::loadFromJSON(assets);
 
+	rapidjson::Value& entities = dom["entities"];
+
+	// Size the entity and component pools for everything in the file, plus whatever the scene asked to reserve for spawning
+	std::unordered_map<std::string, unsigned int> poolCounts;
+	poolCounts["Entity"] = entities.Size();
+	for (rapidjson::SizeType i = 0; i < entities.Size(); i++)
+	{
+		rapidjson::Value& components = entities[i]["components"];
+		for (rapidjson::SizeType j = 0; j < components.Size(); j++)
+		{
+			poolCounts[components[j]["type"].GetString()]++;
+		}
+	}
+
+	rapidjson::Value::MemberIterator poolReservations = dom.FindMember("poolReservations");
+	if (poolReservations != dom.MemberEnd())
+	{
+		for (auto it = poolReservations->value.MemberBegin(); it != poolReservations->value.MemberEnd(); it++)
+		{
+			std::string typeName = it->name.GetString();
+			m_poolReservations[typeName] = it->value.GetUint();
+
+			if (m_poolReservations[typeName] > poolCounts[typeName])
+				poolCounts[typeName] = m_poolReservations[typeName];
+		}
+	}
+
+	for (auto it = poolCounts.begin(); it != poolCounts.end(); it++)
+	{
+		reservePool(it->first, it->second);
+	}
+
 	// Load the scene's entities.
 	std::unordered_map<Entity*, std::vector<std::string>> childrenNames;
 
-	rapidjson::Value& entities = dom["entities"];
 	for (rapidjson::SizeType i = 0; i < entities.Size(); i++)
 	{
 		rapidjson::Value& entity = entities[i];
@@ -307,6 +405,19 @@ void Scene::saveToJSON(std::string filepath)
 	}
 	writer.EndArray();
 
+	// 3. Pool reservations, if the scene has any
+	if (m_poolReservations.size() > 0)
+	{
+		writer.Key("poolReservations");
+		writer.StartObject();
+		for (auto it = m_poolReservations.begin(); it != m_poolReservations.end(); it++)
+		{
+			writer.Key(it->first.c_str());
+			writer.Uint(it->second);
+		}
+		writer.EndObject();
+	}
+
 	writer.EndObject();
 
 	// Now stringify the DOM and save it to a file
@@ -357,16 +468,18 @@ std::vector<std::string> Scene::getAllTags() const
 	return tags;
 }
 
-void Scene::addTagToEntity(Entity& entity, std::string tag)
+void Scene::addTagToEntity(Entity& entity, std::string_view tag)
 {
-	if (m_taggedEntities.find(tag) == m_taggedEntities.end())
+	auto it = m_taggedEntities.find(Util::lookupKey(tag));
+	if (it == m_taggedEntities.end())
 	{
-		addTag(tag);
+		addTag(std::string(tag));
+		it = m_taggedEntities.find(Util::lookupKey(tag));
 	}
 
 	if (entity.hasTag(tag))
 	{
-		Debug::warning("Tag " + tag + " not added to entity " + entity.getName() + " because the entity already has this tag.");
+		Debug::warning("Tag " + std::string(tag) + " not added to entity " + entity.getName() + " because the entity already has this tag.");
 		return;
 	}
 
@@ -382,19 +495,23 @@ void Scene::addTagToEntity(Entity& entity, std::string tag)
 			setMainCamera(&entity);
 	}
 
-	m_taggedEntities[tag].push_back(&entity);
+	it->second.push_back(&entity);
 	entity.addTagNonResursive(tag);
+
+	if (tag == TAG_GUI)
+		m_activeGUIsDirty = true;
 }
 
-void Scene::removeTagFromEntity(Entity& entity, std::string tag)
+void Scene::removeTagFromEntity(Entity& entity, std::string_view tag)
 {
-	if (m_taggedEntities.find(tag) == m_taggedEntities.end())
+	auto it = m_taggedEntities.find(Util::lookupKey(tag));
+	if (it == m_taggedEntities.end())
 	{
-		Debug::warning("Could not remove tag " + tag + " from entity " + entity.getName() + " because the tag doesn't exist.");
+		Debug::warning("Could not remove tag " + std::string(tag) + " from entity " + entity.getName() + " because the tag doesn't exist.");
 		return;
 	}
 
-	std::vector<Entity*>& entities = m_taggedEntities.at(tag);
+	std::vector<Entity*>& entities = it->second;
 	for (unsigned int i = 0; i < entities.size(); i++)
 	{
 		if (entities[i] == &entity)
@@ -402,6 +519,9 @@ void Scene::removeTagFromEntity(Entity& entity, std::string tag)
 			entities[i]->removeTagNonRecursive(tag);
 			entities.erase(entities.begin() + i);
 
+			if (tag == TAG_GUI)
+				m_activeGUIsDirty = true;
+
 			if (tag == TAG_MAIN_CAMERA && m_mainCamera)
 				setMainCamera((Entity*)nullptr);
 
@@ -409,7 +529,7 @@ void Scene::removeTagFromEntity(Entity& entity, std::string tag)
 		}
 	}
 
-	Debug::warning("Tag " + tag + " not removed from entity " + entity.getName() + " because the entity does not have this tag.");
+	Debug::warning("Tag " + std::string(tag) + " not removed from entity " + entity.getName() + " because the entity does not have this tag.");
 }
 
 CameraComponent* Scene::getMainCamera() const
@@ -450,133 +570,550 @@ void Scene::setMainCamera(Entity* entity)
 	setMainCamera(camera);
 }
 
-CameraComponent* Scene::getDebugCamera() const
+void Scene::onComponentAdded(Component* component)
 {
-#if defined(DEBUG) || defined(_DEBUG)
-	return m_debugCamera->getComponent<CameraComponent>();
-#endif
+	refreshUpdateState(component);
+	refreshQueries(&component->getEntity(), component, nullptr);
+}
 
-	return nullptr;
+void Scene::onComponentRemoved(Component* component)
+{
+	IComponentUpdateList* updateList = getUpdateList(typeid(*component));
+	if (updateList)
+		updateList->remove(component);
+
+	// Only entities with a transform have a place in the spatial index
+	if (dynamic_cast<Transform*>(component))
+		m_spatialIndex.remove(&component->getEntity());
+
+	refreshQueries(&component->getEntity(), component, component);
 }
 
-void Scene::renderGeometry(Renderer* renderer, ID3D11RenderTargetView* backBufferRTV, ID3D11DepthStencilView* backBufferDSV, float width, float height)
+void Scene::onComponentEnabledChanged(Component* component)
 {
-	CameraComponent* camera = nullptr;
+	// Components that were never added to an entity (like debug icon components) aren't ticked by the scene
+	const std::vector<Component*>& components = component->getEntity().m_components;
+	if (std::find(components.begin(), components.end(), component) == components.end()) return;
 
-	if (Debug::inPlayMode)
+	refreshUpdateState(component);
+	refreshQueries(&component->getEntity(), component, nullptr);
+}
+
+void Scene::onEntityEnabledChanged(Entity* entity)
+{
+	for (unsigned int i = 0; i < entity->m_components.size(); i++)
 	{
-		if (m_mainCamera)
-			camera = m_mainCamera;
+		refreshUpdateState(entity->m_components[i]);
+	}
+	refreshQueries(entity, nullptr, nullptr);
+}
+
+void Scene::onComponentTickIntervalChanged(Component* component)
+{
+	IComponentUpdateList* updateList = getUpdateList(typeid(*component));
+	if (!updateList) return;
+
+	// Moves the component to a bucket for its new interval, if it's being ticked at all
+	updateList->remove(component);
+	refreshUpdateState(component);
+}
+
+IComponentUpdateList* Scene::getUpdateList(std::type_index type)
+{
+	auto it = m_updateListsByType.find(type);
+	if (it != m_updateListsByType.end())
+		return it->second;
+
+	// Remember types that don't need updating as well so the registry is only asked once per type
+	IComponentUpdateList* updateList = ComponentRegistry::createUpdateList(type);
+	m_updateListsByType[type] = updateList;
+
+	if (updateList)
+	{
+		m_tickingLists.push_back(updateList);
+
+		if (updateList->hasUpdate())
+			m_updateLists[updateList->getTickGroup()].push_back(updateList);
+
+		if (updateList->hasLateUpdate())
+			m_lateUpdateLists.push_back(updateList);
+	}
+
+	return updateList;
+}
+
+void Scene::refreshUpdateState(Component* component)
+{
+	// The debug camera is updated separately from the scene's entities
+	if (m_debugCamera && &component->getEntity() == m_debugCamera) return;
+
+	IComponentUpdateList* updateList = getUpdateList(typeid(*component));
+	if (!updateList) return;
+
+	if (component->getEnabled() && component->getEntity().getEnabled())
+		updateList->add(component);
+	else
+		updateList->remove(component);
+}
+
+void Scene::refreshQueries(Entity* entity, const Component* changedComponent, const Component* removedComponent)
+{
+	if (entity == m_debugCamera) return;
+
+	if (entity->hasTag(TAG_GUI))
+		m_activeGUIsDirty = true;
+
+	for (unsigned int i = 0; i < m_queries.size(); i++)
+	{
+		// Only queries that care about the changed component's type can be affected by it
+		if (changedComponent && !m_queries[i]->isInterestedIn(changedComponent)) continue;
+
+		m_queries[i]->refresh(entity, removedComponent);
+	}
+}
+
+void Scene::tick(TickGroup group, float totalTime)
+{
+	const std::vector<IComponentUpdateList*>& updateLists = m_updateLists[group];
+	if (updateLists.empty()) return;
+
+	// Reading a dirty transform recalculates its world matrix, so the hierarchy is brought up to date first.
+	// That way systems that only read transforms really only read them, and can run alongside each other.
+	m_transformHierarchy.update();
+
+	m_updateScheduler.clear();
+	for (unsigned int i = 0; i < updateLists.size(); i++)
+	{
+		scheduleUpdateList(m_updateScheduler, updateLists[i], false, totalTime);
+	}
+	runSystems(m_updateScheduler);
+}
+
+void Scene::scheduleUpdateList(SystemScheduler& scheduler, IComponentUpdateList* updateList, bool late, float totalTime)
+{
+	// Every other system that reads or writes transforms conflicts with this one and can't be running while it finishes,
+	// so the hierarchy can be updated from whichever worker ran it
+	bool writesTransforms = updateList->getAccess().canWrite(typeid(Transform));
+
+	// Numbered when it's scheduled rather than when it runs, since which systems run first depends on the workers
+	unsigned int systemOrder = ++m_systemOrder;
+
+	scheduler.addSystem(&updateList->getAccess(), [this, updateList, late, writesTransforms, totalTime, systemOrder]()
+	{
+		// Another system can run on this thread while this one waits, so the previous order is put back afterwards
+		SceneCommandBuffer& commands = getCommandBuffer();
+		unsigned int previousOrder = commands.m_systemOrder;
+		commands.m_systemOrder = systemOrder;
+
+		if (late)
+			updateList->lateUpdate(totalTime);
 		else
-			return;
+			updateList->update(totalTime);
+
+		commands.m_systemOrder = previousOrder;
+
+		if (writesTransforms)
+			m_transformHierarchy.update();
+	});
+}
+
+void Scene::runSystems(SystemScheduler& scheduler)
+{
+	scheduler.run();
+
+	// Commands recorded outside of a system go after those of every system that's run so far
+	m_systemOrder++;
+	for (unsigned int i = 0; i < m_commandBuffers.size(); i++)
+	{
+		m_commandBuffers[i].m_systemOrder = m_systemOrder;
+	}
+}
+
+void Scene::updateDebugIcons(float deltaTime, float totalTime)
+{
+	// Only runs in the editor, where every entity with a transform shows a clickable icon whether it's active or not,
+	// so this walks every entity rather than an active list.
+	// Icons only move on screen when their entity or the camera moves. While the camera is still,
+	// reposition a different slice of them each frame rather than all of them every frame.
+	XMFLOAT4X4 viewMatrix = getDebugCamera()->getViewMatrix();
+	bool cameraMoved = memcmp(&viewMatrix, &m_lastDebugViewMatrix, sizeof(XMFLOAT4X4)) != 0;
+	m_lastDebugViewMatrix = viewMatrix;
+
+	m_debugIconSlice = (m_debugIconSlice + 1) % DEBUG_ICON_REFRESH_FRAMES;
+
+	for (unsigned int i = 0; i < m_entities.size(); i++)
+	{
+		DebugEntity* entityDebugIcon = m_entities[i]->getDebugIcon();
+		if (!entityDebugIcon) continue;
+
+		Transform* entityTransform = m_entities[i]->getComponent<Transform>();
+		if (!entityTransform) continue;
+
+		// Always updated since it handles clicking on the icon
+		GUIDebugSpriteComponent* debugIconSpriteComponent = entityDebugIcon->getGUIDebugSpriteComponent();
+		debugIconSpriteComponent->update(deltaTime, totalTime);
+
+		// The selected entity is the one likely being moved in the editor, so its icon is always kept up to date
+		if (cameraMoved || m_entities[i]->selected || i % DEBUG_ICON_REFRESH_FRAMES == m_debugIconSlice)
+			debugIconSpriteComponent->calculatePosition(entityTransform->getPosition());
+	}
+}
+
+void Scene::updateTransforms()
+{
+	m_transformHierarchy.update();
+
+	const std::vector<Transform*>& movedTransforms = m_transformHierarchy.getMovedTransforms();
+	for (unsigned int i = 0; i < movedTransforms.size(); i++)
+	{
+		updateSpatialBounds(&movedTransforms[i]->getEntity());
+	}
+	m_transformHierarchy.clearMovedTransforms();
+}
+
+void Scene::updateSpatialBounds(Entity* entity)
+{
+	if (entity == m_debugCamera) return;
+
+	Transform* transform = entity->getComponent<Transform>();
+	if (!transform) return;
+
+	XMFLOAT3 center;
+	XMFLOAT3 extents;
+
+	MeshRenderComponent* meshRenderComponent = entity->getComponent<MeshRenderComponent>();
+	Mesh* mesh = meshRenderComponent ? meshRenderComponent->getMesh() : nullptr;
+	if (mesh)
+	{
+		XMFLOAT4X4 worldMatrix = transform->getWorldMatrix();
+		RenderSnapshot::transformBounds(mesh->getBoundsCenter(), mesh->getBoundsExtents(), worldMatrix, center, extents);
 	}
 	else
 	{
-		camera = m_debugCamera->getComponent<CameraComponent>();
+		center = transform->getPosition();
+		extents = XMFLOAT3(0, 0, 0);
 	}
 
-	std::vector<GPU_LIGHT_DATA> lightData = std::vector<GPU_LIGHT_DATA>(MAX_LIGHTS);
+	m_spatialIndex.update(entity, center, extents);
+}
 
-	std::vector<GPU_SHADOW_MATRICES> shadowMatrices = std::vector<GPU_SHADOW_MATRICES>(MAX_SHADOWMAPS);
-	std::vector<ID3D11ShaderResourceView*> shadowMapSRVs = std::vector<ID3D11ShaderResourceView*>(MAX_SHADOWMAPS);
+SceneCommandBuffer& Scene::getCommandBuffer()
+{
+	return m_commandBuffers[JobSystem::getThreadIndex()];
+}
 
-	// Preprocess each light entity to get it's position and direction, and see if it should cast shadows.
-	std::vector<Entity*> lightEntities = m_taggedEntities.at(TAG_LIGHT);
-	for (unsigned int i = 0; i < lightEntities.size() && i < MAX_LIGHTS; i++)
+void Scene::playbackCommands()
+{
+	// Take every thread's commands before playing any of them back, so commands recorded during playback
+	// (from a component's init, for example) are left for the next sync point instead of growing the list being played back.
+	m_playbackCommands.clear();
+	for (unsigned int i = 0; i < m_commandBuffers.size(); i++)
 	{
-		if (!lightEntities[i]->getEnabled()) continue;
+		std::vector<SceneCommand>& commands = m_commandBuffers[i].m_commands;
+		if (commands.empty()) continue;
+
+		if (m_playbackCommands.empty())
+			m_playbackCommands.swap(commands);
+		else
+		{
+			m_playbackCommands.insert(m_playbackCommands.end(), std::make_move_iterator(commands.begin()), std::make_move_iterator(commands.end()));
+			commands.clear();
+		}
+	}
 
-		LightComponent* lightComponent = lightEntities[i]->getComponent<LightComponent>();
+	if (m_playbackCommands.empty()) return;
 
-		if (!lightComponent || !lightComponent->enabled) continue;
+	// Play back in the order the systems were scheduled, then the order each system recorded its commands in.
+	// That keeps each entity's changes in the order they were asked for, and created entities (and their IDs)
+	// come out the same no matter which workers ran which systems.
+	std::sort(m_playbackCommands.begin(), m_playbackCommands.end(), [](const SceneCommand& a, const SceneCommand& b)
+	{
+		if (a.systemOrder != b.systemOrder) return a.systemOrder < b.systemOrder;
+		return a.sequence < b.sequence;
+	});
 
-		const LightSettings lightSettings = lightComponent->getLightSettings();
+	m_playbackDeletedEntities.clear();
+	m_playbackRemovedComponents.clear();
 
-		// Get position, direction, and type of each light
-		Transform* lightTransform = lightEntities[i]->getComponent<Transform>();
-		if (!lightTransform) continue;
+	for (unsigned int i = 0; i < m_playbackCommands.size(); i++)
+	{
+		SceneCommand& command = m_playbackCommands[i];
 
-		XMFLOAT3 lightPosition = lightTransform->getPosition();
-		XMFLOAT3 lightDirection = lightTransform->getForward();
+		switch (command.type)
+		{
+		case SCENECOMMAND_CREATE_ENTITY:
+		{
+			Entity* entity = createEntity(command.name);
+			if (command.onEntityCreated)
+				command.onEntityCreated(entity);
+			break;
+		}
+		case SCENECOMMAND_ADD_COMPONENT:
+		{
+			Component* component = command.addComponent(command.entity);
+			if (component && command.onComponentAdded)
+				command.onComponentAdded(component);
+			break;
+		}
+		case SCENECOMMAND_ADD_TAG:
+			// Several threads may have asked for the same tag
+			if (!command.entity->hasTag(command.name))
+				addTagToEntity(*command.entity, command.name);
+			break;
+		case SCENECOMMAND_REMOVE_TAG:
+			if (command.entity->hasTag(command.name))
+				removeTagFromEntity(*command.entity, command.name);
+			break;
+		case SCENECOMMAND_REMOVE_COMPONENT:
+			if (m_playbackRemovedComponents.insert(command.component).second)
+				command.entity->removeComponent(command.component);
+			break;
+		case SCENECOMMAND_DELETE_ENTITY:
+			// Left until every other command has been played back. Deleting gathers the entities into a set,
+			// so an entity deleted twice is only deleted once.
+			m_playbackDeletedEntities.push_back(command.entity);
+			break;
+		}
+	}
 
-		int lightType = (int)lightComponent->getLightType();
-		int shadowType = (int)lightComponent->getShadowType();
+	if (!m_playbackDeletedEntities.empty())
+		deleteEntities(m_playbackDeletedEntities);
 
-		bool shadowMapEnabled = false;
+	m_playbackCommands.clear();
+}
 
-		if (i < MAX_SHADOWMAPS)
+void Scene::deleteEntities(const std::vector<Entity*>& entities)
+{
+	std::unordered_set<Entity*> deletedEntities;
+	for (unsigned int i = 0; i < entities.size(); i++)
+	{
+		gatherEntityAndDescendants(entities[i], deletedEntities);
+	}
+
+	for (auto it = deletedEntities.begin(); it != deletedEntities.end(); it++)
+	{
+		Entity* entity = *it;
+
+		// Parents that are staying in the scene forget about their deleted children
+		Entity* parent = entity->m_parent;
+		if (parent && deletedEntities.find(parent) == deletedEntities.end())
 		{
-			if (lightComponent->canCastShadows())
-			{
-				Texture* shadowMap = lightComponent->getShadowMap();
-				if (shadowMap)
-				{
-					renderer->prepareShadowMapPass(shadowMap);
-					renderer->renderShadowMapPass(&m_entities[0], m_entities.size(), *lightComponent);
-
-					XMFLOAT4X4 lightViewT;
-					XMFLOAT4X4 lightView = lightComponent->getViewMatrix();
-					XMMATRIX lightViewMatrixT = XMMatrixTranspose(XMLoadFloat4x4(&lightView));
-					XMStoreFloat4x4(&lightViewT, lightViewMatrixT);
-
-					XMFLOAT4X4 lightProjT;
-					XMFLOAT4X4 lightProj = lightComponent->getProjectionMatrix();
-					XMMATRIX lightProjectionMatrixT = XMMatrixTranspose(XMLoadFloat4x4(&lightProj));
-					XMStoreFloat4x4(&lightProjT, lightProjectionMatrixT);
-
-					shadowMatrices[i] =
-					{
-						lightViewT,
-						lightProjT,
-					};
-
-					shadowMapSRVs[i] = shadowMap->getSRV();
-					shadowMapEnabled = true;
-				}
-			}
+			std::vector<Entity*>& siblings = parent->m_children;
+			siblings.erase(std::remove(siblings.begin(), siblings.end(), entity), siblings.end());
 		}
+	}
+
+	// The hierarchy between deleted entities is cut so they can be deleted in any order without touching each other
+	for (auto it = deletedEntities.begin(); it != deletedEntities.end(); it++)
+	{
+		(*it)->m_parent = nullptr;
+		(*it)->m_children.clear();
+	}
 
-		// Creates the final memory-aligned struct that is sent to the GPU
-		lightData[i] =
+	// One pass over each tag list instead of one search per tag per deleted entity
+	m_activeGUIsDirty = true;
+	for (auto it = m_taggedEntities.begin(); it != m_taggedEntities.end(); it++)
+	{
+		std::vector<Entity*>& taggedEntities = it->second;
+		taggedEntities.erase(std::remove_if(taggedEntities.begin(), taggedEntities.end(), [&deletedEntities](Entity* entity)
 		{
-			lightSettings.color,
-			lightDirection,
-			lightSettings.brightness,
-			lightPosition,
-			lightSettings.specularity,
-			lightSettings.radius,
-			lightSettings.spotAngle,
-			lightComponent->enabled,
-			lightType,
-			shadowMapEnabled,
-			shadowType
-		};
+			return deletedEntities.find(entity) != deletedEntities.end();
+		}), taggedEntities.end());
 	}
 
-	renderer->prepareMainPass(backBufferRTV, backBufferDSV, width, height);
+	if (m_mainCamera && deletedEntities.find(&m_mainCamera->getEntity()) != deletedEntities.end())
+		setMainCamera((Entity*)nullptr);
 
-	if(m_entities.size() > 0)
-		renderer->renderMainPass(*camera, Window::getProjectionMatrix(), &m_entities[0], m_entities.size(), &lightData[0], &shadowMatrices[0], &shadowMapSRVs[0]);
+	// Compact the entity list in a single pass, deleting entities as they're found
+	unsigned int remaining = 0;
+	for (unsigned int i = 0; i < m_entities.size(); i++)
+	{
+		if (deletedEntities.find(m_entities[i]) != deletedEntities.end())
+			TypePools::destroy(m_entities[i]);
+		else
+			m_entities[remaining++] = m_entities[i];
+	}
+	m_entities.resize(remaining);
+}
+
+void Scene::gatherEntityAndDescendants(Entity* entity, std::unordered_set<Entity*>& entities) const
+{
+	if (!entities.insert(entity).second) return;
+
+	for (unsigned int i = 0; i < entity->m_children.size(); i++)
+	{
+		gatherEntityAndDescendants(entity->m_children[i], entities);
+	}
+}
+
+TransformHierarchy& Scene::getTransformHierarchy()
+{
+	return m_transformHierarchy;
+}
+
+CameraComponent* Scene::getDebugCamera() const
+{
+#if defined(DEBUG) || defined(_DEBUG)
+	return m_debugCamera->getComponent<CameraComponent>();
+#endif
+
+	return nullptr;
+}
+
+void Scene::extractRenderData()
+{
+	RenderSnapshot& snapshot = m_renderSnapshots[1 - m_renderSnapshotIndex];
+	snapshot.clear();
+
+	CameraComponent* camera = nullptr;
+
+	if (Debug::inPlayMode)
+		camera = m_mainCamera;
+	else
+		camera = m_debugCamera->getComponent<CameraComponent>();
+
+	if (!camera) return;
+
+	Transform* cameraTransform = camera->getEntity().getComponent<Transform>();
+	if (!cameraTransform) return;
+
+	// Physics may have moved transforms since the update's hierarchy pass. With every transform up to date,
+	// reading world matrices doesn't write anything, so the objects below can be copied in parallel.
+	updateTransforms();
+
+	snapshot.hasView = true;
+	snapshot.view.viewMatrix = camera->getViewMatrix();
+	snapshot.view.projectionMatrix = Window::getProjectionMatrix();
+	snapshot.view.position = cameraTransform->getPosition();
+
+	// Meshes
+	const ComponentQuery<Transform, MeshRenderComponent>& meshes = query<Transform, MeshRenderComponent>();
+	snapshot.objects.resize(meshes.size());
+
+	JobSystem::parallelFor((unsigned int)meshes.size(), 64, [&meshes, &snapshot](unsigned int start, unsigned int end)
+	{
+		for (unsigned int i = start; i < end; i++)
+		{
+			Transform* transform = meshes[i].get<Transform>();
+			MeshRenderComponent* meshRenderComponent = meshes[i].get<MeshRenderComponent>();
+
+			RenderObject& object = snapshot.objects[i];
+			Mesh* mesh = meshRenderComponent->getMesh();
+			object.mesh = mesh ? mesh->getRenderMesh() : RenderMesh();
+			if (object.mesh.indexCount == 0) continue;
+
+			object.worldMatrix = transform->getWorldMatrix();
+			object.worldInverseMatrix = transform->getInverseWorldMatrix();
+			RenderSnapshot::transformBounds(mesh->getBoundsCenter(), mesh->getBoundsExtents(), object.worldMatrix, object.boundsCenter, object.boundsExtents);
+			object.boundsRadius = RenderSnapshot::transformRadius(mesh->getBoundsRadius(), object.worldMatrix);
+
+			Material* material = meshRenderComponent->getMaterial();
+			object.material = material ? material->getRenderMaterial() : RenderMaterial();
+			object.renderStyle = meshRenderComponent->getRenderStyle();
+			object.wireframeColor = meshRenderComponent->getWireframeColor();
+
+			object.flags = 0;
+			if (meshRenderComponent->castShadows) object.flags |= RENDEROBJECT_CAST_SHADOWS;
+			if (meshRenderComponent->receiveShadows) object.flags |= RENDEROBJECT_RECEIVE_SHADOWS;
+			if (!Debug::inPlayMode && meshes[i].entity->selected) object.flags |= RENDEROBJECT_SELECTED;
+		}
+	});
+
+	// Drop mesh render components that don't have a mesh yet, or whose mesh has nothing to draw
+	snapshot.objects.erase(std::remove_if(snapshot.objects.begin(), snapshot.objects.end(), [](const RenderObject& object)
+	{
+		return object.mesh.indexCount == 0;
+	}), snapshot.objects.end());
+
+	// Lights
+	const ComponentQuery<Transform, LightComponent>& lights = query<Transform, LightComponent>();
+	for (unsigned int i = 0; i < lights.size(); i++)
+	{
+		LightComponent* lightComponent = lights[i].get<LightComponent>();
+		Transform* lightTransform = lights[i].get<Transform>();
+
+		RenderLight light;
+		light.type = lightComponent->getLightType();
+		light.settings = lightComponent->getLightSettings();
+		light.position = lightTransform->getPosition();
+		light.direction = lightTransform->getForward();
+
+		light.castsShadows = lightComponent->canCastShadows();
+		light.shadowMapSize = lightComponent->getShadowMapSize();
+		light.shadowType = lightComponent->getShadowType();
+		light.viewMatrix = lightComponent->getViewMatrix();
+		light.projectionMatrix = lightComponent->getProjectionMatrix();
+
+		snapshot.lights.push_back(light);
+	}
+
+	// Collider wireframes are only shown in the editor
+	if (!Debug::inPlayMode)
+	{
+		const ComponentQuery<Transform, Collider>& colliders = query<Transform, Collider>();
+		for (unsigned int i = 0; i < colliders.size(); i++)
+		{
+			Collider* collider = colliders[i].get<Collider>();
+
+			const Mesh* collisionMesh = collider->getMesh();
+			if (!collisionMesh) continue;
+
+			XMFLOAT4X4 colliderMatrix = collider->getOffsetScaleMatrix();
+			XMFLOAT4X4 worldMatrix = colliders[i].get<Transform>()->getWorldMatrix();
+
+			RenderDebugShape shape;
+			XMStoreFloat4x4(&shape.worldMatrix, XMMatrixMultiply(XMLoadFloat4x4(&colliderMatrix), XMLoadFloat4x4(&worldMatrix)));
+			shape.mesh = collisionMesh->getRenderMesh();
+
+			snapshot.debugShapes.push_back(shape);
+		}
+	}
+}
+
+void Scene::swapRenderSnapshots()
+{
+	m_renderSnapshotIndex = 1 - m_renderSnapshotIndex;
+}
+
+const RenderSnapshot& Scene::getRenderSnapshot() const
+{
+	return m_renderSnapshots[m_renderSnapshotIndex];
+}
+
+void Scene::renderGeometry(Renderer* renderer, ID3D11RenderTargetView* backBufferRTV, ID3D11DepthStencilView* backBufferDSV, float width, float height)
+{
+	renderer->render(getRenderSnapshot(), backBufferRTV, backBufferDSV, width, height);
 }
 
 void Scene::renderGUI(GUIRenderer* guiRenderer)
 {
-	std::vector<GUIComponent*> guis;
-	std::vector<Entity*>& guiEntities = m_taggedEntities.at(TAG_GUI);
-	for (unsigned int i = 0; i < guiEntities.size(); i++)
+	// Queries reorder their matches whenever one is removed, so the GUI keeps a list of its own in tag order
+	if (m_activeGUIsDirty)
 	{
-		if (!m_entities[i]->getEnabled()) continue;
+		const std::vector<Entity*>& guiEntities = m_taggedEntities.at(TAG_GUI);
 
-		GUIComponent* gui = guiEntities[i]->getComponent<GUIComponent>();
-		if (gui && gui->enabled)
+		m_activeGUIs.clear();
+		for (unsigned int i = 0; i < guiEntities.size(); i++)
 		{
-			guis.push_back(gui);
+			if (!guiEntities[i]->getEnabled()) continue;
+
+			GUIComponent* gui = guiEntities[i]->getComponent<GUIComponent>();
+			if (gui && gui->getEnabled())
+			{
+				m_activeGUIs.push_back(gui);
+			}
 		}
+
+		m_activeGUIsDirty = false;
 	}
 
+	guiRenderer->begin();
+
 #if defined(DEBUG) || defined(_DEBUG)
 	if (!Debug::inPlayMode)
 	{
+		// The editor shows an icon for every entity with a transform, active or not, so they can all be selected
+		FrameVector<GUIComponent*> guis(m_activeGUIs.begin(), m_activeGUIs.end());
 		for (unsigned int i = 0; i < m_entities.size(); i++)
 		{
 			DebugEntity* debugIcon = m_entities[i]->getDebugIcon();
@@ -585,14 +1122,20 @@ void Scene::renderGUI(GUIRenderer* guiRenderer)
 				guis.push_back(debugIcon->getGUIDebugSpriteComponent());
 			}
 		}
+
+		if (guis.size() > 0)
+		{
+			guiRenderer->render(&guis[0], guis.size());
+		}
+
+		guiRenderer->end();
+		return;
 	}
 #endif
 
-	guiRenderer->begin();
-
-	if (guis.size() > 0)
+	if (m_activeGUIs.size() > 0)
 	{
-		guiRenderer->render(&guis[0], guis.size());
+		guiRenderer->render(&m_activeGUIs[0], m_activeGUIs.size());
 	}
 
 	guiRenderer->end();
@@ -615,12 +1158,32 @@ unsigned int Scene::getEntityIndex(const Entity& entity) const
 
 Entity* Scene::createEntity(std::string name)
 {
-	Entity* entity = new Entity(*this, ++m_entityCount, name, true);
+	Entity* entity = new (TypePools::get<Entity>().allocate()) Entity(*this, ++m_entityCount, name, true);
 	m_entities.push_back(entity);
 
 	return entity;
 }
 
+void Scene::setPoolReservation(std::string typeName, unsigned int count)
+{
+	m_poolReservations[typeName] = count;
+	reservePool(typeName, count);
+}
+
+void Scene::reservePool(std::string_view typeName, unsigned int count)
+{
+	// Pools are shared with the debug camera and any other scene still alive, so reservations are on top of what they use
+	if (typeName == "Entity")
+	{
+		PoolAllocator& entityPool = TypePools::get<Entity>();
+		entityPool.reserve(entityPool.getAllocatedCount() + count);
+	}
+	else
+	{
+		ComponentRegistry::reserveComponents(typeName, count);
+	}
+}
+
 void Scene::deleteEntity(Entity* entity)
 {
 	if (!entity)
@@ -660,18 +1223,19 @@ void Scene::deleteEntity(Entity* entity)
 	}
 
 	// Remove entity from tag lists
+	// Copied since removing the tags modifies the entity's tag set
 	std::unordered_set<std::string> entityTags = m_entities[index]->getTags();
 	for (auto it = entityTags.begin(); it != entityTags.end(); it++)
 	{
 		removeTagFromEntity(*m_entities[index], *it);
 	}
 
-	delete m_entities[index];
+	TypePools::destroy(m_entities[index]);
 	m_entities.erase(m_entities.begin() + index);
 	return;
 }
 
-Entity* Scene::getEntityByName(std::string name)
+Entity* Scene::getEntityByName(std::string_view name)
 {
 	for (unsigned int i = 0; i < m_entities.size(); i++)
 	{
@@ -681,34 +1245,61 @@ Entity* Scene::getEntityByName(std::string name)
 		}
 	}
 
-	Debug::warning("Failed to find entity with name " + name);
+	Debug::warning("Failed to find entity with name " + std::string(name));
 	return nullptr;
 }
 
-Entity* Scene::getEntityWithTag(std::string tag)
+Entity* Scene::getEntityWithTag(std::string_view tag)
 {
-	std::vector<Entity*> entities = getAllEntitiesWithTag(tag);
+	const std::vector<Entity*>& entities = getAllEntitiesWithTag(tag);
 	if (entities.size() == 0)
 	{
-		Debug::warning("No entities in the scene have a tag " + tag + ".");
+		Debug::warning("No entities in the scene have a tag " + std::string(tag) + ".");
 		return nullptr;
 	}
 
 	return entities[0];
 }
 
-std::vector<Entity*> Scene::getAllEntities() const
+void Scene::getEntitiesInRadius(const XMFLOAT3& center, float radius, std::vector<Entity*>& results) const
+{
+	results.clear();
+	m_spatialIndex.queryRadius(center, radius, results);
+}
+
+void Scene::getEntitiesInBox(const XMFLOAT3& center, const XMFLOAT3& extents, std::vector<Entity*>& results) const
+{
+	results.clear();
+	m_spatialIndex.queryBox(center, extents, results);
+}
+
+void Scene::getEntitiesInFrustum(const Frustum& frustum, std::vector<Entity*>& results) const
+{
+	results.clear();
+	m_spatialIndex.queryFrustum(frustum, results);
+}
+
+void Scene::getNearestEntities(const XMFLOAT3& point, unsigned int count, std::vector<Entity*>& results, float maxDistance) const
+{
+	results.clear();
+	m_spatialIndex.queryNearest(point, count, maxDistance, results);
+}
+
+const std::vector<Entity*>& Scene::getAllEntities() const
 {
 	return m_entities;
 }
 
-std::vector<Entity*> Scene::getAllEntitiesWithTag(std::string tag) const
+const std::vector<Entity*>& Scene::getAllEntitiesWithTag(std::string_view tag) const
 {
-	if (m_taggedEntities.find(tag) == m_taggedEntities.end())
+	static const std::vector<Entity*> noEntities;
+
+	auto it = m_taggedEntities.find(Util::lookupKey(tag));
+	if (it == m_taggedEntities.end())
 	{
-		Debug::warning("Tag " + tag + " doesn't exist.");
-		return std::vector<Entity*>();
+		Debug::warning("Tag " + std::string(tag) + " doesn't exist.");
+		return noEntities;
 	}
 
-	return m_taggedEntities.at(tag);
+	return it->second;
 }
@@ -4,43 +4,106 @@
 
 #include "../Physics/PhysicsHandler.h"
 
+#include "../Component/CameraComponent.h"
+#include "../Component/Collider.h"
+#include "../Component/LightComponent.h"
+#include "../Component/MeshRenderComponent.h"
+#include "../Component/Transform.h"
+
 #include "../Render/Renderer.h"
 #include "../Render/GUIRenderer.h"
+#include "../Render/RenderSnapshot.h"
+
+#include "../Memory/FrameAllocator.h"
+
+#include "ComponentQuery.h"
+#include "Frustum.h"
+#include "LooseOctree.h"
+#include "SceneCommandBuffer.h"
+#include "SystemScheduler.h"
+#include "TickSettings.h"
+#include "TransformHierarchy.h"
 
 #include <DirectXMath.h>
+#include <typeindex>
+
+// How many frames it takes to reposition every debug icon while the editor camera isn't moving.
+#define DEBUG_ICON_REFRESH_FRAMES 4
+
+class IComponentUpdateList;
+class GUIComponent;
 
 class Scene
 {
 public:
 	friend class SceneManager;
+	friend class Entity;
+	friend class Component;
 
 	Scene();
 	~Scene();
 
 	bool init();
+
+	// Ticks the components that update before physics, along with the editor when not in play mode.
 	void update(float deltaTime, float totalTime);
 
 	void handlePhysics(PhysicsHandler* physicsHandler);
 
+	// Ticks the components that update after physics, then every lateUpdate, then the components that update just before rendering.
+	void lateUpdate(float deltaTime, float totalTime);
+
+	// Copies everything the renderer needs out of the scene into the snapshot that isn't currently being rendered.
+	void extractRenderData();
+
+	// Makes the most recently extracted snapshot the one that gets rendered.
+	// Must not be called while a snapshot is being extracted or rendered.
+	void swapRenderSnapshots();
+	const RenderSnapshot& getRenderSnapshot() const;
+
+	// Only reads the current render snapshot, never the scene's entities, so it can run alongside the next update.
 	void renderGeometry(Renderer* renderer, ID3D11RenderTargetView* backBufferRTV, ID3D11DepthStencilView* backBufferDSV, float width, float height);
 	void renderGUI(GUIRenderer* guiRenderer);
 
 	Entity* createEntity(std::string name);
 	void deleteEntity(Entity* entity);
 
-	Entity* getEntityByName(std::string name);
-	Entity* getEntityWithTag(std::string tag);
-	std::vector<Entity*> getAllEntities() const;
-	std::vector<Entity*> getAllEntitiesWithTag(std::string tag) const;
+	// Hints how many entities ("Entity") or components of a registered type this scene may have at once,
+	// so their pools can be sized up front instead of growing while the game is running. Saved with the scene.
+	void setPoolReservation(std::string typeName, unsigned int count);
+
+	// Structural changes made while components are updating should be recorded here instead of being made directly.
+	// Returns the calling thread's buffer, which is played back at the end of the scene's update.
+	SceneCommandBuffer& getCommandBuffer();
 
+	Entity* getEntityByName(std::string_view name);
+	Entity* getEntityWithTag(std::string_view tag);
+	const std::vector<Entity*>& getAllEntities() const;
+	const std::vector<Entity*>& getAllEntitiesWithTag(std::string_view tag) const;
+
+	// Replaces the contents of components, so callers can keep one vector around and reuse it.
 	template<typename T>
-	std::vector<T*> getAllComponentsByType() const;
+	void getAllComponentsByType(std::vector<T*>& components) const;
+
+	// Returns a query for every active entity with an active component of each of the given types, e.g. query<Transform, MeshRenderComponent>().
+	// The query is created the first time it's asked for and kept up to date by the scene after that.
+	template<typename... Ts>
+	const ComponentQuery<Ts...>& query();
+
+	// Spatial queries over every active entity with a transform, using its mesh's bounds if it has one and its position otherwise.
+	// Bounds are as of the last time the scene brought its transforms up to date. Each replaces the contents of results,
+	// so callers can keep one vector around and reuse it.
+	void getEntitiesInRadius(const DirectX::XMFLOAT3& center, float radius, std::vector<Entity*>& results) const;
+	void getEntitiesInBox(const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extents, std::vector<Entity*>& results) const;
+	void getEntitiesInFrustum(const Frustum& frustum, std::vector<Entity*>& results) const;
+	// Nearest first
+	void getNearestEntities(const DirectX::XMFLOAT3& point, unsigned int count, std::vector<Entity*>& results, float maxDistance = FLT_MAX) const;
 
 	void addTag(std::string tag);
 	std::vector<std::string> getAllTags() const;
 
-	void addTagToEntity(Entity& entity, std::string tag);
-	void removeTagFromEntity(Entity& entity, std::string tag);
+	void addTagToEntity(Entity& entity, std::string_view tag);
+	void removeTagFromEntity(Entity& entity, std::string_view tag);
 
 	bool isDirty() const;
 
@@ -48,6 +111,8 @@ public:
 
 	CameraComponent* getDebugCamera() const;
 
+	TransformHierarchy& getTransformHierarchy();
+
 private:
 	bool hasFilePath() const;
 
@@ -61,6 +126,38 @@ private:
 	void setMainCamera(CameraComponent* camera);
 	void setMainCamera(Entity* entity);
 
+	void onComponentAdded(Component* component);
+	void onComponentRemoved(Component* component);
+	void onComponentEnabledChanged(Component* component);
+	// Called for each entity whose enabled state in the hierarchy changed, including descendants of the entity that was toggled.
+	void onEntityEnabledChanged(Entity* entity);
+	void onComponentTickIntervalChanged(Component* component);
+
+	IComponentUpdateList* getUpdateList(std::type_index type);
+	void refreshUpdateState(Component* component);
+	void refreshQueries(Entity* entity, const Component* changedComponent, const Component* removedComponent);
+
+	// Runs the update of every component type in a tick group, running types that don't touch the same data in parallel.
+	void tick(TickGroup group, float totalTime);
+
+	// Adds an update list's update or lateUpdate to a scheduler. Types that can write transforms bring the hierarchy back
+	// up to date when they finish, so the systems after them that read transforms never recalculate one themselves.
+	void scheduleUpdateList(SystemScheduler& scheduler, IComponentUpdateList* updateList, bool late, float totalTime);
+	// Runs a scheduler's systems, after which commands recorded outside of any system are played back after theirs.
+	void runSystems(SystemScheduler& scheduler);
+
+	void updateDebugIcons(float deltaTime, float totalTime);
+
+	// Brings every dirty transform up to date, then moves the entities whose transforms moved in the spatial index.
+	void updateTransforms();
+	void updateSpatialBounds(Entity* entity);
+
+	void reservePool(std::string_view typeName, unsigned int count);
+
+	void playbackCommands();
+	void deleteEntities(const std::vector<Entity*>& entities);
+	void gatherEntityAndDescendants(Entity* entity, std::unordered_set<Entity*>& entities) const;
+
 	std::string m_filepath;
 	bool m_dirty;
 
@@ -69,22 +166,85 @@ private:
 
 	std::unordered_map<std::string, std::vector<Entity*>> m_taggedEntities;
 
+	// Every active GUI component, in the order their entities were tagged so elements keep their layering.
+	// Only rebuilt when a GUI entity's tags, components or enabled state change.
+	std::vector<GUIComponent*> m_activeGUIs;
+	bool m_activeGUIsDirty;
+
+	std::unordered_map<std::string, unsigned int> m_poolReservations;
+
+	// Only component types that override update or lateUpdate get a list, and only active components are in them.
+	// Lists with an update are grouped by the tick group they declared.
+	std::unordered_map<std::type_index, IComponentUpdateList*> m_updateListsByType;
+	std::vector<IComponentUpdateList*> m_tickingLists;
+	std::vector<IComponentUpdateList*> m_updateLists[TICKGROUP_COUNT];
+	std::vector<IComponentUpdateList*> m_lateUpdateLists;
+	unsigned int m_frameIndex;
+
+	std::unordered_map<std::type_index, IComponentQuery*> m_queriesByType;
+	std::vector<IComponentQuery*> m_queries;
+
+	std::vector<SceneCommandBuffer> m_commandBuffers;
+	// Counts the systems scheduled so far, so commands can be played back in the order their systems were scheduled
+	unsigned int m_systemOrder;
+	std::vector<SceneCommand> m_playbackCommands;
+	std::vector<Entity*> m_playbackDeletedEntities;
+	std::unordered_set<Component*> m_playbackRemovedComponents;
+
+	TransformHierarchy m_transformHierarchy;
+	LooseOctree m_spatialIndex;
+
+	SystemScheduler m_updateScheduler;
+	SystemScheduler m_lateUpdateScheduler;
+
 	Entity* m_debugCamera;
 	CameraComponent* m_mainCamera;
+
+	// Debug icons only all need repositioning when the debug camera moves, otherwise a slice of them is each frame
+	DirectX::XMFLOAT4X4 m_lastDebugViewMatrix;
+	unsigned int m_debugIconSlice;
+
+	// One snapshot is rendered while the other is extracted into
+	RenderSnapshot m_renderSnapshots[2];
+	unsigned int m_renderSnapshotIndex;
 };
 
 template<typename T>
-inline std::vector<T*> Scene::getAllComponentsByType() const
+inline void Scene::getAllComponentsByType(std::vector<T*>& components) const
 {
 	static_assert(std::is_base_of<Component, T>::value, "Given type is not a Component.");
 
-	std::vector<T*> components;
+	components.clear();
 
 	for (unsigned int i = 0; i < m_entities.size(); i++)
 	{
-		std::vector<T*> entityComponents = m_entities[i]->getComponentsByType<T>();
-		components.insert(components.end(), entityComponents.begin(), entityComponents.end());
+		const std::vector<Component*>& entityComponents = m_entities[i]->m_components;
+		for (unsigned int j = 0; j < entityComponents.size(); j++)
+		{
+			T* component = dynamic_cast<T*>(entityComponents[j]);
+			if (component) components.push_back(component);
+		}
 	}
+}
+
+template<typename... Ts>
+inline const ComponentQuery<Ts...>& Scene::query()
+{
+	std::type_index type = typeid(ComponentQuery<Ts...>);
+
+	auto it = m_queriesByType.find(type);
+	if (it != m_queriesByType.end())
+		return *static_cast<ComponentQuery<Ts...>*>(it->second);
+
+	// First time this query has been asked for, so match it against every entity that's already in the scene
+	ComponentQuery<Ts...>* query = new ComponentQuery<Ts...>();
+	for (unsigned int i = 0; i < m_entities.size(); i++)
+	{
+		query->refresh(m_entities[i], nullptr);
+	}
+
+	m_queriesByType[type] = query;
+	m_queries.push_back(query);
 
-	return components;
+	return *query;
 }
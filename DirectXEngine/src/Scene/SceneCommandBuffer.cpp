@@ -0,0 +1,85 @@
+#include "SceneCommandBuffer.h"
+
+SceneCommandBuffer::SceneCommandBuffer()
+{
+	m_commands = std::vector<SceneCommand>();
+	m_systemOrder = 0;
+}
+
+void SceneCommandBuffer::createEntity(std::string name, std::function<void(Entity*)> onCreated)
+{
+	SceneCommand& command = record(SCENECOMMAND_CREATE_ENTITY, nullptr);
+	command.name = name;
+	command.onEntityCreated = onCreated;
+}
+
+void SceneCommandBuffer::deleteEntity(Entity* entity)
+{
+	if (!entity)
+	{
+		Debug::warning("Attempted to delete a null entity, skipping.");
+		return;
+	}
+
+	record(SCENECOMMAND_DELETE_ENTITY, entity);
+}
+
+void SceneCommandBuffer::removeComponent(Component* component)
+{
+	if (!component)
+	{
+		Debug::warning("Attempted to remove a null component, skipping.");
+		return;
+	}
+
+	SceneCommand& command = record(SCENECOMMAND_REMOVE_COMPONENT, &component->getEntity());
+	command.component = component;
+}
+
+void SceneCommandBuffer::addTag(Entity* entity, std::string tag)
+{
+	if (!entity)
+	{
+		Debug::warning("Attempted to add tag " + tag + " to a null entity, skipping.");
+		return;
+	}
+
+	SceneCommand& command = record(SCENECOMMAND_ADD_TAG, entity);
+	command.name = tag;
+}
+
+void SceneCommandBuffer::removeTag(Entity* entity, std::string tag)
+{
+	if (!entity)
+	{
+		Debug::warning("Attempted to remove tag " + tag + " from a null entity, skipping.");
+		return;
+	}
+
+	SceneCommand& command = record(SCENECOMMAND_REMOVE_TAG, entity);
+	command.name = tag;
+}
+
+bool SceneCommandBuffer::empty() const
+{
+	return m_commands.empty();
+}
+
+size_t SceneCommandBuffer::size() const
+{
+	return m_commands.size();
+}
+
+SceneCommand& SceneCommandBuffer::record(SceneCommandType type, Entity* entity)
+{
+	SceneCommand command;
+	command.type = type;
+	command.entity = entity;
+	command.component = nullptr;
+	command.addComponent = nullptr;
+	command.systemOrder = m_systemOrder;
+	command.sequence = (unsigned int)m_commands.size();
+
+	m_commands.push_back(command);
+	return m_commands.back();
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "../Entity.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+enum SceneCommandType
+{
+	SCENECOMMAND_CREATE_ENTITY,
+	SCENECOMMAND_ADD_COMPONENT,
+	SCENECOMMAND_ADD_TAG,
+	SCENECOMMAND_REMOVE_TAG,
+	SCENECOMMAND_REMOVE_COMPONENT,
+	SCENECOMMAND_DELETE_ENTITY
+};
+
+typedef Component*(*AddComponentFunc)(Entity*);
+
+struct SceneCommand
+{
+	SceneCommandType type;
+	Entity* entity;
+	Component* component;
+	std::string name;
+
+	AddComponentFunc addComponent;
+	std::function<void(Entity*)> onEntityCreated;
+	std::function<void(Component*)> onComponentAdded;
+
+	// Which system recorded the command, numbered in the order systems were scheduled, and where it was in that
+	// system's commands. A system runs on one thread, so together these don't depend on which worker ran it.
+	unsigned int systemOrder;
+	unsigned int sequence;
+};
+
+// Records structural changes to a scene (creating and deleting entities, adding and removing components and tags)
+// so they can be made while components are being updated, possibly on several threads at once.
+// Each worker thread has its own buffer, and the scene plays every buffer back together once the frame's updates are done,
+// in the order the commands were recorded. Entities are only deleted once every other command has been played back.
+class SceneCommandBuffer
+{
+public:
+	friend class Scene;
+
+	SceneCommandBuffer();
+
+	// The created entity is passed to onCreated when the command is played back, which is the earliest it can be used.
+	void createEntity(std::string name, std::function<void(Entity*)> onCreated = nullptr);
+	void deleteEntity(Entity* entity);
+
+	template<typename T>
+	void addComponent(Entity* entity, std::function<void(T*)> onAdded = nullptr);
+	void removeComponent(Component* component);
+
+	void addTag(Entity* entity, std::string tag);
+	void removeTag(Entity* entity, std::string tag);
+
+	bool empty() const;
+	size_t size() const;
+
+private:
+	template<typename T>
+	static Component* addComponentToEntity(Entity* entity);
+
+	SceneCommand& record(SceneCommandType type, Entity* entity);
+
+	std::vector<SceneCommand> m_commands;
+	// Set by the scene to the system running on this buffer's thread
+	unsigned int m_systemOrder;
+};
+
+template<typename T>
+inline void SceneCommandBuffer::addComponent(Entity* entity, std::function<void(T*)> onAdded)
+{
+	static_assert(std::is_base_of<Component, T>::value, "Given type is not a Component.");
+
+	if (!entity)
+	{
+		Debug::warning("Attempted to add a component to a null entity, skipping.");
+		return;
+	}
+
+	SceneCommand& command = record(SCENECOMMAND_ADD_COMPONENT, entity);
+	command.addComponent = &SceneCommandBuffer::addComponentToEntity<T>;
+
+	if (onAdded)
+	{
+		command.onComponentAdded = [onAdded](Component* component)
+		{
+			onAdded(static_cast<T*>(component));
+		};
+	}
+}
+
+template<typename T>
+inline Component* SceneCommandBuffer::addComponentToEntity(Entity* entity)
+{
+	return entity->addComponent<T>();
+}
@@ -0,0 +1,161 @@
+#include "SystemScheduler.h"
+
+#include "../Job/JobSystem.h"
+
+bool SystemScheduler::singleThreaded = false;
+
+SystemAccess::SystemAccess()
+{
+	exclusive = true;
+}
+
+bool SystemAccess::conflictsWith(const SystemAccess& other) const
+{
+	if (exclusive || other.exclusive) return true;
+
+	for (unsigned int i = 0; i < writes.size(); i++)
+	{
+		for (unsigned int j = 0; j < other.writes.size(); j++)
+		{
+			if (writes[i] == other.writes[j]) return true;
+		}
+
+		for (unsigned int j = 0; j < other.reads.size(); j++)
+		{
+			if (writes[i] == other.reads[j]) return true;
+		}
+	}
+
+	for (unsigned int i = 0; i < reads.size(); i++)
+	{
+		for (unsigned int j = 0; j < other.writes.size(); j++)
+		{
+			if (reads[i] == other.writes[j]) return true;
+		}
+	}
+
+	return false;
+}
+
+bool SystemAccess::canWrite(std::type_index type) const
+{
+	if (exclusive) return true;
+
+	for (unsigned int i = 0; i < writes.size(); i++)
+	{
+		if (writes[i] == type) return true;
+	}
+
+	return false;
+}
+
+SystemScheduler::SystemScheduler()
+{
+	m_nodes = std::vector<SystemNode>();
+	m_nodeCount = 0;
+
+	m_remainingDependencies = nullptr;
+	m_remainingDependenciesCapacity = 0;
+}
+
+SystemScheduler::~SystemScheduler()
+{
+	delete[] m_remainingDependencies;
+}
+
+void SystemScheduler::clear()
+{
+	// Nodes are kept around so their dependent lists don't have to be reallocated every frame
+	m_nodeCount = 0;
+}
+
+void SystemScheduler::addSystem(const SystemAccess* access, SystemFunction function)
+{
+	if (m_nodeCount == m_nodes.size())
+		m_nodes.push_back(SystemNode());
+
+	SystemNode& node = m_nodes[m_nodeCount];
+	node.access = access;
+	node.function = function;
+	node.dependents.clear();
+	node.dependencyCount = 0;
+
+	m_nodeCount++;
+}
+
+void SystemScheduler::run()
+{
+	if (m_nodeCount == 0) return;
+
+	if (singleThreaded || JobSystem::getWorkerCount() == 1)
+	{
+		// Adding order is always a valid order to run the graph in
+		for (unsigned int i = 0; i < m_nodeCount; i++)
+		{
+			m_nodes[i].function();
+		}
+
+		return;
+	}
+
+	buildGraph();
+
+	if (m_remainingDependenciesCapacity < m_nodeCount)
+	{
+		delete[] m_remainingDependencies;
+		m_remainingDependencies = new std::atomic<int>[m_nodeCount];
+		m_remainingDependenciesCapacity = m_nodeCount;
+	}
+
+	for (unsigned int i = 0; i < m_nodeCount; i++)
+	{
+		m_remainingDependencies[i] = m_nodes[i].dependencyCount;
+	}
+
+	// Every system runs as a child of the root, so waiting on the root waits for the whole graph
+	Job* root = JobSystem::createJob(nullptr);
+
+	for (unsigned int i = 0; i < m_nodeCount; i++)
+	{
+		if (m_nodes[i].dependencyCount == 0)
+			runNode(i, root);
+	}
+
+	JobSystem::run(root);
+	JobSystem::wait(root);
+}
+
+void SystemScheduler::buildGraph()
+{
+	// A system depends on every earlier system it conflicts with
+	for (unsigned int i = 0; i < m_nodeCount; i++)
+	{
+		for (unsigned int j = i + 1; j < m_nodeCount; j++)
+		{
+			if (m_nodes[i].access->conflictsWith(*m_nodes[j].access))
+			{
+				m_nodes[i].dependents.push_back(j);
+				m_nodes[j].dependencyCount++;
+			}
+		}
+	}
+}
+
+void SystemScheduler::runNode(unsigned int index, Job* root)
+{
+	Job* job = JobSystem::createChildJob(root, [this, index, root](Job*)
+	{
+		SystemNode& node = m_nodes[index];
+		node.function();
+
+		// Kick off any dependents that were only waiting on this system
+		for (unsigned int i = 0; i < node.dependents.size(); i++)
+		{
+			unsigned int dependent = node.dependents[i];
+			if (--m_remainingDependencies[dependent] == 0)
+				runNode(dependent, root);
+		}
+	});
+
+	JobSystem::run(job);
+}
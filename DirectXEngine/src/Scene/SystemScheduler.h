@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <functional>
+#include <typeindex>
+#include <vector>
+
+struct Job;
+
+// The component types a system reads and writes.
+// Systems that haven't declared their access are treated as exclusive and never run alongside anything else.
+struct SystemAccess
+{
+	std::vector<std::type_index> reads;
+	std::vector<std::type_index> writes;
+	bool exclusive;
+
+	SystemAccess();
+
+	bool conflictsWith(const SystemAccess& other) const;
+
+	// Whether the system may write a component type, which exclusive systems always can.
+	bool canWrite(std::type_index type) const;
+};
+
+typedef std::function<void()> SystemFunction;
+
+// Runs a set of systems on the job system, letting any two systems run at the same time as long as
+// neither one writes a component type that the other reads or writes.
+// Systems are added in a fixed order every frame, and when two systems conflict the one added first always runs first.
+class SystemScheduler
+{
+public:
+	SystemScheduler();
+	~SystemScheduler();
+
+	void clear();
+	void addSystem(const SystemAccess* access, SystemFunction function);
+	void run();
+
+	// Runs every system one at a time on the calling thread in the order they were added. Useful for debugging.
+	static bool singleThreaded;
+
+private:
+	struct SystemNode
+	{
+		const SystemAccess* access;
+		SystemFunction function;
+		std::vector<unsigned int> dependents;
+		int dependencyCount;
+	};
+
+	void buildGraph();
+	void runNode(unsigned int index, Job* root);
+
+	std::vector<SystemNode> m_nodes;
+	unsigned int m_nodeCount;
+
+	std::atomic<int>* m_remainingDependencies;
+	unsigned int m_remainingDependenciesCapacity;
+};
@@ -0,0 +1,33 @@
+#pragma once
+
+// How many staggered buckets components ticking at a fixed frequency are spread over.
+#define TICK_FREQUENCY_BUCKETS 8
+
+// When in the frame a component type's update runs. lateUpdate always runs in TICKGROUP_LATE.
+enum TickGroup
+{
+	TICKGROUP_PRE_PHYSICS,
+	TICKGROUP_POST_PHYSICS,
+	TICKGROUP_LATE,
+	TICKGROUP_PRE_RENDER,
+	TICKGROUP_COUNT
+};
+
+// How often a component ticks. Throttled components are spread out over the frames in between ticks
+// so they don't all update on the same frame, and are given the time since their last tick as their delta time.
+struct TickInterval
+{
+	// Tick once every this many frames, used when seconds is 0
+	unsigned int frames;
+	// Tick once every this many seconds
+	float seconds;
+
+	static TickInterval everyFrame() { return { 1, 0.0f }; }
+	static TickInterval everyNthFrame(unsigned int frames) { return { frames > 0 ? frames : 1, 0.0f }; }
+	static TickInterval atFrequency(float hz) { return { 1, hz > 0.0f ? 1.0f / hz : 0.0f }; }
+
+	bool isEveryFrame() const { return seconds <= 0.0f && frames <= 1; }
+
+	bool operator==(const TickInterval& other) const { return frames == other.frames && seconds == other.seconds; }
+	bool operator!=(const TickInterval& other) const { return !(*this == other); }
+};
@@ -0,0 +1,364 @@
+#include "TransformHierarchy.h"
+
+#include "../Component/Transform.h"
+#include "../Entity.h"
+
+#include <algorithm>
+
+using namespace DirectX;
+
+TransformHierarchy::TransformHierarchy()
+{
+	m_transforms = std::vector<Transform*>();
+
+	m_order = std::vector<Transform*>();
+	m_parentIndices = std::vector<int>();
+	m_subtreeEnds = std::vector<unsigned int>();
+	m_orderDirty = false;
+
+	m_dirtyIndices = std::vector<unsigned int>();
+
+	m_movedTransforms = std::vector<Transform*>();
+
+	m_parentSlots = std::vector<int>();
+	m_firstChildren = std::vector<int>();
+	m_nextSiblings = std::vector<int>();
+	m_stack = std::vector<int>();
+}
+
+TransformHierarchy::~TransformHierarchy()
+{
+	for (unsigned int i = 0; i < m_transforms.size(); i++)
+	{
+		m_transforms[i]->m_hierarchySlot = -1;
+		m_transforms[i]->m_hierarchyIndex = -1;
+		m_transforms[i]->m_hasMoved = false;
+	}
+}
+
+void TransformHierarchy::addTransform(Transform* transform)
+{
+	if (transform->m_hierarchySlot >= 0) return;
+
+	transform->m_hierarchySlot = (int)m_transforms.size();
+	m_transforms.push_back(transform);
+
+	// A new transform can become the parent of transforms that are already in the hierarchy
+	m_orderDirty = true;
+}
+
+void TransformHierarchy::removeTransform(Transform* transform)
+{
+	int slot = transform->m_hierarchySlot;
+	if (slot < 0) return;
+
+	Transform* last = m_transforms.back();
+	m_transforms[slot] = last;
+	last->m_hierarchySlot = slot;
+	m_transforms.pop_back();
+
+	transform->m_hierarchySlot = -1;
+	transform->m_hierarchyIndex = -1;
+
+	if (transform->m_hasMoved)
+	{
+		auto it = std::find(m_movedTransforms.begin(), m_movedTransforms.end(), transform);
+		*it = m_movedTransforms.back();
+		m_movedTransforms.pop_back();
+		transform->m_hasMoved = false;
+	}
+
+	m_orderDirty = true;
+}
+
+void TransformHierarchy::setOrderDirty()
+{
+	m_orderDirty = true;
+}
+
+void TransformHierarchy::propagateDirty(Transform* transform)
+{
+	// Rebuilding the order passes dirty flags down to children, so there's nothing to do until then
+	if (m_orderDirty || transform->m_hierarchyIndex < 0) return;
+
+	unsigned int end = m_subtreeEnds[transform->m_hierarchyIndex];
+	unsigned int i = transform->m_hierarchyIndex + 1;
+	while (i < end)
+	{
+		// A dirty transform's descendants are always dirty too, so its whole subtree can be skipped
+		if (m_order[i]->m_isDirty)
+		{
+			i = m_subtreeEnds[i];
+			continue;
+		}
+
+		m_order[i]->m_isDirty = true;
+		i++;
+	}
+}
+
+void TransformHierarchy::update()
+{
+	if (m_orderDirty)
+		rebuildOrder();
+
+	m_dirtyIndices.clear();
+	for (unsigned int i = 0; i < m_order.size(); i++)
+	{
+		if (m_order[i]->m_isDirty)
+			m_dirtyIndices.push_back(i);
+	}
+
+	unsigned int dirtyCount = (unsigned int)m_dirtyIndices.size();
+
+	Transform* batch[TRANSFORM_BATCH_SIZE];
+	XMFLOAT4X4 localMatrices[TRANSFORM_BATCH_SIZE];
+	XMFLOAT4X4 localInverseMatrices[TRANSFORM_BATCH_SIZE];
+
+	for (unsigned int start = 0; start < dirtyCount; start += TRANSFORM_BATCH_SIZE)
+	{
+		unsigned int batchCount = dirtyCount - start < TRANSFORM_BATCH_SIZE ? dirtyCount - start : TRANSFORM_BATCH_SIZE;
+
+		// A partial batch at the end is padded out by repeating its last transform
+		for (unsigned int i = 0; i < TRANSFORM_BATCH_SIZE; i++)
+		{
+			batch[i] = m_order[m_dirtyIndices[start + (i < batchCount ? i : batchCount - 1)]];
+		}
+
+		// Local matrices don't depend on the parent, so they can all be built side by side
+		calcLocalMatricesBatch(batch, localMatrices, localInverseMatrices);
+
+		// Parents come before their children, so a parent's world matrix is always up to date by the time a child needs it,
+		// even if the parent is earlier in the same batch
+		for (unsigned int i = 0; i < batchCount; i++)
+		{
+			int parentIndex = m_parentIndices[m_dirtyIndices[start + i]];
+			batch[i]->setWorldMatrices(localMatrices[i], localInverseMatrices[i], parentIndex >= 0 ? m_order[parentIndex] : nullptr);
+			batch[i]->m_isDirty = false;
+			markMoved(batch[i]);
+		}
+	}
+}
+
+void TransformHierarchy::updateTransform(Transform* transform)
+{
+	if (m_orderDirty)
+		rebuildOrder();
+
+	if (!transform->m_isDirty) return;
+
+	Transform* parent = nullptr;
+	if (transform->m_hierarchyIndex >= 0)
+	{
+		int parentIndex = m_parentIndices[transform->m_hierarchyIndex];
+		if (parentIndex >= 0)
+		{
+			parent = m_order[parentIndex];
+			if (parent->m_isDirty)
+				updateTransform(parent);
+		}
+	}
+
+	transform->calcWorldMatrix(parent);
+	transform->m_isDirty = false;
+	markMoved(transform);
+}
+
+void TransformHierarchy::calcLocalMatricesBatch(Transform* const* transforms, XMFLOAT4X4* localMatrices, XMFLOAT4X4* localInverseMatrices)
+{
+	static_assert(TRANSFORM_BATCH_SIZE == 4, "The batched transform kernel is written for four transforms per XMVECTOR.");
+
+	const Transform* t0 = transforms[0];
+	const Transform* t1 = transforms[1];
+	const Transform* t2 = transforms[2];
+	const Transform* t3 = transforms[3];
+
+	// Gather the transforms into structure of arrays form, so each vector holds one value from all four transforms
+	XMVECTOR positionX = XMVectorSet(t0->m_localPosition.x, t1->m_localPosition.x, t2->m_localPosition.x, t3->m_localPosition.x);
+	XMVECTOR positionY = XMVectorSet(t0->m_localPosition.y, t1->m_localPosition.y, t2->m_localPosition.y, t3->m_localPosition.y);
+	XMVECTOR positionZ = XMVectorSet(t0->m_localPosition.z, t1->m_localPosition.z, t2->m_localPosition.z, t3->m_localPosition.z);
+
+	XMVECTOR rotationX = XMVectorSet(t0->m_localRotation.x, t1->m_localRotation.x, t2->m_localRotation.x, t3->m_localRotation.x);
+	XMVECTOR rotationY = XMVectorSet(t0->m_localRotation.y, t1->m_localRotation.y, t2->m_localRotation.y, t3->m_localRotation.y);
+	XMVECTOR rotationZ = XMVectorSet(t0->m_localRotation.z, t1->m_localRotation.z, t2->m_localRotation.z, t3->m_localRotation.z);
+	XMVECTOR rotationW = XMVectorSet(t0->m_localRotation.w, t1->m_localRotation.w, t2->m_localRotation.w, t3->m_localRotation.w);
+
+	XMVECTOR scaleX = XMVectorSet(t0->m_localScale.x, t1->m_localScale.x, t2->m_localScale.x, t3->m_localScale.x);
+	XMVECTOR scaleY = XMVectorSet(t0->m_localScale.y, t1->m_localScale.y, t2->m_localScale.y, t3->m_localScale.y);
+	XMVECTOR scaleZ = XMVectorSet(t0->m_localScale.z, t1->m_localScale.z, t2->m_localScale.z, t3->m_localScale.z);
+
+	// XMMatrixRotationQuaternion written out element by element
+	XMVECTOR x2 = XMVectorAdd(rotationX, rotationX);
+	XMVECTOR y2 = XMVectorAdd(rotationY, rotationY);
+	XMVECTOR z2 = XMVectorAdd(rotationZ, rotationZ);
+
+	XMVECTOR xx2 = XMVectorMultiply(rotationX, x2);
+	XMVECTOR yy2 = XMVectorMultiply(rotationY, y2);
+	XMVECTOR zz2 = XMVectorMultiply(rotationZ, z2);
+	XMVECTOR xy2 = XMVectorMultiply(rotationX, y2);
+	XMVECTOR xz2 = XMVectorMultiply(rotationX, z2);
+	XMVECTOR yz2 = XMVectorMultiply(rotationY, z2);
+	XMVECTOR wx2 = XMVectorMultiply(rotationW, x2);
+	XMVECTOR wy2 = XMVectorMultiply(rotationW, y2);
+	XMVECTOR wz2 = XMVectorMultiply(rotationW, z2);
+
+	XMVECTOR one = XMVectorSplatOne();
+
+	XMVECTOR r00 = XMVectorSubtract(one, XMVectorAdd(yy2, zz2));
+	XMVECTOR r01 = XMVectorAdd(xy2, wz2);
+	XMVECTOR r02 = XMVectorSubtract(xz2, wy2);
+
+	XMVECTOR r10 = XMVectorSubtract(xy2, wz2);
+	XMVECTOR r11 = XMVectorSubtract(one, XMVectorAdd(xx2, zz2));
+	XMVECTOR r12 = XMVectorAdd(yz2, wx2);
+
+	XMVECTOR r20 = XMVectorAdd(xz2, wy2);
+	XMVECTOR r21 = XMVectorSubtract(yz2, wx2);
+	XMVECTOR r22 = XMVectorSubtract(one, XMVectorAdd(xx2, yy2));
+
+	XMVECTOR zero = XMVectorZero();
+
+	// Local = scale * rotation * translation
+	storeBatchRow(localMatrices, 0, XMVectorMultiply(scaleX, r00), XMVectorMultiply(scaleX, r01), XMVectorMultiply(scaleX, r02), zero);
+	storeBatchRow(localMatrices, 1, XMVectorMultiply(scaleY, r10), XMVectorMultiply(scaleY, r11), XMVectorMultiply(scaleY, r12), zero);
+	storeBatchRow(localMatrices, 2, XMVectorMultiply(scaleZ, r20), XMVectorMultiply(scaleZ, r21), XMVectorMultiply(scaleZ, r22), zero);
+	storeBatchRow(localMatrices, 3, positionX, positionY, positionZ, one);
+
+	// Inverse = inverse translation * transposed rotation * reciprocal scale
+	XMVECTOR inverseScaleX = XMVectorReciprocal(scaleX);
+	XMVECTOR inverseScaleY = XMVectorReciprocal(scaleY);
+	XMVECTOR inverseScaleZ = XMVectorReciprocal(scaleZ);
+
+	XMVECTOR i00 = XMVectorMultiply(r00, inverseScaleX);
+	XMVECTOR i01 = XMVectorMultiply(r10, inverseScaleY);
+	XMVECTOR i02 = XMVectorMultiply(r20, inverseScaleZ);
+
+	XMVECTOR i10 = XMVectorMultiply(r01, inverseScaleX);
+	XMVECTOR i11 = XMVectorMultiply(r11, inverseScaleY);
+	XMVECTOR i12 = XMVectorMultiply(r21, inverseScaleZ);
+
+	XMVECTOR i20 = XMVectorMultiply(r02, inverseScaleX);
+	XMVECTOR i21 = XMVectorMultiply(r12, inverseScaleY);
+	XMVECTOR i22 = XMVectorMultiply(r22, inverseScaleZ);
+
+	XMVECTOR i30 = XMVectorNegate(XMVectorMultiplyAdd(positionX, i00, XMVectorMultiplyAdd(positionY, i10, XMVectorMultiply(positionZ, i20))));
+	XMVECTOR i31 = XMVectorNegate(XMVectorMultiplyAdd(positionX, i01, XMVectorMultiplyAdd(positionY, i11, XMVectorMultiply(positionZ, i21))));
+	XMVECTOR i32 = XMVectorNegate(XMVectorMultiplyAdd(positionX, i02, XMVectorMultiplyAdd(positionY, i12, XMVectorMultiply(positionZ, i22))));
+
+	storeBatchRow(localInverseMatrices, 0, i00, i01, i02, zero);
+	storeBatchRow(localInverseMatrices, 1, i10, i11, i12, zero);
+	storeBatchRow(localInverseMatrices, 2, i20, i21, i22, zero);
+	storeBatchRow(localInverseMatrices, 3, i30, i31, i32, one);
+}
+
+void TransformHierarchy::storeBatchRow(XMFLOAT4X4* matrices, unsigned int row, FXMVECTOR x, FXMVECTOR y, FXMVECTOR z, GXMVECTOR w)
+{
+	// Transposing turns the four per-element vectors back into one row for each transform
+	XMMATRIX rows = XMMatrixTranspose(XMMATRIX(x, y, z, w));
+
+	for (unsigned int i = 0; i < TRANSFORM_BATCH_SIZE; i++)
+	{
+		XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(matrices[i].m[row]), rows.r[i]);
+	}
+}
+
+unsigned int TransformHierarchy::size() const
+{
+	return (unsigned int)m_transforms.size();
+}
+
+const std::vector<Transform*>& TransformHierarchy::getMovedTransforms() const
+{
+	return m_movedTransforms;
+}
+
+void TransformHierarchy::clearMovedTransforms()
+{
+	for (unsigned int i = 0; i < m_movedTransforms.size(); i++)
+	{
+		m_movedTransforms[i]->m_hasMoved = false;
+	}
+	m_movedTransforms.clear();
+}
+
+void TransformHierarchy::markMoved(Transform* transform)
+{
+	// World matrices are only recalculated while nothing else can be touching transforms, but transforms are also
+	// marked when what they carry changes, which can happen from any system running on a worker
+	std::lock_guard<std::mutex> lock(m_movedMutex);
+
+	if (transform->m_hasMoved) return;
+
+	transform->m_hasMoved = true;
+	m_movedTransforms.push_back(transform);
+}
+
+void TransformHierarchy::rebuildOrder()
+{
+	m_orderDirty = false;
+
+	unsigned int count = (unsigned int)m_transforms.size();
+
+	m_order.clear();
+	m_parentIndices.clear();
+	m_subtreeEnds.clear();
+
+	m_parentSlots.assign(count, -1);
+	m_firstChildren.assign(count, -1);
+	m_nextSiblings.assign(count, -1);
+
+	// Link every transform to its parent entity's transform. An entity whose parent has no transform is a root.
+	for (unsigned int i = 0; i < count; i++)
+	{
+		Entity* parentEntity = m_transforms[i]->getEntity().getParent();
+		if (!parentEntity) continue;
+
+		Transform* parentTransform = parentEntity->getComponent<Transform>();
+		if (!parentTransform || parentTransform->m_hierarchySlot < 0) continue;
+
+		int parentSlot = parentTransform->m_hierarchySlot;
+		m_parentSlots[i] = parentSlot;
+		m_nextSiblings[i] = m_firstChildren[parentSlot];
+		m_firstChildren[parentSlot] = i;
+	}
+
+	// Depth first walk from each root. A slot is pushed twice, once to visit it and once (stored as ~slot)
+	// to record where its subtree ends after all of its descendants have been visited.
+	for (unsigned int root = 0; root < count; root++)
+	{
+		if (m_parentSlots[root] >= 0) continue;
+
+		m_stack.clear();
+		m_stack.push_back(root);
+
+		while (!m_stack.empty())
+		{
+			int slot = m_stack.back();
+			m_stack.pop_back();
+
+			if (slot < 0)
+			{
+				m_subtreeEnds[m_transforms[~slot]->m_hierarchyIndex] = (unsigned int)m_order.size();
+				continue;
+			}
+
+			Transform* transform = m_transforms[slot];
+			int parentSlot = m_parentSlots[slot];
+
+			transform->m_hierarchyIndex = (int)m_order.size();
+			m_order.push_back(transform);
+			m_parentIndices.push_back(parentSlot >= 0 ? m_transforms[parentSlot]->m_hierarchyIndex : -1);
+			m_subtreeEnds.push_back(0);
+
+			// A child of a dirty transform has to be recalculated as well
+			if (parentSlot >= 0 && m_transforms[parentSlot]->m_isDirty)
+				transform->m_isDirty = true;
+
+			m_stack.push_back(~slot);
+			for (int child = m_firstChildren[slot]; child >= 0; child = m_nextSiblings[child])
+			{
+				m_stack.push_back(child);
+			}
+		}
+	}
+}
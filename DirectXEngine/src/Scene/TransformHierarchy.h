@@ -0,0 +1,74 @@
+#pragma once
+
+#include <DirectXMath.h>
+#include <mutex>
+#include <vector>
+
+// How many transforms the batched local matrix kernel processes at once, one per SIMD lane.
+#define TRANSFORM_BATCH_SIZE 4
+
+class Transform;
+
+// Keeps every transform in a scene in one flat array, ordered so that parents always come before their children
+// and each transform's descendants directly follow it. Marking a transform dirty marks that contiguous range,
+// and updating walks the array once, building each dirty world matrix from its parent's already updated one.
+class TransformHierarchy
+{
+public:
+	TransformHierarchy();
+	~TransformHierarchy();
+
+	void addTransform(Transform* transform);
+	void removeTransform(Transform* transform);
+
+	// Called when an entity's parent changes, since that changes where its transform belongs in the hierarchy.
+	void setOrderDirty();
+
+	// Marks every descendant of a transform that was just made dirty.
+	void propagateDirty(Transform* transform);
+
+	// Recalculates every dirty transform's world matrix in a single pass.
+	void update();
+
+	// Recalculates a single transform's world matrix, along with any of its ancestors that are also dirty.
+	void updateTransform(Transform* transform);
+
+	unsigned int size() const;
+
+	// Transforms whose world matrix was recalculated since the list was last cleared, so anything caching
+	// world space data about them (like the scene's spatial index) only has to revisit the ones that moved.
+	const std::vector<Transform*>& getMovedTransforms() const;
+	void clearMovedTransforms();
+
+	// Adds a transform to the moved list without its world matrix changing, for when what it carries changed size.
+	// Safe to call from any thread, e.g. from a component's update when its mesh changes.
+	void markMoved(Transform* transform);
+
+private:
+	void rebuildOrder();
+
+	// Builds the local matrices and their inverses for TRANSFORM_BATCH_SIZE transforms at once.
+	static void calcLocalMatricesBatch(Transform* const* transforms, DirectX::XMFLOAT4X4* localMatrices, DirectX::XMFLOAT4X4* localInverseMatrices);
+	static void storeBatchRow(DirectX::XMFLOAT4X4* matrices, unsigned int row, DirectX::FXMVECTOR x, DirectX::FXMVECTOR y, DirectX::FXMVECTOR z, DirectX::GXMVECTOR w);
+
+	// Every registered transform in the order they were added. Transforms remember their slot for constant time removal.
+	std::vector<Transform*> m_transforms;
+
+	// The same transforms sorted parent-before-child, with the index of each one's parent and the end of its subtree.
+	std::vector<Transform*> m_order;
+	std::vector<int> m_parentIndices;
+	std::vector<unsigned int> m_subtreeEnds;
+	bool m_orderDirty;
+
+	// Indices into m_order of the transforms being updated this pass
+	std::vector<unsigned int> m_dirtyIndices;
+
+	std::vector<Transform*> m_movedTransforms;
+	std::mutex m_movedMutex;
+
+	// Scratch space for rebuilding the order, kept around to avoid allocating each rebuild
+	std::vector<int> m_parentSlots;
+	std::vector<int> m_firstChildren;
+	std::vector<int> m_nextSiblings;
+	std::vector<int> m_stack;
+};
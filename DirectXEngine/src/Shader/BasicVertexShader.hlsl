@@ -1,10 +1,15 @@
-cbuffer matrices : register(b0)
+// The view and projection only change between shadow map passes
+cbuffer pass : register(b0)
 {
-	matrix world;
 	matrix view;
 	matrix projection;
 }
 
+cbuffer object : register(b2)
+{
+	matrix world;
+}
+
 struct VertexShaderInput
 {
 	// Data type
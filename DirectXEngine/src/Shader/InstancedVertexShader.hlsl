@@ -0,0 +1,63 @@
+// The instanced version of VertexShader.hlsl, used to draw many copies of a mesh with one call.
+// Each instance's matrices come from a second vertex buffer instead of the constant buffer.
+
+// Every instance's own matrices come from the instance buffer, leaving only the per-frame ones
+cbuffer frame : register(b0)
+{
+	matrix view;
+	matrix projection;
+};
+
+struct VertexShaderInput
+{
+	// Per vertex, from the mesh's vertex buffer
+	float3 position		: POSITION;
+	float2 uv			: TEXCOORD;
+	float3 normal		: NORMAL;
+	float3 tangent		: TANGENT;
+	float3 barycentric	: BARYCENTRIC;
+
+	// Per instance, from the instance buffer. The "_PER_INSTANCE" suffix puts these in input slot 1.
+	// Each row is its own element, so the matrices are rebuilt row by row below.
+	float4 world0					: WORLD_PER_INSTANCE0;
+	float4 world1					: WORLD_PER_INSTANCE1;
+	float4 world2					: WORLD_PER_INSTANCE2;
+	float4 world3					: WORLD_PER_INSTANCE3;
+	float4 worldInverseTranspose0	: WORLD_INVERSE_TRANSPOSE_PER_INSTANCE0;
+	float4 worldInverseTranspose1	: WORLD_INVERSE_TRANSPOSE_PER_INSTANCE1;
+	float4 worldInverseTranspose2	: WORLD_INVERSE_TRANSPOSE_PER_INSTANCE2;
+	float4 worldInverseTranspose3	: WORLD_INVERSE_TRANSPOSE_PER_INSTANCE3;
+};
+
+// Must match the output of VertexShader.hlsl, since both are used with the same pixel shader
+struct VertexToPixel
+{
+	float4 position		: SV_POSITION;
+	float3 worldPosition : WORLD_POSITION;
+	float2 uv			: TEXCOORD;
+	float3 normal		: NORMAL;
+	float3 tangent		: TANGENT;
+	float3 barycentric	: BARYCENTRIC;
+};
+
+VertexToPixel main(VertexShaderInput input)
+{
+	VertexToPixel output;
+
+	matrix world = float4x4(input.world0, input.world1, input.world2, input.world3);
+	matrix worldInverseTranspose = float4x4(input.worldInverseTranspose0, input.worldInverseTranspose1, input.worldInverseTranspose2, input.worldInverseTranspose3);
+
+	float4 worldPosition = mul(float4(input.position, 1.0f), world);
+
+	output.worldPosition = (float3)worldPosition;
+	output.position = mul(mul(worldPosition, view), projection);
+
+	output.uv = input.uv;
+
+	output.normal = mul(input.normal, (float3x3)worldInverseTranspose);
+	output.tangent = mul(input.tangent, (float3x3)worldInverseTranspose);
+
+	output.barycentric = input.barycentric;
+
+	return output;
+}
@@ -4,8 +4,6 @@
 #define DIRECTIONAL_LIGHT 1
 #define SPOT_LIGHT 2
 
-#define MAX_LIGHTS 64
-
 // Struct representing a generic light
 struct Light
 {
@@ -20,7 +18,17 @@ struct Light
 	int type;
 	bool shadowMapEnabled;
 	int shadowType;
-	float2 padding;
+	int shadowMapIndex;
+	float padding;
+};
+
+// Where a light's shadow map is in the shadow atlas. The matrix takes world space straight to the atlas,
+// and samples are clamped between the tile's outermost texel centers.
+struct LightShadow
+{
+	matrix atlasMatrix;
+	float2 tileMin;
+	float2 tileMax;
 };
 
 float4 calculateDiffuse(Light light, float3 normal, float3 directionToLight)
@@ -6,17 +6,22 @@
 #define WIREFRAME 1
 #define SOLID_WIREFRAME 2
 
-cbuffer lighting : register(b0)
-{
-	Light lights[MAX_LIGHTS];
-}
-
-cbuffer camera : register(b1)
+// Constants are grouped by how often they change, so each buffer is only copied to the GPU
+// when something in it actually does. Register b1 is kept for per-material constants.
+cbuffer frame : register(b0)
 {
 	float3 cameraWorldPosition : CAMERA_POSITION;
+	uint directionalLightCount;
+
+	// Finds which light cluster a pixel is in. Its view depth is the distance to the view depth plane,
+	// and its slice is log(viewDepth) * clusterDepthScale + clusterDepthBias.
+	float4 viewDepthPlane;
+	float2 clusterTileScale;
+	float clusterDepthScale;
+	float clusterDepthBias;
 }
 
-cbuffer renderStyle : register(b2)
+cbuffer object : register(b2)
 {
 	int renderStyle;
 	float4 wireColor;
@@ -25,7 +30,13 @@ cbuffer renderStyle : register(b2)
 Texture2D diffuseTexture : register(t0);
 Texture2D specularTexture : register(t1);
 Texture2D normalTexture : register(t2);
-Texture2D shadowMaps[MAX_SHADOWMAPS] : register(t3);
+Texture2D shadowAtlas : register(t3);
+StructuredBuffer<LightShadow> lightShadows : register(t4);
+
+// Directional lights come first, since they reach every pixel. The cluster lists index the lights after them.
+StructuredBuffer<Light> lights : register(t5);
+StructuredBuffer<uint2> clusterLightRanges : register(t6);
+StructuredBuffer<uint> clusterLightIndices : register(t7);
 SamplerState materialSampler : register(s0);
 SamplerComparisonState shadowMapSampler : register(s1);
 
@@ -43,7 +54,6 @@ struct VertexToPixel
 	//  v    v                v
 	float4 position		: SV_POSITION;
 	float3 worldPosition : WORLD_POSITION;
-	float4 shadowPositions[MAX_SHADOWMAPS] : SHADOW_POSITIONS;
 	float2 uv			: TEXCOORD;
 	float3 normal		: NORMAL;
 	float3 tangent		: TANGENT;
@@ -112,37 +122,55 @@ float edgeFactor(float3 barycentric, float width)
 
 }
 
-// Calculates the amount a pixel is in shadow using PCF. Sample width must be an odd positive integer.
-float calculateShadowAmount(Texture2D shadowMap, float4 shadowPosition, const unsigned int sampleWidth)
+// Calculates the amount a pixel is in shadow using PCF over its light's tile of the shadow atlas.
+// Sample width must be an odd positive integer.
+float calculateShadowAmount(LightShadow shadow, float3 worldPosition, const unsigned int sampleWidth)
 {
-	float shadowMapWidth;
-	float shadowMapHeight;
-	float mipLevels;
-	shadowMap.GetDimensions(0, shadowMapWidth, shadowMapHeight, mipLevels);
+	float4 shadowPosition = mul(float4(worldPosition, 1.0f), shadow.atlasMatrix);
+	float3 atlasPosition = shadowPosition.xyz / shadowPosition.w;
 
-	const float texel = 1.0f / shadowMapWidth;
+	// Pixels outside the light's view aren't shadowed by it
+	if (any(atlasPosition.xy < shadow.tileMin) || any(atlasPosition.xy > shadow.tileMax))
+	{
+		return 1.0f;
+	}
 
-	float distanceToLight = shadowPosition.z / shadowPosition.w;
+	float atlasWidth;
+	float atlasHeight;
+	float mipLevels;
+	shadowAtlas.GetDimensions(0, atlasWidth, atlasHeight, mipLevels);
 
-	float2 shadowMapUV = packFloat2(shadowPosition.xy / shadowPosition.w);
-	shadowMapUV.y = 1.0f - shadowMapUV.y;
+	const float texel = 1.0f / atlasWidth;
 
 	float totalShadowAmount = 0;
 	float sampleRadius = sampleWidth / 2.0f;
 	int lowerBound = ceil(-sampleRadius);
 	int upperBound = floor(sampleRadius);
 
+	// Samples are kept inside the tile, since its neighbours hold other lights' depths
 	for (int i = lowerBound; i <= upperBound; i++)
 	{
 		for (int j = lowerBound; j <= upperBound; j++)
 		{
-			totalShadowAmount += shadowMap.SampleCmpLevelZero(shadowMapSampler, shadowMapUV + float2(i, j) * texel, distanceToLight);
+			float2 sampleUV = clamp(atlasPosition.xy + float2(i, j) * texel, shadow.tileMin, shadow.tileMax);
+			totalShadowAmount += shadowAtlas.SampleCmpLevelZero(shadowMapSampler, sampleUV, atlasPosition.z);
 		}
 	}
 	
 	return totalShadowAmount / (sampleWidth * sampleWidth);
 }
 
+// Calculates the amount a pixel is in shadow from a light. Lights without a tile in the atlas this frame never shadow anything.
+float calculateLightShadow(Light light, float3 worldPosition)
+{
+	if (!light.shadowMapEnabled)
+	{
+		return 1.0f;
+	}
+
+	return calculateShadowAmount(lightShadows[light.shadowMapIndex], worldPosition, light.shadowType + 1);
+}
+
 // --------------------------------------------------------
 // The entry point (main method) for our pixel shader
 // 
@@ -175,24 +203,35 @@ float4 main(VertexToPixel input) : SV_TARGET
 	float4 globalAmbient = float4(0.25f, 0.25f, 0.25f, 1.0f);
 	float4 finalLightColor = globalAmbient  * diffuseColor;
 
-	[unroll]
-	for (unsigned int i = 0; i < MAX_SHADOWMAPS; i++)
+	for (unsigned int i = 0; i < directionalLightCount; i++)
 	{
-		float shadowAmount = 1.0f;
-		if (lights[i].shadowMapEnabled)
+		float4 lightColor = calculateLight(lights[i], finalNormal, input.worldPosition, diffuseColor, specularColor);
+
+		// Shadows are only looked up for lights that actually reach this pixel
+		[branch]
+		if (any(lightColor.rgb > 0.0f))
 		{
-			shadowAmount = calculateShadowAmount(shadowMaps[i], input.shadowPositions[i], lights[i].shadowType + 1);
+			finalLightColor += lightColor * calculateLightShadow(lights[i], input.worldPosition);
 		}
-
-		float4 lightColor = calculateLight(lights[i], finalNormal, input.worldPosition, diffuseColor, specularColor);
-		finalLightColor += lightColor * shadowAmount;
 	}
 
-	[unroll]
-	for (unsigned int j = MAX_SHADOWMAPS; j < MAX_LIGHTS; j++)
+	// Only the lights whose bounds touch this pixel's cluster are shaded
+	uint2 tile = min((uint2)(input.position.xy * clusterTileScale), uint2(LIGHT_CLUSTER_TILES_X - 1, LIGHT_CLUSTER_TILES_Y - 1));
+	float viewDepth = dot(float4(input.worldPosition, 1.0f), viewDepthPlane);
+	uint slice = min((uint)max(log(viewDepth) * clusterDepthScale + clusterDepthBias, 0.0f), LIGHT_CLUSTER_SLICES - 1);
+
+	uint2 clusterRange = clusterLightRanges[(slice * LIGHT_CLUSTER_TILES_Y + tile.y) * LIGHT_CLUSTER_TILES_X + tile.x];
+	for (unsigned int j = 0; j < clusterRange.y; j++)
 	{
-		float4 lightColor = calculateLight(lights[j], finalNormal, input.worldPosition, diffuseColor, specularColor);
-		finalLightColor += lightColor;
+		Light light = lights[directionalLightCount + clusterLightIndices[clusterRange.x + j]];
+
+		float4 lightColor = calculateLight(light, finalNormal, input.worldPosition, diffuseColor, specularColor);
+
+		[branch]
+		if (any(lightColor.rgb > 0.0f))
+		{
+			finalLightColor += lightColor * calculateLightShadow(light, input.worldPosition);
+		}
 	}
 
 	switch (renderStyle)
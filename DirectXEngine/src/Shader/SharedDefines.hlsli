@@ -1 +1,4 @@
-#define MAX_SHADOWMAPS 16
\ No newline at end of file
+// The light cluster grid, which must match LightClusterGrid.h
+#define LIGHT_CLUSTER_TILES_X 16
+#define LIGHT_CLUSTER_TILES_Y 9
+#define LIGHT_CLUSTER_SLICES 24
\ No newline at end of file
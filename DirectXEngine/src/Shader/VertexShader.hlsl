@@ -1,25 +1,22 @@
-#include "SharedDefines.hlsli"
-
-struct ShadowMatrices
-{
-	matrix view;
-	matrix projection;
-};
-
 // Constant Buffer
 // - Allows us to define a buffer of individual variables 
 //    which will (eventually) hold data from our C++ code
 // - All non-pipeline variables that get their values from 
 //    our C++ code must be defined inside a Constant Buffer
 // - The name of the cbuffer itself is unimportant
-cbuffer matrices : register(b0)
+// - Constants are grouped by how often they change, so each buffer is only
+//    copied to the GPU when something in it actually does. Register b1 is
+//    kept for per-material constants.
+cbuffer frame : register(b0)
 {
-	matrix world;
 	matrix view;
 	matrix projection;
-	matrix worldInverseTranspose;
+};
 
-	ShadowMatrices shadowMatrices[MAX_SHADOWMAPS];
+cbuffer object : register(b2)
+{
+	matrix world;
+	matrix worldInverseTranspose;
 };
 
 // Struct representing a single vertex worth of data
@@ -55,7 +52,6 @@ struct VertexToPixel
 	//  v    v                v
 	float4 position		: SV_POSITION;	// XYZW position (System Value Position)	
 	float3 worldPosition : WORLD_POSITION;
-	float4 shadowPositions[MAX_SHADOWMAPS] : SHADOW_POSITIONS;
 	float2 uv			: TEXCOORD;
 	float3 normal		: NORMAL;
 	float3 tangent		: TANGENT;
@@ -94,14 +90,6 @@ VertexToPixel main( VertexShaderInput input )
 	// screen and the distance (Z) from the camera (the "depth" of the pixel)
 	output.position = mul(float4(input.position, 1.0f), worldViewProj);
 
-	[unroll]
-	for (unsigned int i = 0; i < MAX_SHADOWMAPS; i++)
-	{
-		matrix shadowWorldViewProj = mul(mul(world, shadowMatrices[i].view), shadowMatrices[i].projection);
-		output.shadowPositions[i] = mul(float4(input.position, 1.0f), shadowWorldViewProj);
-	}
-	
-
 	output.uv = input.uv;
 
 	// Multiply the normals by a casted inverse transpose of the world matrix
@@ -3,6 +3,7 @@
 #include <Windows.h>
 #include <DirectXMath.h>
 #include <string>
+#include <string_view>
 #include <tuple>
 
 namespace Util
@@ -32,6 +33,16 @@ namespace Util
 		return string;
 	}
 
+	// Returns a string with the same characters as the given view, for finding string_view keys in std::string keyed hash maps.
+	// unordered_map can't be searched with a string_view directly until C++20, so the key is copied into a per-thread buffer
+	// that only allocates when it has to grow. The returned string is overwritten by the next call on the same thread.
+	inline const std::string& lookupKey(std::string_view key)
+	{
+		static thread_local std::string buffer;
+		buffer.assign(key.data(), key.size());
+		return buffer;
+	}
+
 	std::string saveFileDialog(HWND hWnd, const char* fileTypeFilter);
 	std::string loadFileDialog(HWND hWnd, const char* fileTypeFilter);
 }
@@ -0,0 +1,165 @@
+#include "Test.h"
+
+#include "../src/Job/JobSystem.h"
+#include "../src/Memory/FrameAllocator.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+// Small enough to overflow on purpose
+static const size_t capacity = 1024;
+
+// Waits for every job to arrive, so each one is held on its own worker until all of them are running
+static void rendezvous(std::atomic<int>& arrived, int count)
+{
+	arrived++;
+
+	auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (arrived.load() < count && std::chrono::steady_clock::now() < timeout)
+	{
+		std::this_thread::yield();
+	}
+}
+
+static void testMemoryIsReusedAfterReset()
+{
+	FrameAllocator::reset();
+
+	void* first = FrameAllocator::allocate(100, 16);
+	void* second = FrameAllocator::allocate(100, 16);
+	CHECK(first != second);
+
+	// Allocations are aligned and follow each other through the same buffer
+	char* byte = FrameAllocator::allocate<char>(1);
+	double* value = FrameAllocator::allocate<double>(1);
+	CHECK((uintptr_t)value % alignof(double) == 0);
+	CHECK((char*)second < byte);
+	CHECK(byte < (char*)value);
+
+	FrameAllocator::reset();
+
+	// The next frame starts from the beginning of the buffer again
+	CHECK(FrameAllocator::allocate(100, 16) == first);
+	CHECK(FrameAllocator::allocate(100, 16) == second);
+
+	// Containers use it too
+	FrameAllocator::reset();
+	FrameVector<int> numbers;
+	for (int i = 0; i < 16; i++)
+	{
+		numbers.push_back(i);
+	}
+	CHECK(numbers.size() == 16);
+	CHECK(numbers[15] == 15);
+
+	FrameAllocator::reset();
+}
+
+static void testEachThreadHasItsOwnAllocator()
+{
+	const int threadCount = (int)JobSystem::getWorkerCount();
+
+	std::atomic<int> arrived(0);
+	std::vector<unsigned char*> memory(threadCount, nullptr);
+	std::vector<int> threads(threadCount, -1);
+
+	Job* root = JobSystem::createJob(nullptr);
+	for (int i = 0; i < threadCount; i++)
+	{
+		JobSystem::run(JobSystem::createChildJob(root, [&, i](Job*)
+		{
+			rendezvous(arrived, threadCount);
+
+			threads[i] = (int)JobSystem::getThreadIndex();
+			memory[i] = FrameAllocator::allocate<unsigned char>(256);
+			memset(memory[i], i, 256);
+		}));
+	}
+	JobSystem::run(root);
+	JobSystem::wait(root);
+
+	// Every job was on a different worker, and got memory nobody else wrote over
+	for (int i = 0; i < threadCount; i++)
+	{
+		for (int j = i + 1; j < threadCount; j++)
+		{
+			CHECK(threads[i] != threads[j]);
+			CHECK(memory[i] != memory[j]);
+		}
+
+		bool intact = true;
+		for (unsigned int k = 0; k < 256; k++)
+		{
+			if (memory[i][k] != i) intact = false;
+		}
+		CHECK(intact);
+	}
+
+	// Each thread's allocation was the first in its own buffer, so all of them fit and nothing overflowed
+	FrameAllocator::reset();
+	CHECK(!FrameAllocator::hasLastFrameOverflowed());
+	CHECK(FrameAllocator::getLastFramePeak() == 256);
+}
+
+static void testOversizedRequestsFallBackToTheHeap()
+{
+	FrameAllocator::reset();
+
+	void* start = FrameAllocator::allocate(16, 16);
+
+	// Bigger than the whole buffer, so it has to come from the heap
+	char* oversized = static_cast<char*>(FrameAllocator::allocate(capacity * 4, 16));
+	CHECK(oversized != nullptr);
+	memset(oversized, 1, capacity * 4);
+
+	// Smaller requests keep using what's left of the buffer
+	char* next = static_cast<char*>(FrameAllocator::allocate(16, 16));
+	CHECK(next == (char*)start + 16);
+
+	FrameAllocator::reset();
+	CHECK(FrameAllocator::hasLastFrameOverflowed());
+	CHECK(FrameAllocator::getLastFramePeak() == 32 + capacity * 4);
+
+	// The heap memory was freed by the reset, and the buffer is used from the start again
+	CHECK(FrameAllocator::allocate(16, 16) == start);
+	FrameAllocator::reset();
+	CHECK(!FrameAllocator::hasLastFrameOverflowed());
+}
+
+static void testPeakIsReportedEveryFrame()
+{
+	FrameAllocator::reset();
+
+	FrameAllocator::allocate(300, 1);
+	FrameAllocator::reset();
+	CHECK(FrameAllocator::getLastFramePeak() == 300);
+	CHECK(!FrameAllocator::hasLastFrameOverflowed());
+
+	// The peak is per frame, while the high-water mark keeps the most any frame has used
+	FrameAllocator::allocate(100, 1);
+	FrameAllocator::reset();
+	CHECK(FrameAllocator::getLastFramePeak() == 100);
+	CHECK(FrameAllocator::getHighWaterMark() >= 300);
+
+	FrameAllocator::reset();
+	CHECK(FrameAllocator::getLastFramePeak() == 0);
+}
+
+int main()
+{
+	// The frame allocator has one allocator per worker, so the job system has to exist first
+	JobSystem jobSystem(4);
+	FrameAllocator frameAllocator(capacity);
+
+	CHECK(FrameAllocator::getCapacityPerThread() == capacity);
+
+	testMemoryIsReusedAfterReset();
+	testEachThreadHasItsOwnAllocator();
+	testOversizedRequestsFallBackToTheHeap();
+	testPeakIsReportedEveryFrame();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,390 @@
+#include "Test.h"
+
+#include "../src/Render/FrameRecorder.h"
+#include "../src/Render/NullRenderBackend.h"
+
+#include <cmath>
+
+using namespace DirectX;
+
+// Stand-ins for device objects. The recorder and the null backend only ever compare handles, never follow them.
+static char deviceObjects[32];
+
+static RenderHandle makeHandle(unsigned int index)
+{
+	return &deviceObjects[index];
+}
+
+enum TestHandle
+{
+	HANDLE_BACK_BUFFER_RTV,
+	HANDLE_BACK_BUFFER_DSV,
+	HANDLE_SHADOW_ATLAS_DSV,
+	HANDLE_SHADOW_RASTERIZER,
+	HANDLE_WIREFRAME_RASTERIZER,
+	HANDLE_DEPTH_DEFAULT,
+	HANDLE_DEPTH_READ_ONLY,
+	HANDLE_TRANSPARENT_BLEND,
+	HANDLE_INSTANCE_BUFFER,
+	HANDLE_LIGHT_BUFFER,
+	HANDLE_LIGHT_SHADOW_BUFFER,
+	HANDLE_CLUSTER_RANGE_BUFFER,
+	HANDLE_CLUSTER_INDEX_BUFFER,
+	HANDLE_INPUT_LAYOUT,
+	HANDLE_SHADOW_VERTEX_SHADER,
+	HANDLE_DEFAULT_VERTEX_SHADER,
+	HANDLE_INSTANCED_VERTEX_SHADER,
+	HANDLE_OTHER_VERTEX_SHADER,
+	HANDLE_DEFAULT_PIXEL_SHADER,
+	HANDLE_OTHER_PIXEL_SHADER,
+	HANDLE_CUBE_VERTICES,
+	HANDLE_CUBE_INDICES,
+	HANDLE_SPHERE_VERTICES,
+	HANDLE_SPHERE_INDICES
+};
+
+// What a material handle points to in these tests
+struct TestMaterial
+{
+	RenderHandle vertexShader;
+	RenderHandle pixelShader;
+};
+
+// Binds shaders straight into the command buffer the way SimpleShader does, and counts everything else it's asked to do
+class TestShaderBinder : public IShaderBinder
+{
+public:
+	TestShaderBinder(RenderCommandBuffer& commands) : m_commands(commands)
+	{
+		materialsUsed = 0;
+		viewConstants = 0;
+		objectConstants = 0;
+		lightingConstants = 0;
+		styleConstants = 0;
+		shadowAtlasUnbinds = 0;
+	}
+
+	void useMaterial(RenderHandle material) override
+	{
+		const TestMaterial* testMaterial = static_cast<const TestMaterial*>(material);
+		useVertexShader(testMaterial->vertexShader);
+		m_commands.setShader(SHADERSTAGE_PIXEL, testMaterial->pixelShader);
+		materialsUsed++;
+	}
+
+	void useVertexShader(RenderHandle vertexShader) override
+	{
+		m_commands.setShader(SHADERSTAGE_VERTEX, vertexShader);
+		m_commands.setInputLayout(makeHandle(HANDLE_INPUT_LAYOUT));
+	}
+
+	void setViewConstants(RenderHandle, const XMFLOAT4X4&, const XMFLOAT4X4&, bool) override { viewConstants++; }
+	void setObjectConstants(RenderHandle, const XMFLOAT4X4&, const XMFLOAT4X4&) override { objectConstants++; }
+	void setLightingConstants(RenderHandle, const ClusteredLighting& frameLighting) override { lightingConstants++; lighting = frameLighting; }
+	void setStyleConstants(RenderHandle, RenderStyle, const XMFLOAT4&) override { styleConstants++; }
+	void unbindShadowAtlas(RenderHandle) override { shadowAtlasUnbinds++; }
+
+	unsigned int materialsUsed;
+	unsigned int viewConstants;
+	unsigned int objectConstants;
+	unsigned int lightingConstants;
+	unsigned int styleConstants;
+	unsigned int shadowAtlasUnbinds;
+	ClusteredLighting lighting;
+
+private:
+	RenderCommandBuffer& m_commands;
+};
+
+static TestMaterial defaultMaterial = { makeHandle(HANDLE_DEFAULT_VERTEX_SHADER), makeHandle(HANDLE_DEFAULT_PIXEL_SHADER) };
+static TestMaterial otherMaterial = { makeHandle(HANDLE_OTHER_VERTEX_SHADER), makeHandle(HANDLE_OTHER_PIXEL_SHADER) };
+
+static RenderMaterial makeMaterial(unsigned int id, TestMaterial& material, unsigned int vertexShaderID, unsigned int pixelShaderID)
+{
+	RenderMaterial renderMaterial;
+	renderMaterial.id = id;
+	renderMaterial.material = &material;
+	renderMaterial.vertexShader = material.vertexShader;
+	renderMaterial.vertexShaderID = vertexShaderID;
+	renderMaterial.pixelShader = material.pixelShader;
+	renderMaterial.pixelShaderID = pixelShaderID;
+
+	return renderMaterial;
+}
+
+static RenderMesh makeMesh(unsigned int id, TestHandle vertexBuffer, TestHandle indexBuffer, unsigned int indexCount)
+{
+	RenderMesh mesh;
+	mesh.id = id;
+	mesh.vertexBuffer = makeHandle(vertexBuffer);
+	mesh.indexBuffer = makeHandle(indexBuffer);
+	mesh.vertexStride = 56;
+	mesh.indexCount = indexCount;
+
+	return mesh;
+}
+
+static XMFLOAT4X4 makeTranslation(float x, float y, float z)
+{
+	return XMFLOAT4X4(
+		1.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, 1.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f,
+		x, y, z, 1.0f);
+}
+
+static XMFLOAT4X4 makePerspective()
+{
+	float nearDepth = 0.1f;
+	float farDepth = 100.0f;
+	float yScale = 1.0f / tanf(0.5f);
+	float range = farDepth / (farDepth - nearDepth);
+
+	return XMFLOAT4X4(
+		yScale * 9.0f / 16.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, yScale, 0.0f, 0.0f,
+		0.0f, 0.0f, range, 1.0f,
+		0.0f, 0.0f, -range * nearDepth, 0.0f);
+}
+
+// Maps [-50, 50] across and [0, 100] deep, like a directional light's shadow volume
+static XMFLOAT4X4 makeOrthographic()
+{
+	return XMFLOAT4X4(
+		1.0f / 50.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, 1.0f / 50.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f / 100.0f, 0.0f,
+		0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+static RenderObject makeObject(const RenderMesh& mesh, const RenderMaterial& material, float x, float y, float z, unsigned int flags)
+{
+	RenderObject object;
+	object.worldMatrix = makeTranslation(x, y, z);
+	object.worldInverseMatrix = makeTranslation(-x, -y, -z);
+	object.boundsCenter = XMFLOAT3(x, y, z);
+	object.boundsExtents = XMFLOAT3(1.0f, 1.0f, 1.0f);
+	object.boundsRadius = sqrtf(3.0f);
+	object.mesh = mesh;
+	object.material = material;
+	object.renderStyle = SOLID;
+	object.wireframeColor = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+	object.flags = flags;
+
+	return object;
+}
+
+static RenderLight makeLight(LightType type, float x, float y, float z, bool castsShadows)
+{
+	RenderLight light;
+	light.type = type;
+	light.settings.color = XMFLOAT4(1.0f, 1.0f, 1.0f, 1.0f);
+	light.settings.brightness = 1.0f;
+	light.settings.specularity = 1.0f;
+	light.settings.radius = 5.0f;
+	light.settings.spotAngle = 30.0f;
+	light.position = XMFLOAT3(x, y, z);
+	light.direction = XMFLOAT3(0.0f, 0.0f, 1.0f);
+	light.castsShadows = castsShadows;
+	light.shadowMapSize = 0;
+	light.shadowType = SHADOWTYPE_HARD;
+	light.viewMatrix = makeTranslation(0.0f, 0.0f, 0.0f);
+	light.projectionMatrix = makeOrthographic();
+
+	return light;
+}
+
+static FrameResources makeResources()
+{
+	FrameResources resources;
+	resources.shadowAtlasDSV = makeHandle(HANDLE_SHADOW_ATLAS_DSV);
+	resources.shadowMapRasterizerState = makeHandle(HANDLE_SHADOW_RASTERIZER);
+	resources.wireframeRasterizerState = makeHandle(HANDLE_WIREFRAME_RASTERIZER);
+	resources.depthStencilStateDefault = makeHandle(HANDLE_DEPTH_DEFAULT);
+	resources.depthStencilStateReadOnly = makeHandle(HANDLE_DEPTH_READ_ONLY);
+	resources.transparentBlendState = makeHandle(HANDLE_TRANSPARENT_BLEND);
+	resources.instanceBuffer = makeHandle(HANDLE_INSTANCE_BUFFER);
+	resources.lightBuffer = makeHandle(HANDLE_LIGHT_BUFFER);
+	resources.lightShadowBuffer = makeHandle(HANDLE_LIGHT_SHADOW_BUFFER);
+	resources.clusterRangeBuffer = makeHandle(HANDLE_CLUSTER_RANGE_BUFFER);
+	resources.clusterIndexBuffer = makeHandle(HANDLE_CLUSTER_INDEX_BUFFER);
+	resources.shadowVertexShader = makeHandle(HANDLE_SHADOW_VERTEX_SHADER);
+	resources.instanceableVertexShader = makeHandle(HANDLE_DEFAULT_VERTEX_SHADER);
+	resources.instancedVertexShader = makeHandle(HANDLE_INSTANCED_VERTEX_SHADER);
+	resources.debugMaterial = makeMaterial(100, otherMaterial, 2, 2);
+
+	return resources;
+}
+
+// A camera at the origin looking down +z, with a row of instanceable cubes in front of it
+static void buildScene(RenderSnapshot& snapshot)
+{
+	RenderMesh cube = makeMesh(1, HANDLE_CUBE_VERTICES, HANDLE_CUBE_INDICES, 36);
+	RenderMesh sphere = makeMesh(2, HANDLE_SPHERE_VERTICES, HANDLE_SPHERE_INDICES, 240);
+	RenderMaterial instanceable = makeMaterial(10, defaultMaterial, 1, 1);
+	RenderMaterial other = makeMaterial(11, otherMaterial, 2, 2);
+
+	snapshot.clear();
+	snapshot.hasView = true;
+	snapshot.view.viewMatrix = makeTranslation(0.0f, 0.0f, 0.0f);
+	snapshot.view.projectionMatrix = makePerspective();
+	snapshot.view.position = XMFLOAT3(0.0f, 0.0f, 0.0f);
+
+	for (unsigned int i = 0; i < 8; i++)
+	{
+		snapshot.objects.push_back(makeObject(cube, instanceable, -7.0f + 2.0f * i, 0.0f, 20.0f, RENDEROBJECT_CAST_SHADOWS | RENDEROBJECT_RECEIVE_SHADOWS));
+	}
+
+	// Drawn on its own, since its material isn't instanceable
+	snapshot.objects.push_back(makeObject(sphere, other, 0.0f, 0.0f, 30.0f, RENDEROBJECT_RECEIVE_SHADOWS));
+
+	// Behind the camera, and behind the light's shadow volume
+	snapshot.objects.push_back(makeObject(cube, instanceable, 0.0f, 0.0f, -20.0f, RENDEROBJECT_CAST_SHADOWS | RENDEROBJECT_RECEIVE_SHADOWS));
+
+	// No material, so it's never drawn
+	RenderMaterial none = {};
+	snapshot.objects.push_back(makeObject(cube, none, 0.0f, 2.0f, 20.0f, 0));
+
+	snapshot.lights.push_back(makeLight(POINT_LIGHT, 0.0f, 0.0f, 20.0f, false));
+	snapshot.lights.push_back(makeLight(DIRECTIONAL_LIGHT, 0.0f, 0.0f, 0.0f, true));
+
+	RenderDebugShape shape;
+	shape.worldMatrix = makeTranslation(0.0f, 0.0f, 25.0f);
+	shape.mesh = cube;
+	snapshot.debugShapes.push_back(shape);
+}
+
+static const RenderCommand* findWrite(const RenderCommandBuffer& commands, TestHandle buffer)
+{
+	for (size_t i = 0; i < commands.size(); i++)
+	{
+		if (commands[i].type == RENDERCOMMAND_WRITE_BUFFER && commands[i].resource == makeHandle(buffer))
+			return &commands[i];
+	}
+
+	return nullptr;
+}
+
+static void testFrameIsValidAndBatched()
+{
+	RenderSnapshot snapshot;
+	buildScene(snapshot);
+
+	RenderCommandBuffer commands;
+	TestShaderBinder shaders(commands);
+
+	FrameRecorder recorder;
+	recorder.setResources(makeResources());
+	recorder.record(snapshot, makeHandle(HANDLE_BACK_BUFFER_RTV), makeHandle(HANDLE_BACK_BUFFER_DSV), 1600.0f, 900.0f, shaders, commands);
+
+	NullRenderBackend backend;
+	backend.execute(commands);
+
+	const RenderBackendStats& stats = backend.getStats();
+	CHECK(backend.getErrors().empty());
+	for (size_t i = 0; i < backend.getErrors().size(); i++)
+	{
+		std::printf("command %zu: %s\n", backend.getErrors()[i].commandIndex, backend.getErrors()[i].message);
+	}
+
+	// Eight casters into the directional light's shadow map, then the cubes as one instanced draw, the sphere and the debug shape
+	CHECK(stats.commandCounts[RENDERCOMMAND_DRAW_INDEXED_INSTANCED] == 1);
+	CHECK(stats.commandCounts[RENDERCOMMAND_DRAW_INDEXED] == 8 + 1 + 1);
+	CHECK(stats.instanceCount == 8 + 8 + 1 + 1);
+	CHECK(stats.indexCount == 8 * 36 + 8 * 36 + 240 + 36);
+
+	CHECK(!recorder.hasRejectedProjection());
+	CHECK(!recorder.hasClusterOverflow());
+	CHECK(recorder.getDroppedLightCount() == 0);
+
+	// Each pixel shader gets the frame's lighting once, and only the last one has the shadow atlas unbound
+	CHECK(shaders.lightingConstants == 2);
+	CHECK(shaders.lighting.directionalLightCount == 1);
+	CHECK(shaders.shadowAtlasUnbinds == 1);
+	CHECK(shaders.materialsUsed == 3);
+	CHECK(shaders.styleConstants == 2);
+
+	// Directional lights go first, and only the shadowed one has a shadow map
+	const RenderCommand* lights = findWrite(commands, HANDLE_LIGHT_BUFFER);
+	CHECK(lights && lights->count == 2 * sizeof(GPU_LIGHT_DATA));
+	if (lights)
+	{
+		const GPU_LIGHT_DATA* lightData = static_cast<const GPU_LIGHT_DATA*>(commands.getData(lights->dataOffset));
+		CHECK(lightData[0].type == DIRECTIONAL_LIGHT && lightData[0].shadowMapIndex == 0 && lightData[0].shadowMapEnabled == 1);
+		CHECK(lightData[1].type == POINT_LIGHT && lightData[1].shadowMapIndex == -1 && lightData[1].shadowMapEnabled == 0);
+	}
+
+	const RenderCommand* shadows = findWrite(commands, HANDLE_LIGHT_SHADOW_BUFFER);
+	CHECK(shadows && shadows->count == sizeof(GPU_LIGHT_SHADOW_DATA));
+
+	CHECK(findWrite(commands, HANDLE_CLUSTER_RANGE_BUFFER) != nullptr);
+	CHECK(findWrite(commands, HANDLE_CLUSTER_INDEX_BUFFER) != nullptr);
+
+	const RenderCommand* instances = findWrite(commands, HANDLE_INSTANCE_BUFFER);
+	CHECK(instances && instances->count == 8 * sizeof(GPU_INSTANCE_DATA) && instances->start == 0 && instances->discard);
+}
+
+static void testInstanceBufferIsAppendedTo()
+{
+	RenderSnapshot snapshot;
+	buildScene(snapshot);
+
+	RenderCommandBuffer commands;
+	TestShaderBinder shaders(commands);
+
+	FrameRecorder recorder;
+	recorder.setResources(makeResources());
+
+	// Frames after the first write after the previous frame's instances without discarding, until the buffer is full
+	for (unsigned int frame = 0; frame < 3; frame++)
+	{
+		commands.clear();
+		recorder.record(snapshot, makeHandle(HANDLE_BACK_BUFFER_RTV), makeHandle(HANDLE_BACK_BUFFER_DSV), 1600.0f, 900.0f, shaders, commands);
+
+		const RenderCommand* instances = findWrite(commands, HANDLE_INSTANCE_BUFFER);
+		CHECK(instances && instances->start == frame * 8 * sizeof(GPU_INSTANCE_DATA) && instances->discard == (frame == 0));
+	}
+}
+
+static void testLimitsAreReported()
+{
+	RenderSnapshot snapshot;
+	buildScene(snapshot);
+
+	// Orthographic views can't be clustered, and lights past the light buffer's size are dropped
+	snapshot.view.projectionMatrix = makeOrthographic();
+	snapshot.lights.clear();
+	for (unsigned int i = 0; i < MAX_LIGHTS + 3; i++)
+	{
+		snapshot.lights.push_back(makeLight(POINT_LIGHT, 0.0f, 0.0f, 20.0f, false));
+	}
+
+	RenderCommandBuffer commands;
+	TestShaderBinder shaders(commands);
+
+	FrameRecorder recorder;
+	recorder.setResources(makeResources());
+	recorder.record(snapshot, makeHandle(HANDLE_BACK_BUFFER_RTV), makeHandle(HANDLE_BACK_BUFFER_DSV), 1600.0f, 900.0f, shaders, commands);
+
+	CHECK(recorder.getDroppedLightCount() == 3);
+	CHECK(recorder.hasRejectedProjection());
+
+	const RenderCommand* lights = findWrite(commands, HANDLE_LIGHT_BUFFER);
+	CHECK(lights && lights->count == MAX_LIGHTS * sizeof(GPU_LIGHT_DATA));
+
+	// With no projection to cluster by, no cluster has any lights
+	CHECK(findWrite(commands, HANDLE_CLUSTER_INDEX_BUFFER) == nullptr);
+
+	NullRenderBackend backend;
+	backend.execute(commands);
+	CHECK(backend.getErrors().empty());
+}
+
+int main()
+{
+	testFrameIsValidAndBatched();
+	testInstanceBufferIsAppendedTo();
+	testLimitsAreReported();
+
+	return TEST_RESULT();
+}
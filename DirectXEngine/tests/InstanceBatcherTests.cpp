@@ -0,0 +1,138 @@
+#include "Test.h"
+
+#include "../src/Render/InstanceBatcher.h"
+
+static InstanceDrawState makeState(unsigned int meshID, unsigned int materialID, bool instanceable = true)
+{
+	InstanceDrawState state;
+	state.meshID = meshID;
+	state.materialID = materialID;
+	state.instanceable = instanceable;
+	state.selected = false;
+	state.wireframe = false;
+	for (unsigned int i = 0; i < 4; i++)
+	{
+		state.wireframeColor[i] = 1.0f;
+	}
+
+	return state;
+}
+
+// Adds a main pass draw for each state, in the order given, as if the list had already been sorted
+static void buildDrawList(const std::vector<InstanceDrawState>& states, DrawList& drawList)
+{
+	drawList.clear();
+	for (unsigned int i = 0; i < states.size(); i++)
+	{
+		drawList.add(DrawList::makeOpaqueKey(DRAWPASS_MAIN, 0, states[i].materialID, states[i].meshID, (float)i), i);
+	}
+}
+
+static std::vector<unsigned int> batchCounts(const std::vector<InstanceDrawState>& states, unsigned int maxInstances)
+{
+	DrawList drawList;
+	buildDrawList(states, drawList);
+
+	std::vector<InstanceBatch> batches;
+	InstanceBatcher::buildBatches(drawList, states.data(), maxInstances, batches);
+
+	std::vector<unsigned int> counts;
+	unsigned int nextItem = 0;
+	for (unsigned int i = 0; i < batches.size(); i++)
+	{
+		// Batches cover the list in order without gaps
+		CHECK(batches[i].firstItem == nextItem);
+		nextItem += batches[i].count;
+
+		counts.push_back(batches[i].count);
+	}
+	CHECK(nextItem == states.size());
+
+	return counts;
+}
+
+static void testMatchingDrawsShareABatch()
+{
+	std::vector<InstanceDrawState> states(5, makeState(1, 1));
+	CHECK(batchCounts(states, 64) == std::vector<unsigned int>({ 5 }));
+}
+
+static void testMeshChangeSplitsRun()
+{
+	std::vector<InstanceDrawState> states = { makeState(1, 1), makeState(1, 1), makeState(2, 1), makeState(2, 1), makeState(2, 1) };
+	CHECK(batchCounts(states, 64) == std::vector<unsigned int>({ 2, 3 }));
+}
+
+static void testMaterialChangeSplitsRun()
+{
+	std::vector<InstanceDrawState> states = { makeState(1, 1), makeState(1, 2), makeState(1, 2), makeState(1, 3) };
+	CHECK(batchCounts(states, 64) == std::vector<unsigned int>({ 1, 2, 1 }));
+}
+
+static void testRunsAreCappedAtMaxInstances()
+{
+	std::vector<InstanceDrawState> states(10, makeState(1, 1));
+	CHECK(batchCounts(states, 4) == std::vector<unsigned int>({ 4, 4, 2 }));
+
+	// A cap of zero still makes progress, one draw at a time
+	CHECK(batchCounts(std::vector<InstanceDrawState>(3, makeState(1, 1)), 0) == std::vector<unsigned int>({ 1, 1, 1 }));
+}
+
+static void testNonInstanceableDrawsFallBackToSingleDraws()
+{
+	std::vector<InstanceDrawState> states = { makeState(1, 1, false), makeState(1, 1, false), makeState(1, 1, false) };
+	CHECK(batchCounts(states, 64) == std::vector<unsigned int>({ 1, 1, 1 }));
+
+	// An instanceable draw doesn't pull in a neighbour that isn't
+	states = { makeState(1, 1), makeState(1, 1), makeState(1, 1, false) };
+	CHECK(batchCounts(states, 64) == std::vector<unsigned int>({ 2, 1 }));
+}
+
+static void testSelectionAndWireframeSplitRuns()
+{
+	std::vector<InstanceDrawState> states(4, makeState(1, 1));
+	states[2].selected = true;
+	CHECK(batchCounts(states, 64) == std::vector<unsigned int>({ 2, 1, 1 }));
+
+	// Wireframe colours only matter when the wireframe is drawn
+	states = std::vector<InstanceDrawState>(4, makeState(1, 1));
+	states[1].wireframeColor[0] = 0.0f;
+	CHECK(batchCounts(states, 64) == std::vector<unsigned int>({ 4 }));
+
+	for (unsigned int i = 0; i < states.size(); i++)
+	{
+		states[i].wireframe = true;
+	}
+	CHECK(batchCounts(states, 64) == std::vector<unsigned int>({ 1, 1, 2 }));
+}
+
+static void testPassChangeSplitsRun()
+{
+	std::vector<InstanceDrawState> states(4, makeState(1, 1));
+
+	DrawList drawList;
+	drawList.add(DrawList::makeOpaqueKey(DRAWPASS_SHADOW, 0, 1, 1, 0.0f), 0);
+	drawList.add(DrawList::makeOpaqueKey(DRAWPASS_SHADOW, 0, 1, 1, 1.0f), 1);
+	drawList.add(DrawList::makeOpaqueKey(DRAWPASS_MAIN, 0, 1, 1, 0.0f), 2);
+	drawList.add(DrawList::makeOpaqueKey(DRAWPASS_MAIN, 0, 1, 1, 1.0f), 3);
+
+	std::vector<InstanceBatch> batches;
+	InstanceBatcher::buildBatches(drawList, states.data(), 64, batches);
+
+	CHECK(batches.size() == 2);
+	CHECK(batches[0].firstItem == 0 && batches[0].count == 2);
+	CHECK(batches[1].firstItem == 2 && batches[1].count == 2);
+}
+
+int main()
+{
+	testMatchingDrawsShareABatch();
+	testMeshChangeSplitsRun();
+	testMaterialChangeSplitsRun();
+	testRunsAreCappedAtMaxInstances();
+	testNonInstanceableDrawsFallBackToSingleDraws();
+	testSelectionAndWireframeSplitRuns();
+	testPassChangeSplitsRun();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,255 @@
+#include "Test.h"
+
+#include "../src/Job/JobSystem.h"
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Waits for every job to arrive, so it only returns true if they were all running at the same time
+static bool rendezvous(std::atomic<int>& arrived, int count)
+{
+	arrived++;
+
+	auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (arrived.load() < count)
+	{
+		if (std::chrono::steady_clock::now() > timeout) return false;
+		std::this_thread::yield();
+	}
+
+	return true;
+}
+
+static bool waitFor(const std::atomic<bool>& flag)
+{
+	auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (!flag.load())
+	{
+		if (std::chrono::steady_clock::now() > timeout) return false;
+		std::this_thread::yield();
+	}
+
+	return true;
+}
+
+static void testWorkIsStolen()
+{
+	const int jobCount = (int)JobSystem::getWorkerCount();
+
+	std::atomic<int> arrived(0);
+	std::atomic<int> met(0);
+	std::vector<std::atomic<int>> ranOn(jobCount);
+	for (int i = 0; i < jobCount; i++)
+	{
+		ranOn[i] = -1;
+	}
+
+	// Every job is pushed onto this thread's queue, and none of them can finish until all of them are running,
+	// so the other workers have to steal them
+	Job* root = JobSystem::createJob(nullptr);
+	for (int i = 0; i < jobCount; i++)
+	{
+		Job* job = JobSystem::createChildJob(root, [&, i](Job*)
+		{
+			ranOn[i] = (int)JobSystem::getThreadIndex();
+			if (rendezvous(arrived, jobCount))
+				met++;
+		});
+		JobSystem::run(job);
+	}
+
+	JobSystem::run(root);
+	JobSystem::wait(root);
+
+	CHECK(met == jobCount);
+
+	// Each job ran on a different worker
+	std::vector<int> threads;
+	for (int i = 0; i < jobCount; i++)
+	{
+		threads.push_back(ranOn[i]);
+	}
+	std::sort(threads.begin(), threads.end());
+	CHECK(std::unique(threads.begin(), threads.end()) == threads.end());
+	CHECK(threads.front() >= 0);
+}
+
+static void testParentWaitsForChildren()
+{
+	std::atomic<bool> parentRan(false);
+	std::atomic<bool> releaseChild(false);
+	std::atomic<bool> childFinished(false);
+	std::atomic<bool> grandchildFinished(false);
+
+	Job* parent = JobSystem::createJob([&](Job*) { parentRan = true; });
+
+	Job* child = JobSystem::createChildJob(parent, [&](Job* self)
+	{
+		// Children can have children of their own, and the parent waits on those too
+		Job* grandchild = JobSystem::createChildJob(self, [&](Job*)
+		{
+			waitFor(releaseChild);
+			grandchildFinished = true;
+		});
+		JobSystem::run(grandchild);
+
+		childFinished = true;
+	});
+
+	JobSystem::run(child);
+	JobSystem::run(parent);
+
+	// The parent's own function and its child have run, but the grandchild is held back
+	CHECK(waitFor(parentRan));
+	CHECK(waitFor(childFinished));
+	CHECK(!JobSystem::isFinished(child));
+	CHECK(!JobSystem::isFinished(parent));
+
+	releaseChild = true;
+	JobSystem::wait(parent);
+
+	CHECK(grandchildFinished);
+	CHECK(JobSystem::isFinished(parent));
+}
+
+static void checkParallelForCoversEachIndexOnce(unsigned int count, unsigned int batchSize)
+{
+	std::unique_ptr<std::atomic<int>[]> visits(new std::atomic<int>[count + 1]);
+	for (unsigned int i = 0; i <= count; i++)
+	{
+		visits[i] = 0;
+	}
+
+	JobSystem::parallelFor(count, batchSize, [&](unsigned int start, unsigned int end)
+	{
+		CHECK(start < end);
+		CHECK(end <= count);
+		if (end > count) end = count;
+
+		for (unsigned int i = start; i < end; i++)
+		{
+			visits[i]++;
+		}
+	});
+
+	unsigned int visitedOnce = 0;
+	for (unsigned int i = 0; i < count; i++)
+	{
+		if (visits[i] == 1) visitedOnce++;
+	}
+	CHECK(visitedOnce == count);
+}
+
+static void testParallelFor()
+{
+	// Many batches, a last batch that's only partly full, exactly one batch, and fewer items than a batch
+	checkParallelForCoversEachIndexOnce(10000, 64);
+	checkParallelForCoversEachIndexOnce(1000, 7);
+	checkParallelForCoversEachIndexOnce(64, 64);
+	checkParallelForCoversEachIndexOnce(10, 64);
+	checkParallelForCoversEachIndexOnce(100, 0);
+
+	bool called = false;
+	JobSystem::parallelFor(0, 64, [&](unsigned int, unsigned int) { called = true; });
+	CHECK(!called);
+}
+
+static void testSingleWorker()
+{
+	JobSystem jobSystem(1);
+	CHECK(JobSystem::getWorkerCount() == 1);
+
+	// Nothing runs until it's waited on, then everything runs on this thread
+	std::vector<unsigned int> ranOn;
+	Job* root = JobSystem::createJob(nullptr);
+	for (unsigned int i = 0; i < 8; i++)
+	{
+		JobSystem::run(JobSystem::createChildJob(root, [&ranOn](Job*) { ranOn.push_back(JobSystem::getThreadIndex()); }));
+	}
+	JobSystem::run(root);
+
+	CHECK(ranOn.empty());
+	JobSystem::wait(root);
+
+	CHECK(ranOn.size() == 8);
+	CHECK(std::count(ranOn.begin(), ranOn.end(), 0u) == 8);
+
+	checkParallelForCoversEachIndexOnce(1000, 7);
+}
+
+static void testJobSlotsInFlightAreNotReused()
+{
+	// A job that's been created but not run yet is in flight. Going all the way around this thread's
+	// ring of slots must skip over it rather than hand its slot out again.
+	Job* held = JobSystem::createJob(nullptr);
+
+	bool reused = false;
+	for (unsigned int i = 0; i < MAX_JOBS_PER_THREAD * 2; i++)
+	{
+		Job* job = JobSystem::createJob(nullptr);
+		if (job == held) reused = true;
+
+		JobSystem::run(job);
+		JobSystem::wait(job);
+	}
+
+	CHECK(!reused);
+	CHECK(!JobSystem::isFinished(held));
+
+	JobSystem::run(held);
+	JobSystem::wait(held);
+}
+
+static void testFullJobPoolRunsJobsToFreeASlot()
+{
+	JobSystem jobSystem(1);
+
+	// With one worker nothing runs until this thread waits, so every slot is in flight
+	std::vector<Job*> jobs;
+	std::vector<char> finished(MAX_JOBS_PER_THREAD, 0);
+	for (unsigned int i = 0; i < MAX_JOBS_PER_THREAD; i++)
+	{
+		Job* job = JobSystem::createJob([&finished, i](Job*) { finished[i] = 1; });
+		jobs.push_back(job);
+		JobSystem::run(job);
+	}
+
+	CHECK(std::count(finished.begin(), finished.end(), 1) == 0);
+
+	// Creating one more has to run a queued job first, and is given that job's slot
+	Job* extra = JobSystem::createJob(nullptr);
+	auto slot = std::find(jobs.begin(), jobs.end(), extra);
+	CHECK(slot != jobs.end());
+	if (slot != jobs.end())
+		CHECK(finished[slot - jobs.begin()] == 1);
+
+	JobSystem::run(extra);
+	JobSystem::wait(extra);
+	for (unsigned int i = 0; i < jobs.size(); i++)
+	{
+		if (jobs[i] != extra)
+			JobSystem::wait(jobs[i]);
+	}
+
+	CHECK(std::count(finished.begin(), finished.end(), 1) == MAX_JOBS_PER_THREAD);
+}
+
+int main()
+{
+	{
+		JobSystem jobSystem(4);
+
+		testWorkIsStolen();
+		testParentWaitsForChildren();
+		testParallelFor();
+		testJobSlotsInFlightAreNotReused();
+	}
+
+	testSingleWorker();
+	testFullJobPoolRunsJobsToFreeASlot();
+
+	return TEST_RESULT();
+}
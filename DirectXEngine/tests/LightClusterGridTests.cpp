@@ -0,0 +1,256 @@
+#include "Test.h"
+
+#include "../src/Render/LightClusterGrid.h"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace DirectX;
+
+static const float nearDepth = 0.1f;
+static const float farDepth = 100.0f;
+
+// A left handed perspective projection, laid out like XMMatrixPerspectiveFovLH's
+static XMFLOAT4X4 makePerspective(float fovY, float aspectRatio)
+{
+	float yScale = 1.0f / tanf(fovY * 0.5f);
+	float range = farDepth / (farDepth - nearDepth);
+
+	return XMFLOAT4X4(
+		yScale / aspectRatio, 0.0f, 0.0f, 0.0f,
+		0.0f, yScale, 0.0f, 0.0f,
+		0.0f, 0.0f, range, 1.0f,
+		0.0f, 0.0f, -range * nearDepth, 0.0f);
+}
+
+static XMFLOAT4X4 makeIdentity()
+{
+	return XMFLOAT4X4(
+		1.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, 1.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f,
+		0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+// The view space point in the middle of a cluster
+static XMFLOAT3 getClusterCenter(const XMFLOAT4X4& projection, unsigned int tileX, unsigned int tileY, unsigned int slice)
+{
+	float sliceNear = nearDepth * powf(farDepth / nearDepth, (float)slice / LIGHT_CLUSTER_SLICES);
+	float sliceFar = nearDepth * powf(farDepth / nearDepth, (float)(slice + 1) / LIGHT_CLUSTER_SLICES);
+	float depth = sqrtf(sliceNear * sliceFar);
+
+	float ndcX = -1.0f + 2.0f * (tileX + 0.5f) / LIGHT_CLUSTER_TILES_X;
+	float ndcY = 1.0f - 2.0f * (tileY + 0.5f) / LIGHT_CLUSTER_TILES_Y;
+
+	return XMFLOAT3(ndcX * depth / projection._11, ndcY * depth / projection._22, depth);
+}
+
+static bool clusterHasLight(const LightClusterGrid& grid, unsigned int cluster, unsigned int light)
+{
+	const LightClusterRange& range = grid.getClusterRanges()[cluster];
+	const std::vector<unsigned int>& indices = grid.getLightIndices();
+
+	return std::find(indices.begin() + range.offset, indices.begin() + range.offset + range.count, light) != indices.begin() + range.offset + range.count;
+}
+
+static unsigned int countClustersWithLights(const LightClusterGrid& grid)
+{
+	unsigned int count = 0;
+	for (unsigned int i = 0; i < LIGHT_CLUSTER_COUNT; i++)
+	{
+		if (grid.getClusterRanges()[i].count > 0) count++;
+	}
+
+	return count;
+}
+
+static unsigned int parallelForCalls = 0;
+
+// Runs batches back to front, so results that depend on the order slices are binned in would show up
+static void reverseParallelFor(unsigned int count, unsigned int batchSize, const std::function<void(unsigned int, unsigned int)>& function)
+{
+	parallelForCalls++;
+
+	for (unsigned int start = (count - 1) / batchSize * batchSize; ; start -= batchSize)
+	{
+		function(start, std::min(start + batchSize, count));
+		if (start == 0) break;
+	}
+}
+
+static void testNoProjectionLeavesClustersEmpty()
+{
+	LightClusterGrid grid;
+
+	LightBounds light;
+	light.center = XMFLOAT3(0.0f, 0.0f, 10.0f);
+	light.radius = 1000.0f;
+	grid.assignLights(makeIdentity(), &light, 1);
+
+	CHECK(countClustersWithLights(grid) == 0);
+	CHECK(grid.getLightIndices().empty());
+
+	// An orthographic projection is rejected, and there's still nothing to bin into
+	XMFLOAT4X4 orthographic = makeIdentity();
+	CHECK(!grid.setProjection(orthographic));
+	grid.assignLights(makeIdentity(), &light, 1);
+	CHECK(countClustersWithLights(grid) == 0);
+}
+
+static void testSmallLightIsInItsCluster()
+{
+	XMFLOAT4X4 projection = makePerspective(1.0f, 16.0f / 9.0f);
+
+	LightClusterGrid grid;
+	CHECK(grid.setProjection(projection));
+	CHECK(fabsf(grid.getNearDepth() - nearDepth) < 1e-4f);
+	CHECK(fabsf(grid.getFarDepth() - farDepth) < 1e-2f);
+
+	const unsigned int tileX = 5;
+	const unsigned int tileY = 2;
+	const unsigned int slice = 12;
+
+	LightBounds light;
+	light.center = getClusterCenter(projection, tileX, tileY, slice);
+	light.radius = 0.001f;
+	grid.assignLights(makeIdentity(), &light, 1);
+
+	CHECK(grid.getSlice(light.center.z) == slice);
+	CHECK(clusterHasLight(grid, LightClusterGrid::getClusterIndex(tileX, tileY, slice), 0));
+
+	// Cluster boxes are conservative, so a light can touch its direct neighbours' boxes too, but nothing further away
+	for (unsigned int s = 0; s < LIGHT_CLUSTER_SLICES; s++)
+	{
+		for (unsigned int y = 0; y < LIGHT_CLUSTER_TILES_Y; y++)
+		{
+			for (unsigned int x = 0; x < LIGHT_CLUSTER_TILES_X; x++)
+			{
+				bool near = abs((int)s - (int)slice) <= 1 && abs((int)y - (int)tileY) <= 1 && abs((int)x - (int)tileX) <= 1;
+				if (!near)
+					CHECK(!clusterHasLight(grid, LightClusterGrid::getClusterIndex(x, y, s), 0));
+			}
+		}
+	}
+}
+
+static void testLightsOutsideTheViewAreSkipped()
+{
+	XMFLOAT4X4 projection = makePerspective(1.0f, 16.0f / 9.0f);
+
+	LightClusterGrid grid;
+	grid.setProjection(projection);
+
+	LightBounds lights[3];
+	// Behind the camera
+	lights[0].center = XMFLOAT3(0.0f, 0.0f, -10.0f);
+	lights[0].radius = 5.0f;
+	// Past the far plane
+	lights[1].center = XMFLOAT3(0.0f, 0.0f, farDepth + 10.0f);
+	lights[1].radius = 5.0f;
+	// Far above the top of the screen
+	lights[2].center = XMFLOAT3(0.0f, 50.0f, 10.0f);
+	lights[2].radius = 1.0f;
+
+	grid.assignLights(makeIdentity(), lights, 3);
+	CHECK(grid.getLightIndices().empty());
+
+	// The view matrix moves lights into view space, so moving the camera back brings the first one into view
+	XMFLOAT4X4 view = makeIdentity();
+	view._43 = 20.0f;
+	grid.assignLights(view, lights, 1);
+	CHECK(!grid.getLightIndices().empty());
+}
+
+static void testLargeLightIsInEveryCluster()
+{
+	LightClusterGrid grid(&reverseParallelFor);
+	grid.setProjection(makePerspective(1.0f, 16.0f / 9.0f));
+
+	LightBounds lights[2];
+	lights[0].center = XMFLOAT3(0.0f, 0.0f, 50.0f);
+	lights[0].radius = 1000.0f;
+	lights[1].center = XMFLOAT3(0.0f, 0.0f, 50.0f);
+	lights[1].radius = 1000.0f;
+
+	parallelForCalls = 0;
+	grid.assignLights(makeIdentity(), lights, 2);
+
+	CHECK(parallelForCalls == 1);
+	CHECK(!grid.hasOverflowed());
+	CHECK(grid.getLightIndices().size() == 2 * LIGHT_CLUSTER_COUNT);
+
+	// Ranges are laid out in cluster order, with each cluster's lights in increasing index order
+	unsigned int offset = 0;
+	for (unsigned int i = 0; i < LIGHT_CLUSTER_COUNT; i++)
+	{
+		const LightClusterRange& range = grid.getClusterRanges()[i];
+		CHECK(range.offset == offset && range.count == 2);
+		CHECK(grid.getLightIndices()[range.offset] == 0 && grid.getLightIndices()[range.offset + 1] == 1);
+		offset += range.count;
+	}
+}
+
+static void testOverflowIsReported()
+{
+	LightClusterGrid grid;
+	grid.setProjection(makePerspective(1.0f, 16.0f / 9.0f));
+
+	std::vector<LightBounds> lights(LIGHT_CLUSTER_MAX_INDICES / LIGHT_CLUSTER_COUNT + 1);
+	for (unsigned int i = 0; i < lights.size(); i++)
+	{
+		lights[i].center = XMFLOAT3(0.0f, 0.0f, 50.0f);
+		lights[i].radius = 1000.0f;
+	}
+
+	grid.assignLights(makeIdentity(), lights.data(), (unsigned int)lights.size());
+	CHECK(grid.hasOverflowed());
+	CHECK(grid.getLightIndices().size() == LIGHT_CLUSTER_MAX_INDICES);
+
+	grid.assignLights(makeIdentity(), nullptr, 0);
+	CHECK(!grid.hasOverflowed());
+	CHECK(grid.getLightIndices().empty());
+}
+
+static void testSpotLightBoundsContainCone()
+{
+	XMFLOAT3 position(1.0f, 2.0f, 3.0f);
+	XMFLOAT3 direction(0.0f, 0.0f, 2.0f);
+	float radius = 10.0f;
+	float spotAngle = 20.0f;
+
+	LightBounds bounds = LightClusterGrid::getSpotLightBounds(position, direction, radius, spotAngle);
+	CHECK(bounds.radius < radius);
+
+	// The light itself, the tip of the cone and a point on the rim of its end cap are all inside
+	float rimAngle = XMConvertToRadians(spotAngle);
+	XMFLOAT3 points[3] =
+	{
+		position,
+		XMFLOAT3(position.x, position.y, position.z + radius),
+		XMFLOAT3(position.x + radius * sinf(rimAngle), position.y, position.z + radius * cosf(rimAngle))
+	};
+
+	for (unsigned int i = 0; i < 3; i++)
+	{
+		float dx = points[i].x - bounds.center.x;
+		float dy = points[i].y - bounds.center.y;
+		float dz = points[i].z - bounds.center.z;
+		CHECK(sqrtf(dx * dx + dy * dy + dz * dz) <= bounds.radius * 1.0001f);
+	}
+
+	// Wide cones just use the light's radius
+	bounds = LightClusterGrid::getSpotLightBounds(position, direction, radius, 70.0f);
+	CHECK(bounds.radius == radius);
+}
+
+int main()
+{
+	testNoProjectionLeavesClustersEmpty();
+	testSmallLightIsInItsCluster();
+	testLightsOutsideTheViewAreSkipped();
+	testLargeLightIsInEveryCluster();
+	testOverflowIsReported();
+	testSpotLightBoundsContainCone();
+
+	return TEST_RESULT();
+}
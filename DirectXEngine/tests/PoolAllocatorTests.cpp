@@ -0,0 +1,86 @@
+#include "Test.h"
+
+#include "../src/Memory/PoolAllocator.h"
+
+#include <thread>
+#include <vector>
+
+struct Pooled
+{
+	int value;
+	double padding;
+};
+
+static void testConcurrentAllocation()
+{
+	const unsigned int threadCount = 8;
+	const unsigned int allocationsPerThread = 10000;
+
+	std::vector<std::thread> threads;
+	std::vector<std::vector<Pooled*>> allocated(threadCount);
+
+	for (unsigned int i = 0; i < threadCount; i++)
+	{
+		threads.push_back(std::thread([i, &allocated]()
+		{
+			for (unsigned int j = 0; j < allocationsPerThread; j++)
+			{
+				Pooled* object = new (TypePools::get<Pooled>().allocate()) Pooled();
+				object->value = i;
+				allocated[i].push_back(object);
+
+				// Free every other one straight away so allocations and frees interleave across threads
+				if (j % 2 == 1)
+				{
+					TypePools::destroy(allocated[i].back());
+					allocated[i].pop_back();
+				}
+			}
+		}));
+	}
+
+	for (unsigned int i = 0; i < threadCount; i++)
+	{
+		threads[i].join();
+	}
+
+	CHECK(TypePools::get<Pooled>().getAllocatedCount() == threadCount * allocationsPerThread / 2);
+
+	// No slot was handed out twice
+	for (unsigned int i = 0; i < threadCount; i++)
+	{
+		for (unsigned int j = 0; j < allocated[i].size(); j++)
+		{
+			CHECK(allocated[i][j]->value == (int)i);
+			TypePools::destroy(allocated[i][j]);
+		}
+	}
+
+	CHECK(TypePools::get<Pooled>().getAllocatedCount() == 0);
+}
+
+static void testGetAfterRelease()
+{
+	TypePools::get<Pooled>().reserve(16);
+	TypePools::release();
+
+	CHECK(TypePools::find(typeid(Pooled)) == nullptr);
+
+	// A new pool is created rather than handing back the one that was released
+	PoolAllocator& pool = TypePools::get<Pooled>();
+	CHECK(pool.getCapacity() == 0);
+	CHECK(TypePools::find(typeid(Pooled)) == &pool);
+
+	TypePools::destroy(new (pool.allocate()) Pooled());
+	CHECK(pool.getAllocatedCount() == 0);
+
+	TypePools::release();
+}
+
+int main()
+{
+	testConcurrentAllocation();
+	testGetAfterRelease();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,221 @@
+#include "Test.h"
+
+#include "../src/Render/ShadowAtlas.h"
+
+#include <cmath>
+#include <vector>
+
+using namespace DirectX;
+
+// Small enough that packing runs out of room quickly, 8 by 8 of the smallest tiles
+static const unsigned int atlasSize = 1024;
+static const unsigned int minTileSize = 128;
+
+static bool tilesOverlap(const ShadowAtlasTile& a, const ShadowAtlasTile& b)
+{
+	return a.x < b.x + b.size && b.x < a.x + a.size && a.y < b.y + b.size && b.y < a.y + a.size;
+}
+
+// Every placed tile is inside the atlas, aligned to its own size and clear of every other tile
+static void checkPlacement(const std::vector<ShadowAtlasTile>& tiles)
+{
+	for (unsigned int i = 0; i < tiles.size(); i++)
+	{
+		const ShadowAtlasTile& tile = tiles[i];
+		if (tile.size == 0) continue;
+
+		CHECK(tile.x + tile.size <= atlasSize);
+		CHECK(tile.y + tile.size <= atlasSize);
+		CHECK(tile.x % tile.size == 0);
+		CHECK(tile.y % tile.size == 0);
+
+		for (unsigned int j = i + 1; j < tiles.size(); j++)
+		{
+			if (tiles[j].size > 0)
+				CHECK(!tilesOverlap(tile, tiles[j]));
+		}
+	}
+}
+
+static bool tileIs(const ShadowAtlasTile& tile, unsigned int x, unsigned int y, unsigned int size)
+{
+	return tile.x == x && tile.y == y && tile.size == size;
+}
+
+static std::vector<ShadowAtlasTile> pack(ShadowAtlas& atlas, const std::vector<unsigned int>& sizes)
+{
+	std::vector<ShadowAtlasTile> tiles(sizes.size());
+	atlas.pack(sizes.data(), (unsigned int)sizes.size(), tiles.data());
+	checkPlacement(tiles);
+
+	return tiles;
+}
+
+// A left handed perspective projection with a 90 degree vertical field of view
+static XMFLOAT4X4 makePerspective()
+{
+	float nearDepth = 0.1f;
+	float farDepth = 100.0f;
+	float range = farDepth / (farDepth - nearDepth);
+
+	return XMFLOAT4X4(
+		1.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, 1.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, range, 1.0f,
+		0.0f, 0.0f, -range * nearDepth, 0.0f);
+}
+
+static XMFLOAT4X4 makeIdentity()
+{
+	return XMFLOAT4X4(
+		1.0f, 0.0f, 0.0f, 0.0f,
+		0.0f, 1.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f, 0.0f,
+		0.0f, 0.0f, 0.0f, 1.0f);
+}
+
+static void testTilesFollowTheCurve()
+{
+	ShadowAtlas atlas(atlasSize, minTileSize);
+	std::vector<ShadowAtlasTile> tiles = pack(atlas, { 128, 512, 256, 128, 256, 128 });
+
+	// Largest first, then in request order within a size, each starting where the Z-order curve got to.
+	// The 512 takes the first 16 cells, the 256s the next two runs of 4, and the 128s the three cells after that.
+	CHECK(tileIs(tiles[1], 0, 0, 512));
+	CHECK(tileIs(tiles[2], 512, 0, 256));
+	CHECK(tileIs(tiles[4], 768, 0, 256));
+	CHECK(tileIs(tiles[0], 512, 256, 128));
+	CHECK(tileIs(tiles[3], 640, 256, 128));
+	CHECK(tileIs(tiles[5], 512, 384, 128));
+
+	// Exactly filling the atlas with a mix of sizes, two 512s, seven 256s and four 128s, leaves no gaps for anything to be dropped from
+	std::vector<unsigned int> sizes = { 128, 256, 512, 256, 128, 256, 256, 128, 512, 256, 256, 128, 256 };
+
+	tiles = pack(atlas, sizes);
+	for (unsigned int i = 0; i < tiles.size(); i++)
+	{
+		CHECK(tiles[i].size == sizes[i]);
+	}
+}
+
+static void testLargestTilesArePlacedFirst()
+{
+	ShadowAtlas atlas(atlasSize, minTileSize);
+	std::vector<ShadowAtlasTile> tiles = pack(atlas, { 128, 128, 512 });
+
+	CHECK(tileIs(tiles[2], 0, 0, 512));
+	CHECK(tileIs(tiles[0], 512, 0, 128));
+	CHECK(tileIs(tiles[1], 640, 0, 128));
+}
+
+static void testTilesShrinkWhenTheAtlasIsFull()
+{
+	ShadowAtlas atlas(atlasSize, minTileSize);
+
+	// Requests are clamped to the atlas
+	std::vector<ShadowAtlasTile> tiles = pack(atlas, { 2048 });
+	CHECK(tileIs(tiles[0], 0, 0, atlasSize));
+
+	// The whole atlas and two quarters of it don't fit, so the largest gives up half its size
+	tiles = pack(atlas, { 1024, 512, 512 });
+	CHECK(tileIs(tiles[0], 0, 0, 512));
+	CHECK(tileIs(tiles[1], 512, 0, 512));
+	CHECK(tileIs(tiles[2], 0, 512, 512));
+
+	// Five quarters don't fit either. Only the last two of them shrink, and only as far as it takes.
+	tiles = pack(atlas, { 512, 512, 512, 512, 512 });
+	CHECK(tiles[0].size == 512);
+	CHECK(tiles[1].size == 512);
+	CHECK(tiles[2].size == 512);
+	CHECK(tiles[3].size == 256);
+	CHECK(tiles[4].size == 256);
+
+	// Too many lights for even the smallest tiles, so everything shrinks to them and the last ones get nothing
+	std::vector<unsigned int> sizes(66, 512);
+	tiles = pack(atlas, sizes);
+	for (unsigned int i = 0; i < 64; i++)
+	{
+		CHECK(tiles[i].size == minTileSize);
+	}
+	CHECK(tiles[64].size == 0);
+	CHECK(tiles[65].size == 0);
+
+	// Packing nothing is fine
+	atlas.pack(nullptr, 0, nullptr);
+}
+
+static void testTileSizeIsClamped()
+{
+	ShadowAtlas atlas(atlasSize, minTileSize);
+
+	CHECK(atlas.selectTileSize(1.0f, 512) == 512);
+	CHECK(atlas.selectTileSize(0.5f, 512) == 256);
+
+	// Sizes in between round down to a power of two
+	CHECK(atlas.selectTileSize(0.3f, 512) == 128);
+	CHECK(atlas.selectTileSize(1.0f, 600) == 512);
+
+	// Never smaller than the smallest tile
+	CHECK(atlas.selectTileSize(0.0f, 512) == minTileSize);
+	CHECK(atlas.selectTileSize(0.01f, 512) == minTileSize);
+	CHECK(atlas.selectTileSize(1.0f, 16) == minTileSize);
+
+	// Never larger than the light's largest size or the atlas
+	CHECK(atlas.selectTileSize(4.0f, 512) == 512);
+	CHECK(atlas.selectTileSize(1.0f, 8192) == atlasSize);
+}
+
+static void testScreenCoverage()
+{
+	XMFLOAT4X4 view = makeIdentity();
+	XMFLOAT4X4 projection = makePerspective();
+
+	// The camera is inside the sphere, or the sphere reaches behind it
+	CHECK(ShadowAtlas::getScreenCoverage(XMFLOAT3(0, 0, 0), 1.0f, view, projection) == 1.0f);
+	CHECK(ShadowAtlas::getScreenCoverage(XMFLOAT3(0, 0, 0.5f), 1.0f, view, projection) == 1.0f);
+	CHECK(ShadowAtlas::getScreenCoverage(XMFLOAT3(0, 0, -5.0f), 1.0f, view, projection) == 1.0f);
+
+	// A sphere of radius 1 ten units away covers a tenth of the screen at a 90 degree field of view
+	CHECK(fabsf(ShadowAtlas::getScreenCoverage(XMFLOAT3(0, 0, 10.0f), 1.0f, view, projection) - 0.1f) < 0.0001f);
+
+	// Further away covers less
+	CHECK(ShadowAtlas::getScreenCoverage(XMFLOAT3(0, 0, 20.0f), 1.0f, view, projection) < ShadowAtlas::getScreenCoverage(XMFLOAT3(0, 0, 10.0f), 1.0f, view, projection));
+}
+
+static void testTileMatrixMapsClipSpaceToTheTile()
+{
+	ShadowAtlas atlas(atlasSize, minTileSize);
+
+	ShadowAtlasTile tile;
+	tile.x = 256;
+	tile.y = 512;
+	tile.size = 256;
+	XMFLOAT4X4 matrix = atlas.getTileMatrix(tile);
+
+	// The top left corner of clip space goes to the tile's top left corner, and the bottom right to its bottom right
+	float u = -1.0f * matrix._11 + 1.0f * matrix._21 + matrix._41;
+	float v = -1.0f * matrix._12 + 1.0f * matrix._22 + matrix._42;
+	CHECK(fabsf(u - 0.25f) < 0.0001f);
+	CHECK(fabsf(v - 0.5f) < 0.0001f);
+
+	u = 1.0f * matrix._11 - 1.0f * matrix._21 + matrix._41;
+	v = 1.0f * matrix._12 - 1.0f * matrix._22 + matrix._42;
+	CHECK(fabsf(u - 0.5f) < 0.0001f);
+	CHECK(fabsf(v - 0.75f) < 0.0001f);
+
+	// Depth is left alone
+	CHECK(matrix._33 == 1.0f);
+	CHECK(matrix._43 == 0.0f);
+}
+
+int main()
+{
+	testTilesFollowTheCurve();
+	testLargestTilesArePlacedFirst();
+	testTilesShrinkWhenTheAtlasIsFull();
+	testTileSizeIsClamped();
+	testScreenCoverage();
+	testTileMatrixMapsClipSpaceToTheTile();
+
+	return TEST_RESULT();
+}
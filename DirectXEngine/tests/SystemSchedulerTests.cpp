@@ -0,0 +1,128 @@
+#include "Test.h"
+
+#include "../src/Job/JobSystem.h"
+#include "../src/Scene/SystemScheduler.h"
+
+#include <chrono>
+#include <mutex>
+#include <thread>
+
+struct ComponentA {};
+struct ComponentB {};
+
+// Waits for every system to arrive, so it only returns true if they were all running at the same time
+static bool rendezvous(std::atomic<int>& arrived, int count)
+{
+	arrived++;
+
+	auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+	while (arrived.load() < count)
+	{
+		if (std::chrono::steady_clock::now() > timeout) return false;
+		std::this_thread::yield();
+	}
+
+	return true;
+}
+
+static void testNonConflictingSystemsRunConcurrently()
+{
+	SystemAccess writesA;
+	writesA.exclusive = false;
+	writesA.writes = { typeid(ComponentA) };
+
+	SystemAccess writesB;
+	writesB.exclusive = false;
+	writesB.writes = { typeid(ComponentB) };
+
+	CHECK(!writesA.conflictsWith(writesB));
+
+	std::atomic<int> arrived(0);
+	std::atomic<bool> firstMet(false);
+	std::atomic<bool> secondMet(false);
+
+	SystemScheduler scheduler;
+	scheduler.addSystem(&writesA, [&]() { firstMet = rendezvous(arrived, 2); });
+	scheduler.addSystem(&writesB, [&]() { secondMet = rendezvous(arrived, 2); });
+	scheduler.run();
+
+	CHECK(firstMet);
+	CHECK(secondMet);
+}
+
+static void testReadersRunConcurrently()
+{
+	SystemAccess readsA;
+	readsA.exclusive = false;
+	readsA.reads = { typeid(ComponentA) };
+	readsA.writes = { typeid(ComponentB) };
+
+	SystemAccess alsoReadsA;
+	alsoReadsA.exclusive = false;
+	alsoReadsA.reads = { typeid(ComponentA) };
+
+	CHECK(!readsA.conflictsWith(alsoReadsA));
+
+	std::atomic<int> arrived(0);
+	std::atomic<bool> firstMet(false);
+	std::atomic<bool> secondMet(false);
+
+	SystemScheduler scheduler;
+	scheduler.addSystem(&readsA, [&]() { firstMet = rendezvous(arrived, 2); });
+	scheduler.addSystem(&alsoReadsA, [&]() { secondMet = rendezvous(arrived, 2); });
+	scheduler.run();
+
+	CHECK(firstMet);
+	CHECK(secondMet);
+}
+
+static void testConflictingSystemsRunInOrder()
+{
+	SystemAccess writesA;
+	writesA.exclusive = false;
+	writesA.writes = { typeid(ComponentA) };
+
+	SystemAccess readsA;
+	readsA.exclusive = false;
+	readsA.reads = { typeid(ComponentA) };
+
+	SystemAccess exclusive;
+
+	CHECK(writesA.conflictsWith(readsA));
+	CHECK(exclusive.conflictsWith(readsA));
+	CHECK(exclusive.canWrite(typeid(ComponentB)));
+	CHECK(!readsA.canWrite(typeid(ComponentA)));
+
+	std::mutex mutex;
+	std::vector<int> order;
+	auto record = [&](int system)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		order.push_back(system);
+	};
+
+	SystemScheduler scheduler;
+	for (int frame = 0; frame < 100; frame++)
+	{
+		order.clear();
+
+		scheduler.clear();
+		scheduler.addSystem(&writesA, [&]() { std::this_thread::yield(); record(0); });
+		scheduler.addSystem(&readsA, [&]() { record(1); });
+		scheduler.addSystem(&exclusive, [&]() { record(2); });
+		scheduler.run();
+
+		CHECK(order == std::vector<int>({ 0, 1, 2 }));
+	}
+}
+
+int main()
+{
+	JobSystem jobSystem(4);
+
+	testNonConflictingSystemsRunConcurrently();
+	testReadersRunConcurrently();
+	testConflictingSystemsRunInOrder();
+
+	return TEST_RESULT();
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdio>
+
+// Minimal checks for the test executables. A test fails if any check failed, and keeps going after a failure
+// so every failing check gets reported.
+static int testFailures = 0;
+
+#define CHECK(condition) \
+	do \
+	{ \
+		if (!(condition)) \
+		{ \
+			std::printf("%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition); \
+			testFailures++; \
+		} \
+	} while (false)
+
+#define TEST_RESULT() (testFailures == 0 ? 0 : 1)